@@ -64,11 +64,52 @@ control_ret_t control_cleanup_i2c(void);
  *  \returns           Whether the initialization was successful or not
  */
 control_ret_t control_init_usb(int vendor_id, int product_id, int interface_num);
+
+/** Maximum length of a USB bus path, including the terminating null */
+#define CONTROL_USB_PATH_MAX_CHARS 32
+
+/** Initialize the USB host interface with the device at a bus path
+ *
+ *  The bus path is the bus number and the port numbers from the root hub,
+ *  "1-2.3" for port 3 of the hub on port 2 of bus 1, as in Linux sysfs.
+ *  On Windows it is the bus and device names given by libusb-win32.
+ *
+ *  \param vendor_id     Vendor ID of controlled USB device
+ *  \param product_id    Product ID of controlled USB device
+ *  \param interface_num USB Control interface number of controlled device
+ *  \param bus_path      Bus path of the device, NULL for the first device found
+ *
+ *  \returns           Whether the initialization was successful or not
+ */
+control_ret_t control_init_usb_path(int vendor_id, int product_id, int interface_num,
+                                    const char *bus_path);
+/** List the bus paths of the connected USB devices with a vendor and product ID
+ *
+ *  \param vendor_id     Vendor ID of the devices
+ *  \param product_id    Product ID of the devices
+ *  \param bus_paths     Buffer for the bus paths
+ *  \param max_devices   Number of bus paths the buffer can hold
+ *  \param num_devices   Number of devices found, at most max_devices
+ *
+ *  \returns           Whether the devices could be listed or not
+ */
+control_ret_t control_list_usb(int vendor_id, int product_id,
+                               char bus_paths[][CONTROL_USB_PATH_MAX_CHARS],
+                               unsigned max_devices, unsigned *num_devices);
 /** Shutdown the USB host interface connection
  *
  *  \returns           Whether the shutdown was successful or not
  */
 control_ret_t control_cleanup_usb(void);
+/** Get the identity of the connected USB device from its descriptors
+ *
+ *  \param serial        Buffer for the serial number string, empty if the device has none
+ *  \param serial_len    Size of the serial buffer
+ *  \param bcd_device    Device release number (bcdDevice)
+ *
+ *  \returns           Whether the descriptors could be read or not
+ */
+control_ret_t control_get_usb_device_id(char *serial, size_t serial_len, unsigned *bcd_device);
 #endif
 #if USE_SPI || __DOXYGEN__
 #if RPI || __DOXYGEN__
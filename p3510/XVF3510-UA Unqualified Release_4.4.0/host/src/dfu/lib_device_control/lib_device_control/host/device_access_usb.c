@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #ifdef _WIN32
 #include <windows.h>
 #include "usb.h"
@@ -177,12 +178,22 @@ control_read_command(control_resid_t resid, control_cmd_t cmd,
 
 #ifdef _WIN32
 
-static control_ret_t find_xmos_device(int vendor_id, int product_id)
+static void get_bus_path(struct usb_bus *bus, struct usb_device *dev, char *path, size_t size)
 {
+  snprintf(path, size, "%s-%s", bus->dirname, dev->filename);
+}
+
+static control_ret_t find_xmos_device(int vendor_id, int product_id, const char *bus_path)
+{
+  char path[CONTROL_USB_PATH_MAX_CHARS];
+
   for (struct usb_bus *bus = usb_get_busses(); bus && !devh; bus = bus->next) {
     for (struct usb_device *dev = bus->devices; dev; dev = dev->next) {
       if ((dev->descriptor.idVendor == vendor_id) &&
               (dev->descriptor.idProduct == product_id)) {
+        get_bus_path(bus, dev, path, sizeof(path));
+        if (bus_path != NULL && strcmp(path, bus_path) != 0)
+          continue;
         devh = usb_open(dev);
         if (!devh) {
           fprintf(stderr, "failed to open device\n");
@@ -201,13 +212,37 @@ static control_ret_t find_xmos_device(int vendor_id, int product_id)
   return CONTROL_SUCCESS;
 }
 
-control_ret_t control_init_usb(int vendor_id, int product_id, int interface_num)
+control_ret_t control_list_usb(int vendor_id, int product_id,
+                               char bus_paths[][CONTROL_USB_PATH_MAX_CHARS],
+                               unsigned max_devices, unsigned *num_devices)
+{
+  usb_init();
+  usb_find_busses();
+  usb_find_devices();
+
+  *num_devices = 0;
+  for (struct usb_bus *bus = usb_get_busses(); bus; bus = bus->next) {
+    for (struct usb_device *dev = bus->devices; dev; dev = dev->next) {
+      if ((dev->descriptor.idVendor == vendor_id) &&
+              (dev->descriptor.idProduct == product_id) &&
+              *num_devices < max_devices) {
+        get_bus_path(bus, dev, bus_paths[*num_devices], CONTROL_USB_PATH_MAX_CHARS);
+        (*num_devices)++;
+      }
+    }
+  }
+
+  return CONTROL_SUCCESS;
+}
+
+control_ret_t control_init_usb_path(int vendor_id, int product_id, int interface_num,
+                                    const char *bus_path)
 {
   usb_init();
   usb_find_busses(); /* find all busses */
   usb_find_devices(); /* find all connected devices */
 
-  if (find_xmos_device(vendor_id, product_id) != CONTROL_SUCCESS)
+  if (find_xmos_device(vendor_id, product_id, bus_path) != CONTROL_SUCCESS)
       return CONTROL_ERROR;
 
   int r = usb_set_configuration(devh, 1);
@@ -233,9 +268,71 @@ control_ret_t control_cleanup_usb(void)
   return CONTROL_SUCCESS;
 }
 
+control_ret_t control_get_usb_device_id(char *serial, size_t serial_len, unsigned *bcd_device)
+{
+  struct usb_device *dev = usb_device(devh);
+
+  serial[0] = '\0';
+  *bcd_device = dev->descriptor.bcdDevice;
+  if (dev->descriptor.iSerialNumber != 0 &&
+      usb_get_string_simple(devh, dev->descriptor.iSerialNumber, serial, serial_len) < 0) {
+    return CONTROL_ERROR;
+  }
+
+  return CONTROL_SUCCESS;
+}
+
 #else
 
-control_ret_t control_init_usb(int vendor_id, int product_id, int interface_num)
+// bus number and port numbers from the root hub, as the Linux sysfs names.
+// libusb before 1.0.16 has no port numbers, the device address is used.
+static void get_bus_path(libusb_device *dev, char *path, size_t size)
+{
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000102)
+  uint8_t ports[7];
+  int num_ports = libusb_get_port_numbers(dev, ports, sizeof(ports));
+  int n = snprintf(path, size, "%u", libusb_get_bus_number(dev));
+
+  for (int i = 0; i < num_ports && n > 0 && (size_t)n < size; i++)
+    n += snprintf(path + n, size - n, "%c%u", i == 0 ? '-' : '.', ports[i]);
+#else
+  snprintf(path, size, "%u:%u", libusb_get_bus_number(dev),
+           libusb_get_device_address(dev));
+#endif
+}
+
+control_ret_t control_list_usb(int vendor_id, int product_id,
+                               char bus_paths[][CONTROL_USB_PATH_MAX_CHARS],
+                               unsigned max_devices, unsigned *num_devices)
+{
+  int ret = libusb_init(NULL);
+  if (ret < 0) {
+    fprintf(stderr, "failed to initialise libusb\n");
+    return CONTROL_ERROR;
+  }
+
+  libusb_device **devs = NULL;
+  int num_dev = libusb_get_device_list(NULL, &devs);
+
+  *num_devices = 0;
+  for (int i = 0; i < num_dev && *num_devices < max_devices; i++) {
+    struct libusb_device_descriptor desc;
+    libusb_get_device_descriptor(devs[i], &desc);
+    if (desc.idVendor == vendor_id && desc.idProduct == product_id) {
+      get_bus_path(devs[i], bus_paths[*num_devices], CONTROL_USB_PATH_MAX_CHARS);
+      (*num_devices)++;
+    }
+  }
+
+  if (num_dev >= 0)
+    libusb_free_device_list(devs, 1);
+  libusb_exit(NULL);
+
+  return CONTROL_SUCCESS;
+}
+
+control_ret_t control_init_usb_path(int vendor_id, int product_id, int interface_num,
+                                    const char *bus_path)
 {
   int ret = libusb_init(NULL);
   if (ret < 0) {
@@ -247,10 +344,14 @@ control_ret_t control_init_usb(int vendor_id, int product_id, int interface_num)
   int num_dev = libusb_get_device_list(NULL, &devs);
 
   libusb_device *dev = NULL;
+  char path[CONTROL_USB_PATH_MAX_CHARS];
   for (int i = 0; i < num_dev; i++) {
     struct libusb_device_descriptor desc;
     libusb_get_device_descriptor(devs[i], &desc);
     if (desc.idVendor == vendor_id && desc.idProduct == product_id) {
+      get_bus_path(devs[i], path, sizeof(path));
+      if (bus_path != NULL && strcmp(path, bus_path) != 0)
+        continue;
       dev = devs[i];
       break;
     }
@@ -279,6 +380,29 @@ control_ret_t control_cleanup_usb(void)
   return CONTROL_SUCCESS;
 }
 
+control_ret_t control_get_usb_device_id(char *serial, size_t serial_len, unsigned *bcd_device)
+{
+  struct libusb_device_descriptor desc;
+
+  serial[0] = '\0';
+  // the device descriptor is cached by libusb, only the string needs a transfer
+  if (libusb_get_device_descriptor(libusb_get_device(devh), &desc) < 0)
+    return CONTROL_ERROR;
+
+  *bcd_device = desc.bcdDevice;
+  if (desc.iSerialNumber != 0 &&
+      libusb_get_string_descriptor_ascii(devh, desc.iSerialNumber, (unsigned char*)serial, serial_len) < 0) {
+    return CONTROL_ERROR;
+  }
+
+  return CONTROL_SUCCESS;
+}
+
 #endif // _WIN32
 
+control_ret_t control_init_usb(int vendor_id, int product_id, int interface_num)
+{
+  return control_init_usb_path(vendor_id, product_id, interface_num, NULL);
+}
+
 #endif // USE_USB
@@ -22,7 +22,11 @@
 
 static volatile unsigned int probe_id = 0xffffffff;
 static volatile size_t record_count = 0;
+// The response buffer is allocated when connecting and only grows for a response which does not fit,
+// the commands themselves do not allocate.
+#define RESPONSE_INITIAL_BYTES (sizeof(struct control_xscope_response) + XSCOPE_UPLOAD_MAX_BYTES)
 static unsigned char *last_response = NULL;
+static unsigned last_response_capacity = 0;
 static struct control_xscope_response *last_response_struct = NULL;
 static unsigned last_response_length = 0;
 static unsigned num_commands = 0;
@@ -65,10 +69,11 @@ void record_callback(unsigned int id, unsigned long long timestamp,
   UNUSED_PARAMETER(dataval);
 
   if (id == probe_id) {
-    if (last_response != NULL) {
+    if (length > last_response_capacity) {
       free(last_response);
+      last_response = (unsigned char*)malloc(length);
+      last_response_capacity = length;
     }
-    last_response = (unsigned char*)malloc(length);
     last_response_struct = (struct control_xscope_response*)last_response;
     last_response_length = length;
     memcpy(last_response, databytes, length);
@@ -79,6 +84,11 @@ void record_callback(unsigned int id, unsigned long long timestamp,
 
 control_ret_t control_init_xscope(const char *host_str, const char *port_str)
 {
+  if (last_response == NULL) {
+    last_response = (unsigned char*)malloc(RESPONSE_INITIAL_BYTES);
+    last_response_capacity = RESPONSE_INITIAL_BYTES;
+  }
+
   if (xscope_ep_set_print_cb(xscope_print) != XSCOPE_EP_SUCCESS) {
     fprintf(stderr, "xscope_ep_set_print_cb failed\n");
     return CONTROL_ERROR;
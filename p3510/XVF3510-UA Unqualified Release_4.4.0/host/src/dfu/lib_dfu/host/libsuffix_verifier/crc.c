@@ -4,6 +4,8 @@
 #include "crc.h"
 
 static bool verbose = false;
+static unsigned crc_table[256];
+static bool crc_table_ready = false;
 
 unsigned crc_init(void)
 {
@@ -37,3 +39,32 @@ unsigned crc_finish(unsigned crc)
 
   return ~crc;
 }
+
+// crc_step shifts the bytes in at the top, after 8 steps the register is the
+// previous one shifted down with the byte on top, xored with the polynomial
+// terms which depend only on the 8 bits shifted out
+static void make_crc_table(void)
+{
+  for (unsigned i = 0; i < 256; i++) {
+    unsigned crc = i;
+    for (int b = 0; b < 8; b++) {
+      bool xor_bit = (crc & 1) == 1;
+      crc >>= 1;
+      if (xor_bit)
+        crc ^= 0xEDB88320;
+    }
+    crc_table[i] = crc;
+  }
+  crc_table_ready = true;
+}
+
+unsigned crc_update(unsigned crc, const unsigned char *bytes, size_t num_bytes)
+{
+  if (!crc_table_ready)
+    make_crc_table();
+
+  for (size_t i = 0; i < num_bytes; i++)
+    crc = ((crc >> 8) | ((unsigned)bytes[i] << 24)) ^ crc_table[crc & 0xFF];
+
+  return crc;
+}
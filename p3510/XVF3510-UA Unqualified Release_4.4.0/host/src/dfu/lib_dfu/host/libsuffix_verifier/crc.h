@@ -2,8 +2,13 @@
 #ifndef __crc_h__
 #define __crc_h__
 
+#include <stddef.h>
+
 unsigned crc_init(void);
 void crc_step(unsigned *crc, unsigned char byte);
 unsigned crc_finish(unsigned crc);
 
+// same as crc_step on each byte, a byte at a time from a table
+unsigned crc_update(unsigned crc, const unsigned char *bytes, size_t num_bytes);
+
 #endif
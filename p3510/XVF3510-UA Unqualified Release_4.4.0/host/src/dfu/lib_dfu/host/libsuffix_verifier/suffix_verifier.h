@@ -10,4 +10,13 @@ int verify_dfu_suffix(const unsigned char *file, size_t num_bytes,
                       unsigned short bcd_device,
                       size_t *suffix_length, char msg[256]);
 
+// All the checks of verify_dfu_suffix but the checksum, which is returned in
+// suffix_crc for the caller to compare with the crc_finish of the image
+int verify_dfu_suffix_fields(const unsigned char *file, size_t num_bytes,
+                             unsigned short vendor_id,
+                             unsigned short product_id,
+                             unsigned short bcd_device,
+                             size_t *suffix_length, unsigned *suffix_crc,
+                             char msg[256]);
+
 #endif
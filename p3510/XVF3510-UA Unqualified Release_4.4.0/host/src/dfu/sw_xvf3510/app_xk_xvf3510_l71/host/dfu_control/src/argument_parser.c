@@ -15,33 +15,97 @@ void print_usage(FILE *stream)
   fprintf(stream, "\
 usage:      dfu_usb --help\n\
             dfu_usb OPTIONS write_upgrade boot.dfu data.dfu\n\
+            dfu_usb OPTIONS autotune boot.dfu data.dfu\n\
+            dfu_usb OPTIONS list_devices\n\
 \n\
 OPTIONS:    --quiet\n\
             --vendor-id 0x%04X (default)\n\
             --product-id 0x%04X (default)\n\
             --bcd-device 0x%04X (default)\n\
-            --block-size %d (default)\n",
+            --block-size %d (default)\n\
+            --window %d (default, needs firmware with a DNLOAD queue)\n\
+            --poll-msec N (default is the poll timeout of the device)\n\
+            --bus-path PATH (default is the first device found)\n\
+            --devices all|PATH,PATH...\n\
+            --jobs %d (default, devices updated at the same time)\n\
+\n\
+autotune times the downloads of data.dfu with a range of block sizes and poll\n\
+intervals, writes the upgrade with the fastest and saves it for this transport\n\
+and board. write_upgrade uses the saved settings unless --block-size or\n\
+--poll-msec is given.\n\
+\n\
+With --devices, write_upgrade updates the devices at the bus paths listed by\n\
+list_devices, or all of them, --jobs at a time.\n",
           VENDOR_ID_DEFAULT,
           PRODUCT_ID_DEFAULT,
           BCD_DEVICE_DEFAULT,
-          BLOCK_SIZE_DEFAULT);
+          BLOCK_SIZE_DEFAULT,
+          WINDOW_DEFAULT,
+          JOBS_DEFAULT);
 #endif
 #if USE_I2C
   fprintf(stream, "\
 usage:      dfu_i2c --help\n\
             dfu_i2c OPTIONS write_upgrade boot.dfu data.dfu\n\
+            dfu_i2c OPTIONS autotune boot.dfu data.dfu\n\
+            dfu_i2c OPTIONS list_devices\n\
+\n\
+OPTIONS:    --quiet\n\
+            --vendor-id 0x%04X (default)\n\
+            --product-id 0x%04X (default)\n\
+            --bcd-device 0x%04X (default)\n\
+            --i2c-address 0x%02X (default)\n\
+            --block-size %d (default)\n\
+            --window %d (default, needs firmware with a DNLOAD queue)\n\
+            --poll-msec N (default is the poll timeout of the device)\n\
+            --bus-path PATH (default is the first device found)\n\
+            --devices all|PATH,PATH...\n\
+            --jobs %d (default, devices updated at the same time)\n\
+\n\
+autotune times the downloads of data.dfu with a range of block sizes and poll\n\
+intervals, writes the upgrade with the fastest and saves it for this transport\n\
+and board. write_upgrade uses the saved settings unless --block-size or\n\
+--poll-msec is given.\n\
+\n\
+With --devices, write_upgrade updates the devices at the bus paths listed by\n\
+list_devices, or all of them, --jobs at a time.\n",
+          VENDOR_ID_DEFAULT,
+          PRODUCT_ID_DEFAULT,
+          BCD_DEVICE_DEFAULT,
+          I2C_ADDRESS_DEFAULT,
+          BLOCK_SIZE_DEFAULT,
+          WINDOW_DEFAULT,
+          JOBS_DEFAULT);
+#endif
+#if USE_SIM
+  fprintf(stream, "\
+usage:      dfu_sim --help\n\
+            dfu_sim OPTIONS write_upgrade boot.dfu data.dfu\n\
+            dfu_sim OPTIONS autotune boot.dfu data.dfu\n\
+            dfu_sim OPTIONS list_devices\n\
 \n\
 OPTIONS:    --quiet\n\
             --vendor-id 0x%04X (default)\n\
             --product-id 0x%04X (default)\n\
             --bcd-device 0x%04X (default)\n\
             --i2c-address 0x%02X (default)\n\
-            --block-size %d (default)\n",
+            --block-size %d (default)\n\
+            --window %d (default, needs firmware with a DNLOAD queue)\n\
+            --poll-msec N (default is the poll timeout of the device)\n\
+            --bus-path PATH (default is the first device found)\n\
+            --devices all|PATH,PATH...\n\
+            --jobs %d (default, devices updated at the same time)\n\
+\n\
+Simulated device for tests, DFU_SIM_TRANSPORT=usb (default) or i2c selects\n\
+the timings of the transport. DFU_SIM_DEVICES=N simulates N devices, at the\n\
+bus paths sim-0 to sim-N-1.\n",
           VENDOR_ID_DEFAULT,
           PRODUCT_ID_DEFAULT,
           BCD_DEVICE_DEFAULT,
           I2C_ADDRESS_DEFAULT,
-          BLOCK_SIZE_DEFAULT);
+          BLOCK_SIZE_DEFAULT,
+          WINDOW_DEFAULT,
+          JOBS_DEFAULT);
 #endif
 }
 
@@ -50,6 +114,11 @@ static const char advanced_usage[] =
 "\n\
             --skip-boot-image\n\
             --skip-data-image\n\
+            --installed-boot boot.dfu\n\
+            --installed-data data.dfu\n\
+\n\
+            With the files of the installed images, write_upgrade sends only\n\
+            the blocks which changed, if the device supports delta updates.\n\
 \n\
 advanced:   dfu_usb OPTIONS override_spispec spispec.bin\n\
             dfu_usb OPTIONS detach_and_bus_reset\n\
@@ -59,11 +128,30 @@ advanced:   dfu_usb OPTIONS override_spispec spispec.bin\n\
 "\n\
             --skip-boot-image\n\
             --skip-data-image\n\
+            --installed-boot boot.dfu\n\
+            --installed-data data.dfu\n\
+\n\
+            With the files of the installed images, write_upgrade sends only\n\
+            the blocks which changed, if the device supports delta updates.\n\
 \n\
 advanced:   dfu_i2c OPTIONS override_spispec spispec.bin\n\
             dfu_i2c OPTIONS detach_and_bus_reset\n\
             dfu_i2c OPTIONS reboot\n"
 #endif
+#if USE_SIM
+"\n\
+            --skip-boot-image\n\
+            --skip-data-image\n\
+            --installed-boot boot.dfu\n\
+            --installed-data data.dfu\n\
+\n\
+            With the files of the installed images, write_upgrade sends only\n\
+            the blocks which changed, if the device supports delta updates.\n\
+\n\
+advanced:   dfu_sim OPTIONS override_spispec spispec.bin\n\
+            dfu_sim OPTIONS detach_and_bus_reset\n\
+            dfu_sim OPTIONS reboot\n"
+#endif
 ;
 
 const char *operation_str(int operation)
@@ -73,6 +161,8 @@ const char *operation_str(int operation)
     case OVERRIDE_SPISPEC:     return "override_spispec";
     case DETACH_AND_BUS_RESET: return "detach_and_bus_reset";
     case REBOOT:               return "reboot";
+    case AUTOTUNE:             return "autotune";
+    case LIST_DEVICES:         return "list_devices";
     default: return "?";
   }
 }
@@ -80,7 +170,8 @@ const char *operation_str(int operation)
 int parse_operation(const char *arg)
 {
   const int operations[] = {WRITE_UPGRADE, OVERRIDE_SPISPEC,
-                            DETACH_AND_BUS_RESET, REBOOT, UNKNOWN};
+                            DETACH_AND_BUS_RESET, REBOOT, AUTOTUNE,
+                            LIST_DEVICES, UNKNOWN};
   for (int i = 0; operations[i] != UNKNOWN; i++) {
     if (strcmp(arg, operation_str(operations[i])) == 0)
       return operations[i];
@@ -94,10 +185,17 @@ struct options parse_arguments(int argc, char **argv)
     .operation = UNKNOWN,
     .arguments = {NULL, NULL},
     .device_id = {VENDOR_ID_DEFAULT, PRODUCT_ID_DEFAULT,
-                  BCD_DEVICE_DEFAULT, I2C_ADDRESS_DEFAULT},
+                  BCD_DEVICE_DEFAULT, I2C_ADDRESS_DEFAULT, NULL},
     .block_size = BLOCK_SIZE_DEFAULT,
+    .window = WINDOW_DEFAULT,
+    .poll_msec = POLL_MSEC_DEVICE,
+    .tuning_overridden = false,
     .skip_boot_image = false,
-    .skip_data_image = false
+    .skip_data_image = false,
+    .installed_boot = NULL,
+    .installed_data = NULL,
+    .devices = NULL,
+    .jobs = JOBS_DEFAULT
   };
 
   if (argc <= 1) {
@@ -173,6 +271,49 @@ struct options parse_arguments(int argc, char **argv)
         fprintf(stderr, "error: invalid block size `%s'\n", argv[optind]);
         exit(1);
       }
+      o.tuning_overridden = true;
+      continue;
+    } else if ( (strcmp(argv[optind], "--window") == 0 ) || (strcmp(argv[optind], "-w") == 0) ) {
+      optind++;
+      o.window = strtoul(argv[optind], NULL, 0);
+      if (o.window == 0) {
+        fprintf(stderr, "error: invalid window `%s'\n", argv[optind]);
+        exit(1);
+      }
+      continue;
+    } else if ( (strcmp(argv[optind], "--poll-msec") == 0 ) || (strcmp(argv[optind], "-m") == 0) ) {
+      optind++;
+      char *end;
+      o.poll_msec = strtol(argv[optind], &end, 0);
+      if (end == argv[optind] || o.poll_msec < 0) {
+        fprintf(stderr, "error: invalid poll interval `%s'\n", argv[optind]);
+        exit(1);
+      }
+      o.tuning_overridden = true;
+      continue;
+    } else if ( (strcmp(argv[optind], "--installed-boot") == 0 ) || (strcmp(argv[optind], "-B") == 0) ) {
+      optind++;
+      o.installed_boot = argv[optind];
+      continue;
+    } else if ( (strcmp(argv[optind], "--installed-data") == 0 ) || (strcmp(argv[optind], "-D") == 0) ) {
+      optind++;
+      o.installed_data = argv[optind];
+      continue;
+    } else if ( (strcmp(argv[optind], "--bus-path") == 0 ) || (strcmp(argv[optind], "-l") == 0) ) {
+      optind++;
+      o.device_id.bus_path = argv[optind];
+      continue;
+    } else if ( (strcmp(argv[optind], "--devices") == 0 ) || (strcmp(argv[optind], "-L") == 0) ) {
+      optind++;
+      o.devices = argv[optind];
+      continue;
+    } else if ( (strcmp(argv[optind], "--jobs") == 0 ) || (strcmp(argv[optind], "-j") == 0) ) {
+      optind++;
+      o.jobs = strtoul(argv[optind], NULL, 0);
+      if (o.jobs == 0) {
+        fprintf(stderr, "error: invalid number of jobs `%s'\n", argv[optind]);
+        exit(1);
+      }
       continue;
     } else if ( (strcmp(argv[optind], "--skip-boot-image") == 0 ) || (strcmp(argv[optind], "-s") == 0) ) {
       o.skip_boot_image = true;
@@ -184,6 +325,7 @@ struct options parse_arguments(int argc, char **argv)
       o.operation = parse_operation(argv[optind]);
       switch (o.operation) {
         case WRITE_UPGRADE:
+        case AUTOTUNE:
           if (argc != optind + 3) {
             if (argc < optind + 3)
               fprintf(stderr, "error: not enough command line arguments\n");
@@ -221,6 +363,7 @@ struct options parse_arguments(int argc, char **argv)
           break;
 
         case REBOOT:
+        case LIST_DEVICES:
           if (argc != optind + 1) {
             print_usage(stderr);
             exit(1);
@@ -235,11 +378,17 @@ struct options parse_arguments(int argc, char **argv)
           exit(1);
       }
 
+      if (o.devices != NULL && o.operation != WRITE_UPGRADE) {
+        fprintf(stderr, "error: --devices is only for write_upgrade\n");
+        exit(1);
+      }
+
       if (!quiet) {
         printf("options:\n");
         printf("- operation: ");
         switch (o.operation) {
           case WRITE_UPGRADE:
+          case AUTOTUNE:
             printf("%s %s %s\n", operation_str(o.operation),
                    o.arguments[0], o.arguments[1]);
             break;
@@ -253,6 +402,7 @@ struct options parse_arguments(int argc, char **argv)
             break;
 
           case REBOOT:
+          case LIST_DEVICES:
             printf("%s\n", operation_str(o.operation));
             break;
 
@@ -265,15 +415,29 @@ struct options parse_arguments(int argc, char **argv)
 #if USE_I2C
         printf("- I2C address 0x%02X\n", o.device_id.i2c_address);
 #endif
-        if (o.operation == WRITE_UPGRADE) {
+        if (o.device_id.bus_path != NULL)
+          printf("- bus path %s\n", o.device_id.bus_path);
+        if (o.devices != NULL)
+          printf("- devices %s, %u at a time\n", o.devices, o.jobs);
+        if (o.operation == WRITE_UPGRADE || o.operation == AUTOTUNE) {
           printf("- block size %u\n", o.block_size);
           printf("- block size %d\n", o.block_size);
+          printf("- window %u blocks\n", o.window);
+          if (o.poll_msec != POLL_MSEC_DEVICE) {
+            printf("- poll %d msec\n", o.poll_msec);
+          }
           if (o.skip_boot_image) {
             printf("- skip boot image\n");
           }
           if (o.skip_data_image) {
             printf("- skip data image\n");
           }
+          if (o.installed_boot != NULL) {
+            printf("- installed boot image %s\n", o.installed_boot);
+          }
+          if (o.installed_data != NULL) {
+            printf("- installed data image %s\n", o.installed_data);
+          }
         }
       }
       break;
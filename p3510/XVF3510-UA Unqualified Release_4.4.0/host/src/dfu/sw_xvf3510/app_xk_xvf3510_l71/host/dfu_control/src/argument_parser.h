@@ -7,12 +7,15 @@
 #endif
 #include <stdbool.h>
 #include "device_id.h"
+#include "tuning.h"
+#include "orchestrator.h"
 
 #define PRODUCT_ID_DEFAULT 0x0014
 #define VENDOR_ID_DEFAULT 0x20B1
 #define BCD_DEVICE_DEFAULT 0xFFFF // default 0xFFFF means skip checking
 #define I2C_ADDRESS_DEFAULT 0x2C
 #define BLOCK_SIZE_DEFAULT 128
+#define WINDOW_DEFAULT 1 // blocks sent before polling the status
 
 extern bool quiet;
 
@@ -22,13 +25,22 @@ struct options {
     WRITE_UPGRADE,
     OVERRIDE_SPISPEC,
     DETACH_AND_BUS_RESET,
-    REBOOT
+    REBOOT,
+    AUTOTUNE,
+    LIST_DEVICES
   } operation;
   const char *arguments[2];
   struct device_id device_id;
   unsigned block_size;
+  unsigned window;
+  int poll_msec;
+  bool tuning_overridden; // --block-size or --poll-msec given, the saved tuning is not used
   bool skip_boot_image;
   bool skip_data_image;
+  const char *installed_boot; // files of the installed images for a delta upgrade
+  const char *installed_data;
+  char *devices; // comma separated bus paths or "all", write_upgrade of several devices
+  unsigned jobs;
 };
 
 struct options parse_arguments(int argc, char **argv);
@@ -4,9 +4,15 @@
 
 #include <stdint.h>
 
+#define BUS_PATH_MAX_CHARS 32
+
+// bus_path selects one of several devices with the same IDs: the USB bus and
+// ports ("1-2.3") or the I2C address. NULL is the first USB device found or
+// i2c_address.
 struct device_id {
   uint16_t vendor, product, bcddevice;
   uint8_t i2c_address;
+  const char *bus_path;
 };
 
 #endif
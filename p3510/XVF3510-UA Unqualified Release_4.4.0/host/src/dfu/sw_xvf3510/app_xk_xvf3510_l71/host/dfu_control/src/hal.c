@@ -1,8 +1,10 @@
 // Copyright (c) 2020, XMOS Ltd, All rights reserved
 #include <stdio.h>
+#include <stdlib.h>
 #include <stdbool.h>
 #include "control_host.h"
 #include "dfu_commands.h"
+#include "dfu_types.h"
 #include "util.h"
 #include "device_id.h"
 #include "sleep.h"
@@ -15,11 +17,14 @@
 
 extern bool quiet;
 
+static struct device_id connected_id;
+
 #if USE_USB
 static int hal_connect_usb(struct device_id device_id)
 {
   const int usb_interface_number = 3;
-  if (control_init_usb(device_id.vendor, device_id.product, usb_interface_number)
+  if (control_init_usb_path(device_id.vendor, device_id.product,
+                            usb_interface_number, device_id.bus_path)
       != CONTROL_SUCCESS) {
     fprintf(stderr, "Error: Control initialisation over USB failed\n");
     return 1;
@@ -27,6 +32,8 @@ static int hal_connect_usb(struct device_id device_id)
   if (!quiet) {
     printf("USB connected (vendor ID 0x%04X, product ID 0x%04X)\n",
            device_id.vendor, device_id.product);
+    if (device_id.bus_path != NULL)
+      printf("bus path %s\n", device_id.bus_path);
   }
 
   control_version_t version;
@@ -50,6 +57,9 @@ static int hal_connect_usb(struct device_id device_id)
 static int hal_connect_i2c(struct device_id device_id)
 {
   const int shift = 0;
+  if (device_id.bus_path != NULL)
+    device_id.i2c_address = (uint8_t)strtol(device_id.bus_path, NULL, 0);
+  connected_id.i2c_address = device_id.i2c_address;
   if (control_init_i2c(device_id.i2c_address << shift) != CONTROL_SUCCESS) {
     fprintf(stderr, "Error: Control initialisation over I2C failed\n");
     return 1;
@@ -77,6 +87,7 @@ static int hal_connect_i2c(struct device_id device_id)
 
 int hal_connect(struct device_id device_id)
 {
+  connected_id = device_id;
 #if USE_USB
   return hal_connect_usb(device_id);
 #endif
@@ -85,6 +96,29 @@ int hal_connect(struct device_id device_id)
 #endif
 }
 
+int hal_list_devices(struct device_id device_id,
+                     char bus_paths[][BUS_PATH_MAX_CHARS], unsigned max_devices)
+{
+#if USE_USB
+  // BUS_PATH_MAX_CHARS is the same as CONTROL_USB_PATH_MAX_CHARS
+  unsigned num_devices = 0;
+
+  if (control_list_usb(device_id.vendor, device_id.product, bus_paths,
+                       max_devices, &num_devices) != CONTROL_SUCCESS)
+    return -1;
+
+  return (int)num_devices;
+#endif
+#if USE_I2C
+  // the I2C devices cannot be enumerated, only the one at the address is used
+  if (max_devices == 0)
+    return 0;
+
+  snprintf(bus_paths[0], BUS_PATH_MAX_CHARS, "0x%02X", device_id.i2c_address);
+  return 1;
+#endif
+}
+
 int hal_read_command(enum dfu_command command,
                      unsigned char *payload, size_t num_bytes)
 {
@@ -147,3 +181,43 @@ int hal_disconnect(void)
 
   return 0;
 }
+
+const char *hal_transport_name(void)
+{
+#if USE_USB
+  return "usb";
+#endif
+#if USE_I2C
+  return "i2c";
+#endif
+}
+
+int hal_get_board_id(char *board_id, size_t size)
+{
+#if USE_USB
+  // the device was opened by its vendor and product ID, bcdDevice is read
+  char serial[BUS_PATH_MAX_CHARS];
+  unsigned bcd_device;
+  if (control_get_usb_device_id(serial, sizeof(serial), &bcd_device) != CONTROL_SUCCESS) {
+    fprintf(stderr, "error: cannot read the USB device descriptor\n");
+    return 1;
+  }
+  snprintf(board_id, size, "%04X:%04X:%04X", connected_id.vendor,
+           connected_id.product, bcd_device);
+#endif
+#if USE_I2C
+  snprintf(board_id, size, "%02X", connected_id.i2c_address);
+#endif
+  return 0;
+}
+
+unsigned hal_max_block_size(void)
+{
+#if USE_USB
+  const unsigned max_block_size = USB_DATA_MAX_BYTES - sizeof(struct dfu_dnload_header);
+#endif
+#if USE_I2C
+  const unsigned max_block_size = I2C_DATA_MAX_BYTES - sizeof(struct dfu_dnload_header);
+#endif
+  return max_block_size < DFU_BLOCK_SIZE_MAX_BYTES ? max_block_size : DFU_BLOCK_SIZE_MAX_BYTES;
+}
@@ -8,6 +8,11 @@
 
 int hal_connect(struct device_id device_id);
 
+// bus paths of the devices with the vendor and product ID of device_id, at
+// most max_devices. Returns the number of devices, -1 on error.
+int hal_list_devices(struct device_id device_id,
+                     char bus_paths[][BUS_PATH_MAX_CHARS], unsigned max_devices);
+
 int hal_read_command(enum dfu_command command,
                      unsigned char *payload, size_t num_bytes);
 
@@ -18,4 +23,15 @@ int hal_reboot(void);
 
 int hal_disconnect(void);
 
+// name of the transport, the tuning is saved per transport
+const char *hal_transport_name(void);
+
+// identity of the connected board, read from the device, the tuning is saved
+// per board: vendor ID, product ID and bcdDevice of the USB device descriptor,
+// or the I2C address. Returns 0 on success.
+int hal_get_board_id(char *board_id, size_t size);
+
+// largest DFU block the transport can carry in one command
+unsigned hal_max_block_size(void);
+
 #endif
@@ -0,0 +1,571 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+// Simulated DFU device for tests: the DFU state machine of lib_dfu with the
+// timings of a USB or I2C transport and of the flash, without any hardware.
+// DNLOAD only takes the block and moves to dfuDNLOAD_SYNC, the following
+// GETSTATUS writes it to the flash and reports dfuDNBUSY with the poll
+// timeout. Any request before the poll timeout has passed, or a DNLOAD before
+// the GETSTATUS of the previous one, stalls the device into dfuERROR.
+// The installed images are kept in DFU_SIM_FLASH/boot.bin and data.bin if set.
+// DFU_SIM_DEVICES=N simulates N devices at the bus paths sim-0 to sim-N-1,
+// each with its images in DFU_SIM_FLASH/sim-0... DFU_SIM_FAIL=sim-1,... lists
+// the devices which fail to write their flash. DFU_SIM_CORRUPT=N flips the
+// byte at offset N of each downloaded image, as a bad flash write would.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#if defined(_MSC_VER)
+#include <direct.h>
+#define mkdir(path, mode) _mkdir(path)
+#else
+#include <sys/stat.h>
+#endif
+#include "dfu_commands.h"
+#include "dfu_types.h"
+#include "device_id.h"
+#include "crc.h"
+#include "sleep.h"
+#include "labels.h"
+#include "hal.h"
+
+#define SIM_POLL_TIMEOUT_MSEC 2      // reported by GETSTATUS, busy until it has passed
+#define SIM_SECTOR_BYTES 4096
+#define SIM_SECTOR_ERASE_USEC 8000
+#define SIM_PAGE_BYTES 256
+#define SIM_PAGE_PROGRAM_USEC 400
+#define SIM_MANIFEST_USEC 20000
+#define SIM_PARTITION_MAX_BYTES (8 * 1024 * 1024)
+#define SIM_PATH_MAX_CHARS 1024
+#define SIM_BCD_DEVICE 0x0440         // reported by the device descriptor
+
+extern bool quiet;
+
+struct sim_transport {
+  const char *name;
+  unsigned command_usec;   // fixed cost of a command
+  unsigned byte_nsec;      // cost of each payload byte
+  unsigned max_data_bytes;
+};
+
+static const struct sim_transport transports[] = {
+  {"sim-usb", 250, 10, USB_DATA_MAX_BYTES},
+  {"sim-i2c", 150, 22500, I2C_DATA_MAX_BYTES}, // 400 kHz
+};
+
+static const struct sim_transport *transport = NULL;
+static struct device_id connected_id;
+static const char *device_path = NULL; // NULL for the single device
+static bool flash_fails = false;
+static enum dfu_state state = APP_IDLE;
+static enum dfu_status status = DFU_OK;
+static int error_info = 0;
+
+struct sim_image {
+  unsigned char *bytes;
+  size_t length;
+};
+
+static const char *image_names[2] = {"boot.bin", "data.bin"};
+static struct sim_image installed[2]; // boot and data partitions
+
+// download in progress
+static struct sim_image staged;
+static unsigned staged_partition = 0;
+static unsigned next_block = 0;
+static unsigned first_block_bytes = 0;
+static unsigned erased_sectors = 0;
+
+// the blocks of the last DNLOAD or DNLOAD_COPY, or the manifest, left for the
+// GETSTATUS of the dfuDNLOAD_SYNC or dfuMANIFEST_SYNC state
+static bool pending = false;
+static size_t pending_offset = 0;
+static size_t pending_bytes = 0;
+static const unsigned char *pending_src = NULL;
+static unsigned char pending_block[DFU_BLOCK_SIZE_MAX_BYTES];
+static unsigned long long busy_usec = 0; // end of the poll timeout
+
+static const struct sim_transport *get_transport(void)
+{
+  if (transport == NULL) {
+    const char *env = getenv("DFU_SIM_TRANSPORT");
+    transport = &transports[0];
+    if (env != NULL && strcmp(env, "i2c") == 0)
+      transport = &transports[1];
+  }
+  return transport;
+}
+
+// spun rather than slept for accuracy
+static void spin(unsigned long long usec)
+{
+  unsigned long long end = time_microseconds() + usec;
+  while (time_microseconds() < end)
+    ;
+}
+
+// the transfer time of a command
+static void transport_delay(size_t num_bytes)
+{
+  const struct sim_transport *t = get_transport();
+  spin(t->command_usec + (num_bytes * t->byte_nsec) / 1000);
+}
+
+static unsigned num_devices(void)
+{
+  const char *env = getenv("DFU_SIM_DEVICES");
+  int n = env != NULL ? atoi(env) : 1;
+  return n > 0 ? (unsigned)n : 1;
+}
+
+// whether path is in the comma separated list
+static bool in_list(const char *list, const char *path)
+{
+  size_t length = strlen(path);
+  for (const char *p = list; p != NULL && *p != '\0'; ) {
+    const char *end = strchr(p, ',');
+    size_t n = end != NULL ? (size_t)(end - p) : strlen(p);
+    if (n == length && strncmp(p, path, n) == 0)
+      return true;
+    p = end != NULL ? end + 1 : NULL;
+  }
+  return false;
+}
+
+static void image_path(unsigned partition, char *path, size_t size)
+{
+  const char *dir = getenv("DFU_SIM_FLASH");
+  if (dir == NULL)
+    path[0] = '\0';
+  else if (device_path == NULL)
+    snprintf(path, size, "%s/%s", dir, image_names[partition]);
+  else
+    snprintf(path, size, "%s/%s/%s", dir, device_path, image_names[partition]);
+}
+
+static void load_installed(void)
+{
+  char path[SIM_PATH_MAX_CHARS];
+
+  for (unsigned p = 0; p < 2; p++) {
+    installed[p].bytes = malloc(SIM_PARTITION_MAX_BYTES);
+    installed[p].length = 0;
+    image_path(p, path, sizeof(path));
+    FILE *handle = path[0] != '\0' ? fopen(path, "rb") : NULL;
+    if (handle != NULL) {
+      installed[p].length = fread(installed[p].bytes, 1, SIM_PARTITION_MAX_BYTES, handle);
+      fclose(handle);
+    }
+  }
+}
+
+static void install_staged(void)
+{
+  char path[SIM_PATH_MAX_CHARS];
+  struct sim_image *image = &installed[staged_partition];
+
+  memcpy(image->bytes, staged.bytes, staged.length);
+  image->length = staged.length;
+
+  image_path(staged_partition, path, sizeof(path));
+  FILE *handle = path[0] != '\0' ? fopen(path, "wb") : NULL;
+  if (handle != NULL) {
+    fwrite(image->bytes, 1, image->length, handle);
+    fclose(handle);
+  }
+}
+
+static unsigned image_crc(const struct sim_image *image)
+{
+  return crc_finish(crc_update(crc_init(), image->bytes, image->length));
+}
+
+// the first error is kept until CLRSTATUS
+static void set_error(enum dfu_status error, int info)
+{
+  if (state == DFU_ERROR)
+    return;
+
+  state = DFU_ERROR;
+  status = error;
+  error_info = info;
+}
+
+// the device stays busy for the poll timeout it reported
+static void update_state(void)
+{
+  if (state != DFU_DNBUSY && state != DFU_MANIFEST)
+    return;
+
+  if (time_microseconds() < busy_usec) {
+    set_error(ERR_STALLED_PKT, state);
+    return;
+  }
+
+  state = state == DFU_DNBUSY ? DFU_DNLOAD_SYNC : DFU_MANIFEST_SYNC;
+}
+
+// take num_bytes from block_num of the staged image, in blocks of block_bytes
+// with the last one shorter, to be written by the next GETSTATUS
+static void take_blocks(unsigned block_num, unsigned partition,
+                        unsigned block_bytes, const unsigned char *src,
+                        size_t num_bytes)
+{
+  if (state != DFU_IDLE && state != DFU_DNLOAD_IDLE) {
+    set_error(ERR_STALLED_PKT, state);
+    return;
+  }
+
+  if (state == DFU_IDLE) {
+    if (block_num != 0) {
+      set_error(ERR_ADDRESS, block_num);
+      return;
+    }
+    staged.length = 0;
+    staged_partition = partition;
+    next_block = 0;
+    first_block_bytes = block_bytes;
+    erased_sectors = 0;
+  }
+
+  if (partition != staged_partition) {
+    set_error(ERR_TARGET, 2);
+    return;
+  }
+
+  // an image starts at block 0 and the blocks follow in order, a block sent
+  // again or out of order is refused
+  size_t offset = (size_t)block_num * first_block_bytes;
+  if (block_num != next_block || block_bytes != first_block_bytes ||
+      offset + num_bytes > SIM_PARTITION_MAX_BYTES) {
+    set_error(ERR_ADDRESS, block_num);
+    return;
+  }
+
+  next_block = block_num + (unsigned)((num_bytes + block_bytes - 1) / block_bytes);
+  pending = true;
+  pending_offset = offset;
+  pending_bytes = num_bytes;
+  pending_src = src;
+  state = DFU_DNLOAD_SYNC;
+}
+
+// the flash work of GETSTATUS, then busy for the poll timeout
+static void write_pending(void)
+{
+  unsigned long long cost = ((pending_bytes + SIM_PAGE_BYTES - 1) / SIM_PAGE_BYTES) *
+                            SIM_PAGE_PROGRAM_USEC;
+  while ((pending_offset + pending_bytes + SIM_SECTOR_BYTES - 1) / SIM_SECTOR_BYTES > erased_sectors) {
+    cost += SIM_SECTOR_ERASE_USEC;
+    erased_sectors++;
+  }
+  spin(cost);
+  pending = false;
+
+  if (flash_fails) {
+    set_error(ERR_WRITE, (int)(pending_offset / first_block_bytes));
+    return;
+  }
+
+  if (staged.bytes == NULL)
+    staged.bytes = malloc(SIM_PARTITION_MAX_BYTES);
+  memmove(staged.bytes + pending_offset, pending_src, pending_bytes);
+  if (pending_offset + pending_bytes > staged.length)
+    staged.length = pending_offset + pending_bytes;
+
+  const char *corrupt = getenv("DFU_SIM_CORRUPT");
+  if (corrupt != NULL) {
+    size_t offset = strtoul(corrupt, NULL, 0);
+    if (offset >= pending_offset && offset < pending_offset + pending_bytes)
+      staged.bytes[offset] ^= 0xFF;
+  }
+
+  state = DFU_DNBUSY;
+  busy_usec = time_microseconds() + SIM_POLL_TIMEOUT_MSEC * 1000;
+}
+
+static void manifest(void)
+{
+  spin(SIM_MANIFEST_USEC);
+  pending = false;
+  install_staged();
+  state = DFU_MANIFEST;
+  busy_usec = time_microseconds() + SIM_POLL_TIMEOUT_MSEC * 1000;
+}
+
+static void getstatus(void)
+{
+  if (state == DFU_DNLOAD_SYNC) {
+    if (pending)
+      write_pending();
+    else
+      state = DFU_DNLOAD_IDLE;
+  } else if (state == DFU_MANIFEST_SYNC) {
+    if (pending)
+      manifest();
+    else
+      state = DFU_IDLE;
+  }
+}
+
+static void dnload(const unsigned char *payload, size_t num_bytes)
+{
+  struct dfu_dnload_header header;
+  memcpy(&header, payload, sizeof(header));
+  unsigned block_num = header.block_num & ~DFU_BLOCK_NUM_DATA_IMAGE_MARKER;
+  unsigned partition = (header.block_num & DFU_BLOCK_NUM_DATA_IMAGE_MARKER) ? 1 : 0;
+  size_t block_bytes = num_bytes - sizeof(header);
+
+  if (block_bytes == 0) {
+    if (state != DFU_DNLOAD_IDLE) {
+      set_error(ERR_NOTDONE, state);
+      return;
+    }
+    pending = true;
+    state = DFU_MANIFEST_SYNC;
+    return;
+  }
+
+  if (block_bytes > sizeof(pending_block)) {
+    set_error(ERR_ADDRESS, block_num);
+    return;
+  }
+  memcpy(pending_block, payload + sizeof(header), block_bytes);
+
+  // only the last block of an image can be shorter than the first
+  if (block_num > 0 && block_bytes < first_block_bytes)
+    take_blocks(block_num, partition, first_block_bytes, pending_block, block_bytes);
+  else
+    take_blocks(block_num, partition, (unsigned)block_bytes, pending_block, block_bytes);
+}
+
+// unchanged blocks of a delta download, copied from the installed image
+static int dnload_copy(const unsigned char *payload, size_t num_bytes)
+{
+  struct dfu_dnload_copy copy;
+  if (num_bytes != sizeof(copy))
+    return 1;
+
+  memcpy(&copy, payload, sizeof(copy));
+  unsigned block_num = copy.block_num & ~DFU_BLOCK_NUM_DATA_IMAGE_MARKER;
+  unsigned partition = (copy.block_num & DFU_BLOCK_NUM_DATA_IMAGE_MARKER) ? 1 : 0;
+  const struct sim_image *image = &installed[partition];
+  size_t offset = (size_t)block_num * copy.block_bytes;
+  size_t copy_bytes = (size_t)copy.num_blocks * copy.block_bytes;
+
+  if (copy.block_bytes == 0 || copy.num_blocks == 0 || offset >= image->length) {
+    set_error(ERR_ADDRESS, block_num);
+    return 0;
+  }
+  if (offset + copy_bytes > image->length)
+    copy_bytes = image->length - offset;
+
+  take_blocks(block_num, partition, copy.block_bytes, image->bytes + offset,
+              copy_bytes);
+  return 0;
+}
+
+int hal_connect(struct device_id device_id)
+{
+  const struct sim_transport *t = get_transport();
+
+  device_path = NULL;
+  if (device_id.bus_path != NULL) {
+    char path[BUS_PATH_MAX_CHARS];
+    unsigned n = num_devices();
+    for (unsigned i = 0; i < n && device_path == NULL; i++) {
+      snprintf(path, sizeof(path), "sim-%u", i);
+      if (strcmp(path, device_id.bus_path) == 0)
+        device_path = device_id.bus_path;
+    }
+    if (device_path == NULL) {
+      fprintf(stderr, "could not find device\n");
+      fprintf(stderr, "Error: Control initialisation over %s failed\n", t->name);
+      return 1;
+    }
+
+    const char *dir = getenv("DFU_SIM_FLASH");
+    if (dir != NULL) {
+      char device_dir[SIM_PATH_MAX_CHARS];
+      snprintf(device_dir, sizeof(device_dir), "%s/%s", dir, device_path);
+      mkdir(device_dir, 0755); // fails harmlessly if it exists
+    }
+  }
+  flash_fails = device_path != NULL && in_list(getenv("DFU_SIM_FAIL"), device_path);
+
+  if (!quiet) {
+    printf("%s connected (vendor ID 0x%04X, product ID 0x%04X, address 0x%X)\n",
+           t->name, device_id.vendor, device_id.product, device_id.i2c_address);
+    if (device_path != NULL)
+      printf("bus path %s\n", device_path);
+  }
+
+  connected_id = device_id;
+  state = APP_IDLE;
+  status = DFU_OK;
+  pending = false;
+  load_installed();
+  return 0;
+}
+
+int hal_list_devices(struct device_id device_id,
+                     char bus_paths[][BUS_PATH_MAX_CHARS], unsigned max_devices)
+{
+  unsigned n = num_devices();
+  (void)device_id;
+
+  for (unsigned i = 0; i < n && i < max_devices; i++)
+    snprintf(bus_paths[i], BUS_PATH_MAX_CHARS, "sim-%u", i);
+
+  return (int)(n < max_devices ? n : max_devices);
+}
+
+int hal_read_command(enum dfu_command command,
+                     unsigned char *payload, size_t num_bytes)
+{
+  if (!quiet) {
+    printf("HAL: read command: %s (%d), %lu bytes\n",
+           command_str(command), command, num_bytes);
+  }
+
+  transport_delay(num_bytes);
+  update_state();
+
+  memset(payload, 0, num_bytes);
+  switch (command) {
+    case DFU_CMD_GETSTATE: {
+      int value = state;
+      memcpy(payload, &value, num_bytes < sizeof(value) ? num_bytes : sizeof(value));
+      break;
+    }
+
+    case DFU_CMD_GETSTATUS: {
+      getstatus();
+      struct dfu_getstatus getstatus = {status, state, SIM_POLL_TIMEOUT_MSEC};
+      memcpy(payload, &getstatus, num_bytes < sizeof(getstatus) ? num_bytes : sizeof(getstatus));
+      break;
+    }
+
+    case DFU_CMD_GET_IMAGE_CRC: {
+      struct dfu_image_crc crcs;
+      crcs.installed_boot = image_crc(&installed[0]);
+      crcs.installed_data = image_crc(&installed[1]);
+      crcs.downloaded = image_crc(&staged);
+      memcpy(payload, &crcs, num_bytes < sizeof(crcs) ? num_bytes : sizeof(crcs));
+      break;
+    }
+
+    case DFU_CMD_GET_ERROR_INFO:
+      memcpy(payload, &error_info, num_bytes < sizeof(error_info) ? num_bytes : sizeof(error_info));
+      break;
+
+    default:
+      fprintf(stderr, "error: control read command did not return success\n");
+      return 1;
+  }
+
+  return 0;
+}
+
+int hal_write_command(enum dfu_command command,
+                      const unsigned char *payload, size_t num_bytes)
+{
+  if (!quiet) {
+    printf("HAL: write command: %s (%d), %lu bytes\n",
+           command_str(command), command, num_bytes);
+  }
+
+  if (num_bytes > get_transport()->max_data_bytes) {
+    fprintf(stderr, "error: control write command did not return success\n");
+    return 1;
+  }
+
+  transport_delay(num_bytes);
+  update_state();
+
+  int ret = 0;
+  switch (command) {
+    case DFU_CMD_DETACH:
+      if (state == APP_IDLE)
+        state = APP_DETACH;
+      break;
+
+    case DFU_CMD_BUS_RESET:
+      if (state == APP_DETACH)
+        state = DFU_IDLE;
+      break;
+
+    case DFU_CMD_DNLOAD:
+      dnload(payload, num_bytes);
+      break;
+
+    case DFU_CMD_DNLOAD_COPY:
+      ret = dnload_copy(payload, num_bytes);
+      break;
+
+    case DFU_CMD_CLRSTATUS:
+      status = DFU_OK;
+      error_info = 0;
+      state = DFU_IDLE;
+      pending = false;
+      break;
+
+    case DFU_CMD_REBOOT:
+      state = APP_IDLE;
+      break;
+
+    case DFU_CMD_OVERRIDE_SPISPEC:
+      break;
+
+    default:
+      ret = 1;
+      break;
+  }
+
+  if (ret != 0)
+    fprintf(stderr, "error: control write command did not return success\n");
+
+  return ret;
+}
+
+int hal_reboot(void)
+{
+  if (!quiet)
+    printf("HAL: reboot\n");
+
+  if (hal_write_command(DFU_CMD_REBOOT, NULL, 0) != 0)
+    return 1;
+
+  return 0;
+}
+
+int hal_disconnect(void)
+{
+  free(staged.bytes);
+  free(installed[0].bytes);
+  free(installed[1].bytes);
+  memset(&staged, 0, sizeof(staged));
+  memset(installed, 0, sizeof(installed));
+  return 0;
+}
+
+const char *hal_transport_name(void)
+{
+  return get_transport()->name;
+}
+
+int hal_get_board_id(char *board_id, size_t size)
+{
+  if (get_transport() == &transports[0])
+    snprintf(board_id, size, "%04X:%04X:%04X", connected_id.vendor,
+             connected_id.product, SIM_BCD_DEVICE);
+  else
+    snprintf(board_id, size, "%02X", connected_id.i2c_address);
+  return 0;
+}
+
+unsigned hal_max_block_size(void)
+{
+  const unsigned max_block_size = get_transport()->max_data_bytes -
+                                  sizeof(struct dfu_dnload_header);
+  return max_block_size < DFU_BLOCK_SIZE_MAX_BYTES ? max_block_size : DFU_BLOCK_SIZE_MAX_BYTES;
+}
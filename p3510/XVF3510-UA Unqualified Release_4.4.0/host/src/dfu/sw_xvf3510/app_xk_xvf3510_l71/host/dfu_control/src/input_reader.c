@@ -5,84 +5,138 @@
 #include <stdbool.h>
 #include <memory.h>
 #include <errno.h>
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
 #include "suffix_verifier.h"
+#include "crc.h"
 #include "device_id.h"
 #include "input_reader.h"
 
 extern bool quiet;
 
-static size_t file_size(FILE *handle, const char *name)
+// the file is mapped rather than read so that nothing is read before the
+// download needs it and the memory use does not grow with the image size
+static size_t map_file(const char *name, const unsigned char **bytes)
 {
-  if (handle == NULL)
-    return 0;
-
-  if (fseek(handle, 0, SEEK_END) != 0) {
-    fprintf(stderr, "fseek failed on %s (errno %d)\n", name, errno);
+#if defined(_WIN32)
+  HANDLE file = CreateFileA(name, GENERIC_READ, FILE_SHARE_READ, NULL,
+                            OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+  if (file == INVALID_HANDLE_VALUE) {
+    fprintf(stderr, "problem opening file %s\n", name);
     exit(1);
   }
 
-  long length = ftell(handle);
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size)) {
+    fprintf(stderr, "problem reading file %s (error %lu)\n", name, GetLastError());
+    exit(1);
+  }
+  size_t length = (size_t)size.QuadPart;
+
+  if (length > 0) {
+    HANDLE mapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (mapping == NULL) {
+      fprintf(stderr, "problem mapping file %s (error %lu)\n", name, GetLastError());
+      exit(1);
+    }
+    *bytes = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping); // the view keeps the mapping
+    if (*bytes == NULL) {
+      fprintf(stderr, "problem mapping file %s (error %lu)\n", name, GetLastError());
+      exit(1);
+    }
+  }
+  CloseHandle(file);
+#else
+  int fd = open(name, O_RDONLY);
+  if (fd < 0) {
+    fprintf(stderr, "problem opening file %s\n", name);
+    exit(1);
+  }
 
-  if (fseek(handle, 0, SEEK_SET) != 0) {
-    fprintf(stderr, "fseek failed on %s (errno %d)\n", name, errno);
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    fprintf(stderr, "problem reading file %s (errno %d)\n", name, errno);
     exit(1);
   }
+  size_t length = (size_t)st.st_size;
+
+  if (length > 0) {
+    void *map = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+      fprintf(stderr, "problem mapping file %s (errno %d)\n", name, errno);
+      exit(1);
+    }
+    madvise(map, length, MADV_SEQUENTIAL);
+    *bytes = map;
+  }
+  close(fd); // the mapping keeps the file
+#endif
 
-  return (size_t)length;
+  return length;
 }
 
-static size_t verify_suffix(const unsigned char *bytes, size_t num_bytes,
-                            struct device_id device_id)
+static void unmap_file(const unsigned char *bytes, size_t length)
 {
-  size_t suffix_length = 0;
-  char msg[256];
-  int ret;
-
-  ret = verify_dfu_suffix(bytes, num_bytes, device_id.vendor, device_id.product,
-                          device_id.bcddevice, &suffix_length, msg);
-  if (ret != 0) {
-    fprintf(stderr, "failed DFU suffix verification (code %d): %s\n", ret, msg);
-    exit(1);
-  }
-
-  return num_bytes - suffix_length;
+#if defined(_WIN32)
+  (void)length;
+  UnmapViewOfFile(bytes);
+#else
+  munmap((void *)bytes, length);
+#endif
 }
 
-static size_t load_file(const char *file_name, unsigned char **bytes)
+static void load_file(const char *file_name, struct input_file *input)
 {
   if (file_name == NULL)
-    return 0;
+    return;
 
-  FILE *handle = fopen(file_name, "rb");
-  size_t length = file_size(handle, file_name);
+  input->mapped_length = map_file(file_name, &input->bytes);
+  input->length = input->mapped_length;
 
-  if (handle == NULL) {
-    fprintf(stderr, "problem opening file %s\n", file_name);
-    exit(1);
-  }
-  *bytes = malloc(length + 1);
-  if (fread(*bytes, 1, length, handle) != length) {
-    fprintf(stderr, "problem reading file %s (errno %d)\n", file_name, errno);
+  if (!quiet)
+    printf("opened %s, %lu bytes\n", file_name, input->length);
+}
+
+// the checksum is verified by verify_checksum, or for an installed file by the
+// device, see download_delta
+static void verify_suffix(struct input_file *input, struct device_id device_id)
+{
+  size_t suffix_length = 0;
+  char msg[256];
+  int ret;
+
+  ret = verify_dfu_suffix_fields(input->bytes, input->length, device_id.vendor,
+                                 device_id.product, device_id.bcddevice,
+                                 &suffix_length, &input->crc, msg);
+  if (ret != 0) {
+    fprintf(stderr, "failed DFU suffix verification (code %d): %s\n", ret, msg);
     exit(1);
   }
 
-  fclose(handle);
+  input->length -= suffix_length;
 
   if (!quiet)
-    printf("opened %s, %lu bytes\n", file_name, length);
-
-  return length;
+    printf("no problem found with suffix fields, checksum 0x%08X\n", input->crc);
 }
 
-static size_t call_verify_suffix(const unsigned char *bytes, size_t length,
-                                 struct device_id device_id)
+// one pass over the mapped image before the device is detached, so that a
+// corrupt file stops the upgrade before any image is manifested
+static void verify_checksum(const struct input_file *input)
 {
-  size_t stripped_length = verify_suffix(bytes, length, device_id);
-
-  if (!quiet)
-    printf("no problem found with suffix\n");
-
-  return stripped_length;
+  unsigned computed_crc = crc_finish(crc_update(crc_init(), input->bytes,
+                                                input->length));
+  if (computed_crc != input->crc) {
+    fprintf(stderr, "failed DFU suffix verification: checksum mismatch: suffix 0x%08X computed 0x%08X\n",
+            input->crc, computed_crc);
+    exit(1);
+  }
 }
 
 struct inputs read_write_upgrade_inputs(const char *boot_file_name,
@@ -91,10 +145,27 @@ struct inputs read_write_upgrade_inputs(const char *boot_file_name,
 {
   struct inputs inputs;
   memset(&inputs, 0, sizeof(struct inputs));
-  inputs.boot.length = load_file(boot_file_name, &inputs.boot.bytes);
-  inputs.data.length = load_file(data_file_name, &inputs.data.bytes);
-  inputs.boot.length = call_verify_suffix(inputs.boot.bytes, inputs.boot.length, device_id);
-  inputs.data.length = call_verify_suffix(inputs.data.bytes, inputs.data.length, device_id);
+  load_file(boot_file_name, &inputs.boot);
+  load_file(data_file_name, &inputs.data);
+  verify_suffix(&inputs.boot, device_id);
+  verify_suffix(&inputs.data, device_id);
+  verify_checksum(&inputs.boot);
+  verify_checksum(&inputs.data);
+  return inputs;
+}
+
+struct inputs read_installed_inputs(const char *boot_file_name,
+                                    const char *data_file_name,
+                                    struct device_id device_id)
+{
+  struct inputs inputs;
+  memset(&inputs, 0, sizeof(struct inputs));
+  load_file(boot_file_name, &inputs.boot);
+  load_file(data_file_name, &inputs.data);
+  if (boot_file_name != NULL)
+    verify_suffix(&inputs.boot, device_id);
+  if (data_file_name != NULL)
+    verify_suffix(&inputs.data, device_id);
   return inputs;
 }
 
@@ -102,25 +173,21 @@ struct inputs read_override_spispec_input(const char *spispec_file_name)
 {
   struct inputs inputs;
   memset(&inputs, 0, sizeof(struct inputs));
-  inputs.spispec.length = load_file(spispec_file_name, &inputs.spispec.bytes);
+  load_file(spispec_file_name, &inputs.spispec);
   return inputs;
 }
 
+static void cleanup_input(struct input_file *input)
+{
+  if (input->bytes != NULL)
+    unmap_file(input->bytes, input->mapped_length);
+
+  memset(input, 0, sizeof(struct input_file));
+}
+
 void cleanup_inputs(struct inputs *inputs)
 {
-  if (inputs->boot.bytes != NULL) {
-    free(inputs->boot.bytes);
-    inputs->boot.bytes = NULL;
-  }
-  if (inputs->data.bytes != NULL) {
-    free(inputs->data.bytes);
-    inputs->data.bytes = NULL;
-  }
-  if (inputs->spispec.bytes != NULL) {
-    free(inputs->spispec.bytes);
-    inputs->spispec.bytes = NULL;
-  }
-  inputs->boot.length = 0;
-  inputs->data.length = 0;
-  inputs->spispec.length = 0;
+  cleanup_input(&inputs->boot);
+  cleanup_input(&inputs->data);
+  cleanup_input(&inputs->spispec);
 }
@@ -5,17 +5,30 @@
 #include <stddef.h>
 #include "device_id.h"
 
+// an input file mapped in memory, length excludes the DFU suffix. The suffix
+// fields and checksum of an upgrade image are verified when the file is
+// opened, and the checksum again as the image is downloaded.
+struct input_file {
+  const unsigned char *bytes;
+  size_t length;
+  size_t mapped_length;
+  unsigned crc; // from the DFU suffix
+};
+
 struct inputs {
-  struct {
-    unsigned char *bytes;
-    size_t length;
-  } boot, data, spispec;
+  struct input_file boot, data, spispec;
 };
 
 struct inputs read_write_upgrade_inputs(const char *boot_file_name,
                                         const char *data_file_name,
                                         struct device_id device_id);
 
+// the files of the images installed on the device, for a delta upgrade,
+// either name can be NULL
+struct inputs read_installed_inputs(const char *boot_file_name,
+                                    const char *data_file_name,
+                                    struct device_id device_id);
+
 struct inputs read_override_spispec_input(const char *spispec_file_name);
 
 void cleanup_inputs(struct inputs *inputs);
@@ -15,6 +15,8 @@ const char *command_str(enum dfu_command command)
     case DFU_CMD_REBOOT:            return "REBOOT";
     case DFU_CMD_GET_ERROR_INFO:    return "GET_ERROR_INFO";
     case DFU_CMD_OVERRIDE_SPISPEC:  return "OVERRIDE_SPISPEC";
+    case DFU_CMD_DNLOAD_COPY:       return "DNLOAD_COPY";
+    case DFU_CMD_GET_IMAGE_CRC:     return "GET_IMAGE_CRC";
     default: return "?";
   }
 }
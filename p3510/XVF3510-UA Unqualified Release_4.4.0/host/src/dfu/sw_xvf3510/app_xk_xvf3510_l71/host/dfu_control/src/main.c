@@ -1,12 +1,79 @@
 // Copyright (c) 2016-2020, XMOS Ltd, All rights reserved
 #include <stddef.h>
 #include <stdio.h>
+#include <stdbool.h>
 #include <assert.h>
 #include "argument_parser.h"
 #include "input_reader.h"
 #include "device_id.h"
 #include "operations.h"
 #include "hal.h"
+#include "vfctrl_cache.h"
+#include "tuning.h"
+#include "orchestrator.h"
+
+// the inputs of write_upgrade, read once for all the devices
+struct upgrade {
+  const struct options *options;
+  struct inputs inputs;
+  struct inputs installed;
+  struct dfu_tuning tuning;
+};
+
+// block number is 16 bits with top bit reserved for boot/data marker
+// so maximum block count is 32,768
+static int check_image_sizes(const struct upgrade *upgrade, unsigned block_size)
+{
+  const struct options *options = upgrade->options;
+  const size_t fifteen_bits_max = 32768;
+  const size_t max_dnload_size = fifteen_bits_max * block_size;
+
+  if (!options->skip_boot_image && upgrade->inputs.boot.length > max_dnload_size) {
+    fprintf(stderr, "boot image size %lu exceeds maximum %lu\n",
+                    upgrade->inputs.boot.length, max_dnload_size);
+    return 1;
+  }
+
+  if (!options->skip_data_image && upgrade->inputs.data.length > max_dnload_size) {
+    fprintf(stderr, "data image size %lu exceeds maximum %lu\n",
+                    upgrade->inputs.data.length, max_dnload_size);
+    return 1;
+  }
+
+  return 0;
+}
+
+static int upgrade_device(struct device_id device_id, void *context)
+{
+  const struct upgrade *upgrade = (const struct upgrade *)context;
+  const struct options *options = upgrade->options;
+  bool delta = options->installed_boot != NULL || options->installed_data != NULL;
+  struct dfu_tuning tuning = upgrade->tuning;
+
+  if (hal_connect(device_id) != 0) // will do a check that suffix IDs
+    return 1;                      // match the running target
+
+  // the tuning is saved per board, it is read once connected
+  if (!options->tuning_overridden && load_tuning(&tuning) == 0 && !quiet) {
+    printf("tuned block size %u, poll %d msec\n",
+           tuning.block_size, tuning.poll_msec);
+  }
+
+  int ret = check_image_sizes(upgrade, tuning.block_size);
+  if (ret == 0) {
+    ret = write_upgrade(upgrade->inputs, delta ? &upgrade->installed : NULL,
+                        tuning, options->skip_boot_image,
+                        options->skip_data_image);
+  }
+
+  if (ret == 0) {
+    remove_vfctrl_cache();
+    hal_reboot();
+  }
+
+  hal_disconnect();
+  return ret;
+}
 
 int main(int argc, char **argv)
 {
@@ -15,35 +82,58 @@ int main(int argc, char **argv)
 
   switch (options.operation) {
     case WRITE_UPGRADE: {
+      struct upgrade upgrade;
+      upgrade.options = &options;
+      upgrade.inputs = read_write_upgrade_inputs(options.arguments[0],
+                                                 options.arguments[1],
+                                                 options.device_id);
+      upgrade.tuning.block_size = options.block_size;
+      upgrade.tuning.window = options.window;
+      upgrade.tuning.poll_msec = options.poll_msec;
+
+      upgrade.installed = read_installed_inputs(options.installed_boot,
+                                                options.installed_data,
+                                                options.device_id);
+
+      if (options.devices != NULL) {
+        char buffer[MAX_DEVICES][BUS_PATH_MAX_CHARS];
+        const char *bus_paths[MAX_DEVICES];
+        int num_devices = get_bus_paths(options.device_id, options.devices,
+                                        buffer, bus_paths);
+        if (num_devices <= 0) {
+          if (num_devices == 0)
+            fprintf(stderr, "error: no devices found\n");
+          ret = 1;
+        } else {
+          ret = update_devices(options.device_id, bus_paths, num_devices,
+                               options.jobs, upgrade_device, &upgrade);
+        }
+      } else {
+        ret = upgrade_device(options.device_id, &upgrade);
+      }
+
+      cleanup_inputs(&upgrade.installed);
+      cleanup_inputs(&upgrade.inputs);
+      break;
+    }
+
+    case AUTOTUNE: {
       struct inputs inputs = read_write_upgrade_inputs(options.arguments[0],
                                                        options.arguments[1],
                                                        options.device_id);
+      struct dfu_tuning tuning = {options.block_size, options.window,
+                                  options.poll_msec};
 
-      // block number is 16 bits with top bit reserved for boot/data marker
-      // so maximum block count is 32,768
-      const size_t fifteen_bits_max = 32768;
-      const size_t max_dnload_size = fifteen_bits_max * options.block_size;
-
-      if (!options.skip_boot_image && inputs.boot.length > max_dnload_size) {
-        fprintf(stderr, "boot image size %lu exceeds maximum %lu\n",
-                        inputs.boot.length, max_dnload_size);
-        return 1;
-      }
-
-      if (!options.skip_data_image && inputs.data.length > max_dnload_size) {
-        fprintf(stderr, "data image size %lu exceeds maximum %lu\n",
-                        inputs.data.length, max_dnload_size);
+      if (hal_connect(options.device_id) != 0)
         return 1;
-      }
-
-      if (hal_connect(options.device_id) != 0) // will do a check that suffix IDs
-        return 1;                              // match the running target
 
-      ret = write_upgrade(inputs, options.block_size,
-                          options.skip_boot_image, options.skip_data_image);
+      ret = autotune(inputs, &tuning, options.skip_boot_image);
 
-      if (ret == 0)
+      if (ret == 0) {
+        save_tuning(&tuning);
+        remove_vfctrl_cache();
         hal_reboot();
+      }
 
       hal_disconnect();
       cleanup_inputs(&inputs);
@@ -83,6 +173,17 @@ int main(int argc, char **argv)
       break;
     }
 
+    case LIST_DEVICES: {
+      char bus_paths[MAX_DEVICES][BUS_PATH_MAX_CHARS];
+      int num_devices = hal_list_devices(options.device_id, bus_paths, MAX_DEVICES);
+      if (num_devices < 0)
+        return 1;
+
+      for (int i = 0; i < num_devices; i++)
+        printf("%s\n", bus_paths[i]);
+      break;
+    }
+
     default:
       assert(0);
       break;
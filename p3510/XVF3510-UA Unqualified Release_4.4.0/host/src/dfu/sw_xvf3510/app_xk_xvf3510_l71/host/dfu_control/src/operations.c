@@ -26,6 +26,7 @@
 #endif
 
 #include "dfu_commands.h"
+#include "crc.h"
 #include "labels.h"
 #include "sleep.h"
 #include "hal.h"
@@ -34,6 +35,21 @@
 
 extern bool quiet;
 
+static progress_handler progress = NULL;
+
+void set_progress_handler(progress_handler handler)
+{
+  progress = handler;
+}
+
+// num_bytes of the image accepted by the device
+static void report_progress(unsigned short marker, size_t num_bytes, size_t length)
+{
+  if (progress != NULL)
+    progress(marker == DFU_BLOCK_NUM_DATA_IMAGE_MARKER ? "data" : "boot",
+             num_bytes, length);
+}
+
 static int check_state(enum dfu_state expected)
 {
   enum dfu_state state;
@@ -161,21 +177,62 @@ static int dnload_block(const unsigned char *block, int num_block_bytes,
   return 0;
 }
 
-static int download_file(const unsigned char *bytes, size_t length,
-                         unsigned block_size, unsigned short marker)
+// sleep the poll timeout reported by the device, or the tuned interval
+static void poll_sleep(const struct dfu_getstatus *getstatus,
+                       const struct dfu_tuning *tuning)
 {
-  size_t byte_count = 0;
-  unsigned block_count = 0;
-  struct dfu_getstatus getstatus;
+  if (tuning->poll_msec == POLL_MSEC_DEVICE)
+    sleep_milliseconds(getstatus->poll_timeout_msec);
+  else if (tuning->poll_msec > 0)
+    sleep_milliseconds(tuning->poll_msec);
+}
 
-  if (!quiet) {
-    printf("start download of %d bytes, block size %d, marker 0x%X\n",
-           (int)length, block_size, marker); // size_t different in xCORE unit test
+// poll the status, sleeping only while the device reports the busy state
+static int wait_while_busy(enum dfu_state busy_state,
+                           struct dfu_getstatus *getstatus,
+                           const struct dfu_tuning *tuning)
+{
+  for (;;) {
+    if (check_status(getstatus) != 0)
+      return 1;
+
+    if (getstatus->state != busy_state)
+      return 0;
+
+    poll_sleep(getstatus, tuning);
   }
+}
+
+// checksum of the image as it is sent, restarted with the download
+struct download_crc {
+  unsigned crc;
+  size_t num_bytes;
+};
+
+static void crc_block(struct download_crc *crc, size_t byte_count,
+                      const unsigned char *block, size_t block_bytes)
+{
+  if (byte_count != crc->num_bytes)
+    return;
+
+  crc->crc = crc_update(crc->crc, block, block_bytes);
+  crc->num_bytes += block_bytes;
+}
+
+// one block at a time, with the status and state handshake after each block
+static int download_blocks(const struct input_file *image,
+                           size_t byte_count, unsigned block_count,
+                           unsigned short marker,
+                           const struct dfu_tuning *tuning,
+                           struct download_crc *crc)
+{
+  const unsigned char *bytes = image->bytes;
+  size_t length = image->length;
+  struct dfu_getstatus getstatus;
 
   while (byte_count < length) {
-    size_t block_bytes = block_size;
-    if (length - byte_count < block_size)
+    size_t block_bytes = tuning->block_size;
+    if (length - byte_count < tuning->block_size)
       block_bytes = length - byte_count;
 
     if (!quiet) {
@@ -186,11 +243,13 @@ static int download_file(const unsigned char *bytes, size_t length,
     if (dnload_block(bytes + byte_count, block_bytes, block_count, marker) != 0)
       return 1;
 
+    crc_block(crc, byte_count, bytes + byte_count, block_bytes);
+
     do {
       if (check_status(&getstatus) != 0)
         return 2;
 
-      sleep_milliseconds(getstatus.poll_timeout_msec);
+      poll_sleep(&getstatus, tuning);
     } while (getstatus.state == DFU_DNBUSY);
 
     if (check_state(DFU_DNLOAD_IDLE) != 0)
@@ -198,6 +257,96 @@ static int download_file(const unsigned char *bytes, size_t length,
 
     block_count++;
     byte_count += block_bytes;
+    report_progress(marker, byte_count, length);
+  }
+
+  return 0;
+}
+
+// up to window blocks back to back, the status is polled at the end of each
+// window only. This needs firmware which queues the DNLOAD blocks, lib_dfu
+// writes the flash in GETSTATUS and fails the second DNLOAD. If a block is refused or the device is not idle at the end of
+// a window, the device is brought back to dfuIDLE and the download restarts
+// from block 0 one block at a time, with window set to 1 for the rest of the
+// upgrade. The device only accepts the blocks in order, so no block of the
+// failed window is sent again on its own.
+static int download_windows(const struct input_file *image,
+                            unsigned short marker, struct dfu_tuning *tuning,
+                            struct download_crc *crc)
+{
+  const unsigned char *bytes = image->bytes;
+  size_t length = image->length;
+  size_t byte_count = 0;
+  unsigned block_count = 0;
+  struct dfu_getstatus getstatus;
+
+  while (byte_count < length) {
+    unsigned window_block_count = block_count;
+    bool failed = false;
+
+    for (unsigned i = 0; i < tuning->window && byte_count < length; i++) {
+      size_t block_bytes = tuning->block_size;
+      if (length - byte_count < tuning->block_size)
+        block_bytes = length - byte_count;
+
+      if (!quiet) {
+        printf("download block %u, %d bytes, window %u/%u\n",
+               block_count, (int)block_bytes, i + 1, tuning->window);
+      }
+
+      if (dnload_block(bytes + byte_count, block_bytes, block_count, marker) != 0) {
+        failed = true;
+        break;
+      }
+
+      crc_block(crc, byte_count, bytes + byte_count, block_bytes);
+      block_count++;
+      byte_count += block_bytes;
+    }
+
+    if (!failed && wait_while_busy(DFU_DNBUSY, &getstatus, tuning) == 0 &&
+        getstatus.state == DFU_DNLOAD_IDLE) {
+      report_progress(marker, byte_count, length);
+      continue;
+    }
+
+    fprintf(stderr, "window from block %u failed, restarting from block 0 one block at a time\n",
+            window_block_count);
+    tuning->window = 1;
+
+    // let the device finish the blocks it accepted, an error status is
+    // cleared by check_status
+    while (check_status(&getstatus) == 0 && getstatus.state == DFU_DNBUSY)
+      poll_sleep(&getstatus, tuning);
+
+    // back to dfuIDLE, where the device starts a new image at block 0
+    if (hal_write_command(DFU_CMD_CLRSTATUS, NULL, 0) != 0 ||
+        check_state(DFU_IDLE) != 0)
+      return 1;
+
+    crc->crc = crc_init();
+    crc->num_bytes = 0;
+    return download_blocks(image, 0, 0, marker, tuning, crc);
+  }
+
+  return 0;
+}
+
+// the image is only installed by the manifest, which is not started if the
+// file does not match its suffix
+static int finish_download(const struct input_file *image,
+                           const struct download_crc *crc,
+                           unsigned short marker,
+                           const struct dfu_tuning *tuning)
+{
+  struct dfu_getstatus getstatus;
+
+  unsigned computed_crc = crc_finish(crc->crc);
+  if (crc->num_bytes != image->length || computed_crc != image->crc) {
+    fprintf(stderr, "failed DFU suffix verification: checksum mismatch: suffix 0x%08X computed 0x%08X\n",
+            image->crc, computed_crc);
+    fprintf(stderr, "download aborted before manifest\n");
+    return 7;
   }
 
   if (dnload_block(NULL, 0, 0, marker) != 0)
@@ -207,7 +356,7 @@ static int download_file(const unsigned char *bytes, size_t length,
     if (check_status(&getstatus) != 0)
       return 5;
 
-    sleep_milliseconds(getstatus.poll_timeout_msec);
+    poll_sleep(&getstatus, tuning);
   } while (getstatus.state == DFU_MANIFEST);
 
   if (check_state(DFU_IDLE) != 0)
@@ -216,31 +365,308 @@ static int download_file(const unsigned char *bytes, size_t length,
   return 0;
 }
 
-int write_upgrade(struct inputs inputs, unsigned block_size,
-                  bool skip_boot_image, bool skip_data_image)
+static int download_file(const struct input_file *image,
+                         unsigned short marker, struct dfu_tuning *tuning)
 {
+  struct download_crc crc = {crc_init(), 0};
+
   if (!quiet) {
-    printf("write upgrade %d boot bytes and %d data bytes\n",
-           (int)inputs.boot.length, (int)inputs.data.length);
+    printf("start download of %d bytes, block size %d, marker 0x%X, window %u\n",
+           (int)image->length, tuning->block_size, marker, tuning->window); // size_t different in xCORE unit test
   }
 
-  if (detach_and_bus_reset() != 0)
+  if (tuning->window > 1) {
+    if (download_windows(image, marker, tuning, &crc) != 0)
+      return 1;
+  } else {
+    if (download_blocks(image, 0, 0, marker, tuning, &crc) != 0)
+      return 1;
+  }
+
+  return finish_download(image, &crc, marker, tuning);
+}
+
+static int read_image_crc(struct dfu_image_crc *image_crc)
+{
+  if (hal_read_command(DFU_CMD_GET_IMAGE_CRC, (unsigned char*)image_crc,
+                       sizeof(struct dfu_image_crc)) != 0) {
     return 1;
+  }
 
+  // convert from hard little endian order after deserialisation
+  image_crc->installed_boot = le32toh(image_crc->installed_boot);
+  image_crc->installed_data = le32toh(image_crc->installed_data);
+  image_crc->downloaded = le32toh(image_crc->downloaded);
+  return 0;
+}
+
+static bool same_block(const struct input_file *image,
+                       const struct input_file *installed,
+                       size_t byte_count, size_t block_bytes)
+{
+  return byte_count + block_bytes <= installed->length &&
+         memcmp(image->bytes + byte_count, installed->bytes + byte_count,
+                block_bytes) == 0;
+}
+
+// only the blocks which differ from the installed image are sent, the device
+// copies the others from its installed image. The device must report the
+// checksum of the installed file before and of the new file after, otherwise
+// the whole image is downloaded or the download is aborted before manifest.
+static int download_delta(const struct input_file *image,
+                          const struct input_file *installed,
+                          unsigned short marker, struct dfu_tuning *tuning)
+{
+  struct dfu_image_crc image_crc;
+  struct dfu_getstatus getstatus;
+  struct download_crc crc = {crc_init(), 0};
+  size_t byte_count = 0;
+  unsigned block_count = 0;
+  unsigned num_sent = 0;
+  unsigned num_copied = 0;
+
+  if (read_image_crc(&image_crc) != 0) {
+    fprintf(stderr, "device does not support delta updates, downloading the whole image\n");
+    return download_file(image, marker, tuning);
+  }
+
+  unsigned installed_crc = marker == DFU_BLOCK_NUM_DATA_IMAGE_MARKER ?
+                           image_crc.installed_data : image_crc.installed_boot;
+  if (installed_crc != installed->crc) {
+    fprintf(stderr, "installed image checksum 0x%08X is not the one of the installed file 0x%08X,\n"
+                    "downloading the whole image\n", installed_crc, installed->crc);
+    return download_file(image, marker, tuning);
+  }
+
+  if (!quiet) {
+    printf("start delta download of %d bytes, block size %d, marker 0x%X\n",
+           (int)image->length, tuning->block_size, marker);
+  }
+
+  while (byte_count < image->length) {
+    size_t block_bytes = tuning->block_size;
+    if (image->length - byte_count < tuning->block_size)
+      block_bytes = image->length - byte_count;
+
+    if (block_bytes == tuning->block_size &&
+        same_block(image, installed, byte_count, block_bytes)) {
+      // a run of unchanged blocks in one command, full blocks only so that a
+      // short last block of the image is always sent
+      struct dfu_dnload_copy copy;
+      unsigned num_blocks = 0;
+      while (byte_count < image->length && num_blocks < 0xFFFF) {
+        block_bytes = tuning->block_size;
+        if (image->length - byte_count < tuning->block_size)
+          block_bytes = image->length - byte_count;
+
+        if (block_bytes != tuning->block_size ||
+            !same_block(image, installed, byte_count, block_bytes))
+          break;
+
+        crc_block(&crc, byte_count, image->bytes + byte_count, block_bytes);
+        byte_count += block_bytes;
+        num_blocks++;
+      }
+
+      // note hard little endian order for serialisation
+      copy.block_num = htole16(marker | block_count);
+      copy.num_blocks = htole16(num_blocks);
+      copy.block_bytes = htole16(tuning->block_size);
+      copy.pad = 0;
+
+      if (!quiet)
+        printf("copy blocks %u to %u\n", block_count, block_count + num_blocks - 1);
+
+      if (hal_write_command(DFU_CMD_DNLOAD_COPY, (unsigned char*)&copy,
+                            sizeof(copy)) != 0)
+        return 1;
+
+      block_count += num_blocks;
+      num_copied += num_blocks;
+    } else {
+      if (!quiet) {
+        printf("download block %u, %d bytes\n",
+               block_count, (int)block_bytes); // size_t different in xCORE unit test
+      }
+
+      if (dnload_block(image->bytes + byte_count, block_bytes, block_count, marker) != 0)
+        return 1;
+
+      crc_block(&crc, byte_count, image->bytes + byte_count, block_bytes);
+      byte_count += block_bytes;
+      block_count++;
+      num_sent++;
+    }
+
+    if (wait_while_busy(DFU_DNBUSY, &getstatus, tuning) != 0)
+      return 2;
+
+    if (getstatus.state != DFU_DNLOAD_IDLE && check_state(DFU_DNLOAD_IDLE) != 0)
+      return 3;
+
+    report_progress(marker, byte_count, image->length);
+  }
+
+  if (!quiet) {
+    printf("delta: %u blocks sent, %u blocks copied from the installed image\n",
+           num_sent, num_copied);
+  }
+
+  if (read_image_crc(&image_crc) != 0)
+    return 8;
+
+  if (image_crc.downloaded != image->crc) {
+    fprintf(stderr, "downloaded image checksum 0x%08X does not match the file 0x%08X\n",
+            image_crc.downloaded, image->crc);
+    fprintf(stderr, "download aborted before manifest\n");
+    return 9;
+  }
+
+  return finish_download(image, &crc, marker, tuning);
+}
+
+// installed is NULL or has the files of the installed images, the partitions
+// with an installed file are updated with a delta download
+static int download_upgrade(struct inputs inputs, const struct inputs *installed,
+                            struct dfu_tuning tuning,
+                            bool skip_boot_image, bool skip_data_image)
+{
   // data first so a failed cycle doesn't leave a good boot
   // that way device only needs to fall back on bad data but not on bad boot
   if (!skip_data_image) {
-    if (download_file(inputs.data.bytes, inputs.data.length,
-                      block_size, DFU_BLOCK_NUM_DATA_IMAGE_MARKER) != 0)
+    if (installed != NULL && installed->data.bytes != NULL) {
+      if (download_delta(&inputs.data, &installed->data,
+                         DFU_BLOCK_NUM_DATA_IMAGE_MARKER, &tuning) != 0)
+        return 2;
+    } else if (download_file(&inputs.data, DFU_BLOCK_NUM_DATA_IMAGE_MARKER,
+                             &tuning) != 0) {
       return 2;
+    }
   }
 
   if (!skip_boot_image) {
-    if (download_file(inputs.boot.bytes, inputs.boot.length,
-                      block_size, 0) != 0)
+    if (installed != NULL && installed->boot.bytes != NULL) {
+      if (download_delta(&inputs.boot, &installed->boot, 0, &tuning) != 0)
+        return 3;
+    } else if (download_file(&inputs.boot, 0, &tuning) != 0) {
       return 3;
+    }
+  }
+
+  return 0;
+}
+
+int write_upgrade(struct inputs inputs, const struct inputs *installed,
+                  struct dfu_tuning tuning,
+                  bool skip_boot_image, bool skip_data_image)
+{
+  if (!quiet) {
+    printf("write upgrade %d boot bytes and %d data bytes\n",
+           (int)inputs.boot.length, (int)inputs.data.length);
   }
 
+  if (detach_and_bus_reset() != 0)
+    return 1;
+
+  int ret = download_upgrade(inputs, installed, tuning,
+                             skip_boot_image, skip_data_image);
+  if (ret != 0)
+    return ret;
+
+  if (!quiet)
+    printf("write upgrade successful\n");
+
+  return 0;
+}
+
+// time one download of the data image, the data partition is the sacrificial
+// region as the upgrade rewrites it anyway. Returns 0 on success.
+static int probe_tuning(struct inputs inputs, struct dfu_tuning tuning,
+                        double *seconds)
+{
+  unsigned long long start = time_microseconds();
+
+  if (download_file(&inputs.data, DFU_BLOCK_NUM_DATA_IMAGE_MARKER,
+                    &tuning) != 0)
+    return 1;
+
+  *seconds = (time_microseconds() - start) / 1e6;
+  return 0;
+}
+
+int autotune(struct inputs inputs, struct dfu_tuning *tuning,
+             bool skip_boot_image)
+{
+  static const unsigned block_sizes[] = {32, 64, 128, 256, 512};
+  static const int poll_msecs[] = {0, 1, 2, 5};
+  const size_t fifteen_bits_max = 32768;
+  double best_seconds = 0;
+
+  printf("autotune on %d data bytes over %s\n",
+         (int)inputs.data.length, hal_transport_name());
+
+  if (detach_and_bus_reset() != 0)
+    return 1;
+
+  // block size first with the poll timeout of the device, then the poll
+  // interval with the fastest block size
+  struct dfu_tuning best = *tuning;
+  best.block_size = 0;
+  for (unsigned i = 0; i < sizeof(block_sizes) / sizeof(block_sizes[0]); i++) {
+    struct dfu_tuning probe = *tuning;
+    double seconds;
+    probe.block_size = block_sizes[i];
+    probe.poll_msec = POLL_MSEC_DEVICE;
+    if (probe.block_size > hal_max_block_size() ||
+        inputs.data.length > fifteen_bits_max * probe.block_size ||
+        (!skip_boot_image && inputs.boot.length > fifteen_bits_max * probe.block_size))
+      continue;
+
+    if (probe_tuning(inputs, probe, &seconds) != 0) {
+      printf("block size %u, device poll timeout: failed\n", probe.block_size);
+      continue;
+    }
+    printf("block size %u, device poll timeout: %.3f s\n", probe.block_size, seconds);
+    if (best.block_size == 0 || seconds < best_seconds) {
+      best = probe;
+      best_seconds = seconds;
+    }
+  }
+
+  if (best.block_size == 0) {
+    fprintf(stderr, "error: no block size could download the data image\n");
+    return 2;
+  }
+
+  for (unsigned i = 0; i < sizeof(poll_msecs) / sizeof(poll_msecs[0]); i++) {
+    struct dfu_tuning probe = best;
+    double seconds;
+    probe.poll_msec = poll_msecs[i];
+
+    if (probe_tuning(inputs, probe, &seconds) != 0) {
+      printf("block size %u, poll %d msec: failed\n", probe.block_size, probe.poll_msec);
+      continue;
+    }
+    printf("block size %u, poll %d msec: %.3f s\n", probe.block_size, probe.poll_msec, seconds);
+    if (seconds < best_seconds) {
+      best = probe;
+      best_seconds = seconds;
+    }
+  }
+
+  if (best.poll_msec == POLL_MSEC_DEVICE)
+    printf("fastest: block size %u, device poll timeout, %.3f s\n", best.block_size, best_seconds);
+  else
+    printf("fastest: block size %u, poll %d msec, %.3f s\n", best.block_size, best.poll_msec, best_seconds);
+
+  *tuning = best;
+
+  // the upgrade itself with the tuned settings, this also rewrites a data
+  // partition left incomplete by a failed probe
+  int ret = download_upgrade(inputs, NULL, best, skip_boot_image, false);
+  if (ret != 0)
+    return ret + 1;
+
   if (!quiet)
     printf("write upgrade successful\n");
 
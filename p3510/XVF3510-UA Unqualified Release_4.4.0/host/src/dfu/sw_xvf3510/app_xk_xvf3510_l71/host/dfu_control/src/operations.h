@@ -2,12 +2,28 @@
 #ifndef __operations_h__
 #define __operations_h__
 
+#include <stddef.h>
 #include <stdbool.h>
 #include "input_reader.h"
+#include "tuning.h"
 
-int write_upgrade(struct inputs inputs, unsigned block_size,
+// called as the blocks of the boot or data image are accepted by the device
+typedef void (*progress_handler)(const char *image, size_t num_bytes, size_t length);
+
+// NULL for no progress reports, the default
+void set_progress_handler(progress_handler handler);
+
+// installed is NULL or has the files of the images installed on the device,
+// these partitions are updated with a delta download
+int write_upgrade(struct inputs inputs, const struct inputs *installed,
+                  struct dfu_tuning tuning,
                   bool skip_boot_image, bool skip_data_image);
 
+// Probe the block sizes and poll intervals on the data image, then write the
+// upgrade with the fastest. tuning is updated with the fastest settings.
+int autotune(struct inputs inputs, struct dfu_tuning *tuning,
+             bool skip_boot_image);
+
 int override_spispec(struct inputs inputs);
 
 int detach_and_bus_reset(void);
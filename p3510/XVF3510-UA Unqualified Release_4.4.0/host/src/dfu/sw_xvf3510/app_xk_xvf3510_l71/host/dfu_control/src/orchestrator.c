@@ -0,0 +1,330 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#if !defined(_WIN32)
+#include <errno.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#endif
+#include "hal.h"
+#include "sleep.h"
+#include "operations.h"
+#include "orchestrator.h"
+
+#define LINE_MAX_CHARS 256
+#define PROGRESS_STEP_PERCENT 10
+
+extern bool quiet;
+
+struct device_result {
+  int status; // exit status of the update, 0 on success
+  double seconds;
+};
+
+// progress of the update in this process, printed every PROGRESS_STEP_PERCENT
+static const char *progress_prefix = "";
+static char progress_image[8];
+static unsigned progress_percent = 0;
+
+static void print_progress(const char *image, size_t num_bytes, size_t length)
+{
+  unsigned percent = length > 0 ? (unsigned)(num_bytes * 100 / length) : 100;
+  percent -= percent % PROGRESS_STEP_PERCENT;
+
+  if (strcmp(image, progress_image) == 0 && percent == progress_percent)
+    return;
+
+  snprintf(progress_image, sizeof(progress_image), "%s", image);
+  progress_percent = percent;
+  printf("%s%s image %u%%\n", progress_prefix, image, percent);
+  fflush(stdout);
+}
+
+static void reset_progress(const char *prefix)
+{
+  progress_prefix = prefix;
+  progress_image[0] = '\0';
+  progress_percent = 0;
+}
+
+int get_bus_paths(struct device_id device_id, char *list,
+                  char buffer[][BUS_PATH_MAX_CHARS], const char **bus_paths)
+{
+  int num_devices = 0;
+
+  if (strcmp(list, "all") == 0) {
+    num_devices = hal_list_devices(device_id, buffer, MAX_DEVICES);
+    for (int i = 0; i < num_devices; i++)
+      bus_paths[i] = buffer[i];
+    return num_devices;
+  }
+
+  for (char *path = strtok(list, ","); path != NULL; path = strtok(NULL, ",")) {
+    if (num_devices == MAX_DEVICES) {
+      fprintf(stderr, "error: more than %d devices\n", MAX_DEVICES);
+      return -1;
+    }
+    // two processes would update the same device at the same time
+    for (int i = 0; i < num_devices; i++) {
+      if (strcmp(bus_paths[i], path) == 0) {
+        fprintf(stderr, "error: device %s is listed twice\n", path);
+        return -1;
+      }
+    }
+    bus_paths[num_devices++] = path;
+  }
+
+  return num_devices;
+}
+
+static int path_width(const char *const *bus_paths, unsigned num_devices)
+{
+  size_t width = 0;
+  for (unsigned i = 0; i < num_devices; i++) {
+    if (strlen(bus_paths[i]) > width)
+      width = strlen(bus_paths[i]);
+  }
+  return (int)width;
+}
+
+static int print_results(const char *const *bus_paths, unsigned num_devices,
+                         const struct device_result *results)
+{
+  int width = path_width(bus_paths, num_devices);
+  int num_failed = 0;
+
+  for (unsigned i = 0; i < num_devices; i++) {
+    if (results[i].status != 0)
+      num_failed++;
+  }
+
+  printf("%d of %u devices updated\n", (int)num_devices - num_failed, num_devices);
+  for (unsigned i = 0; i < num_devices; i++) {
+    if (results[i].status == 0)
+      printf("%-*s  ok      %.1f s\n", width, bus_paths[i], results[i].seconds);
+    else
+      printf("%-*s  failed  %.1f s, status %d\n", width, bus_paths[i],
+             results[i].seconds, results[i].status);
+  }
+
+  return num_failed;
+}
+
+#if !defined(_WIN32)
+
+// an update running in a child process, its stdout and stderr are a pipe
+struct job {
+  pid_t pid;
+  int fd;
+  unsigned device;
+  unsigned long long start_usec;
+  char line[LINE_MAX_CHARS];
+  size_t line_length;
+};
+
+static void print_line(const char *bus_path, int width, const char *line)
+{
+  printf("%-*s  %s\n", width, bus_path, line);
+  fflush(stdout);
+}
+
+static int start_job(struct job *job, struct device_id device_id,
+                     const char *bus_path, update_function update, void *context)
+{
+  int fds[2];
+
+  if (pipe(fds) != 0) {
+    fprintf(stderr, "cannot start the update of %s\n", bus_path);
+    return 1;
+  }
+
+  // nothing buffered is written twice
+  fflush(stdout);
+  fflush(stderr);
+
+  pid_t pid = fork();
+  if (pid < 0) {
+    close(fds[0]);
+    close(fds[1]);
+    fprintf(stderr, "cannot start the update of %s\n", bus_path);
+    return 1;
+  }
+
+  if (pid == 0) {
+    close(fds[0]);
+    dup2(fds[1], STDOUT_FILENO);
+    dup2(fds[1], STDERR_FILENO);
+    close(fds[1]);
+
+    if (!quiet) {
+      reset_progress(""); // the parent prefixes the lines
+      set_progress_handler(print_progress);
+    }
+    quiet = true;
+
+    device_id.bus_path = bus_path;
+    int ret = update(device_id, context);
+
+    fflush(stdout);
+    _exit(ret >= 0 && ret < 126 ? ret : 1);
+  }
+
+  close(fds[1]);
+  job->pid = pid;
+  job->fd = fds[0];
+  job->start_usec = time_microseconds();
+  job->line_length = 0;
+  return 0;
+}
+
+// prints the complete lines from the job, returns false at the end of its output
+static bool read_output(struct job *job, const char *bus_path, int width)
+{
+  char bytes[LINE_MAX_CHARS];
+  ssize_t n = read(job->fd, bytes, sizeof(bytes));
+
+  if (n < 0 && errno == EINTR)
+    return true;
+
+  if (n <= 0) {
+    if (job->line_length > 0) {
+      job->line[job->line_length] = '\0';
+      print_line(bus_path, width, job->line);
+    }
+    return false;
+  }
+
+  for (ssize_t i = 0; i < n; i++) {
+    if (bytes[i] == '\n' || job->line_length == sizeof(job->line) - 1) {
+      job->line[job->line_length] = '\0';
+      print_line(bus_path, width, job->line);
+      job->line_length = 0;
+      if (bytes[i] == '\n')
+        continue;
+    }
+    job->line[job->line_length++] = bytes[i];
+  }
+
+  return true;
+}
+
+static void finish_job(const struct job *job, struct device_result *result)
+{
+  int status = 0;
+
+  while (waitpid(job->pid, &status, 0) < 0 && errno == EINTR)
+    ;
+
+  result->seconds = (time_microseconds() - job->start_usec) / 1000000.0;
+  if (WIFEXITED(status))
+    result->status = WEXITSTATUS(status);
+  else
+    result->status = 128 + WTERMSIG(status); // as the shells report a signal
+}
+
+int update_devices(struct device_id device_id,
+                   const char *const *bus_paths, unsigned num_devices,
+                   unsigned jobs, update_function update, void *context)
+{
+  struct device_result results[MAX_DEVICES];
+  struct job running[MAX_DEVICES];
+  struct pollfd fds[MAX_DEVICES];
+  unsigned num_running = 0;
+  unsigned next = 0;
+  int width = path_width(bus_paths, num_devices);
+
+  if (num_devices > MAX_DEVICES)
+    num_devices = MAX_DEVICES;
+  if (jobs == 0)
+    jobs = 1;
+
+  while (next < num_devices || num_running > 0) {
+    while (num_running < jobs && next < num_devices) {
+      struct job *job = &running[num_running];
+      job->device = next;
+      results[next].seconds = 0;
+      if (start_job(job, device_id, bus_paths[next], update, context) != 0) {
+        results[next].status = 1;
+      } else {
+        if (!quiet)
+          print_line(bus_paths[next], width, "started");
+        num_running++;
+      }
+      next++;
+    }
+
+    if (num_running == 0)
+      continue;
+
+    for (unsigned i = 0; i < num_running; i++) {
+      fds[i].fd = running[i].fd;
+      fds[i].events = POLLIN;
+      fds[i].revents = 0;
+    }
+
+    if (poll(fds, num_running, -1) < 0) {
+      if (errno == EINTR)
+        continue;
+      fprintf(stderr, "error: cannot read the output of the updates\n");
+      return (int)num_devices;
+    }
+
+    // backwards, a finished job is replaced by the last one
+    for (unsigned i = num_running; i-- > 0; ) {
+      struct job *job = &running[i];
+      if (fds[i].revents == 0 || read_output(job, bus_paths[job->device], width))
+        continue;
+
+      close(job->fd);
+      struct device_result *result = &results[job->device];
+      finish_job(job, result);
+      print_line(bus_paths[job->device], width, result->status == 0 ? "done" : "failed");
+      running[i] = running[--num_running];
+    }
+  }
+
+  return print_results(bus_paths, num_devices, results);
+}
+
+#else
+
+int update_devices(struct device_id device_id,
+                   const char *const *bus_paths, unsigned num_devices,
+                   unsigned jobs, update_function update, void *context)
+{
+  struct device_result results[MAX_DEVICES];
+  int width = path_width(bus_paths, num_devices);
+  bool was_quiet = quiet;
+
+  (void)jobs;
+  if (num_devices > MAX_DEVICES)
+    num_devices = MAX_DEVICES;
+
+  for (unsigned i = 0; i < num_devices; i++) {
+    char prefix[BUS_PATH_MAX_CHARS + LINE_MAX_CHARS];
+    snprintf(prefix, sizeof(prefix), "%-*s  ", width, bus_paths[i]);
+    if (!was_quiet) {
+      printf("%sstarted\n", prefix);
+      reset_progress(prefix);
+      set_progress_handler(print_progress);
+    }
+    quiet = true;
+
+    unsigned long long start_usec = time_microseconds();
+    device_id.bus_path = bus_paths[i];
+    results[i].status = update(device_id, context);
+    results[i].seconds = (time_microseconds() - start_usec) / 1000000.0;
+
+    quiet = was_quiet;
+    set_progress_handler(NULL);
+    printf("%s%s\n", prefix, results[i].status == 0 ? "done" : "failed");
+  }
+
+  return print_results(bus_paths, num_devices, results);
+}
+
+#endif
@@ -0,0 +1,27 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#ifndef __orchestrator_h__
+#define __orchestrator_h__
+
+#include "device_id.h"
+
+#define MAX_DEVICES 64
+#define JOBS_DEFAULT 4 // devices updated at the same time
+
+// updates the device at device_id.bus_path, returns 0 on success
+typedef int (*update_function)(struct device_id device_id, void *context);
+
+// Split a comma separated list of bus paths, or list the connected devices if
+// it is "all". Returns the number of devices, -1 on error, a path listed twice
+// is an error. The paths point to list or to buffer.
+int get_bus_paths(struct device_id device_id, char *list,
+                  char buffer[][BUS_PATH_MAX_CHARS], const char **bus_paths);
+
+// Update the devices at the bus paths, at most jobs at a time. Each update
+// runs in its own process, its output is printed prefixed with the bus path
+// of the device. Windows has no fork, the devices are updated one at a time.
+// Prints the result of each device and returns the number which failed.
+int update_devices(struct device_id device_id,
+                   const char *const *bus_paths, unsigned num_devices,
+                   unsigned jobs, update_function update, void *context);
+
+#endif
@@ -3,9 +3,11 @@
 #if defined(_MSC_VER)
 #include <Winsock2.h>
 #pragma comment(lib, "ws2_32.lib")
+#include <windows.h>
 #else
 #include <unistd.h>
 #include <arpa/inet.h>
+#include <time.h>
 #endif
 
 void sleep_milliseconds(unsigned milliseconds)
@@ -16,3 +18,21 @@ void sleep_milliseconds(unsigned milliseconds)
   usleep(milliseconds * 1000);
 #endif
 }
+
+unsigned long long time_microseconds(void)
+{
+#if defined(_MSC_VER)
+  LARGE_INTEGER frequency, count;
+  QueryPerformanceFrequency(&frequency);
+  QueryPerformanceCounter(&count);
+  // seconds and remainder apart, the counter frequency need not be a multiple
+  // of 1 MHz and count * 1000000 would overflow
+  unsigned long long seconds = count.QuadPart / frequency.QuadPart;
+  unsigned long long remainder = count.QuadPart % frequency.QuadPart;
+  return seconds * 1000000 + remainder * 1000000 / frequency.QuadPart;
+#else
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (unsigned long long)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+#endif
+}
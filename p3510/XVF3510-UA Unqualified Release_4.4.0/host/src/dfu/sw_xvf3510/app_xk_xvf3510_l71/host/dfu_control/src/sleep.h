@@ -4,4 +4,7 @@
 
 void sleep_milliseconds(unsigned milliseconds);
 
+// monotonic time, for the measurements of the transfers
+unsigned long long time_microseconds(void);
+
 #endif
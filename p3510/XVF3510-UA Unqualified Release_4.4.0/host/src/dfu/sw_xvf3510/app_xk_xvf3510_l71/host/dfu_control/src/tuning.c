@@ -0,0 +1,133 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#if defined(_MSC_VER)
+#include <direct.h>
+#define mkdir(path, mode) _mkdir(path)
+#else
+#include <sys/stat.h>
+#endif
+#include "hal.h"
+#include "vfctrl_cache.h"
+#include "tuning.h"
+
+#define PATH_MAX_CHARS 1024
+#define LINE_MAX_CHARS 256
+#define KEY_MAX_CHARS 64
+
+extern bool quiet;
+
+// one line per transport and board: transport board_id block_size poll_msec,
+// the board ID is vendor:product:bcdDevice over USB and the address over I2C
+static int make_key(char *key, size_t size)
+{
+  char board_id[KEY_MAX_CHARS / 2];
+
+  if (hal_get_board_id(board_id, sizeof(board_id)) != 0)
+    return 1;
+
+  snprintf(key, size, "%s %s", hal_transport_name(), board_id);
+  return 0;
+}
+
+static int get_tuning_path(char *path, size_t size)
+{
+  char dir[PATH_MAX_CHARS];
+
+  if (get_cache_dir(dir, sizeof(dir)) != 0)
+    return 1;
+
+  snprintf(path, size, "%s/%s", dir, TUNING_FILE_NAME);
+  return 0;
+}
+
+int load_tuning(struct dfu_tuning *tuning)
+{
+  char path[PATH_MAX_CHARS + sizeof(TUNING_FILE_NAME)];
+  char key[KEY_MAX_CHARS];
+  char line[LINE_MAX_CHARS];
+  int ret = 1;
+
+  if (get_tuning_path(path, sizeof(path)) != 0)
+    return 1;
+
+  if (make_key(key, sizeof(key)) != 0)
+    return 1;
+
+  FILE *handle = fopen(path, "r");
+  if (handle == NULL)
+    return 1;
+
+  size_t key_length = strlen(key);
+  while (fgets(line, sizeof(line), handle) != NULL) {
+    unsigned block_size;
+    int poll_msec;
+    if (strncmp(line, key, key_length) == 0 && line[key_length] == ' ' &&
+        sscanf(line + key_length, "%u %d", &block_size, &poll_msec) == 2 &&
+        block_size > 0 && block_size <= hal_max_block_size()) {
+      tuning->block_size = block_size;
+      tuning->poll_msec = poll_msec;
+      ret = 0;
+    }
+  }
+
+  fclose(handle);
+  return ret;
+}
+
+int save_tuning(const struct dfu_tuning *tuning)
+{
+  char dir[PATH_MAX_CHARS];
+  char path[PATH_MAX_CHARS + sizeof(TUNING_FILE_NAME)];
+  char tmp_path[sizeof(path) + 4];
+  char key[KEY_MAX_CHARS];
+  char line[LINE_MAX_CHARS];
+
+  if (get_cache_dir(dir, sizeof(dir)) != 0 || make_key(key, sizeof(key)) != 0)
+    return 1;
+
+#if !defined(_WIN32)
+  const char *home = getenv("HOME");
+  if (getenv("VFCTRL_CACHE_DIR") == NULL && getenv("XDG_CACHE_HOME") == NULL &&
+      home != NULL) {
+    char parent[PATH_MAX_CHARS];
+    snprintf(parent, sizeof(parent), "%s/.cache", home);
+    mkdir(parent, 0755);
+  }
+#endif
+  mkdir(dir, 0755); // fails harmlessly if it exists
+
+  snprintf(path, sizeof(path), "%s/%s", dir, TUNING_FILE_NAME);
+  snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+  size_t key_length = strlen(key);
+
+  // rewrite the file with the other transports and boards unchanged
+  FILE *out = fopen(tmp_path, "w");
+  if (out == NULL) {
+    fprintf(stderr, "cannot write %s\n", tmp_path);
+    return 2;
+  }
+  FILE *in = fopen(path, "r");
+  if (in != NULL) {
+    while (fgets(line, sizeof(line), in) != NULL) {
+      if (strncmp(line, key, key_length) != 0 || line[key_length] != ' ')
+        fputs(line, out);
+    }
+    fclose(in);
+  }
+  fprintf(out, "%s %u %d\n", key, tuning->block_size, tuning->poll_msec);
+  fclose(out);
+
+  remove(path);
+  if (rename(tmp_path, path) != 0) {
+    fprintf(stderr, "cannot write %s\n", path);
+    return 3;
+  }
+
+  if (!quiet)
+    printf("saved tuning to %s\n", path);
+
+  return 0;
+}
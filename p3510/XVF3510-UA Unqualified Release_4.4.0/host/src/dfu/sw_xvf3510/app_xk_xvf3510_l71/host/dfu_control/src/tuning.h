@@ -0,0 +1,24 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#ifndef __tuning_h__
+#define __tuning_h__
+
+#define TUNING_FILE_NAME "dfu_tuning.txt"
+#define POLL_MSEC_DEVICE (-1) // sleep the poll timeout reported by the device
+
+// transfer settings of a download, the fastest block size and poll interval
+// found by the autotune operation are saved per transport and board. The board
+// is identified by what the connected device reports, so both need a
+// connection.
+struct dfu_tuning {
+  unsigned block_size;
+  unsigned window;
+  int poll_msec;
+};
+
+// Returns 0 and updates block_size and poll_msec if settings were saved for
+// the transport and board of the connected device
+int load_tuning(struct dfu_tuning *tuning);
+
+int save_tuning(const struct dfu_tuning *tuning);
+
+#endif
@@ -0,0 +1,44 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#include <stdio.h>
+#include <stdlib.h>
+#include "vfctrl_cache.h"
+
+#define PATH_MAX_CHARS 1024
+
+int get_cache_dir(char *dir, size_t size)
+{
+  const char *env = getenv("VFCTRL_CACHE_DIR");
+
+  if (env != NULL) {
+    snprintf(dir, size, "%s", env);
+  }
+#if defined(_WIN32)
+  else if ((env = getenv("LOCALAPPDATA")) != NULL) {
+    snprintf(dir, size, "%s\\%s", env, VFCTRL_CACHE_DIR_NAME);
+  }
+#else
+  else if ((env = getenv("XDG_CACHE_HOME")) != NULL) {
+    snprintf(dir, size, "%s/%s", env, VFCTRL_CACHE_DIR_NAME);
+  }
+  else if ((env = getenv("HOME")) != NULL) {
+    snprintf(dir, size, "%s/.cache/%s", env, VFCTRL_CACHE_DIR_NAME);
+  }
+#endif
+  else {
+    return 1;
+  }
+
+  return 0;
+}
+
+void remove_vfctrl_cache(void)
+{
+  char dir[PATH_MAX_CHARS];
+  char path[PATH_MAX_CHARS];
+
+  if (get_cache_dir(dir, sizeof(dir)) != 0)
+    return;
+
+  snprintf(path, sizeof(path), "%s/%s", dir, VFCTRL_ATTR_CACHE_FILE_NAME);
+  remove(path); // fails harmlessly if there is no cache
+}
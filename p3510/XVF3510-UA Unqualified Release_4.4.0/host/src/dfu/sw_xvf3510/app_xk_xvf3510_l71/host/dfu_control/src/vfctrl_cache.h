@@ -0,0 +1,18 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#ifndef __vfctrl_cache_h__
+#define __vfctrl_cache_h__
+
+#include <stddef.h>
+
+// vfctrl keeps the version, build and USB attributes of the devices in a cache file,
+// see attr_cache.h in dsp_control. The location must match the one used there.
+#define VFCTRL_CACHE_DIR_NAME        "xmos"
+#define VFCTRL_ATTR_CACHE_FILE_NAME  "vfctrl_attr_cache.txt"
+
+// Directory of the vfctrl cache, shared with the DFU tuning file. Returns 0 on success.
+int get_cache_dir(char *dir, size_t size);
+
+// Remove the vfctrl attribute cache, the cached values are stale after an upgrade
+void remove_vfctrl_cache(void);
+
+#endif
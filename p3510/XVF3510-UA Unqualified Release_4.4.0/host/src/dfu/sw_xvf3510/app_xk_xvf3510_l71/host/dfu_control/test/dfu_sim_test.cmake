@@ -0,0 +1,181 @@
+# Copyright (c) 2020, XMOS Ltd, All rights reserved
+# One test of dfu_sim, run with cmake -P and these variables:
+#   DFU_SIM     the dfu_sim tool
+#   SUFFIX_GEN  the dfu_suffix_generator tool
+#   WORK_DIR    directory of the test, emptied first
+#   CASE        write_upgrade, autotune, delta, delta_stale, delta_corrupt or
+#               devices
+# The images are made of seeded random bytes, given a DFU suffix, and the
+# simulated flash files are compared with them after the operation.
+
+set(VENDOR_ID 0x20B1)
+set(PRODUCT_ID 0x0014)
+
+file(REMOVE_RECURSE ${WORK_DIR})
+file(MAKE_DIRECTORY ${WORK_DIR}/flash ${WORK_DIR}/cache)
+
+# name.bin with the bytes and name.dfu, the same with a suffix
+function(write_image name bytes)
+  file(WRITE ${WORK_DIR}/${name}.bin "${bytes}")
+  execute_process(COMMAND ${SUFFIX_GEN} ${VENDOR_ID} ${PRODUCT_ID}
+                          ${WORK_DIR}/${name}.bin ${WORK_DIR}/${name}.dfu
+                  RESULT_VARIABLE result OUTPUT_QUIET)
+  if (NOT result EQUAL 0)
+    message(FATAL_ERROR "${SUFFIX_GEN} failed on ${name}.bin")
+  endif()
+endfunction()
+
+# an image of length random bytes
+function(make_image name length seed)
+  string(RANDOM LENGTH ${length} RANDOM_SEED ${seed} bytes)
+  write_image(${name} "${bytes}")
+endfunction()
+
+# an image which is the image from with the byte at offset changed
+function(change_image name from offset)
+  file(READ ${WORK_DIR}/${from}.bin bytes)
+  string(SUBSTRING "${bytes}" 0 ${offset} head)
+  math(EXPR offset "${offset} + 1")
+  string(SUBSTRING "${bytes}" ${offset} -1 tail)
+  write_image(${name} "${head}#${tail}")
+endfunction()
+
+# run dfu_sim with the arguments, on the simulated flash of the test, and
+# check its exit status. Its output is in sim_output. sim_env has more
+# variables of its environment.
+function(run_sim expected_result)
+  execute_process(COMMAND ${CMAKE_COMMAND} -E env
+                          DFU_SIM_FLASH=${WORK_DIR}/flash
+                          VFCTRL_CACHE_DIR=${WORK_DIR}/cache
+                          ${sim_env}
+                          ${DFU_SIM} ${ARGN}
+                  WORKING_DIRECTORY ${WORK_DIR}
+                  RESULT_VARIABLE result
+                  OUTPUT_VARIABLE output ERROR_VARIABLE output)
+  if (NOT result EQUAL expected_result)
+    message(FATAL_ERROR "dfu_sim ${ARGN} exited with ${result}, expected ${expected_result}:\n${output}")
+  endif()
+  set(sim_output "${output}" PARENT_SCOPE)
+endfunction()
+
+# the flash file of a partition is the image
+function(check_flash flash_file image)
+  execute_process(COMMAND ${CMAKE_COMMAND} -E compare_files
+                          ${WORK_DIR}/flash/${flash_file} ${WORK_DIR}/${image}.bin
+                  RESULT_VARIABLE result)
+  if (NOT result EQUAL 0)
+    message(FATAL_ERROR "flash ${flash_file} is not ${image}.bin")
+  endif()
+endfunction()
+
+# the output matches the regular expression, given in parts which are joined
+function(check_output)
+  string(CONCAT regex ${ARGV})
+  if (NOT sim_output MATCHES "${regex}")
+    message(FATAL_ERROR "dfu_sim output does not match \"${regex}\":\n${sim_output}")
+  endif()
+endfunction()
+
+make_image(boot 3000 1)
+make_image(data 9000 2)
+
+if (CASE STREQUAL "write_upgrade")
+  # with the default one block at a time, then with a window which lib_dfu
+  # refuses, so the download restarts one block at a time
+  run_sim(0 --quiet write_upgrade boot.dfu data.dfu)
+  check_flash(boot.bin boot)
+  check_flash(data.bin data)
+
+  make_image(boot2 2000 3)
+  make_image(data2 12000 4)
+  run_sim(0 --quiet --window 4 write_upgrade boot2.dfu data2.dfu)
+  check_output("window from block 0 failed, restarting from block 0 one block at a time")
+  check_flash(boot.bin boot2)
+  check_flash(data.bin data2)
+
+elseif (CASE STREQUAL "autotune")
+  # polls faster than the poll timeout of the device stall it, the tuning is
+  # saved for the board and used by the next upgrade
+  run_sim(0 --quiet autotune boot.dfu data.dfu)
+  check_output("block size 512, poll 0 msec: failed")
+  check_output("fastest: block size [0-9]+, ")
+  check_flash(boot.bin boot)
+  check_flash(data.bin data)
+  file(READ ${WORK_DIR}/cache/dfu_tuning.txt tuning)
+  string(REPLACE "0x" "" board_id "${VENDOR_ID}:${PRODUCT_ID}")
+  if (NOT tuning MATCHES "^sim-usb ${board_id}:[0-9A-F]+ [0-9]+ [0-9-]+\n$")
+    message(FATAL_ERROR "unexpected dfu_tuning.txt:\n${tuning}")
+  endif()
+
+  make_image(boot2 2000 3)
+  make_image(data2 12000 4)
+  run_sim(0 write_upgrade boot2.dfu data2.dfu)
+  check_output("tuned block size [0-9]+, poll [0-9-]+ msec")
+  check_flash(boot.bin boot2)
+  check_flash(data.bin data2)
+
+elseif (CASE STREQUAL "delta")
+  # the installed files match the flash, only the changed block and the short
+  # last block of each image are sent in blocks of 128 bytes, data first
+  run_sim(0 --quiet write_upgrade boot.dfu data.dfu)
+  change_image(boot2 boot 100)
+  change_image(data2 data 5000)
+  run_sim(0 --block-size 128 --installed-boot boot.dfu --installed-data data.dfu
+          write_upgrade boot2.dfu data2.dfu)
+  check_output("delta: 2 blocks sent, 69 blocks copied from the installed image\n.*"
+               "delta: 2 blocks sent, 22 blocks copied from the installed image\n")
+  check_flash(boot.bin boot2)
+  check_flash(data.bin data2)
+
+elseif (CASE STREQUAL "delta_stale")
+  # the installed file is not the one on the flash, the whole image is sent
+  run_sim(0 --quiet write_upgrade boot.dfu data.dfu)
+  make_image(stale 9000 5)
+  change_image(data2 data 5000)
+  run_sim(0 --quiet --installed-data stale.dfu write_upgrade boot.dfu data2.dfu)
+  check_output("installed image checksum 0x[0-9A-F]+ is not the one of the installed file 0x[0-9A-F]+,\n"
+               "downloading the whole image")
+  check_flash(boot.bin boot)
+  check_flash(data.bin data2)
+
+elseif (CASE STREQUAL "delta_corrupt")
+  # a byte of the data image is changed by the flash write, the device reports
+  # a checksum which is not the one of the file and nothing is installed
+  run_sim(0 --quiet write_upgrade boot.dfu data.dfu)
+  change_image(boot2 boot 100)
+  change_image(data2 data 5000)
+  set(sim_env DFU_SIM_CORRUPT=7000)
+  run_sim(1 --quiet --installed-boot boot.dfu --installed-data data.dfu
+          write_upgrade boot2.dfu data2.dfu)
+  check_output("downloaded image checksum 0x[0-9A-F]+ does not match the file 0x[0-9A-F]+\n"
+               "download aborted before manifest")
+  check_flash(boot.bin boot)
+  check_flash(data.bin data)
+
+elseif (CASE STREQUAL "devices")
+  # three devices, two at a time, the flash writes of sim-1 fail
+  set(sim_env DFU_SIM_DEVICES=3 DFU_SIM_FAIL=sim-1)
+  run_sim(1 --quiet --devices all --jobs 2 write_upgrade boot.dfu data.dfu)
+  check_output("2 of 3 devices updated\n"
+               "sim-0  ok      [0-9.]+ s\n"
+               "sim-1  failed  [0-9.]+ s, status 2\n"
+               "sim-2  ok      [0-9.]+ s\n")
+  check_flash(sim-0/boot.bin boot)
+  check_flash(sim-0/data.bin data)
+  check_flash(sim-2/boot.bin boot)
+  check_flash(sim-2/data.bin data)
+  if (EXISTS ${WORK_DIR}/flash/sim-1/boot.bin OR EXISTS ${WORK_DIR}/flash/sim-1/data.bin)
+    message(FATAL_ERROR "an image was installed on the failing device sim-1")
+  endif()
+
+  # a device listed twice is refused before any update
+  make_image(boot2 2000 3)
+  make_image(data2 12000 4)
+  run_sim(1 --quiet --devices sim-0,sim-2,sim-0 write_upgrade boot2.dfu data2.dfu)
+  check_output("error: device sim-0 is listed twice")
+  check_flash(sim-0/boot.bin boot)
+  check_flash(sim-2/data.bin data)
+
+else()
+  message(FATAL_ERROR "unknown case ${CASE}")
+endif()
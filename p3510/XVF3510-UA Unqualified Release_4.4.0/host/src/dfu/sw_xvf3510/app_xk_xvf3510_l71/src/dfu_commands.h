@@ -28,7 +28,9 @@ enum dfu_command {
   DFU_CMD_GETSTATE         = CONTROL_CMD_SET_READ(6),
   DFU_CMD_GETSTATUS        = CONTROL_CMD_SET_READ(7),
   DFU_CMD_GET_ERROR_INFO   = CONTROL_CMD_SET_READ(8),
-  DFU_CMD_OVERRIDE_SPISPEC = CONTROL_CMD_SET_WRITE(9)
+  DFU_CMD_OVERRIDE_SPISPEC = CONTROL_CMD_SET_WRITE(9),
+  DFU_CMD_DNLOAD_COPY      = CONTROL_CMD_SET_WRITE(10),
+  DFU_CMD_GET_IMAGE_CRC    = CONTROL_CMD_SET_READ(11)
 };
 
 struct dfu_get_version {
@@ -40,6 +42,29 @@ struct dfu_dnload_header {
   uint16_t pad;
 };
 
+/**
+ * Delta download: instead of num_blocks DNLOAD of unchanged blocks, the
+ * device copies them from the installed image of the same partition, at the
+ * same block numbers. The data image marker is set in block_num as in DNLOAD.
+ */
+struct dfu_dnload_copy {
+  uint16_t block_num;
+  uint16_t num_blocks;
+  uint16_t block_bytes;
+  uint16_t pad;
+};
+
+/**
+ * Checksums of the installed images and of the image being downloaded, the
+ * same CRC as in the DFU suffix, for the host to check that a delta applies
+ * to the installed image and that the result matches the file
+ */
+struct dfu_image_crc {
+  uint32_t installed_boot;
+  uint32_t installed_data;
+  uint32_t downloaded;
+};
+
 struct dfu_timeout {
   bool enable;
   unsigned delta;
@@ -142,7 +142,7 @@ static struct data_image_tlv_header make_item_header(struct byte_stream *stream,
   return header;
 }
 
-static struct byte_stream render_item_list(const struct item *item_list)
+struct byte_stream render_item_list(const struct item *item_list)
 {
   struct byte_stream stream = {
     .bytes = calloc(count_item_list_size(item_list), 1),
@@ -20,6 +20,9 @@ struct byte_stream render_byte_stream(const struct images *images,
                                       bool bad_factory_crc,
                                       bool bad_upgrade_crc);
 
+// TLV items of an image section, without the section header, padded to a word
+struct byte_stream render_item_list(const struct item *item_list);
+
 void cleanup_byte_stream(struct byte_stream stream);
 
 #endif
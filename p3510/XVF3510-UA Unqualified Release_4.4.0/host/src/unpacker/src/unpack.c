@@ -0,0 +1,214 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+// Streaming unpacker of the 16 kHz channels packed into a 48 kHz stereo capture
+
+#include <string.h>
+#include "unpack.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define UNPACK_SSE2 1
+#include <emmintrin.h>
+#else
+#define UNPACK_SSE2 0
+#endif
+
+#define LEGACY_OUT_CHANNELS (2)
+
+int unpack_init(unpack_state_t *s, unpack_format_t format, unsigned bit_res, unsigned legacy_channel)
+{
+    memset(s, 0, sizeof(*s));
+    if (bit_res != 32 && bit_res != 24 && bit_res != 16) {
+        return -1;
+    }
+    if (legacy_channel >= UNPACK_IN_CHANNELS) {
+        return -1;
+    }
+    s->format = format;
+    s->flag_mask = (int32_t)(1u << (32 - bit_res));
+    s->legacy_channel = legacy_channel;
+    return 0;
+}
+
+unsigned unpack_num_out_channels(const unpack_state_t *s)
+{
+    return (s->format == UNPACK_FORMAT_LEGACY) ? LEGACY_OUT_CHANNELS : UNPACK_FRAME_WORDS;
+}
+
+unsigned unpack_max_out_frames(unsigned num_samples)
+{
+    // every sample can start a frame in a corrupted capture, plus the samples kept from the previous call
+    return num_samples + UNPACK_FRAME_SAMPLES;
+}
+
+unsigned unpack_count_aligned_frames(const int32_t *in, unsigned max_frames, int32_t flag_mask)
+{
+    unsigned k = 0;
+#if UNPACK_SSE2
+    // two triples are three vectors: the start bit must be set on one of the two first lanes of the first
+    // vector and of the two last lanes of the second vector, and clear everywhere else
+    const __m128i mask = _mm_set1_epi32(flag_mask);
+    const __m128i zero = _mm_setzero_si128();
+    for (; k + 2 <= max_frames; k += 2) {
+        const int32_t *w = &in[k * UNPACK_FRAME_WORDS];
+        __m128i a = _mm_and_si128(_mm_loadu_si128((const __m128i *)&w[0]), mask);
+        __m128i b = _mm_and_si128(_mm_loadu_si128((const __m128i *)&w[4]), mask);
+        __m128i c = _mm_and_si128(_mm_loadu_si128((const __m128i *)&w[8]), mask);
+        int za = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(a, zero)));
+        int zb = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(b, zero)));
+        int zc = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(c, zero)));
+        if ((za & 0xc) != 0xc || (za & 0x3) == 0x3 || (zb & 0x3) != 0x3 || (zb & 0xc) == 0xc || zc != 0xf) {
+            break;
+        }
+    }
+#endif
+    for (; k < max_frames; k++) {
+        const int32_t *w = &in[k * UNPACK_FRAME_WORDS];
+        if (((w[0] | w[1]) & flag_mask) == 0 || ((w[2] | w[3] | w[4] | w[5]) & flag_mask) != 0) {
+            break;
+        }
+    }
+    return k;
+}
+
+void unpack_deinterleave(const int32_t *in, unsigned num_frames, unsigned num_channels, int32_t *out[])
+{
+    unsigned f = 0;
+#if UNPACK_SSE2
+    if (num_channels == UNPACK_FRAME_WORDS) {
+        // four frames are six vectors, the first four channels are a 4x4 transpose of the frames
+        // realigned on 64-bit boundaries and the last two are gathered from the remaining halves
+        for (; f + 4 <= num_frames; f += 4) {
+            const float *w = (const float *)&in[f * UNPACK_FRAME_WORDS];
+            __m128 v1 = _mm_loadu_ps(&w[4]);
+            __m128 v2 = _mm_loadu_ps(&w[8]);
+            __m128 v4 = _mm_loadu_ps(&w[16]);
+            __m128 v5 = _mm_loadu_ps(&w[20]);
+            __m128 r0 = _mm_loadu_ps(&w[0]);
+            __m128 r1 = _mm_castpd_ps(_mm_shuffle_pd(_mm_castps_pd(v1), _mm_castps_pd(v2), 1));
+            __m128 r2 = _mm_loadu_ps(&w[12]);
+            __m128 r3 = _mm_castpd_ps(_mm_shuffle_pd(_mm_castps_pd(v4), _mm_castps_pd(v5), 1));
+            __m128 x = _mm_castpd_ps(_mm_shuffle_pd(_mm_castps_pd(v1), _mm_castps_pd(v2), 2));
+            __m128 y = _mm_castpd_ps(_mm_shuffle_pd(_mm_castps_pd(v4), _mm_castps_pd(v5), 2));
+            _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+            _mm_storeu_ps((float *)&out[0][f], r0);
+            _mm_storeu_ps((float *)&out[1][f], r1);
+            _mm_storeu_ps((float *)&out[2][f], r2);
+            _mm_storeu_ps((float *)&out[3][f], r3);
+            _mm_storeu_ps((float *)&out[4][f], _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps((float *)&out[5][f], _mm_shuffle_ps(x, y, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+    } else if (num_channels == 2) {
+        for (; f + 4 <= num_frames; f += 4) {
+            __m128 v0 = _mm_loadu_ps((const float *)&in[2 * f]);
+            __m128 v1 = _mm_loadu_ps((const float *)&in[2 * f + 4]);
+            _mm_storeu_ps((float *)&out[0][f], _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0)));
+            _mm_storeu_ps((float *)&out[1][f], _mm_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1)));
+        }
+    }
+#endif
+    for (; f < num_frames; f++) {
+        for (unsigned c=0; c<num_channels; c++) {
+            out[c][f] = in[f * num_channels + c];
+        }
+    }
+}
+
+static void frame_start(unpack_state_t *s, uint64_t sample)
+{
+    if (s->last_start != 0 && sample + 1 - s->last_start != UNPACK_FRAME_SAMPLES) {
+        s->num_corrupted++;
+        if (s->on_corrupt != NULL) {
+            s->on_corrupt(s->ctx, sample, sample + 1 - s->last_start);
+        }
+    }
+    s->last_start = sample + 1;
+}
+
+// p points to the three stereo samples from the tested position
+static int is_start(const unpack_state_t *s, const int32_t *p)
+{
+    if (s->format == UNPACK_FORMAT_ALL) {
+        return ((p[0] | p[1]) & s->flag_mask) != 0;
+    }
+    unsigned c = s->legacy_channel;
+    return (p[c] & 0xff) == 0 && (p[2 + c] & 0xff) == 1 && (p[4 + c] & 0xff) == 2;
+}
+
+static void write_frame(const unpack_state_t *s, const int32_t *p, int32_t *out)
+{
+    if (s->format == UNPACK_FORMAT_ALL) {
+        // the samples of a frame are already in the output order: mics, references and outputs of the two channels
+        memcpy(out, p, UNPACK_FRAME_WORDS * sizeof(int32_t));
+        return;
+    }
+    unsigned c = s->legacy_channel;
+    uint32_t low = (uint32_t)p[4 + c];
+    out[0] = (int32_t)(((uint32_t)p[c] & 0xffffff00) | ((low >> 24) & 0xff));
+    out[1] = (int32_t)(((uint32_t)p[2 + c] & 0xffffff00) | ((low >> 16) & 0xff));
+}
+
+unsigned unpack_process(unpack_state_t *s, const int32_t *in, unsigned num_samples, int32_t *out)
+{
+    unsigned out_words = unpack_num_out_channels(s);
+    unsigned num_frames = 0;
+    unsigned num_pending = s->num_pending;
+    // sample index of the first pending sample, or of in if none
+    uint64_t base = s->in_samples - num_pending;
+
+    // the frames starting in the samples kept from the previous call are tested on a copy joined to the
+    // first samples of this call
+    int32_t head[2 * UNPACK_FRAME_WORDS];
+    unsigned head_samples = num_pending + ((num_samples < 2) ? num_samples : 2);
+    memcpy(head, s->pending, num_pending * UNPACK_IN_CHANNELS * sizeof(int32_t));
+    memcpy(&head[num_pending * UNPACK_IN_CHANNELS], in, (head_samples - num_pending) * UNPACK_IN_CHANNELS * sizeof(int32_t));
+
+    unsigned pos = 0;
+    while (pos < num_pending && pos + 2 < head_samples) {
+        const int32_t *p = &head[pos * UNPACK_IN_CHANNELS];
+        if (is_start(s, p)) {
+            frame_start(s, base + pos);
+            write_frame(s, p, &out[num_frames++ * out_words]);
+            pos += (s->format == UNPACK_FORMAT_LEGACY) ? UNPACK_FRAME_SAMPLES : 1;
+        } else {
+            pos++;
+        }
+    }
+    s->in_samples += num_samples;
+    if (pos < num_pending) {
+        // still not enough samples for a frame
+        s->num_pending = head_samples - pos;
+        memmove(s->pending, &head[pos * UNPACK_IN_CHANNELS], s->num_pending * UNPACK_IN_CHANNELS * sizeof(int32_t));
+        s->out_frames += num_frames;
+        return num_frames;
+    }
+
+    base += num_pending;
+    unsigned i = pos - num_pending;
+    while (i + 2 < num_samples) {
+        const int32_t *p = &in[i * UNPACK_IN_CHANNELS];
+        if (!is_start(s, p)) {
+            i++;
+            continue;
+        }
+        frame_start(s, base + i);
+        if (s->format == UNPACK_FORMAT_LEGACY) {
+            write_frame(s, p, &out[num_frames++ * out_words]);
+            i += UNPACK_FRAME_SAMPLES;
+            continue;
+        }
+        // the frames following a start are copied in one go as long as they are aligned
+        unsigned n = unpack_count_aligned_frames(p, (num_samples - i) / UNPACK_FRAME_SAMPLES, s->flag_mask);
+        if (n == 0) {
+            write_frame(s, p, &out[num_frames++ * out_words]);
+            i++;
+            continue;
+        }
+        memcpy(&out[num_frames * out_words], p, n * UNPACK_FRAME_WORDS * sizeof(int32_t));
+        num_frames += n;
+        i += n * UNPACK_FRAME_SAMPLES;
+        s->last_start = base + i - UNPACK_FRAME_SAMPLES + 1;
+    }
+    s->num_pending = num_samples - i;
+    memcpy(s->pending, &in[i * UNPACK_IN_CHANNELS], s->num_pending * UNPACK_IN_CHANNELS * sizeof(int32_t));
+    s->out_frames += num_frames;
+    return num_frames;
+}
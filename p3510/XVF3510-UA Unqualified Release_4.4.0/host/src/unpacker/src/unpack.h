@@ -0,0 +1,58 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#ifndef UNPACK_H
+#define UNPACK_H
+
+#include <stdint.h>
+
+// The packed output of the device carries three 16 kHz frames in each 48 kHz stereo sample triple
+#define UNPACK_IN_CHANNELS      (2)
+#define UNPACK_FRAME_SAMPLES    (3)
+#define UNPACK_FRAME_WORDS      (UNPACK_IN_CHANNELS * UNPACK_FRAME_SAMPLES)
+#define UNPACK_MAX_OUT_CHANNELS (UNPACK_FRAME_WORDS)
+#define UNPACK_OUT_RATE         (16000)
+#define UNPACK_IN_RATE          (48000)
+
+typedef enum {
+    // unpacker_packed_all.py: the bit of the lowest resolution bit is set on both channels at the start of
+    // each triple, which holds the mics, the references and the processed output of the two channels
+    UNPACK_FORMAT_ALL,
+    // unpacker.py: the lowest byte of the three samples of one channel is 0, 1 and 2, the lower 8 bits of
+    // the two 16 kHz channels are carried in the upper bytes of the third sample
+    UNPACK_FORMAT_LEGACY,
+} unpack_format_t;
+
+// Called for each gap between two frame starts which is not a frame long, sample is the 48 kHz
+// sample index of the frame start after the gap
+typedef void (*unpack_corrupt_cb_t)(void *ctx, uint64_t sample, uint64_t gap);
+
+typedef struct {
+    unpack_format_t format;
+    int32_t flag_mask;          // frame start bit of UNPACK_FORMAT_ALL
+    unsigned legacy_channel;    // input channel with the packed data of UNPACK_FORMAT_LEGACY
+    unpack_corrupt_cb_t on_corrupt;
+    void *ctx;
+
+    // stream state
+    int32_t pending[UNPACK_FRAME_WORDS];    // samples of a frame split between two calls
+    unsigned num_pending;                   // stereo samples in pending
+    uint64_t in_samples;                    // stereo samples received before the current call
+    uint64_t last_start;                    // sample index of the last frame start + 1, 0 before the first
+    uint64_t out_frames;
+    unsigned num_corrupted;
+} unpack_state_t;
+
+// bit_res is the resolution of the packed data, 32, 24 or 16, the samples are 32-bit left aligned
+int unpack_init(unpack_state_t *s, unpack_format_t format, unsigned bit_res, unsigned legacy_channel);
+unsigned unpack_num_out_channels(const unpack_state_t *s);
+// Unpack num_samples interleaved stereo samples into frames of unpack_num_out_channels() interleaved
+// samples. out must hold unpack_max_out_frames(num_samples) frames. Returns the number of frames written.
+unsigned unpack_process(unpack_state_t *s, const int32_t *in, unsigned num_samples, int32_t *out);
+unsigned unpack_max_out_frames(unsigned num_samples);
+
+// Kernels, SIMD where the target supports it
+// Number of consecutive triples from in, up to max_frames, with the frame start bit on the first sample only
+unsigned unpack_count_aligned_frames(const int32_t *in, unsigned max_frames, int32_t flag_mask);
+// Split num_frames interleaved frames of num_channels samples into a buffer per channel
+void unpack_deinterleave(const int32_t *in, unsigned num_frames, unsigned num_channels, int32_t *out[]);
+
+#endif
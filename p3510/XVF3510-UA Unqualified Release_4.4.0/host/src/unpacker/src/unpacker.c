@@ -0,0 +1,180 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+// Command line unpacker of the packed 48 kHz captures, replaces unpacker.py and unpacker_packed_all.py
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "unpack.h"
+#include "wav_io.h"
+
+#define BLOCK_SAMPLES           (65536)
+#define MAX_CORRUPT_MESSAGES    (100)
+#define MAX_FILENAME_CHARS      (1024)
+
+static const char *all_channel_names[UNPACK_FRAME_WORDS] = {"mic0", "mic1", "ref0", "ref1", "out0", "out1"};
+static const char *legacy_channel_names[2] = {"ch0", "ch1"};
+
+// diagnostics go to stderr when the output is on stdout
+static FILE *msg_fp;
+
+static void print_help(void)
+{
+    printf("Usage: unpacker [options] INPUT\n");
+    printf("Unpack the 16 kHz channels packed into a 48 kHz stereo WAV capture. Use - to read stdin\n");
+    printf("    -o FILE          all the channels in one file, - for stdout. Default is unpacked.wav\n");
+    printf("    --split PREFIX   one file per channel, PREFIX_mic0.wav, PREFIX_mic1.wav, PREFIX_ref0.wav...\n");
+    printf("    --raw            raw 32-bit little endian samples instead of WAV\n");
+    printf("    --bits N         resolution of the packed data, 32, 24 or 16. Default is the WAV sample size\n");
+    printf("    --legacy CH      format of unpacker.py, packed into channel CH (0 or 1), unpacked into two channels\n");
+    printf("The output of the default format is mic0, mic1, ref0, ref1, out0 and out1 as unpacker_packed_all.py\n");
+}
+
+static void report_corrupt(void *ctx, uint64_t sample, uint64_t gap)
+{
+    unsigned *num_reported = (unsigned *)ctx;
+    if (*num_reported < MAX_CORRUPT_MESSAGES) {
+        fprintf(msg_fp, "Frame corrupted @ %.2fs (sample: %llu), diff: %llu\n", (double)sample / UNPACK_IN_RATE,
+                (unsigned long long)sample, (unsigned long long)gap);
+    } else if (*num_reported == MAX_CORRUPT_MESSAGES) {
+        fprintf(msg_fp, "More frames corrupted, only the total is reported\n");
+    }
+    (*num_reported)++;
+}
+
+int main(int argc, char **argv)
+{
+    const char *input_file = NULL;
+    const char *output_file = "unpacked.wav";
+    const char *split_prefix = NULL;
+    unsigned raw = 0;
+    unsigned bit_res = 0;
+    int legacy_channel = -1;
+    msg_fp = stdout;
+
+    for (int i=1; i<argc; i++) {
+        if (strcmp(argv[i], "-o") == 0 && i + 1 < argc) {
+            output_file = argv[++i];
+        } else if (strcmp(argv[i], "--split") == 0 && i + 1 < argc) {
+            split_prefix = argv[++i];
+        } else if (strcmp(argv[i], "--raw") == 0) {
+            raw = 1;
+        } else if (strcmp(argv[i], "--bits") == 0 && i + 1 < argc) {
+            bit_res = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--legacy") == 0 && i + 1 < argc) {
+            legacy_channel = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0) {
+            print_help();
+            return 0;
+        } else if (input_file == NULL) {
+            input_file = argv[i];
+        } else {
+            printf("Error: unexpected argument %s\n", argv[i]);
+            print_help();
+            return 1;
+        }
+    }
+    if (input_file == NULL) {
+        print_help();
+        return 1;
+    }
+    if (split_prefix == NULL && strcmp(output_file, "-") == 0) {
+        msg_fp = stderr;
+    }
+
+    wav_reader_t reader;
+    if (wav_reader_open(&reader, input_file) != 0) {
+        return 1;
+    }
+    if (reader.channels != UNPACK_IN_CHANNELS || reader.sample_rate != UNPACK_IN_RATE) {
+        fprintf(msg_fp, "Error: packed data is always stereo 48kHz, this wav is %u channels %.1fkHz\n",
+                reader.channels, reader.sample_rate / 1000.0);
+        wav_reader_close(&reader);
+        return 1;
+    }
+    if (bit_res == 0) {
+        bit_res = reader.bits;
+    }
+    unpack_state_t state;
+    unpack_format_t format = (legacy_channel >= 0) ? UNPACK_FORMAT_LEGACY : UNPACK_FORMAT_ALL;
+    if (unpack_init(&state, format, bit_res, (legacy_channel >= 0) ? legacy_channel : 0) != 0) {
+        fprintf(msg_fp, "Error: --bits must be 32, 24 or 16 and --legacy 0 or 1\n");
+        wav_reader_close(&reader);
+        return 1;
+    }
+    unsigned num_reported = 0;
+    state.on_corrupt = report_corrupt;
+    state.ctx = &num_reported;
+
+    unsigned num_channels = unpack_num_out_channels(&state);
+    const char **channel_names = (format == UNPACK_FORMAT_LEGACY) ? legacy_channel_names : all_channel_names;
+    unsigned num_writers = (split_prefix != NULL) ? num_channels : 1;
+    wav_writer_t writers[UNPACK_MAX_OUT_CHANNELS];
+    int ret = 0;
+    for (unsigned c=0; c<num_writers && ret == 0; c++) {
+        char filename[MAX_FILENAME_CHARS];
+        if (split_prefix != NULL) {
+            snprintf(filename, sizeof(filename), "%s_%s.%s", split_prefix, channel_names[c], raw ? "raw" : "wav");
+        } else {
+            snprintf(filename, sizeof(filename), "%s", output_file);
+        }
+        ret = wav_writer_open(&writers[c], filename, (split_prefix != NULL) ? 1 : num_channels, UNPACK_OUT_RATE, raw);
+        if (ret != 0) {
+            num_writers = c;
+        }
+    }
+
+    unsigned max_frames = unpack_max_out_frames(BLOCK_SAMPLES);
+    int32_t *in = malloc((size_t)BLOCK_SAMPLES * UNPACK_IN_CHANNELS * sizeof(int32_t));
+    int32_t *out = malloc((size_t)max_frames * num_channels * sizeof(int32_t));
+    int32_t *split[UNPACK_MAX_OUT_CHANNELS];
+    for (unsigned c=0; c<num_channels; c++) {
+        split[c] = (split_prefix != NULL) ? malloc((size_t)max_frames * sizeof(int32_t)) : NULL;
+    }
+
+    clock_t start = clock();
+    unsigned num_samples;
+    while (ret == 0 && (num_samples = wav_reader_read(&reader, in, BLOCK_SAMPLES)) > 0) {
+        unsigned num_frames = unpack_process(&state, in, num_samples, out);
+        if (split_prefix == NULL) {
+            ret = wav_writer_write(&writers[0], out, num_frames);
+        } else {
+            unpack_deinterleave(out, num_frames, num_channels, split);
+            for (unsigned c=0; c<num_channels && ret == 0; c++) {
+                ret = wav_writer_write(&writers[c], split[c], num_frames);
+            }
+        }
+        if (ret != 0) {
+            fprintf(msg_fp, "Error: cannot write the output\n");
+        }
+    }
+    double elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    for (unsigned c=0; c<num_writers; c++) {
+        if (wav_writer_close(&writers[c]) != 0) {
+            fprintf(msg_fp, "Error: cannot write the output\n");
+            ret = 1;
+        }
+    }
+    if (ret == 0 && state.last_start == 0) {
+        fprintf(msg_fp, "Error: no packed data found, check the format and --bits\n");
+        ret = 1;
+    }
+    if (ret == 0) {
+        double seconds = (double)state.out_frames / UNPACK_OUT_RATE;
+        fprintf(msg_fp, "Unpacked %llu frames (%.1f s) of %u channels in %.2f s", (unsigned long long)state.out_frames,
+                seconds, num_channels, elapsed);
+        if (state.num_corrupted > 0) {
+            fprintf(msg_fp, ", %u corrupted frames", state.num_corrupted);
+        }
+        fprintf(msg_fp, "\n");
+    }
+
+    for (unsigned c=0; c<num_channels; c++) {
+        free(split[c]);
+    }
+    free(out);
+    free(in);
+    wav_reader_close(&reader);
+    return ret ? 1 : 0;
+}
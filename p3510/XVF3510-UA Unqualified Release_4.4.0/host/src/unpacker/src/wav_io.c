@@ -0,0 +1,242 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+// Streaming PCM WAV input and output
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "wav_io.h"
+#if defined(_WIN32)
+#include <io.h>
+#include <fcntl.h>
+#endif
+
+#define WAV_FORMAT_PCM          (1)
+#define WAV_FORMAT_EXTENSIBLE   (0xfffe)
+#define WAV_HEADER_BYTES        (44)
+#define WAV_UNKNOWN_SIZE        (0xffffffff)
+#define WAV_READ_BUFFER_FRAMES  (16384)
+
+static uint32_t get_le(const uint8_t *p, unsigned num_bytes)
+{
+    uint32_t v = 0;
+    for (unsigned i=0; i<num_bytes; i++) {
+        v |= (uint32_t)p[i] << (8 * i);
+    }
+    return v;
+}
+
+static void put_le(uint8_t *p, uint32_t v, unsigned num_bytes)
+{
+    for (unsigned i=0; i<num_bytes; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+// stdin cannot seek, the chunks before the data are read through
+static int skip_bytes(FILE *fp, uint32_t num_bytes)
+{
+    uint8_t buf[256];
+    while (num_bytes > 0) {
+        size_t n = (num_bytes < sizeof(buf)) ? num_bytes : sizeof(buf);
+        if (fread(buf, 1, n, fp) != n) {
+            return -1;
+        }
+        num_bytes -= (uint32_t)n;
+    }
+    return 0;
+}
+
+int wav_reader_open(wav_reader_t *r, const char *filename)
+{
+    memset(r, 0, sizeof(*r));
+    if (strcmp(filename, "-") == 0) {
+        r->fp = stdin;
+#if defined(_WIN32)
+        _setmode(_fileno(stdin), _O_BINARY);
+#endif
+    } else {
+        r->fp = fopen(filename, "rb");
+        if (r->fp == NULL) {
+            fprintf(stderr, "Error: cannot open %s\n", filename);
+            return -1;
+        }
+    }
+    uint8_t hdr[12];
+    if (fread(hdr, 1, sizeof(hdr), r->fp) != sizeof(hdr) || memcmp(hdr, "RIFF", 4) != 0 || memcmp(&hdr[8], "WAVE", 4) != 0) {
+        fprintf(stderr, "Error: %s is not a WAV file\n", filename);
+        wav_reader_close(r);
+        return -1;
+    }
+    unsigned format = 0;
+    for (;;) {
+        uint8_t chunk[8];
+        if (fread(chunk, 1, sizeof(chunk), r->fp) != sizeof(chunk)) {
+            fprintf(stderr, "Error: no data in %s\n", filename);
+            wav_reader_close(r);
+            return -1;
+        }
+        uint32_t size = get_le(&chunk[4], 4);
+        if (memcmp(chunk, "fmt ", 4) == 0 && size >= 16 && size <= 64) {
+            uint8_t fmt[64];
+            if (fread(fmt, 1, size + (size & 1), r->fp) != size + (size & 1)) {
+                break;
+            }
+            format = get_le(&fmt[0], 2);
+            r->channels = get_le(&fmt[2], 2);
+            r->sample_rate = get_le(&fmt[4], 4);
+            r->bits = get_le(&fmt[14], 2);
+            if (format == WAV_FORMAT_EXTENSIBLE && size >= 26) {
+                format = get_le(&fmt[24], 2);
+            }
+        } else if (memcmp(chunk, "data", 4) == 0) {
+            r->bytes_left = (size == 0 || size == WAV_UNKNOWN_SIZE) ? UINT64_MAX : size;
+            break;
+        } else if (skip_bytes(r->fp, size + (size & 1)) != 0) {
+            fprintf(stderr, "Error: no data in %s\n", filename);
+            wav_reader_close(r);
+            return -1;
+        }
+    }
+    if (format != WAV_FORMAT_PCM || r->channels == 0 || (r->bits != 16 && r->bits != 24 && r->bits != 32)) {
+        fprintf(stderr, "Error: %s must be a 16, 24 or 32-bit PCM WAV file\n", filename);
+        wav_reader_close(r);
+        return -1;
+    }
+    r->buffer_frames = WAV_READ_BUFFER_FRAMES;
+    r->buffer = malloc((size_t)r->buffer_frames * r->channels * (r->bits / 8));
+    return 0;
+}
+
+unsigned wav_reader_read(wav_reader_t *r, int32_t *samples, unsigned max_frames)
+{
+    unsigned sample_bytes = r->bits / 8;
+    unsigned frame_bytes = r->channels * sample_bytes;
+    if (r->bits == 32) {
+        // read in place, the file and the host are little endian
+        uint64_t max_bytes = (uint64_t)max_frames * frame_bytes;
+        if (max_bytes > r->bytes_left) {
+            max_bytes = r->bytes_left - (r->bytes_left % frame_bytes);
+        }
+        size_t n = fread(samples, frame_bytes, (size_t)(max_bytes / frame_bytes), r->fp);
+        r->bytes_left -= n * frame_bytes;
+        return (unsigned)n;
+    }
+    unsigned num_frames = 0;
+    while (num_frames < max_frames) {
+        uint64_t n = max_frames - num_frames;
+        if (n > r->buffer_frames) {
+            n = r->buffer_frames;
+        }
+        if (n * frame_bytes > r->bytes_left) {
+            n = r->bytes_left / frame_bytes;
+        }
+        n = fread(r->buffer, frame_bytes, (size_t)n, r->fp);
+        if (n == 0) {
+            break;
+        }
+        r->bytes_left -= n * frame_bytes;
+        unsigned num_samples = (unsigned)n * r->channels;
+        int32_t *out = &samples[num_frames * r->channels];
+        if (r->bits == 16) {
+            for (unsigned i=0; i<num_samples; i++) {
+                out[i] = (int32_t)((uint32_t)get_le(&r->buffer[2 * i], 2) << 16);
+            }
+        } else {
+            for (unsigned i=0; i<num_samples; i++) {
+                out[i] = (int32_t)(get_le(&r->buffer[3 * i], 3) << 8);
+            }
+        }
+        num_frames += (unsigned)n;
+    }
+    return num_frames;
+}
+
+void wav_reader_close(wav_reader_t *r)
+{
+    if (r->fp != NULL && r->fp != stdin) {
+        fclose(r->fp);
+    }
+    free(r->buffer);
+    r->fp = NULL;
+    r->buffer = NULL;
+}
+
+static void make_header(uint8_t *hdr, unsigned channels, unsigned sample_rate, uint64_t data_bytes)
+{
+    uint32_t data_size = (data_bytes > WAV_UNKNOWN_SIZE - 36) ? WAV_UNKNOWN_SIZE : (uint32_t)data_bytes;
+    memcpy(&hdr[0], "RIFF", 4);
+    put_le(&hdr[4], (data_size == WAV_UNKNOWN_SIZE) ? WAV_UNKNOWN_SIZE : 36 + data_size, 4);
+    memcpy(&hdr[8], "WAVEfmt ", 8);
+    put_le(&hdr[16], 16, 4);
+    put_le(&hdr[20], WAV_FORMAT_PCM, 2);
+    put_le(&hdr[22], channels, 2);
+    put_le(&hdr[24], sample_rate, 4);
+    put_le(&hdr[28], sample_rate * channels * 4, 4);
+    put_le(&hdr[32], channels * 4, 2);
+    put_le(&hdr[34], 32, 2);
+    memcpy(&hdr[36], "data", 4);
+    put_le(&hdr[40], data_size, 4);
+}
+
+int wav_writer_open(wav_writer_t *w, const char *filename, unsigned channels, unsigned sample_rate, unsigned raw)
+{
+    memset(w, 0, sizeof(*w));
+    w->channels = channels;
+    w->sample_rate = sample_rate;
+    w->raw = raw;
+    if (strcmp(filename, "-") == 0) {
+        w->fp = stdout;
+#if defined(_WIN32)
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+    } else {
+        w->fp = fopen(filename, "wb");
+        if (w->fp == NULL) {
+            fprintf(stderr, "Error: cannot open %s\n", filename);
+            return -1;
+        }
+    }
+    if (!raw) {
+        uint8_t hdr[WAV_HEADER_BYTES];
+        make_header(hdr, channels, sample_rate, WAV_UNKNOWN_SIZE);
+        if (fwrite(hdr, 1, sizeof(hdr), w->fp) != sizeof(hdr)) {
+            fprintf(stderr, "Error: cannot write %s\n", filename);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int wav_writer_write(wav_writer_t *w, const int32_t *samples, unsigned num_frames)
+{
+    if (fwrite(samples, w->channels * sizeof(int32_t), num_frames, w->fp) != num_frames) {
+        return -1;
+    }
+    w->data_bytes += (uint64_t)num_frames * w->channels * sizeof(int32_t);
+    return 0;
+}
+
+int wav_writer_close(wav_writer_t *w)
+{
+    int ret = 0;
+    if (w->fp == NULL) {
+        return 0;
+    }
+    // patch the sizes when the output can be seeked
+    if (!w->raw && w->fp != stdout && fseek(w->fp, 0, SEEK_SET) == 0) {
+        uint8_t hdr[WAV_HEADER_BYTES];
+        make_header(hdr, w->channels, w->sample_rate, w->data_bytes);
+        if (fwrite(hdr, 1, sizeof(hdr), w->fp) != sizeof(hdr)) {
+            ret = -1;
+        }
+    }
+    if (w->fp != stdout) {
+        if (fclose(w->fp) != 0) {
+            ret = -1;
+        }
+    } else {
+        fflush(stdout);
+    }
+    w->fp = NULL;
+    return ret;
+}
@@ -0,0 +1,41 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#ifndef WAV_IO_H
+#define WAV_IO_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Streaming PCM WAV input, from a file or stdin. A data chunk size of 0 or 0xffffffff, as written by the
+// recorders which cannot seek back, is read until the end of the stream.
+typedef struct {
+    FILE *fp;
+    unsigned channels;
+    unsigned sample_rate;
+    unsigned bits;
+    uint64_t bytes_left;
+    uint8_t *buffer;
+    unsigned buffer_frames;
+} wav_reader_t;
+
+// Streaming 32-bit PCM WAV or raw output. The sizes in the header are set when the file is closed
+// if it can be seeked, they are left at 0xffffffff on stdout.
+typedef struct {
+    FILE *fp;
+    unsigned channels;
+    unsigned sample_rate;
+    unsigned raw;
+    uint64_t data_bytes;
+} wav_writer_t;
+
+// filename - is stdin. Returns 0 on success, the errors are printed.
+int wav_reader_open(wav_reader_t *r, const char *filename);
+// Read up to max_frames frames as left aligned 32-bit samples. Returns the number of frames read, 0 at the end.
+unsigned wav_reader_read(wav_reader_t *r, int32_t *samples, unsigned max_frames);
+void wav_reader_close(wav_reader_t *r);
+
+// filename - is stdout
+int wav_writer_open(wav_writer_t *w, const char *filename, unsigned channels, unsigned sample_rate, unsigned raw);
+int wav_writer_write(wav_writer_t *w, const int32_t *samples, unsigned num_frames);
+int wav_writer_close(wav_writer_t *w);
+
+#endif
@@ -69,6 +69,15 @@ control_ret_t control_init_usb(int vendor_id, int product_id, int interface_num)
  *  \returns           Whether the shutdown was successful or not
  */
 control_ret_t control_cleanup_usb(void);
+/** Get the identity of the connected USB device from its descriptors
+ *
+ *  \param serial        Buffer for the serial number string, empty if the device has none
+ *  \param serial_len    Size of the serial buffer
+ *  \param bcd_device    Device release number (bcdDevice)
+ *
+ *  \returns           Whether the descriptors could be read or not
+ */
+control_ret_t control_get_usb_device_id(char *serial, size_t serial_len, unsigned *bcd_device);
 #endif
 #if USE_SPI || __DOXYGEN__
 #if RPI || __DOXYGEN__
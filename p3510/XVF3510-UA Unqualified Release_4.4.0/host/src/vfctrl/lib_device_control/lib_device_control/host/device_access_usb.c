@@ -233,6 +233,20 @@ control_ret_t control_cleanup_usb(void)
   return CONTROL_SUCCESS;
 }
 
+control_ret_t control_get_usb_device_id(char *serial, size_t serial_len, unsigned *bcd_device)
+{
+  struct usb_device *dev = usb_device(devh);
+
+  serial[0] = '\0';
+  *bcd_device = dev->descriptor.bcdDevice;
+  if (dev->descriptor.iSerialNumber != 0 &&
+      usb_get_string_simple(devh, dev->descriptor.iSerialNumber, serial, serial_len) < 0) {
+    return CONTROL_ERROR;
+  }
+
+  return CONTROL_SUCCESS;
+}
+
 #else
 
 control_ret_t control_init_usb(int vendor_id, int product_id, int interface_num)
@@ -279,6 +293,24 @@ control_ret_t control_cleanup_usb(void)
   return CONTROL_SUCCESS;
 }
 
+control_ret_t control_get_usb_device_id(char *serial, size_t serial_len, unsigned *bcd_device)
+{
+  struct libusb_device_descriptor desc;
+
+  serial[0] = '\0';
+  // the device descriptor is cached by libusb, only the string needs a transfer
+  if (libusb_get_device_descriptor(libusb_get_device(devh), &desc) < 0)
+    return CONTROL_ERROR;
+
+  *bcd_device = desc.bcdDevice;
+  if (desc.iSerialNumber != 0 &&
+      libusb_get_string_descriptor_ascii(devh, desc.iSerialNumber, (unsigned char*)serial, serial_len) < 0) {
+    return CONTROL_ERROR;
+  }
+
+  return CONTROL_SUCCESS;
+}
+
 #endif // _WIN32
 
 #endif // USE_USB
@@ -8,6 +8,7 @@ typedef uint8_t control_resid_t;
 #define MAX_PAR_NAME_CHARS (40)
 #define MAX_PAR_INFO_CHARS (200)
 #define CMD_MAX_BYTES      (64)
+#define MAX_OUTPUT_STR_CHARS (1000)
 
 #define XVF3510_PID_DEFAULT (0x0014)
 #define XVF3510_VID_DEFAULT (0x20b1)
@@ -43,20 +44,100 @@ typedef struct cmdspec_t {
   unsigned app_read_result_size; //for read commands, the total amount of memory app needs to allocate and send for returning read values into .
 } cmdspec_t;
 
+// Command ids for the typed API, generated from the command table.
+// The ids are the same in all the builds, the commands which are not in a build return an error.
+typedef enum {
+#define VFCTRL_CMD(name, resid, type, offset, rw, num_values, info) VFCTRL_##name,
+#define VFCTRL_CMD_NOT_I2C VFCTRL_CMD
+#include "host_control_cmds.h"
+#undef VFCTRL_CMD
+#undef VFCTRL_CMD_NOT_I2C
+    VFCTRL_NUM_CMDS
+} vfctrl_cmd_id_t;
+
+// Throughput counters of the SPI passthrough streaming functions
+typedef struct {
+    uint64_t bytes_written;
+    uint64_t bytes_read;
+    uint64_t busy_us;           // time spent in vfctrl_spi_write() and vfctrl_spi_read()
+    unsigned num_transactions;  // completed writes and reads
+    unsigned num_commands;      // control commands sent
+    unsigned num_retries;       // commands sent again because the device queue was full
+    unsigned num_errors;
+} vfctrl_spi_stats_t;
+
+// Receives the bytes of a data partition control item: resource ID, command, payload length and payload
+typedef void (*vfctrl_dp_item_sink_t)(const uint8_t *bytes, unsigned num_bytes);
+
 //API functions
 void vfctrl_set_vendor_id(int vendor_id);
 void vfctrl_set_product_id(int product_id);
+// The version, build and USB attributes are cached on disk per device unless disabled before the first command
+void vfctrl_set_attribute_cache(unsigned enable);
 char* vfctrl_print_help(unsigned full);
 void vfctrl_dump_params(void);
+// Read all the parameters, pipelined and grouped by resource, into a JSON snapshot with the time each value was read.
+// With freeze_adaptation set the AEC, IC and AGC adaptation is turned off during the capture and restored afterwards.
+int vfctrl_dump_snapshot(const char *snapshot_file, unsigned freeze_adaptation);
 int vfctrl_get_cmdspec(int num_args, const char *command, cmdspec_t *cmd_spec, uint8_t log_for_data_partition);
 int vfctrl_do_command(cmdspec_t *cmd_spec, const char **command_plus_values, void *data_out_ptr, uint8_t log_for_data_partition);
+// vfctrl_do_command() with the commands the app handles separately: the AEC and IC coefficients are saved to
+// aec_coefficients.py and ic_coefficients.py and the filter coefficients are converted from floating point.
+// The result of a read is formatted into output_string, of at least MAX_OUTPUT_STR_CHARS, which is left empty
+// otherwise. data_out_ptr is optional and receives the app_read_result_size bytes of the values read.
+int vfctrl_execute_command(cmdspec_t *cmd_spec, const char **command_plus_values, void *data_out_ptr, uint8_t log_for_data_partition, char *output_string);
+// Read several commands in one go. data_out_ptrs[i] must hold cmd_specs[i].app_read_result_size bytes.
+// cmd_ret is optional and receives the result of each command. Returns the first error or 0.
+int vfctrl_do_read_commands(cmdspec_t cmd_specs[], void *data_out_ptrs[], int cmd_ret[], unsigned num_cmds);
+// Compare the values of write commands with the device, reading back their GET_ counterparts in one batch.
+// diff[i] is 0 if the device holds the values already, 1 if they differ, -1 if they cannot be read back
+// and 2 if a later command in the list writes the same value. Selectors such as SET_FILTER_INDEX, and the
+// commands depending on them if the list has the selector, are -1: they must be written in the list order.
+// Returns the first read error or 0.
+int vfctrl_diff_commands(cmdspec_t cmd_specs[], const char **command_plus_values[], int diff[], unsigned num_cmds);
+// Typed access to a single command, with no text conversion. num_values must match the command.
+// The float functions take the floating point value of the fixed point and energy commands,
+// the int functions the 8 and 32-bit integer commands and the q functions the raw fixed point words.
+// Return 0 on success, -2 if the command does not take these values or is not in this build.
+int vfctrl_get_float(vfctrl_cmd_id_t cmd_id, float *value);
+int vfctrl_get_float_array(vfctrl_cmd_id_t cmd_id, float *values, unsigned num_values);
+int vfctrl_set_float(vfctrl_cmd_id_t cmd_id, float value);
+int vfctrl_set_float_array(vfctrl_cmd_id_t cmd_id, const float *values, unsigned num_values);
+int vfctrl_get_int(vfctrl_cmd_id_t cmd_id, int32_t *value);
+int vfctrl_get_int_array(vfctrl_cmd_id_t cmd_id, int32_t *values, unsigned num_values);
+int vfctrl_set_int(vfctrl_cmd_id_t cmd_id, int32_t value);
+int vfctrl_set_int_array(vfctrl_cmd_id_t cmd_id, const int32_t *values, unsigned num_values);
+int vfctrl_get_q(vfctrl_cmd_id_t cmd_id, int32_t *values, unsigned num_values);
+int vfctrl_set_q(vfctrl_cmd_id_t cmd_id, const int32_t *values, unsigned num_values);
+// Command description of a command id, to format the typed values with vfctrl_format_read_result()
+int vfctrl_get_cmdspec_by_id(vfctrl_cmd_id_t cmd_id, cmdspec_t *cmd_spec);
+// With a sink set, the commands logged for the data partition are passed to it instead of being printed as JSON
+void vfctrl_set_data_partition_sink(vfctrl_dp_item_sink_t sink);
+// Log the current value of every setting which can be read back from the device, as the SET_ commands which
+// restore it. The start up commands and the commands which depend on an index are not captured.
+int vfctrl_capture_params(unsigned *num_captured);
+void vfctrl_get_host_version(int *major, int *minor, int *patch);
+// Write num_bytes as a single SPI transaction, of any length. The data is split into SET_SPI_PUSH commands
+// sent back to back and the last bytes are sent with SET_SPI_PUSH_AND_EXEC, which runs the transaction.
+// Each command carries its full raw payload, so the last one is padded with zeros to SPI_MAX_CMD_SIZE bytes.
+int vfctrl_spi_write(const uint8_t *data, unsigned num_bytes, uint8_t log_for_data_partition);
+// Read num_bytes from address, in reads of up to the size of the SPI read buffer. The address of each read
+// is advanced by the bytes already read, as for the auto-incremented registers of most SPI peripherals.
+// The read must end within the 256 addresses, address + num_bytes <= 256.
+int vfctrl_spi_read(uint8_t address, uint8_t *data, unsigned num_bytes);
+void vfctrl_get_spi_stats(vfctrl_spi_stats_t *stats);
+void vfctrl_reset_spi_stats(void);
 int vfctrl_get_aec_coefficients_to_file(const char* aec_coeffs_file);
 int vfctrl_get_ic_coefficients_to_file(const char* aec_coeffs_file);
 int vfctrl_get_filter_coefficients_human_readable(cmdspec_t *cmd_original);
+int vfctrl_get_filter_coefficients_to_string(char *output_string);
 int vfctrl_set_filter_coefficients_human_readable(cmdspec_t *cmd_original, const char **command_plus_values, unsigned log_for_data_partition);
 int vfctrl_format_read_result(cmdspec_t *cmd_spec_ptr, void* data_out_ptr, char* output_string);
 int vfctrl_check_version(unsigned print_version_only);
 int vfctrl_check_run_status();
+void vfctrl_print_poll_stats(void);
+uint64_t vfctrl_get_time_us(void);
+void vfctrl_sleep_us(unsigned microseconds);
 
 #endif
 
@@ -0,0 +1,300 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+// Table of the vfctrl commands, used to generate the command table in host.c and the command ids of the API.
+// Define VFCTRL_CMD(name, resid, type, offset, rw, num_values, info) and VFCTRL_CMD_NOT_I2C before including it.
+// VFCTRL_CMD_NOT_I2C marks the commands which access an I2C device through the xvf device,
+// they are not available when the xvf device itself is controlled over I2C.
+// The resource and command ids are defined in host_control.h.
+// No include guard, the file is included once per use.
+
+VFCTRL_CMD(GET_VERSION, AP_CONTROL_RESID, TYPE_UINT32, AP_CONTROL_CMD_GET_VERSION, READ, 1, "CONTROL: get version")
+VFCTRL_CMD(GET_STATUS, AP_CONTROL_RESID, TYPE_UINT8, AP_CONTROL_CMD_GET_STATUS, READ, 1, "CONTROL: get status")
+VFCTRL_CMD(GET_DELAY_SAMPLES, AP_CONTROL_RESID, TYPE_UINT32, AP_CONTROL_CMD_GET_DELAY_SAMPLES, READ, 1, "CONTROL: get configurable delay in samples")
+VFCTRL_CMD(GET_BLD_MSG, AP_CONTROL_RESID, TYPE_UINT8, AP_CONTROL_CMD_GET_BLD_MSG, READ, BLD_MSG_LEN, "CONTROL: get build message")
+VFCTRL_CMD(GET_BLD_HOST, AP_CONTROL_RESID, TYPE_UINT8, AP_CONTROL_CMD_GET_BLD_HOST, READ, BLD_HOST_LEN, "CONTROL: get build host")
+VFCTRL_CMD(GET_BLD_REPO_HASH, AP_CONTROL_RESID, TYPE_UINT8, AP_CONTROL_CMD_GET_BLD_REPO_HASH, READ, BLD_REPO_HASH_LEN, "CONTROL: get repo hash")
+VFCTRL_CMD(GET_BLD_XGIT_VIEW, AP_CONTROL_RESID, TYPE_UINT8, AP_CONTROL_CMD_GET_BLD_XGIT_VIEW, READ, BLD_XGIT_VIEW_LEN, "CONTROL: get xgit view")
+VFCTRL_CMD(GET_BLD_XGIT_HASH, AP_CONTROL_RESID, TYPE_UINT8, AP_CONTROL_CMD_GET_BLD_XGIT_HASH, READ, BLD_XGIT_HASH_LEN, "CONTROL: get xgit hash")
+VFCTRL_CMD(GET_BLD_MODIFIED, AP_CONTROL_RESID, TYPE_UINT8, AP_CONTROL_CMD_GET_BLD_MODIFIED, READ, BLD_MODIFIED_LEN, "CONTROL: get build modified from given view/hash")
+VFCTRL_CMD_NOT_I2C(GET_I2C, GPIO_RESID, TYPE_UINT8, GPIO_CMD_GET_I2C, READ, I2C_MAX_CMD_SIZE, "GPIO: Read from an I2C device connected to the xvf device")
+VFCTRL_CMD_NOT_I2C(GET_I2C_WITH_REG, GPIO_RESID, TYPE_UINT8, GPIO_CMD_GET_I2C_WITH_REG, READ, I2C_MAX_CMD_SIZE, "GPIO: Read from the register of an I2C device connected to the xvf device")
+VFCTRL_CMD_NOT_I2C(GET_I2C_READ_HEADER, GPIO_RESID, TYPE_UINT8, GPIO_CMD_GET_I2C_READ_HEADER, READ, 3, "GPIO: Get the address, register address, and count of next I2C read")
+VFCTRL_CMD_NOT_I2C(SET_I2C, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_I2C, WRITE, I2C_MAX_CMD_SIZE, "GPIO: Write to an I2C device connected to the xvf device")
+VFCTRL_CMD_NOT_I2C(SET_I2C_WITH_REG, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_I2C_WITH_REG, WRITE, I2C_MAX_CMD_SIZE, "GPIO: Write to the register of an I2C device connected to the xvf device")
+VFCTRL_CMD_NOT_I2C(SET_I2C_READ_HEADER, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_I2C_READ_HEADER, WRITE, 3, "GPIO: Set address, register address, and count of next I2C read")
+
+VFCTRL_CMD(GET_SPI, GPIO_RESID, TYPE_UINT8, GPIO_CMD_GET_SPI, READ, SPI_READ_BUF_SIZE, "GPIO: Gets the contents of the SPI read buffer")
+VFCTRL_CMD(GET_SPI_READ_HEADER, GPIO_RESID, TYPE_UINT8, GPIO_CMD_GET_SPI_READ_HEADER, READ, 2, "GPIO: Get the address and count of next SPI read")
+VFCTRL_CMD(SET_SPI_PUSH, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_SPI_PUSH, WRITE, SPI_MAX_CMD_SIZE, "GPIO: Push SPI command data onto the execution queue")
+VFCTRL_CMD(SET_SPI_PUSH_AND_EXEC, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_SPI_PUSH_AND_EXEC, WRITE, SPI_MAX_CMD_SIZE, "GPIO: Push SPI command data and execute the command from the stack")
+VFCTRL_CMD(SET_SPI_READ_HEADER, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_SPI_READ_HEADER, WRITE, 2, "GPIO: Set address and count of next SPI read")
+
+VFCTRL_CMD(GET_GPI_PORT, GPIO_RESID, TYPE_UINT32, GPIO_CMD_GET_GPI_PORT, READ, 1, "GPIO: Read current state of the selected GPIO port")
+VFCTRL_CMD(GET_GPI_PIN, GPIO_RESID, TYPE_UINT32, GPIO_CMD_GET_GPI_PIN, READ, 1, "GPIO: Read current state of the selected GPIO pin")
+VFCTRL_CMD(GET_GPI_INT_PENDING_PIN, GPIO_RESID, TYPE_UINT32, GPIO_CMD_GET_GPI_INT_PENDING_PIN, READ, 1, "GPIO: Read whether interrupt was triggered for selected pin")
+VFCTRL_CMD(GET_GPI_INT_PENDING_PORT, GPIO_RESID, TYPE_UINT32, GPIO_CMD_GET_GPI_INT_PENDING_PORT, READ, 1, "GPIO: Read whether interrupt was triggered for all pins on selected port")
+VFCTRL_CMD(GET_KWD_HID_EVENT_CNT, GPIO_RESID, TYPE_UINT32, GPIO_CMD_GET_KWD_HID_EVENT_CNT, READ, 1, "GPIO: read number of KWD HID events detected")
+VFCTRL_CMD(SET_KWD_HID_EVENT_CNT, GPIO_RESID, TYPE_UINT32, GPIO_CMD_SET_KWD_HID_EVENT_CNT, WRITE, 1, "GPIO: write number of KWD HID events detected")
+VFCTRL_CMD(SET_GPO_PORT, GPIO_RESID, TYPE_UINT32, GPIO_CMD_SET_GPO_PORT, WRITE, 2, "GPIO: Write to all pins of a GPIO port")
+VFCTRL_CMD(SET_GPO_PIN, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_GPO_PIN, WRITE, 3, "GPIO: Write to a specific GPIO pin")
+VFCTRL_CMD(SET_GPO_PIN_ACTIVE_LEVEL, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_GPO_PIN_ACTIVE_LEVEL, WRITE, 3, "GPIO: Set the active level for a specific GPO pin. 0: active low, 1: active high")
+VFCTRL_CMD(SET_GPI_PIN_ACTIVE_LEVEL, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_GPI_PIN_ACTIVE_LEVEL, WRITE, 3, "GPIO: Set the active level for a specific GPI pin. 0: active low, 1: active high")
+VFCTRL_CMD(SET_GPI_INT_CONFIG, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_GPI_INT_CONFIG, WRITE, 3, "GPIO: Sets the interrupt config for a specific pin")
+VFCTRL_CMD(SET_GPI_READ_HEADER, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_GPI_READ_HEADER, WRITE, 2, "GPIO: Sets the selected port and pin for the next GPIO read")
+VFCTRL_CMD(GET_GPI_READ_HEADER, GPIO_RESID, TYPE_UINT8, GPIO_CMD_GET_GPI_READ_HEADER, READ, 2, "GPIO: Gets the currently selected port and pin")
+VFCTRL_CMD(SET_GPO_PWM_DUTY, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_GPO_PWM_DUTY, WRITE, 3, "GPIO: Set the pwm duty for a specific pin. Value given as an integer percentage")
+VFCTRL_CMD(SET_GPO_FLASHING, GPIO_RESID, TYPE_UINT32, GPIO_CMD_SET_GPO_FLASHING, WRITE, 3, "GPIO: Set the serial flash mask for a specific pin. Each bit in the mask describes the GPO state for 100ms intervals")
+
+VFCTRL_CMD(GET_KWD_BOOT_STATUS, GPIO_RESID, TYPE_UINT8, GPIO_CMD_GET_KWD_BOOT_STATUS, READ, 1, "GPIO: Gets boot status for keyword detectors")
+VFCTRL_CMD(GET_RUN_STATUS, GPIO_RESID, TYPE_UINT8, GPIO_CMD_GET_RUN_STATUS, READ, 1, "GPIO: Gets run status for the device")
+VFCTRL_CMD(GET_IO_MAP_AND_SHIFT, GPIO_RESID, TYPE_UINT8, GPIO_CMD_GET_IO_MAP_AND_SHIFT, READ, NUM_IO_MAP_OUTPUTS*sizeof(io_map_and_output_shift_t), "Get IO map and output shift values for the device")
+VFCTRL_CMD(SET_IO_MAP, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_IO_MAP, WRITE, 2, "Set IO map for the device. arg1: dest(output_io_map_t), arg2: source(input_io_map_t)")
+
+VFCTRL_CMD(SET_FILTER_INDEX, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_FILTER_INDEX, WRITE, 1, "Set filter index. Selects which filter block will be read from/written to arg1: dest(filter_block_map_t)")
+VFCTRL_CMD(SET_FILTER_BYPASS, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_FILTER_BYPASS, WRITE, 1, "Set filter bypass state. arg1: 0 - filter enabled, 1 - bypassed")
+VFCTRL_CMD(SET_FILTER_COEFF, GPIO_RESID, TYPE_ENERGY, GPIO_CMD_SET_FILTER_COEFF, WRITE, NUM_FILTER_COEFFS, "Set biquad coeffs for a selected filter using floating point. arg1..10: 5x2 float coeffs in forward order (a1,a2,b0,b1,b2) where a0 always is 1.0")
+VFCTRL_CMD(SET_FILTER_COEFF_RAW, GPIO_RESID, TYPE_INT32, GPIO_CMD_SET_FILTER_COEFF, WRITE, NUM_FILTER_COEFFS, "Set raw biquad coeffs for a selected filters. arg1..10: 2 sets of coeffs in forward order (b0,b1,b2,-a1,-a2) signed Q28 format")
+
+VFCTRL_CMD(GET_FILTER_INDEX, GPIO_RESID, TYPE_UINT8, GPIO_CMD_GET_FILTER_INDEX, READ, 1, "Get filter index. Selects which filter block will be read from/written to")
+VFCTRL_CMD(GET_FILTER_BYPASS, GPIO_RESID, TYPE_UINT8, GPIO_CMD_GET_FILTER_BYPASS, READ, 1, "Get filter bypass state. 0 - filter enabled, 1 - bypassed")
+VFCTRL_CMD(GET_FILTER_COEFF, GPIO_RESID, TYPE_ENERGY, GPIO_CMD_GET_FILTER_COEFF, READ, NUM_FILTER_COEFFS, "Get biquad coeffs for a selected filter using floating point. arg1..10: 5x2 float coeffs in forward order (a1,a2,b0,b1,b2) where a0 always is 1.0")
+VFCTRL_CMD(GET_FILTER_COEFF_RAW, GPIO_RESID, TYPE_INT32, GPIO_CMD_GET_FILTER_COEFF, READ, NUM_FILTER_COEFFS, "Get raw biquad coeffs for a selected filters. arg1..10: 2 sets of coeffs in forward order (b0,b1,b2,-a1,-a2) signed Q28 format")
+
+VFCTRL_CMD(SET_OUTPUT_SHIFT, GPIO_RESID, TYPE_INT32, GPIO_CMD_SET_OUTPUT_SHIFT, WRITE, 2, "For a selected output(output_io_map_t), set the no. of bits the output samples will be shifted by. Postive shift value indicates left shift, negative indicates right shift")
+VFCTRL_CMD(GET_MAX_UBM_CYCLES, GPIO_RESID, TYPE_UINT32, GPIO_CMD_GET_MAX_UBM_CYCLES, READ, 1, "Get maximum no. of cycles taken by the user buffer management function")
+VFCTRL_CMD(RESET_MAX_UBM_CYCLES, GPIO_RESID, TYPE_UINT8, GPIO_CMD_RESET_MAX_UBM_CYCLES, WRITE, 1, "reset the max user buffer management cycles count")
+VFCTRL_CMD(GET_I2S_RATE, GPIO_RESID, TYPE_UINT32, GPIO_CMD_GET_I2S_RATE, READ, 1, "Get I2S rate")
+VFCTRL_CMD(SET_I2S_RATE, GPIO_RESID, TYPE_UINT32, GPIO_CMD_SET_I2S_RATE, WRITE, 1, "Set I2S rate. This command is only run from the flash. Run it only with -l option to generate what goes in the flash data-partition.")
+VFCTRL_CMD(SET_I2S_START_STATUS, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_I2S_START_STATUS, WRITE, 1, "Start I2S. This command is only run from the flash. Run it only with -l option to generate the json item to use in the flash data-partition")
+VFCTRL_CMD(GET_I2S_START_STATUS, GPIO_RESID, TYPE_UINT8, GPIO_CMD_GET_I2S_START_STATUS, READ, 1, "Get I2S start status")
+VFCTRL_CMD(GET_USB_VENDOR_ID, GPIO_RESID, TYPE_UINT32, GPIO_CMD_GET_USB_VENDOR_ID, READ, 1, "Get USB Vendor ID")
+VFCTRL_CMD(GET_USB_PRODUCT_ID, GPIO_RESID, TYPE_UINT32, GPIO_CMD_GET_USB_PRODUCT_ID, READ, 1, "Get USB Product ID")
+VFCTRL_CMD(GET_USB_BCD_DEVICE, GPIO_RESID, TYPE_UINT32, GPIO_CMD_GET_USB_BCD_DEVICE, READ, 1, "Get USB Device Release Number (bcdDevice)")
+VFCTRL_CMD(GET_USB_VENDOR_STRING, GPIO_RESID, TYPE_UINT8, GPIO_CMD_GET_USB_VENDOR_STRING, READ, USB_STR_MAX_BYTES, "Get USB Vendor string")
+VFCTRL_CMD(GET_USB_PRODUCT_STRING, GPIO_RESID, TYPE_UINT8, GPIO_CMD_GET_USB_PRODUCT_STRING, READ, USB_STR_MAX_BYTES, "Get USB Product string")
+VFCTRL_CMD(GET_SERIAL_NUMBER, GPIO_RESID, TYPE_UINT8, GPIO_CMD_GET_SERIAL_NUMBER, READ, USB_STR_MAX_BYTES, "Read serial number from USB descriptor (normally initialised from flash).")
+VFCTRL_CMD(GET_HARDWARE_BUILD, GPIO_RESID, TYPE_UINT32, GPIO_CMD_GET_HARDWARE_BUILD, READ, 1, "Get the build number from the hardware build section of the flash data partition.")
+
+VFCTRL_CMD(SET_USB_VENDOR_ID, GPIO_RESID, TYPE_UINT32, GPIO_CMD_SET_USB_VENDOR_ID, WRITE, 1, "Set USB Vendor ID. This command is only run from the flash. Run it only with -l option to generate the json item to use in the flash data-partition")
+VFCTRL_CMD(SET_USB_PRODUCT_ID, GPIO_RESID, TYPE_UINT32, GPIO_CMD_SET_USB_PRODUCT_ID, WRITE, 1, "Set USB Product ID. This command is only run from the flash. Run it only with -l option to generate the json item to use in the flash data-partition")
+VFCTRL_CMD(SET_USB_VENDOR_STRING, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_USB_VENDOR_STRING, WRITE, USB_STR_MAX_BYTES, "Set USB Vendor string. This command is only run from the flash. Run it only with -l option to generate the json item to use in the flash data-partition")
+VFCTRL_CMD(SET_USB_PRODUCT_STRING, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_USB_PRODUCT_STRING, WRITE, USB_STR_MAX_BYTES, "Set USB Product string. This command is only run from the flash. Run it only with -l option to generate the json item to use in the flash data-partition")
+VFCTRL_CMD(SET_SERIAL_NUMBER, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_SERIAL_NUMBER, WRITE, USB_STR_MAX_BYTES, "Program serial number to flash")
+VFCTRL_CMD(SET_USB_SERIAL_NUMBER, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_USB_SERIAL_NUMBER, WRITE, 1, "Load serial number from flash and initialise USB device descriptor with it. Will not work after boot since descriptor is populated only once, with USB start.")
+
+VFCTRL_CMD(SET_USB_BCD_DEVICE, GPIO_RESID, TYPE_UINT32, GPIO_CMD_SET_USB_BCD_DEVICE, WRITE, 1, "Set USB Device Release Number (bcdDevice)")
+VFCTRL_CMD_NOT_I2C(SET_USB_START_STATUS, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_USB_START_STATUS, WRITE, 1, "Start USB. This command is only run from the flash. Run it only with -l option to generate the json item to use in the flash data-partition")
+VFCTRL_CMD_NOT_I2C(GET_USB_START_STATUS, GPIO_RESID, TYPE_UINT8, GPIO_CMD_GET_USB_START_STATUS, READ, 1, "Get USB start status")
+VFCTRL_CMD(GET_USB_TO_DEVICE_RATE, GPIO_RESID, TYPE_UINT32, GPIO_CMD_GET_USB_TO_DEVICE_RATE, READ, 1, "Get USB to device rate")
+VFCTRL_CMD(GET_DEVICE_TO_USB_RATE, GPIO_RESID, TYPE_UINT32, GPIO_CMD_GET_DEVICE_TO_USB_RATE, READ, 1, "Get device to USB rate")
+VFCTRL_CMD(GET_USB_TO_DEVICE_BIT_RES, GPIO_RESID, TYPE_UINT32, GPIO_CMD_GET_USB_TO_DEVICE_BIT_RES, READ, 1, "Get USB to device bit resolution")
+VFCTRL_CMD(GET_DEVICE_TO_USB_BIT_RES, GPIO_RESID, TYPE_UINT32, GPIO_CMD_GET_DEVICE_TO_USB_BIT_RES, READ, 1, "Get device to USB bit resolution")
+VFCTRL_CMD(SET_USB_TO_DEVICE_RATE, GPIO_RESID, TYPE_UINT32, GPIO_CMD_SET_USB_TO_DEVICE_RATE, WRITE, 1, "Set USB to device rate")
+VFCTRL_CMD(SET_DEVICE_TO_USB_RATE, GPIO_RESID, TYPE_UINT32, GPIO_CMD_SET_DEVICE_TO_USB_RATE, WRITE, 1, "Set device to USB rate")
+VFCTRL_CMD(SET_USB_TO_DEVICE_BIT_RES, GPIO_RESID, TYPE_UINT32, GPIO_CMD_SET_USB_TO_DEVICE_BIT_RES, WRITE, 1, "Set USB to device bit resolution")
+VFCTRL_CMD(SET_DEVICE_TO_USB_BIT_RES, GPIO_RESID, TYPE_UINT32, GPIO_CMD_SET_DEVICE_TO_USB_BIT_RES, WRITE, 1, "Set device to USB bit resolution")
+
+VFCTRL_CMD(GET_MCLK_IN_TO_PDM_CLK_DIVIDER, GPIO_RESID, TYPE_UINT8, GPIO_CMD_GET_MCLK_IN_TO_PDM_CLK_DIVIDER, READ, 1, "Get XCore divider from input master clock to 6.144MHz DDR PDM microphone clock")
+VFCTRL_CMD(GET_SYS_CLK_TO_MCLK_OUT_DIVIDER, GPIO_RESID, TYPE_UINT8, GPIO_CMD_GET_SYS_CLK_TO_MCLK_OUT_DIVIDER, READ, 1, "Get XCore divider from system clock to output master clock")
+VFCTRL_CMD(SET_MCLK_IN_TO_PDM_CLK_DIVIDER, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_MCLK_IN_TO_PDM_CLK_DIVIDER, WRITE, 1, "Set XCore divider from input master clock to 6.144MHz DDR PDM microphone clock (when master clock is slaved). Run it only with -l option to generate the json item to use in the flash data-partition")
+VFCTRL_CMD(SET_SYS_CLK_TO_MCLK_OUT_DIVIDER, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_SYS_CLK_TO_MCLK_OUT_DIVIDER, WRITE, 1, "Set XCore divider from system clock to output master clock (where master clock output is used). Run it only with -l option to generate the json item to use in the flash data-partition")
+VFCTRL_CMD(GET_MIC_START_STATUS, GPIO_RESID, TYPE_UINT8, GPIO_CMD_GET_MIC_START_STATUS, READ, 1, "Get microphone client start status.")
+VFCTRL_CMD(SET_MIC_START_STATUS, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_MIC_START_STATUS, WRITE, 1, "Start microphone client (audio frontend).  This command is only run from the flash. Run it only with -l option to generate the json item to use in the flash data-partition")
+VFCTRL_CMD(SET_MONITOR_STATE_USING_GPO_ENABLED, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_MONITOR_STATE_USING_GPO_ENABLED, WRITE, 1, "enable monitoring of state on GPO. This command is only run from the flash. Run it only with -l option to generate the json item to use in the flash data-partition")
+VFCTRL_CMD(SET_KWD_INTERRUPT_PIN, GPIO_RESID, TYPE_UINT8, GPIO_CMD_SET_KWD_INTERRUPT_PIN, WRITE, 1, "set gpi pin index to receive kwd interrupt on")
+VFCTRL_CMD(GET_KWD_INTERRUPT_PIN, GPIO_RESID, TYPE_UINT8, GPIO_CMD_GET_KWD_INTERRUPT_PIN, READ, 1, "get gpi pin index to receive kwd interrupt on")
+
+VFCTRL_CMD(GET_BYPASS_AEC, AEC_RESID, TYPE_INT32, AEC_CMD_GET_BYPASS, READ, 1, "AEC: get bypass")
+VFCTRL_CMD(GET_X_ENERGY_DELTA_AEC, AEC_RESID, TYPE_ENERGY, AEC_CMD_GET_X_ENERGY_DELTA, READ, 1, "AEC: get X energy delta")
+VFCTRL_CMD(GET_X_ENERGY_GAMMA_LOG2_AEC, AEC_RESID, TYPE_INT32, AEC_CMD_GET_X_ENERGY_GAMMA_LOG2, READ, 1, "AEC: get X energy gamma log2")
+VFCTRL_CMD(GET_FORCED_MU_VALUE_AEC, AEC_RESID, TYPE_FIXED_1_31, AEC_CMD_GET_FORCED_MU_VALUE, READ, 1, "AEC: get forced mu value")
+VFCTRL_CMD(GET_ADAPTATION_CONFIG_AEC, AEC_RESID, TYPE_INT32, AEC_CMD_GET_ADAPTION_CONFIG, READ, 1, "AEC: get adaptation config")
+VFCTRL_CMD(GET_MU_SCALAR_AEC, AEC_RESID, TYPE_FIXED_8_24, AEC_CMD_GET_MU_SCALAR, READ, 1, "AEC: get mu_scalar")
+VFCTRL_CMD(GET_MU_LIMITS_AEC, AEC_RESID, TYPE_FIXED_1_31, AEC_CMD_GET_MU_LIMITS, READ, 2, "AEC: get mu_high and mu_low")
+VFCTRL_CMD(GET_SIGMA_ALPHAS_AEC, AEC_RESID, TYPE_UINT32, AEC_CMD_GET_SIGMA_ALPHAS, READ, 3, "AEC: get sigma alphas")
+VFCTRL_CMD(GET_ERLE_CH0_AEC, AEC_RESID, TYPE_ENERGY, AEC_CMD_GET_ERLE_CH0, READ, 2, "AEC: get channel 0 ERLE")
+VFCTRL_CMD(GET_ERLE_CH1_AEC, AEC_RESID, TYPE_ENERGY, AEC_CMD_GET_ERLE_CH1, READ, 2, "AEC: get channel 1 ERLE")
+VFCTRL_CMD(GET_FRAME_ADVANCE_AEC, AEC_RESID, TYPE_UINT32, AEC_CMD_GET_FRAME_ADVANCE, READ, 1, "AEC: get frame advance")
+VFCTRL_CMD(GET_Y_CHANNELS_AEC, AEC_RESID, TYPE_UINT32, AEC_CMD_GET_Y_CHANNELS, READ, 1, "AEC: get y channels")
+VFCTRL_CMD(GET_X_CHANNELS_AEC, AEC_RESID, TYPE_UINT32, AEC_CMD_GET_X_CHANNELS, READ, 1, "AEC: get x channels")
+VFCTRL_CMD(GET_X_CHANNEL_PHASES_AEC, AEC_RESID, TYPE_UINT8, AEC_CMD_GET_X_CHANNEL_PHASES, READ, AEC_MAX_X_CHANNELS, "AEC: get x channel phases")
+VFCTRL_CMD(GET_F_BIN_COUNT_AEC, AEC_RESID, TYPE_UINT32, AEC_CMD_GET_F_BIN_COUNT, READ, 1, "AEC: get f bin count")
+VFCTRL_CMD(GET_FILTER_COEFFICIENTS_AEC, AEC_RESID, TYPE_INT32, AEC_CMD_GET_FILTER_COEFFICIENTS, READ, AEC_COEFFICIENT_CHUNK_SIZE/sizeof(uint32_t), "AEC: get filter coefficients")
+VFCTRL_CMD(GET_COEFF_INDEX_AEC, AEC_RESID, TYPE_UINT32, AEC_CMD_GET_COEFFICIENT_INDEX, READ, 1, "AEC: get coefficient index")
+VFCTRL_CMD(GET_CH1_BEAMFORM_ENABLE, IC_RESID, TYPE_UINT8, IC_CMD_GET_CH1_BEAMFORM_ENABLE, READ, 1, "get if beamforming is enabled on channel1. default:enable")
+
+VFCTRL_CMD(GET_DELAY_ESTIMATOR_ENABLED, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_GET_DELAY_ESTIMATOR_ENABLED, READ, 1, "CONTROL: enable/disable delay estimation")
+VFCTRL_CMD(GET_DELAY_ESTIMATE, AP_STAGE_A_RESID, TYPE_INT32, AP_STAGE_A_CMD_GET_DELAY_ESTIMATE, READ, 1, "CONTROL: get delay estimate")
+VFCTRL_CMD(GET_DELAY_DIRECTION, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_GET_DELAY_DIRECTION, READ, 1, "CONTROL: get configurable delay direction: 0: delay references, 1: delay mics")
+VFCTRL_CMD(GET_MIC_SHIFT_SATURATE, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_GET_MIC_SHIFT_SATURATE, READ, 2, "CONTROL: get the shift value and saturation (1=enable) to be applied to the input mic samples")
+VFCTRL_CMD(GET_ALT_ARCH_ENABLED, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_GET_ALT_ARCH_ENABLED, READ, 1, "stage A: Get state of xvf3510 alternate architecture setting: 0: normal, 1: alt-arch")
+
+VFCTRL_CMD(GET_ADEC_ENABLED, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_GET_ADEC_ENABLED, READ, 1, "stage A: get automatic delay estimator controller enabled: 0: off, 1: on")
+VFCTRL_CMD(GET_ADEC_MODE, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_GET_ADEC_MODE, READ, 1, "stage A: get automatic delay estimator controller mode: 0: normal AEC mode, 1: delay estimation mode")
+VFCTRL_CMD(GET_ADEC_TIME_SINCE_RESET, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_GET_ADEC_TIME_SINCE_RESET, READ, 1, "stage A: get time in milliseconds since last automatic delay change by ADEC")
+VFCTRL_CMD(GET_AGM, AP_STAGE_A_RESID, TYPE_FIXED_7_24, AP_STAGE_A_CMD_GET_AGM, READ, 1, "stage A: get AEC Goodness Metric estimate (0.0 - 1.0")
+VFCTRL_CMD(GET_ERLE_BAD_BITS, AP_STAGE_A_RESID, TYPE_FIXED_7_24, AP_STAGE_A_CMD_GET_ERLE_BAD_BITS, READ, 1, "stage A: get ERLE bad threshold in bits (log2)")
+VFCTRL_CMD(GET_ERLE_GOOD_BITS, AP_STAGE_A_RESID, TYPE_FIXED_7_24, AP_STAGE_A_CMD_GET_ERLE_GOOD_BITS, READ, 1, "stage A: get ERLE good threshold in bits (log2)")
+VFCTRL_CMD(GET_PEAK_PHASE_ENERGY_TREND_GAIN, AP_STAGE_A_RESID, TYPE_FIXED_7_24, AP_STAGE_A_CMD_GET_PEAK_PHASE_ENERGY_TREND_GAIN, READ, 1, "stage A: get value which sets AGM sensitivity to peak phase energy slope")
+VFCTRL_CMD(GET_ERLE_BAD_GAIN, AP_STAGE_A_RESID, TYPE_FIXED_7_24, AP_STAGE_A_CMD_GET_ERLE_BAD_GAIN, READ, 1, "stage A: set how steeply AGM drops off when ERLE below threshold")
+VFCTRL_CMD(GET_ADEC_FAR_THRESHOLD, AP_STAGE_A_RESID, TYPE_ENERGY, AP_STAGE_A_CMD_GET_ADEC_FAR_THRESHOLD, READ, 1, "stage A: get far signal energy threshold above which we update AGM")
+VFCTRL_CMD(GET_AEC_PEAK_TO_AVERAGE_RATIO, AP_STAGE_A_RESID, TYPE_ENERGY, AP_STAGE_A_CMD_GET_AEC_PEAK_TO_AVERAGE_RATIO, READ, 1, "stage A: get AEC coefficients peak to average ratio")
+VFCTRL_CMD(GET_PHASE_POWERS, AP_STAGE_A_RESID, TYPE_ENERGY, AP_STAGE_A_CMD_GET_PHASE_POWERS, READ, ADEC_READ_PHASE_POWER_CHUNK_SIZE/sizeof(uint32_t)/2, "stage A: get 5 phase powers (240 samples per phase) used in delay estimation from the index set.")
+VFCTRL_CMD(GET_PHASE_POWER_INDEX, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_GET_PHASE_POWER_INDEX, READ, 1, "stage A: get GERLE gain (how strongly it responds either side of mid point)")
+VFCTRL_CMD(GET_LOCKER_ENABLED, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_GET_LOCKER_ENABLED, READ, 1, "stage A: get locker delay detection and control enabled enabled: 0: off, 1: on")
+
+VFCTRL_CMD(GET_LOCKER_STATE, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_GET_LOCKER_STATE, READ, 1, "stage A: get locker state")
+VFCTRL_CMD(GET_MIN_RX_TIME_STAGE_A, AP_STAGE_A_RESID, TYPE_TICKS, AP_STAGE_A_CMD_GET_MIN_TIME_RX, READ, 1, "stage A min rx time per frame")
+VFCTRL_CMD(GET_MAX_RX_TIME_STAGE_A, AP_STAGE_A_RESID, TYPE_TICKS, AP_STAGE_A_CMD_GET_MAX_TIME_RX, READ, 1, "stage A max rx time per frame")
+VFCTRL_CMD(GET_MIN_CONTROL_TIME_STAGE_A, AP_STAGE_A_RESID, TYPE_TICKS, AP_STAGE_A_CMD_GET_MIN_TIME_CONTROL, READ, 1, "stage A min control time per frame")
+VFCTRL_CMD(GET_MAX_CONTROL_TIME_STAGE_A, AP_STAGE_A_RESID, TYPE_TICKS, AP_STAGE_A_CMD_GET_MAX_TIME_CONTROL, READ, 1, "stage A max control time per frame")
+VFCTRL_CMD(GET_MIN_DSP_TIME_STAGE_A, AP_STAGE_A_RESID, TYPE_TICKS, AP_STAGE_A_CMD_GET_MIN_TIME_DSP, READ, 1, "stage A min dsp time per frame")
+VFCTRL_CMD(GET_MAX_DSP_TIME_STAGE_A, AP_STAGE_A_RESID, TYPE_TICKS, AP_STAGE_A_CMD_GET_MAX_TIME_DSP, READ, 1, "stage A max dsp time per frame")
+VFCTRL_CMD(GET_MIN_TX_TIME_STAGE_A, AP_STAGE_A_RESID, TYPE_TICKS, AP_STAGE_A_CMD_GET_MIN_TIME_TX, READ, 1, "stage A min tx time per frame")
+VFCTRL_CMD(GET_MAX_TX_TIME_STAGE_A, AP_STAGE_A_RESID, TYPE_TICKS, AP_STAGE_A_CMD_GET_MAX_TIME_TX, READ, 1, "stage A max tx time per frame")
+VFCTRL_CMD(GET_MIN_IDLE_TIME_STAGE_A, AP_STAGE_A_RESID, TYPE_TICKS, AP_STAGE_A_CMD_GET_MIN_TIME_IDLE, READ, 1, "stage A min idle time per frame")
+VFCTRL_CMD(GET_MAX_IDLE_TIME_STAGE_A, AP_STAGE_A_RESID, TYPE_TICKS, AP_STAGE_A_CMD_GET_MAX_TIME_IDLE, READ, 1, "stage A max idle time per frame")
+
+VFCTRL_CMD(GET_LOCKER_NUM_BAD_FRAMES_THRESHOLD, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_GET_LOCKER_NUM_BAD_FRAMES_THRESHOLD, READ, 1, "stage A: get no. of bad peak to avg erle frames that locker sees before it triggers adec. Default: 666")
+VFCTRL_CMD(GET_LOCKER_DELAY_SETPOINT_ENABLED, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_GET_LOCKER_DELAY_SETPOINT_ENABLED, READ, 1, "Get delay setpoint enabled")
+VFCTRL_CMD(GET_LOCKER_DELAY_SETPOINT_SAMPLES, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_GET_LOCKER_DELAY_SETPOINT_SAMPLES, READ, 1, "Get delay setpoint samples")
+VFCTRL_CMD(GET_LOCKER_DELAY_SETPOINT_DIRECTION, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_GET_LOCKER_DELAY_SETPOINT_DIRECTION, READ, 1, "Get delay setpoint direction")
+VFCTRL_CMD(GET_ADEC_PEAK_TO_AVERAGE_GOOD_AEC, AP_STAGE_A_RESID, TYPE_ENERGY, AP_STAGE_A_CMD_GET_ADEC_PEAK_TO_AVERAGE_GOOD_AEC, READ, 1, "stage A: get the peak to average ratio that is considered good when in normal AEC mode")
+
+VFCTRL_CMD(SET_LOCKER_NUM_BAD_FRAMES_THRESHOLD, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_SET_LOCKER_NUM_BAD_FRAMES_THRESHOLD, WRITE, 1, "stage A: set no. of bad peak to avg erle frames that locker sees before it triggers adec. Default: 666")
+VFCTRL_CMD(SET_LOCKER_DELAY_SETPOINT_ENABLED, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_SET_LOCKER_DELAY_SETPOINT_ENABLED, WRITE, 1, "Set delay setpoint enabled")
+VFCTRL_CMD(SET_LOCKER_DELAY_SETPOINT_SAMPLES, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_SET_LOCKER_DELAY_SETPOINT_SAMPLES, WRITE, 1, "Set delay setpoint samples")
+VFCTRL_CMD(SET_LOCKER_DELAY_SETPOINT_DIRECTION, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_SET_LOCKER_DELAY_SETPOINT_DIRECTION, WRITE, 1, "Set delay setpoint direction")
+VFCTRL_CMD(SET_ADEC_PEAK_TO_AVERAGE_GOOD_AEC, AP_STAGE_A_RESID, TYPE_ENERGY, AP_STAGE_A_CMD_SET_ADEC_PEAK_TO_AVERAGE_GOOD_AEC, WRITE, 1, "stage A: set the peak to average ratio that is considered good when in normal AEC mode")
+
+VFCTRL_CMD(GET_MIN_RX_TIME_STAGE_B, AP_STAGE_B_RESID, TYPE_TICKS, AP_STAGE_B_CMD_GET_MIN_TIME_RX, READ, 1, "stage B min rx time per frame")
+VFCTRL_CMD(GET_MAX_RX_TIME_STAGE_B, AP_STAGE_B_RESID, TYPE_TICKS, AP_STAGE_B_CMD_GET_MAX_TIME_RX, READ, 1, "stage B max rx time per frame")
+VFCTRL_CMD(GET_MIN_CONTROL_TIME_STAGE_B, AP_STAGE_B_RESID, TYPE_TICKS, AP_STAGE_B_CMD_GET_MIN_TIME_CONTROL, READ, 1, "stage B min control time per frame")
+VFCTRL_CMD(GET_MAX_CONTROL_TIME_STAGE_B, AP_STAGE_B_RESID, TYPE_TICKS, AP_STAGE_B_CMD_GET_MAX_TIME_CONTROL, READ, 1, "stage B max control time per frame")
+VFCTRL_CMD(GET_MIN_DSP_TIME_STAGE_B, AP_STAGE_B_RESID, TYPE_TICKS, AP_STAGE_B_CMD_GET_MIN_TIME_DSP, READ, 1, "stage B min dsp time per frame")
+VFCTRL_CMD(GET_MAX_DSP_TIME_STAGE_B, AP_STAGE_B_RESID, TYPE_TICKS, AP_STAGE_B_CMD_GET_MAX_TIME_DSP, READ, 1, "stage B max dsp time per frame")
+VFCTRL_CMD(GET_MIN_TX_TIME_STAGE_B, AP_STAGE_B_RESID, TYPE_TICKS, AP_STAGE_B_CMD_GET_MIN_TIME_TX, READ, 1, "stage B min tx time per frame")
+VFCTRL_CMD(GET_MAX_TX_TIME_STAGE_B, AP_STAGE_B_RESID, TYPE_TICKS, AP_STAGE_B_CMD_GET_MAX_TIME_TX, READ, 1, "stage B max tx time per frame")
+VFCTRL_CMD(GET_MIN_IDLE_TIME_STAGE_B, AP_STAGE_B_RESID, TYPE_TICKS, AP_STAGE_B_CMD_GET_MIN_TIME_IDLE, READ, 1, "stage B min idle time per frame")
+VFCTRL_CMD(GET_MAX_IDLE_TIME_STAGE_B, AP_STAGE_B_RESID, TYPE_TICKS, AP_STAGE_B_CMD_GET_MAX_TIME_IDLE, READ, 1, "stage B max idle time per frame")
+
+VFCTRL_CMD(GET_MIN_RX_TIME_STAGE_C, AP_STAGE_C_RESID, TYPE_TICKS, AP_STAGE_C_CMD_GET_MIN_TIME_RX, READ, 1, "stage C min rx time per frame")
+VFCTRL_CMD(GET_MAX_RX_TIME_STAGE_C, AP_STAGE_C_RESID, TYPE_TICKS, AP_STAGE_C_CMD_GET_MAX_TIME_RX, READ, 1, "stage C max rx time per frame")
+VFCTRL_CMD(GET_MIN_CONTROL_TIME_STAGE_C, AP_STAGE_C_RESID, TYPE_TICKS, AP_STAGE_C_CMD_GET_MIN_TIME_CONTROL, READ, 1, "stage C min control time per frame")
+VFCTRL_CMD(GET_MAX_CONTROL_TIME_STAGE_C, AP_STAGE_C_RESID, TYPE_TICKS, AP_STAGE_C_CMD_GET_MAX_TIME_CONTROL, READ, 1, "stage C max control time per frame")
+VFCTRL_CMD(GET_MIN_DSP_TIME_STAGE_C, AP_STAGE_C_RESID, TYPE_TICKS, AP_STAGE_C_CMD_GET_MIN_TIME_DSP, READ, 1, "stage C min dsp time per frame")
+VFCTRL_CMD(GET_MAX_DSP_TIME_STAGE_C, AP_STAGE_C_RESID, TYPE_TICKS, AP_STAGE_C_CMD_GET_MAX_TIME_DSP, READ, 1, "stage C max dsp time per frame")
+VFCTRL_CMD(GET_MIN_TX_TIME_STAGE_C, AP_STAGE_C_RESID, TYPE_TICKS, AP_STAGE_C_CMD_GET_MIN_TIME_TX, READ, 1, "stage C min tx time per frame")
+VFCTRL_CMD(GET_MAX_TX_TIME_STAGE_C, AP_STAGE_C_RESID, TYPE_TICKS, AP_STAGE_C_CMD_GET_MAX_TIME_TX, READ, 1, "stage C max tx time per frame")
+VFCTRL_CMD(GET_MIN_IDLE_TIME_STAGE_C, AP_STAGE_C_RESID, TYPE_TICKS, AP_STAGE_C_CMD_GET_MIN_TIME_IDLE, READ, 1, "stage C min idle time per frame")
+VFCTRL_CMD(GET_MAX_IDLE_TIME_STAGE_C, AP_STAGE_C_RESID, TYPE_TICKS, AP_STAGE_C_CMD_GET_MAX_TIME_IDLE, READ, 1, "stage C max idle time per frame")
+VFCTRL_CMD(GET_GAIN_CH0_AGC, AGC_RESID, TYPE_FIXED_16_16, AGC_CMD_GET_GAIN, READ, 1, "get gain for channel 0")
+VFCTRL_CMD(GET_GAIN_CH1_AGC, AGC_RESID, TYPE_FIXED_16_16, AGC_CMD_GET_GAIN, READ, 1, "get gain for channel 1")
+VFCTRL_CMD(GET_MAX_GAIN_CH0_AGC, AGC_RESID, TYPE_FIXED_16_16, AGC_CMD_GET_MAX_GAIN, READ, 1, "get max gain for channel 0")
+VFCTRL_CMD(GET_MAX_GAIN_CH1_AGC, AGC_RESID, TYPE_FIXED_16_16, AGC_CMD_GET_MAX_GAIN, READ, 1, "get max gain for channel 1")
+VFCTRL_CMD(GET_MIN_GAIN_CH0_AGC, AGC_RESID, TYPE_FIXED_16_16, AGC_CMD_GET_MIN_GAIN, READ, 1, "get min gain for channel 0")
+VFCTRL_CMD(GET_MIN_GAIN_CH1_AGC, AGC_RESID, TYPE_FIXED_16_16, AGC_CMD_GET_MIN_GAIN, READ, 1, "get min gain for channel 1")
+VFCTRL_CMD(GET_UPPER_THRESHOLD_CH0_AGC, AGC_RESID, TYPE_FIXED_1_31, AGC_CMD_GET_DESIRED_UPPER_THRESHOLD, READ, 1, "get upper threshold of desired level for channel 0")
+VFCTRL_CMD(GET_UPPER_THRESHOLD_CH1_AGC, AGC_RESID, TYPE_FIXED_1_31, AGC_CMD_GET_DESIRED_UPPER_THRESHOLD, READ, 1, "get upper threshold of desired level for channel 1")
+VFCTRL_CMD(GET_LOWER_THRESHOLD_CH0_AGC, AGC_RESID, TYPE_FIXED_1_31, AGC_CMD_GET_DESIRED_LOWER_THRESHOLD, READ, 1, "get lower threshold of desired level for channel 0")
+VFCTRL_CMD(GET_LOWER_THRESHOLD_CH1_AGC, AGC_RESID, TYPE_FIXED_1_31, AGC_CMD_GET_DESIRED_LOWER_THRESHOLD, READ, 1, "get lower threshold of desired level for channel 1")
+VFCTRL_CMD(GET_ADAPT_CH0_AGC, AGC_RESID, TYPE_UINT32, AGC_CMD_GET_ADAPT, READ, 1, "get AGC adaptation for channel 0")
+VFCTRL_CMD(GET_ADAPT_CH1_AGC, AGC_RESID, TYPE_UINT32, AGC_CMD_GET_ADAPT, READ, 1, "get AGC adaptation for channel 1")
+VFCTRL_CMD(GET_ADAPT_ON_VAD_CH0_AGC, AGC_RESID, TYPE_UINT32, AGC_CMD_GET_ADAPT_ON_VAD, READ, 1, "get AGC adaptation using VAD data for channel 0")
+VFCTRL_CMD(GET_ADAPT_ON_VAD_CH1_AGC, AGC_RESID, TYPE_UINT32, AGC_CMD_GET_ADAPT_ON_VAD, READ, 1, "get AGC adaptation using VAD data for channel 1")
+
+VFCTRL_CMD(GET_SOFT_CLIPPING_CH0_AGC, AGC_RESID, TYPE_UINT32, AGC_CMD_GET_SOFT_CLIPPING, READ, 1, "get AGC soft clipping for channel 0")
+VFCTRL_CMD(GET_SOFT_CLIPPING_CH1_AGC, AGC_RESID, TYPE_UINT32, AGC_CMD_GET_SOFT_CLIPPING, READ, 1, "get AGC soft clipping  for channel 1")
+VFCTRL_CMD(GET_LC_ENABLED_CH0_AGC, AGC_RESID, TYPE_UINT32, AGC_CMD_GET_LC_ENABLED, READ, 1, "get loss control enable for channel 0")
+VFCTRL_CMD(GET_LC_ENABLED_CH1_AGC, AGC_RESID, TYPE_UINT32, AGC_CMD_GET_LC_ENABLED, READ, 1, "get loss control enable for channel 1")
+
+VFCTRL_CMD(GET_INCREMENT_GAIN_STEPSIZE_CH0_AGC, AGC_RESID, TYPE_FIXED_16_16, AGC_CMD_GET_GAIN_INCREMENT_STEPSIZE, READ, 1, "get stepsize with which gain is incremented for AGC ch0")
+VFCTRL_CMD(GET_INCREMENT_GAIN_STEPSIZE_CH1_AGC, AGC_RESID, TYPE_FIXED_16_16, AGC_CMD_GET_GAIN_INCREMENT_STEPSIZE, READ, 1, "get stepsize with which gain is incremented for AGC ch1")
+VFCTRL_CMD(GET_DECREMENT_GAIN_STEPSIZE_CH0_AGC, AGC_RESID, TYPE_FIXED_16_16, AGC_CMD_GET_GAIN_DECREMENT_STEPSIZE, READ, 1, "get stepsize with which gain is decremented for AGC ch0")
+VFCTRL_CMD(GET_DECREMENT_GAIN_STEPSIZE_CH1_AGC, AGC_RESID, TYPE_FIXED_16_16, AGC_CMD_GET_GAIN_DECREMENT_STEPSIZE, READ, 1, "get stepsize with which gain is decremented for AGC ch1")
+
+VFCTRL_CMD(GET_BYPASS_IC, IC_RESID, TYPE_INT32, IC_CMD_GET_BYPASS, READ, 1, "IC: get bypass state")
+VFCTRL_CMD(GET_X_ENERGY_DELTA_IC, IC_RESID, TYPE_ENERGY, IC_CMD_GET_X_ENERGY_DELTA, READ, 1, "IC: get X energy delta")
+VFCTRL_CMD(GET_X_ENERGY_GAMMA_LOG2_IC, IC_RESID, TYPE_UINT32, IC_CMD_GET_X_ENERGY_GAMMA_LOG2, READ, 1, "IC: get X energy gamma log2")
+VFCTRL_CMD(GET_FORCED_MU_VALUE_IC, IC_RESID, TYPE_FIXED_1_31, IC_CMD_GET_FORCED_MU_VALUE, READ, 1, "IC: get forced mu value")
+VFCTRL_CMD(GET_ADAPTATION_CONFIG_IC, IC_RESID, TYPE_INT32, IC_CMD_GET_ADAPTION_CONFIG, READ, 1, "IC: get adaptation config")
+VFCTRL_CMD(GET_SIGMA_ALPHA_IC, IC_RESID, TYPE_UINT32, IC_CMD_GET_SIGMA_ALPHA, READ, 1, "IC: get adaptation config")
+VFCTRL_CMD(GET_PHASES_IC, IC_RESID, TYPE_UINT32, IC_CMD_GET_PHASES, READ, 1, "IC: get phases")
+VFCTRL_CMD(GET_PROC_FRAME_BINS_IC, IC_RESID, TYPE_UINT32, IC_CMD_GET_PROC_FRAME_BINS, READ, 1, "IC: get proc frame bins")
+VFCTRL_CMD(GET_FILTER_COEFFICIENTS_IC, IC_RESID, TYPE_UINT32, IC_CMD_GET_FILTER_COEFFICIENTS, READ, IC_COEFFICIENT_CHUNK_SIZE/sizeof(uint32_t), "IC: get filter coefficients")
+VFCTRL_CMD(GET_COEFFICIENT_INDEX_IC, IC_RESID, TYPE_UINT32, IC_CMD_GET_COEFFICIENT_INDEX, READ, 1, "IC: get coefficient index")
+
+VFCTRL_CMD(GET_BYPASS_SUP, SUP_RESID, TYPE_INT32, SUP_CMD_GET_BYPASS, READ, 1, "SUP: get bypass")
+VFCTRL_CMD(GET_ENABLED_AES, SUP_RESID, TYPE_INT32, SUP_CMD_GET_ECHO_SUPPRESSION_ENABLED, READ, 1, "SUP: get echo suppresion enabled")
+VFCTRL_CMD(GET_ENABLED_NS, SUP_RESID, TYPE_INT32, SUP_CMD_GET_NOISE_SUPPRESSION_ENABLED, READ, 1, "SUP: get noise suppresion enabled")
+VFCTRL_CMD(GET_NOISE_FLOOR_NS, SUP_RESID, TYPE_FIXED_0_32, SUP_CMD_GET_NOISE_MCRA_NOISE_FLOOR, READ, 1, "SUP: get noise suppression noise floor")
+
+VFCTRL_CMD(SET_BYPASS_AEC, AEC_RESID, TYPE_INT32, AEC_CMD_SET_BYPASS, WRITE, 1, "AEC: set bypass")
+VFCTRL_CMD(SET_X_ENERGY_DELTA_AEC, AEC_RESID, TYPE_ENERGY, AEC_CMD_SET_X_ENERGY_DELTA, WRITE, 1, "AEC: set X energy delta")
+VFCTRL_CMD(SET_X_ENERGY_GAMMA_LOG2_AEC, AEC_RESID, TYPE_INT32, AEC_CMD_SET_X_ENERGY_GAMMA_LOG2, WRITE, 1, "AEC: set X energy gamma log2")
+VFCTRL_CMD(SET_FORCED_MU_VALUE_AEC, AEC_RESID, TYPE_FIXED_1_31, AEC_CMD_SET_FORCED_MU_VALUE, WRITE, 1, "AEC: set forced mu value")
+VFCTRL_CMD(SET_ADAPTATION_CONFIG_AEC, AEC_RESID, TYPE_INT32, AEC_CMD_SET_ADAPTION_CONFIG, WRITE, 1, "AEC: set adaptation config")
+VFCTRL_CMD(SET_MU_SCALAR_AEC, AEC_RESID, TYPE_FIXED_8_24, AEC_CMD_SET_MU_SCALAR, WRITE, 1, "AEC: set mu_scalar")
+VFCTRL_CMD(SET_MU_LIMITS_AEC, AEC_RESID, TYPE_FIXED_1_31, AEC_CMD_SET_MU_LIMITS, WRITE, 2, "AEC: set mu_high and mu_low")
+VFCTRL_CMD(SET_SIGMA_ALPHAS_AEC, AEC_RESID, TYPE_UINT32, AEC_CMD_SET_SIGMA_ALPHAS, WRITE, 3, "AEC: set sigma alphas")
+VFCTRL_CMD(RESET_FILTER_AEC, AEC_RESID, TYPE_UINT8, AEC_CMD_RESET_FILTER, WRITE, 1, "AEC: reset filter")
+
+VFCTRL_CMD(SET_COEFF_INDEX_AEC, AEC_RESID, TYPE_UINT32, AEC_CMD_SET_COEFFICIENT_INDEX, WRITE, 1, "AEC: set coefficient index")
+
+VFCTRL_CMD(SET_DELAY_DIRECTION, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_SET_DELAY_DIRECTION, WRITE, 1, "set configurable delay direction: 0: delay references, 1: delay mics ")
+VFCTRL_CMD(SET_DELAY_SAMPLES, AP_CONTROL_RESID, TYPE_UINT32, AP_CONTROL_CMD_SET_DELAY_SAMPLES, WRITE, 1, "CONTROL: set configurable delay in samples")
+VFCTRL_CMD(SET_DELAY_ESTIMATOR_ENABLED, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_SET_DELAY_ESTIMATOR_ENABLED, WRITE, 1, "set delay estimator enabled")
+VFCTRL_CMD(SET_MIC_SHIFT_SATURATE, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_SET_MIC_SHIFT_SATURATE, WRITE, 2, "CONTROL: set the shift value and saturation (1=enable) to be applied to the input mic samples")
+VFCTRL_CMD(SET_ALT_ARCH_ENABLED, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_SET_ALT_ARCH_ENABLED, WRITE, 1, "stage A: Set state of xvf3510 alternate architecture setting: 0: normal, 1: alt-arch")
+
+VFCTRL_CMD(SET_ADEC_ENABLED, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_SET_ADEC_ENABLED, WRITE, 1, "set delay estimator controller enabled: 0: off, 1: on")
+VFCTRL_CMD(SET_MANUAL_ADEC_CYCLE_TRIGGER, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_SET_MANUAL_ADEC_CYCLE_TRIGGER, WRITE, 1, "trigger a delay estimate + delay configure cycle when 1 is written")
+VFCTRL_CMD(SET_ERLE_BAD_BITS, AP_STAGE_A_RESID, TYPE_FIXED_7_24, AP_STAGE_A_CMD_SET_ERLE_BAD_BITS, WRITE, 1, "set ERLE threshold at which AGM is decreased")
+VFCTRL_CMD(SET_ERLE_GOOD_BITS, AP_STAGE_A_RESID, TYPE_FIXED_7_24, AP_STAGE_A_CMD_SET_ERLE_GOOD_BITS, WRITE, 1, "set ERLE threshold at which AGM is increased")
+VFCTRL_CMD(SET_ERLE_BAD_GAIN, AP_STAGE_A_RESID, TYPE_FIXED_7_24, AP_STAGE_A_CMD_SET_ERLE_BAD_GAIN, WRITE, 1, "set how strongly AGM is updated when ERLE below threshold")
+VFCTRL_CMD(SET_PEAK_PHASE_ENERGY_TREND_GAIN, AP_STAGE_A_RESID, TYPE_FIXED_7_24, AP_STAGE_A_CMD_SET_PEAK_PHASE_ENERGY_TREND_GAIN, WRITE, 1, "set how strongly AGM is updated by the peak phase slope")
+VFCTRL_CMD(SET_ADEC_FAR_THRESHOLD, AP_STAGE_A_RESID, TYPE_ENERGY, AP_STAGE_A_CMD_SET_ADEC_FAR_THRESHOLD, WRITE, 1, "set energy threshold of far signal above which AGM is updated")
+VFCTRL_CMD(SET_PHASE_POWER_INDEX, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_SET_PHASE_POWER_INDEX, WRITE, 1, "set index for reading phase powers")
+VFCTRL_CMD(SET_LOCKER_ENABLED, AP_STAGE_A_RESID, TYPE_UINT32, AP_STAGE_A_CMD_SET_LOCKER_ENABLED, WRITE, 1, "stage A: set locker delay detection and control enabled enabled: 0: off, 1: on")
+
+VFCTRL_CMD(RESET_TIME_STAGE_A, AP_STAGE_A_RESID, TYPE_UINT8, AP_STAGE_A_CMD_RESET_TIME, WRITE, 1, "reset stage A frame time")
+VFCTRL_CMD(RESET_TIME_STAGE_B, AP_STAGE_B_RESID, TYPE_UINT8, AP_STAGE_B_CMD_RESET_TIME, WRITE, 1, "reset stage B frame time")
+VFCTRL_CMD(RESET_TIME_STAGE_C, AP_STAGE_C_RESID, TYPE_UINT8, AP_STAGE_C_CMD_RESET_TIME, WRITE, 1, "reset stage C frame time")
+
+VFCTRL_CMD(SET_GAIN_CH0_AGC, AGC_RESID, TYPE_FIXED_16_16, AGC_CMD_SET_GAIN, WRITE, 1, "set gain for channel 0")
+VFCTRL_CMD(SET_GAIN_CH1_AGC, AGC_RESID, TYPE_FIXED_16_16, AGC_CMD_SET_GAIN, WRITE, 1, "set gain for channel 1")
+VFCTRL_CMD(SET_MAX_GAIN_CH0_AGC, AGC_RESID, TYPE_FIXED_16_16, AGC_CMD_SET_MAX_GAIN, WRITE, 1, "set max gain for channel 0")
+VFCTRL_CMD(SET_MAX_GAIN_CH1_AGC, AGC_RESID, TYPE_FIXED_16_16, AGC_CMD_SET_MAX_GAIN, WRITE, 1, "set max gain for channel 1")
+VFCTRL_CMD(SET_MIN_GAIN_CH0_AGC, AGC_RESID, TYPE_FIXED_16_16, AGC_CMD_SET_MIN_GAIN, WRITE, 1, "set min gain for channel 0")
+VFCTRL_CMD(SET_MIN_GAIN_CH1_AGC, AGC_RESID, TYPE_FIXED_16_16, AGC_CMD_SET_MIN_GAIN, WRITE, 1, "set min gain for channel 1")
+VFCTRL_CMD(SET_UPPER_THRESHOLD_CH0_AGC, AGC_RESID, TYPE_FIXED_1_31, AGC_CMD_SET_DESIRED_UPPER_THRESHOLD, WRITE, 1, "set upper threshold of desired level for channel 0")
+VFCTRL_CMD(SET_UPPER_THRESHOLD_CH1_AGC, AGC_RESID, TYPE_FIXED_1_31, AGC_CMD_SET_DESIRED_UPPER_THRESHOLD, WRITE, 1, "set upper threshold of desired level for channel 1")
+VFCTRL_CMD(SET_LOWER_THRESHOLD_CH0_AGC, AGC_RESID, TYPE_FIXED_1_31, AGC_CMD_SET_DESIRED_LOWER_THRESHOLD, WRITE, 1, "set lower threshold of desired level for channel 0")
+VFCTRL_CMD(SET_LOWER_THRESHOLD_CH1_AGC, AGC_RESID, TYPE_FIXED_1_31, AGC_CMD_SET_DESIRED_LOWER_THRESHOLD, WRITE, 1, "set lower threshold of desired level for channel 1")
+VFCTRL_CMD(SET_ADAPT_CH0_AGC, AGC_RESID, TYPE_UINT32, AGC_CMD_SET_ADAPT, WRITE, 1, "set AGC adaptation for channel 0")
+VFCTRL_CMD(SET_ADAPT_CH1_AGC, AGC_RESID, TYPE_UINT32, AGC_CMD_SET_ADAPT, WRITE, 1, "set AGC adaptation for channel 1")
+VFCTRL_CMD(SET_ADAPT_ON_VAD_CH0_AGC, AGC_RESID, TYPE_UINT32, AGC_CMD_SET_ADAPT_ON_VAD, WRITE, 1, "set AGC adaptation using VAD data for channel 0")
+VFCTRL_CMD(SET_ADAPT_ON_VAD_CH1_AGC, AGC_RESID, TYPE_UINT32, AGC_CMD_SET_ADAPT_ON_VAD, WRITE, 1, "set AGC adaptation using VAD data for channel 1")
+
+VFCTRL_CMD(SET_SOFT_CLIPPING_CH0_AGC, AGC_RESID, TYPE_UINT32, AGC_CMD_SET_SOFT_CLIPPING, WRITE, 1, "set AGC soft clipping for channel 0")
+VFCTRL_CMD(SET_SOFT_CLIPPING_CH1_AGC, AGC_RESID, TYPE_UINT32, AGC_CMD_SET_SOFT_CLIPPING, WRITE, 1, "set AGC soft clipping for channel 1")
+VFCTRL_CMD(SET_LC_ENABLED_CH0_AGC, AGC_RESID, TYPE_UINT32, AGC_CMD_SET_LC_ENABLED, WRITE, 1, "enable loss control for channel 0")
+VFCTRL_CMD(SET_LC_ENABLED_CH1_AGC, AGC_RESID, TYPE_UINT32, AGC_CMD_SET_LC_ENABLED, WRITE, 1, "enable loss control for channel 1")
+VFCTRL_CMD(SET_INCREMENT_GAIN_STEPSIZE_CH0_AGC, AGC_RESID, TYPE_FIXED_16_16, AGC_CMD_SET_GAIN_INCREMENT_STEPSIZE, WRITE, 1, "set stepsize with which gain is incremented for AGC ch0")
+VFCTRL_CMD(SET_INCREMENT_GAIN_STEPSIZE_CH1_AGC, AGC_RESID, TYPE_FIXED_16_16, AGC_CMD_SET_GAIN_INCREMENT_STEPSIZE, WRITE, 1, "set stepsize with which gain is incremented for AGC ch1")
+VFCTRL_CMD(SET_DECREMENT_GAIN_STEPSIZE_CH0_AGC, AGC_RESID, TYPE_FIXED_16_16, AGC_CMD_SET_GAIN_DECREMENT_STEPSIZE, WRITE, 1, "set stepsize with which gain is decremented for AGC ch0")
+VFCTRL_CMD(SET_DECREMENT_GAIN_STEPSIZE_CH1_AGC, AGC_RESID, TYPE_FIXED_16_16, AGC_CMD_SET_GAIN_DECREMENT_STEPSIZE, WRITE, 1, "set stepsize with which gain is decremented for AGC ch1")
+
+VFCTRL_CMD(SET_BYPASS_IC, IC_RESID, TYPE_INT32, IC_CMD_SET_BYPASS, WRITE, 1, "IC: set bypass")
+VFCTRL_CMD(SET_X_ENERGY_DELTA_IC, IC_RESID, TYPE_ENERGY, IC_CMD_SET_X_ENERGY_DELTA, WRITE, 1, "IC: set X energy delta")
+VFCTRL_CMD(SET_X_ENERGY_GAMMA_LOG2_IC, IC_RESID, TYPE_UINT32, IC_CMD_SET_X_ENERGY_GAMMA_LOG2, WRITE, 1, "IC: set X energy gamma log2")
+VFCTRL_CMD(SET_FORCED_MU_VALUE_IC, IC_RESID, TYPE_FIXED_1_31, IC_CMD_SET_FORCED_MU_VALUE, WRITE, 1, "IC: set forced mu value")
+VFCTRL_CMD(SET_ADAPTATION_CONFIG_IC, IC_RESID, TYPE_INT32, IC_CMD_SET_ADAPTION_CONFIG, WRITE, 1, "IC: set adaptation config")
+VFCTRL_CMD(SET_SIGMA_ALPHA_IC, IC_RESID, TYPE_UINT32, IC_CMD_SET_SIGMA_ALPHA, WRITE, 1, "IC: set adaptation config")
+VFCTRL_CMD(SET_COEFFICIENT_INDEX_IC, IC_RESID, TYPE_UINT32, IC_CMD_SET_COEFFICIENT_INDEX, WRITE, 1, "IC: set coefficient index")
+VFCTRL_CMD(RESET_FILTER_IC, IC_RESID, TYPE_UINT8, IC_CMD_RESET_FILTER, WRITE, 1, "IC: reset filter")
+VFCTRL_CMD(SET_CH1_BEAMFORM_ENABLE, IC_RESID, TYPE_UINT8, IC_CMD_SET_CH1_BEAMFORM_ENABLE, WRITE, 1, "set if beamforming is enabled on channel1")
+
+VFCTRL_CMD(SET_BYPASS_SUP, SUP_RESID, TYPE_INT32, SUP_CMD_SET_BYPASS, WRITE, 1, "SUP: set bypass")
+VFCTRL_CMD(SET_ENABLED_AES, SUP_RESID, TYPE_INT32, SUP_CMD_SET_ECHO_SUPPRESSION_ENABLED, WRITE, 1, "SUP: set echo suppresion enabled")
+VFCTRL_CMD(SET_ENABLED_NS, SUP_RESID, TYPE_INT32, SUP_CMD_SET_NOISE_SUPPRESSION_ENABLED, WRITE, 1, "SUP: set noise suppresion enabled")
+VFCTRL_CMD(SET_NOISE_FLOOR_NS, SUP_RESID, TYPE_FIXED_0_32, SUP_CMD_SET_NOISE_MCRA_NOISE_FLOOR, WRITE, 1, "SUP: set noise suppression noise floor")
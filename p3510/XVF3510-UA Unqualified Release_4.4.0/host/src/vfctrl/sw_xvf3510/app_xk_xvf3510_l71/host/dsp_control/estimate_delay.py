@@ -98,7 +98,10 @@ def main(set_delay):
 if __name__ == "__main__":
     args = parse_arguments()
     vfctrl.init(args.interface[0])
-    success = do_command('GET_VERSION')
+    try:
+        success = do_command('GET_VERSION')
+    except vfctrl.VfctrlError:
+        success = False
     if not success:
         sys.exit(1)
     main(args.set)
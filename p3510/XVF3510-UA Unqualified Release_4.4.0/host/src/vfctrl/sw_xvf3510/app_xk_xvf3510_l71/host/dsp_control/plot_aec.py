@@ -8,6 +8,9 @@
    The script requires one positional parameter (usb or i2c) to select
    the control interface and one optional parameter(--build-host)
    to add the steps of building the host application.
+   With --full the delay range is swept one filter length at a time, moving
+   to the next delay as soon as the ERLE of the AEC stops changing, and the
+   delay found is then refined by centring the peak of the filter.
    The script requires a valid tools setup.
    The host app will be built by the script
    The script exits with the possible error codes:
@@ -34,6 +37,16 @@ import vfctrl
 
 DIVIDER_STRING = "\n---------------------------------------------------------\n"
 CONVERGE_TIME_SEC = 10
+# The AEC is considered converged when the ERLE of every mic changes by less than
+# CONVERGE_ERLE_DB over CONVERGE_WINDOW_SEC, after at least CONVERGE_MIN_SEC
+CONVERGE_MIN_SEC = 1.0
+CONVERGE_WINDOW_SEC = 1.0
+CONVERGE_ERLE_DB = 0.5
+CONVERGE_POLL_SEC = 0.1
+# Position of the peak in the filter the refined delay aims for, as in estimate_delay()
+PEAK_OFFSET_SAMPLES = 40
+REFINE_MAX_STEPS = 3
+REFINE_TOLERANCE_SAMPLES = 8
 MAX_DELAY_SAMPLES = 2399
 SAMPLE_RATE = 16000
 OUTPUT_DIR = os.path.normpath('./output/')
@@ -65,6 +78,102 @@ def set_delay_parameters(delay_samples):
     vfctrl.do_command("RESET_FILTER_AEC", 0)
     return (delay_samples, delay_dir)
 
+def get_erle(y_ch_num):
+    """Read the ERLE of the mics
+
+    Args:
+        y_ch_num: number of y channels
+
+    Returns:
+        list of the ERLE in dB of each mic, None on error
+    """
+
+    erle = []
+    for y_ch in range(min(y_ch_num, 2)):
+        value = vfctrl.get_values("GET_ERLE_CH{}_AEC".format(y_ch))
+        if value is None:
+            return None
+        erle.append(float(value))
+    return erle
+
+def wait_for_convergence(y_ch_num, max_time_sec=CONVERGE_TIME_SEC):
+    """Wait until the AEC has converged, or for max_time_sec
+
+    Args:
+        y_ch_num: number of y channels
+        max_time_sec: time after which the AEC is assumed converged
+
+    Returns:
+        time waited in seconds
+    """
+
+    start = time.time()
+    history = []
+    while True:
+        now = time.time() - start
+        if now >= max_time_sec:
+            print("AEC not converged after {:.1f} s, continuing".format(now))
+            return now
+        erle = get_erle(y_ch_num)
+        if erle is None:
+            # ERLE not available, fall back to the fixed wait
+            time.sleep(max_time_sec - now)
+            return max_time_sec
+        history.append((now, erle))
+        history = [h for h in history if h[0] >= now - CONVERGE_WINDOW_SEC]
+        if now >= CONVERGE_MIN_SEC and history[0][0] <= now - CONVERGE_WINDOW_SEC + CONVERGE_POLL_SEC:
+            spread = max(max(h[1][y] for h in history) - min(h[1][y] for h in history)
+                         for y in range(len(erle)))
+            if spread < CONVERGE_ERLE_DB:
+                print("AEC converged in {:.1f} s, ERLE {}".format(now,
+                      ", ".join("{:.1f} dB".format(e) for e in erle)))
+                return now
+        time.sleep(CONVERGE_POLL_SEC)
+
+def get_peak_index(H_hat):
+    """Find the position of the peak of the filter, averaged over the channels
+
+    Args:
+        H_hat: H_hat array
+
+    Returns:
+        average peak index in samples and the smallest peak value
+    """
+
+    indexes = []
+    peaks = []
+    for y_ch in range(H_hat.shape[0]):
+        for x_ch in range(H_hat.shape[1]):
+            h_hat_ir_abs = np.absolute(get_h_hat_impulse_response(H_hat, y_ch, x_ch))
+            indexes.append(h_hat_ir_abs.argmax())
+            peaks.append(h_hat_ir_abs.max())
+    return (np.mean(indexes), min(peaks))
+
+def refine_delay(delay_samples, y_ch_num, max_time_sec):
+    """Move the delay until the peak of the filter is PEAK_OFFSET_SAMPLES from its start
+
+    Args:
+        delay_samples: signed delay found by the coarse sweep, negative for delay direction 1
+        y_ch_num: number of y channels
+        max_time_sec: maximum convergence time of each step
+
+    Returns:
+        refined signed delay in samples
+    """
+
+    for step in range(REFINE_MAX_STEPS):
+        print("Refine step {}: delay {}".format(step, delay_samples))
+        H_hat = get_filter_coefficients(delay_samples, max_time_sec=max_time_sec, y_ch_num=y_ch_num)
+        (peak_index, peak_value) = get_peak_index(H_hat)
+        if peak_value == 0:
+            print("Error: no echo found, check that the reference is correctly played into the device")
+            break
+        error = int(round(peak_index)) - PEAK_OFFSET_SAMPLES
+        delay_samples = max(-MAX_DELAY_SAMPLES, min(MAX_DELAY_SAMPLES, delay_samples + error))
+        if abs(error) <= REFINE_TOLERANCE_SAMPLES:
+            break
+    return delay_samples
+
 def compute_all_h_hat(H_hat, h_hat_ir_all, overlapping_samples):
     """Compute the impulse responses for all the channels
 
@@ -156,11 +265,12 @@ def plot_h_hat(h_hat_ir, x_ch_num, y_ch_num, delay=0):
     return max_values
 
 def estimate_delay(max_values, x_ch_num, y_ch_num, set_delay=False,
-                   print_delay_info=True):
+                   print_delay_info=True, refine=None):
     """Analyze the max values and print the recommended delay values
 
     Args:
         max_values: list of max values and respective samples indexes
+        refine: optional function refining the signed delay estimated
 
     Returns:
         None
@@ -184,9 +294,11 @@ def estimate_delay(max_values, x_ch_num, y_ch_num, set_delay=False,
                 print("Warning: delay for y_ch{}, x_ch{} differs from the average: {} vs {} relative to {} samples". \
                         format(y_ch, x_ch, m_x, recommended_delay_samples, -MAX_DELAY_SAMPLES))
 
-    recommended_delay_samples -= MAX_DELAY_SAMPLES + 40
+    recommended_delay_samples -= MAX_DELAY_SAMPLES + PEAK_OFFSET_SAMPLES
     if recommended_delay_samples < -MAX_DELAY_SAMPLES:
         recommended_delay_samples = MAX_DELAY_SAMPLES
+    if refine is not None and print_delay_info:
+        recommended_delay_samples = refine(int(round(recommended_delay_samples)))
     recommended_delay_dir = 0
     if recommended_delay_samples < 0:
         recommended_delay_samples = -recommended_delay_samples
@@ -211,6 +323,12 @@ def parse_arguments():
                         help='Plot the AEC at all possible delay values')
     parser.add_argument('--set-delay', action='store_true',
                         help='Use the AEC coefficients to set the delay on the device')
+    parser.add_argument('--converge-time', type=float, default=CONVERGE_TIME_SEC,
+                        help='Maximum time in seconds allowed for the AEC to converge at each delay')
+    parser.add_argument('--fixed-wait', action='store_true',
+                        help='Always wait the maximum convergence time instead of monitoring the ERLE')
+    parser.add_argument('--no-refine', action='store_true',
+                        help='Skip the refinement of the delay found by the sweep')
     args = parser.parse_args()
     if args.set_delay and not args.full:
         args.full = True
@@ -218,11 +336,14 @@ def parse_arguments():
     return args
 
 
-def get_filter_coefficients(delay_samples=None):
+def get_filter_coefficients(delay_samples=None, max_time_sec=CONVERGE_TIME_SEC, y_ch_num=None):
     if not delay_samples is None:
         (delay_samples, delay_dir) = set_delay_parameters(delay_samples)
-        print("Wait {} seconds to allow AEC to converge".format(CONVERGE_TIME_SEC))
-        time.sleep(CONVERGE_TIME_SEC)
+        if y_ch_num is None:
+            print("Wait {} seconds to allow AEC to converge".format(max_time_sec))
+            time.sleep(max_time_sec)
+        else:
+            wait_for_convergence(y_ch_num, max_time_sec)
 
     try:
         os.remove("aec_coefficients.py")
@@ -277,13 +398,16 @@ def main(args):
     h_hat_ir = [[[np.zeros(0)] for x in range(x_ch_num)] for y in range(y_ch_num)]
     print(DIVIDER_STRING)
 
+    # None selects the fixed wait
+    converge_y_ch_num = None if args.fixed_wait else y_ch_num
     if args.full:
+        sweep_start = time.time()
         original_delay_samples = int(vfctrl.do_command('GET_DELAY_SAMPLES'))
         original_delay_direction = int(vfctrl.do_command('GET_DELAY_DIRECTION'))
         for delay_samples in range(-MAX_DELAY_SAMPLES,
                                    MAX_DELAY_SAMPLES+filter_len_samples,
                                    filter_len_samples):
-            H_hat = get_filter_coefficients(delay_samples)
+            H_hat = get_filter_coefficients(delay_samples, args.converge_time, converge_y_ch_num)
             h_hat_ir = compute_all_h_hat(H_hat, h_hat_ir, overlapping_samples=0)
             print(DIVIDER_STRING)
     else:
@@ -298,7 +422,11 @@ def main(args):
 
     if args.full:
         print(DIVIDER_STRING)
-        estimate_delay(max_values, x_ch_num, y_ch_num, set_delay=args.set_delay)
+        refine = None
+        if not args.no_refine:
+            refine = lambda delay: refine_delay(delay, converge_y_ch_num, args.converge_time)
+        estimate_delay(max_values, x_ch_num, y_ch_num, set_delay=args.set_delay, refine=refine)
+        print("Delay search took {:.1f} s".format(time.time() - sweep_start))
 
     if args.full and not args.set_delay:
         # Reset delay to original values and reset filter
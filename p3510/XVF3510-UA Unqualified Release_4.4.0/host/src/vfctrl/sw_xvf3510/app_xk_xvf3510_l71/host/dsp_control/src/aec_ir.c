@@ -0,0 +1,351 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+// Delay, direct path and tail analysis of the AEC filter impulse responses
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "host_control_api.h"
+#include "aec_ir.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+// The coefficient file stores each phase of the filter as the f_bin_count bins of a real FFT
+typedef struct {
+    unsigned frame_advance;
+    unsigned y_channels;
+    unsigned x_channels;
+    unsigned max_phases;
+    unsigned f_bins;
+    double *re;     // [y_channels][x_channels][max_phases][f_bins]
+    double *im;
+} aec_coeffs_t;
+
+typedef struct {
+    unsigned onset;         // bulk delay in samples
+    unsigned peak;          // direct path peak in samples
+    double amplitude;       // signed value at the peak
+    double energy_db;       // total energy
+    double tail_db;         // energy from AEC_IR_TAIL_START_MS after the peak, relative to the total
+} aec_ir_stats_t;
+
+static double *coeff_bins(aec_coeffs_t *c, double *bins, unsigned y, unsigned x, unsigned p)
+{
+    return &bins[(((size_t)y * c->x_channels + x) * c->max_phases + p) * c->f_bins];
+}
+
+// Read a line of any length, the coefficient lines are several kB long. Returns 0 at the end of the file.
+static int read_line(FILE *fp, char **line, size_t *max_chars)
+{
+    size_t n = 0;
+    int ch;
+    while ((ch = fgetc(fp)) != EOF && ch != '\n') {
+        if (n + 1 >= *max_chars) {
+            *max_chars *= 2;
+            *line = realloc(*line, *max_chars);
+        }
+        (*line)[n++] = (char)ch;
+    }
+    (*line)[n] = '\0';
+    return (n > 0 || ch != EOF);
+}
+
+// Parse the bins of a phase, as written by print_python_fd(): np.asarray([DC, RE + IMj, ..., NYQUIST])
+static int parse_bins(const char *s, double *re, double *im, unsigned f_bins)
+{
+    char *end;
+    for (unsigned k=0; k<f_bins; k++) {
+        re[k] = strtod(s, &end);
+        im[k] = 0;
+        if (end == s) {
+            return -1;
+        }
+        s = end;
+        while (*s == ' ') s++;
+        if (*s == '+' || *s == '-') {
+            // complex value, the sign of the imaginary part follows the operator
+            double sign = (*s == '-') ? -1.0 : 1.0;
+            s++;
+            im[k] = sign * strtod(s, &end);
+            if (end == s || *end != 'j') {
+                return -1;
+            }
+            s = end + 1;
+            while (*s == ' ') s++;
+        }
+        if (*s == ',') {
+            s++;
+        } else if (*s != ']' || k != f_bins - 1) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int load_coeffs(const char *filename, aec_coeffs_t *c)
+{
+    memset(c, 0, sizeof(*c));
+    FILE *fp = fopen(filename, "r");
+    if (fp == NULL) {
+        printf("Error: cannot open %s\n", filename);
+        return -1;
+    }
+    size_t max_chars = 4096;
+    char *line = malloc(max_chars);
+    unsigned line_num = 0;
+    int ret = 0;
+    while (ret == 0 && read_line(fp, &line, &max_chars)) {
+        unsigned y, x, p;
+        int pos = 0;
+        line_num++;
+        if (sscanf(line, "frame_advance = %u", &c->frame_advance) == 1 ||
+            sscanf(line, "y_channel_count = %u", &c->y_channels) == 1 ||
+            sscanf(line, "x_channel_count = %u", &c->x_channels) == 1 ||
+            sscanf(line, "max_phase_count = %u", &c->max_phases) == 1 ||
+            sscanf(line, "f_bin_count = %u", &c->f_bins) == 1) {
+            continue;
+        }
+        if (strncmp(line, "H_hat = ", 8) == 0) {
+            if (c->frame_advance == 0 || c->y_channels == 0 || c->x_channels == 0 || c->max_phases == 0 || c->f_bins < 2) {
+                printf("Error: %s:%u: the filter dimensions must be given before H_hat\n", filename, line_num);
+                ret = -1;
+                break;
+            }
+            size_t num_bins = (size_t)c->y_channels * c->x_channels * c->max_phases * c->f_bins;
+            c->re = calloc(num_bins, sizeof(double));
+            c->im = calloc(num_bins, sizeof(double));
+            continue;
+        }
+        if (sscanf(line, "H_hat[%u][%u][%u] = np.asarray([%n", &y, &x, &p, &pos) == 3 && pos > 0) {
+            if (c->re == NULL || y >= c->y_channels || x >= c->x_channels || p >= c->max_phases ||
+                parse_bins(&line[pos], coeff_bins(c, c->re, y, x, p), coeff_bins(c, c->im, y, x, p), c->f_bins) != 0) {
+                printf("Error: %s:%u: invalid coefficients\n", filename, line_num);
+                ret = -1;
+            }
+        }
+    }
+    free(line);
+    fclose(fp);
+    if (ret == 0 && c->re == NULL) {
+        printf("Error: no AEC coefficients in %s\n", filename);
+        ret = -1;
+    }
+    return ret;
+}
+
+static void free_coeffs(aec_coeffs_t *c)
+{
+    free(c->re);
+    free(c->im);
+}
+
+// In place complex inverse FFT, unscaled. n must be a power of two.
+static void inverse_fft(double *re, double *im, unsigned n)
+{
+    for (unsigned i=1, j=0; i<n; i++) {
+        unsigned bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            double t = re[i]; re[i] = re[j]; re[j] = t;
+            t = im[i]; im[i] = im[j]; im[j] = t;
+        }
+    }
+    for (unsigned len=2; len<=n; len<<=1) {
+        double w_re = cos(2 * M_PI / len);
+        double w_im = sin(2 * M_PI / len);
+        for (unsigned i=0; i<n; i+=len) {
+            double u_re = 1, u_im = 0;
+            for (unsigned k=0; k<len/2; k++) {
+                double *a_re = &re[i+k], *a_im = &im[i+k];
+                double *b_re = &re[i+k+len/2], *b_im = &im[i+k+len/2];
+                double t_re = *b_re * u_re - *b_im * u_im;
+                double t_im = *b_re * u_im + *b_im * u_re;
+                *b_re = *a_re - t_re;
+                *b_im = *a_im - t_im;
+                *a_re += t_re;
+                *a_im += t_im;
+                double next_re = u_re * w_re - u_im * w_im;
+                u_im = u_re * w_im + u_im * w_re;
+                u_re = next_re;
+            }
+        }
+    }
+}
+
+// Impulse response of a mic and reference pair: the first frame_advance samples of the inverse
+// real FFT of each phase, one phase after the other, as get_h_hat_impulse_response() of plot_aec.py
+static void build_ir(aec_coeffs_t *c, unsigned y, unsigned x, double *ir, double *work_re, double *work_im)
+{
+    unsigned n = 2 * (c->f_bins - 1);
+    unsigned copy = (c->frame_advance < n) ? c->frame_advance : n;
+    for (unsigned p=0; p<c->max_phases; p++) {
+        double *bins_re = coeff_bins(c, c->re, y, x, p);
+        double *bins_im = coeff_bins(c, c->im, y, x, p);
+        // Hermitian spectrum, the imaginary part of the DC and Nyquist bins is ignored as by np.fft.irfft
+        work_re[0] = bins_re[0];
+        work_im[0] = 0;
+        work_re[n/2] = bins_re[n/2];
+        work_im[n/2] = 0;
+        for (unsigned k=1; k<n/2; k++) {
+            work_re[k] = bins_re[k];
+            work_im[k] = bins_im[k];
+            work_re[n-k] = bins_re[k];
+            work_im[n-k] = -bins_im[k];
+        }
+        inverse_fft(work_re, work_im, n);
+        for (unsigned i=0; i<c->frame_advance; i++) {
+            ir[p * c->frame_advance + i] = (i < copy) ? work_re[i] / n : 0;
+        }
+    }
+}
+
+static void analyse_ir(const double *ir, unsigned length, aec_ir_stats_t *stats)
+{
+    double peak_abs = 0;
+    double energy = 0;
+    stats->peak = 0;
+    for (unsigned i=0; i<length; i++) {
+        energy += ir[i] * ir[i];
+        if (fabs(ir[i]) > peak_abs) {
+            peak_abs = fabs(ir[i]);
+            stats->peak = i;
+        }
+    }
+    stats->amplitude = ir[stats->peak];
+    stats->onset = stats->peak;
+    for (unsigned i=0; i<stats->peak; i++) {
+        if (fabs(ir[i]) >= AEC_IR_ONSET_FRACTION * peak_abs) {
+            stats->onset = i;
+            break;
+        }
+    }
+    double tail = 0;
+    unsigned tail_start = stats->peak + (unsigned)(AEC_IR_TAIL_START_MS * AEC_IR_SAMPLE_RATE / 1000);
+    for (unsigned i=tail_start; i<length; i++) {
+        tail += ir[i] * ir[i];
+    }
+    stats->energy_db = (energy > 0) ? 10 * log10(energy) : -INFINITY;
+    stats->tail_db = (tail > 0 && energy > 0) ? 10 * log10(tail / energy) : -INFINITY;
+}
+
+static int write_ir_csv(const char *filename, aec_coeffs_t *c, double *irs, unsigned length)
+{
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL) {
+        printf("Error: cannot open %s\n", filename);
+        return -1;
+    }
+    fprintf(fp, "sample,ms");
+    for (unsigned y=0; y<c->y_channels; y++) {
+        for (unsigned x=0; x<c->x_channels; x++) {
+            fprintf(fp, ",mic%u_ref%u", y, x);
+        }
+    }
+    fprintf(fp, "\n");
+    unsigned num_pairs = c->y_channels * c->x_channels;
+    for (unsigned i=0; i<length; i++) {
+        fprintf(fp, "%u,%.4f", i, 1000.0 * i / AEC_IR_SAMPLE_RATE);
+        for (unsigned pair=0; pair<num_pairs; pair++) {
+            fprintf(fp, ",%.9g", irs[(size_t)pair * length + i]);
+        }
+        fprintf(fp, "\n");
+    }
+    fclose(fp);
+    printf("Impulse responses saved to %s\n", filename);
+    return 0;
+}
+
+int run_aec_ir(aec_ir_config_t *config)
+{
+    int32_t delay_samples = 0;
+    int32_t delay_direction = 0;
+    unsigned have_delay = 0;
+    if (config->read_device) {
+        if (vfctrl_get_aec_coefficients_to_file(config->coeff_file) != 0) {
+            printf("Error: cannot read the AEC coefficients\n");
+            return 1;
+        }
+        have_delay = (vfctrl_get_int(VFCTRL_GET_DELAY_SAMPLES, &delay_samples) == 0 &&
+                      vfctrl_get_int(VFCTRL_GET_DELAY_DIRECTION, &delay_direction) == 0);
+    }
+
+    aec_coeffs_t c;
+    if (load_coeffs(config->coeff_file, &c) != 0) {
+        free_coeffs(&c);
+        return 1;
+    }
+    unsigned n = 2 * (c.f_bins - 1);
+    if (n & (n - 1)) {
+        printf("Error: %u bins per phase, the FFT length must be a power of two\n", c.f_bins);
+        free_coeffs(&c);
+        return 1;
+    }
+
+    unsigned length = c.max_phases * c.frame_advance;
+    unsigned num_pairs = c.y_channels * c.x_channels;
+    double *irs = malloc((size_t)num_pairs * length * sizeof(double));
+    double *work_re = malloc(n * sizeof(double));
+    double *work_im = malloc(n * sizeof(double));
+    aec_ir_stats_t *stats = malloc(num_pairs * sizeof(aec_ir_stats_t));
+
+    printf("AEC impulse responses of %s: %u mics, %u references, %u samples (%.1f ms)\n", config->coeff_file,
+           c.y_channels, c.x_channels, length, 1000.0 * length / AEC_IR_SAMPLE_RATE);
+    printf("mic ref  onset   peak  peak_ms   amplitude  tail_db  energy_db\n");
+    double peak_sum = 0;
+    unsigned num_echoes = 0;
+    for (unsigned y=0; y<c.y_channels; y++) {
+        for (unsigned x=0; x<c.x_channels; x++) {
+            unsigned pair = y * c.x_channels + x;
+            double *ir = &irs[(size_t)pair * length];
+            build_ir(&c, y, x, ir, work_re, work_im);
+            analyse_ir(ir, length, &stats[pair]);
+            printf("%3u %3u %6u %6u %8.3f %11.6f %8.1f %10.1f\n", y, x, stats[pair].onset, stats[pair].peak,
+                   1000.0 * stats[pair].peak / AEC_IR_SAMPLE_RATE, stats[pair].amplitude,
+                   stats[pair].tail_db, stats[pair].energy_db);
+            if (stats[pair].amplitude != 0) {
+                peak_sum += stats[pair].peak;
+                num_echoes++;
+            }
+        }
+    }
+
+    int ret = 0;
+    if (num_echoes == 0) {
+        printf("Error: the filter is empty, check that the reference is correctly played into the device\n");
+        ret = 1;
+    } else {
+        double mean_peak = peak_sum / num_echoes;
+        for (unsigned pair=0; pair<num_pairs; pair++) {
+            if (stats[pair].amplitude != 0 && fabs(stats[pair].peak - mean_peak) > 0.1 * mean_peak) {
+                printf("Warning: the peak of mic %u ref %u differs from the average: %u vs %.0f samples\n",
+                       pair / c.x_channels, pair % c.x_channels, stats[pair].peak, mean_peak);
+            }
+        }
+        int adjust = (int)lround(mean_peak) - AEC_IR_PEAK_OFFSET_SAMPLES;
+        printf("Delay adjustment: %+d samples (%+.2f ms)\n", adjust, 1000.0 * adjust / AEC_IR_SAMPLE_RATE);
+        if (have_delay) {
+            // negative delays are applied to the mics
+            int delay = (delay_direction ? -delay_samples : delay_samples) + adjust;
+            if (delay > AEC_IR_MAX_DELAY_SAMPLES) delay = AEC_IR_MAX_DELAY_SAMPLES;
+            if (delay < -AEC_IR_MAX_DELAY_SAMPLES) delay = -AEC_IR_MAX_DELAY_SAMPLES;
+            printf("Recommended delay settings are:\n");
+            printf("\tSET_DELAY_DIRECTION %d\n", (delay < 0) ? 1 : 0);
+            printf("\tSET_DELAY_SAMPLES %d\n", abs(delay));
+        }
+    }
+
+    if (ret == 0 && config->ir_file != NULL && write_ir_csv(config->ir_file, &c, irs, length) != 0) {
+        ret = 1;
+    }
+    free(stats);
+    free(work_im);
+    free(work_re);
+    free(irs);
+    free_coeffs(&c);
+    return ret;
+}
@@ -0,0 +1,23 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#ifndef AEC_IR_H
+#define AEC_IR_H
+
+#define AEC_IR_SAMPLE_RATE          (16000.0)
+#define AEC_IR_ONSET_FRACTION       (0.1)   // bulk delay: first sample within 20 dB of the peak
+#define AEC_IR_TAIL_START_MS        (5.0)   // tail energy: energy from this time after the peak
+#define AEC_IR_PEAK_OFFSET_SAMPLES  (40)    // position of the peak the delay is set for, as in plot_aec.py
+#define AEC_IR_MAX_DELAY_SAMPLES    (2399)
+#define AEC_IR_DEFAULT_FILE         "aec_coefficients.py"
+
+typedef struct {
+    const char *coeff_file;   // coefficients saved by GET_FILTER_COEFFICIENTS_AEC
+    unsigned read_device;     // read the coefficients and the delay from the device into coeff_file first
+    const char *ir_file;      // CSV with the impulse response of each mic and reference pair
+} aec_ir_config_t;
+
+// Rebuild the impulse response of each mic and reference pair from the frequency domain AEC filter and
+// report its bulk delay, direct path peak and tail energy, and the delay setting which puts the peak
+// AEC_IR_PEAK_OFFSET_SAMPLES into the filter.
+int run_aec_ir(aec_ir_config_t *config);
+
+#endif
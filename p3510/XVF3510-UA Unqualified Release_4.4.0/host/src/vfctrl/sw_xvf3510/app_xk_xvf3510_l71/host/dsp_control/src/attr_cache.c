@@ -0,0 +1,224 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#if defined(_MSC_VER)
+#include <direct.h>
+#include <process.h>
+#define mkdir(path, mode) _mkdir(path)
+#define getpid _getpid
+#else
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "host_control_api.h"
+#include "attr_cache.h"
+
+#define ATTR_CACHE_MAX_ENTRIES  (32)
+#define ATTR_CACHE_PATH_CHARS   (1024)
+#define ATTR_CACHE_LINE_CHARS   (512)
+
+typedef struct {
+    uint8_t resid;
+    uint8_t cmd;
+    uint8_t num_bytes;
+    uint8_t payload[CMD_MAX_BYTES];
+} attr_cache_entry_t;
+
+static unsigned cache_enabled = 1;
+static unsigned cache_open = 0;
+static char cache_key[ATTR_CACHE_KEY_MAX_CHARS];
+static char cache_path[ATTR_CACHE_PATH_CHARS];
+static attr_cache_entry_t entries[ATTR_CACHE_MAX_ENTRIES];
+static unsigned num_entries = 0;
+
+void attr_cache_enable(unsigned enable)
+{
+    cache_enabled = enable;
+}
+
+// Find the cache file, creating its directory if needed. Returns 0 on success
+static int get_cache_path(void)
+{
+    char dir[ATTR_CACHE_PATH_CHARS];
+    const char *env = getenv("VFCTRL_CACHE_DIR");
+    if (env != NULL) {
+        snprintf(dir, sizeof(dir), "%s", env);
+    } else {
+#if defined(_WIN32)
+        env = getenv("LOCALAPPDATA");
+        if (env == NULL) {
+            return -1;
+        }
+        snprintf(dir, sizeof(dir), "%s\\%s", env, ATTR_CACHE_DIR_NAME);
+#else
+        env = getenv("XDG_CACHE_HOME");
+        if (env != NULL) {
+            snprintf(dir, sizeof(dir), "%s/%s", env, ATTR_CACHE_DIR_NAME);
+        } else {
+            env = getenv("HOME");
+            if (env == NULL) {
+                return -1;
+            }
+            snprintf(dir, sizeof(dir), "%s/.cache", env);
+            mkdir(dir, 0755);
+            snprintf(dir, sizeof(dir), "%s/.cache/%s", env, ATTR_CACHE_DIR_NAME);
+        }
+#endif
+    }
+    mkdir(dir, 0755); // fails harmlessly if it exists
+    int n = snprintf(cache_path, sizeof(cache_path), "%s/%s", dir, ATTR_CACHE_FILE_NAME);
+    if (n < 0 || n >= (int)sizeof(cache_path)) {
+        return -1;
+    }
+    return 0;
+}
+
+static int parse_entry(char *line, attr_cache_entry_t *entry)
+{
+    unsigned resid, cmd;
+    int pos = 0;
+    if (sscanf(line, "%u %u %n", &resid, &cmd, &pos) != 2 || resid > 0xff || cmd > 0xff) {
+        return -1;
+    }
+    entry->resid = resid;
+    entry->cmd = cmd;
+    entry->num_bytes = 0;
+    for (char *p = line + pos; isxdigit((unsigned char)p[0]) && isxdigit((unsigned char)p[1]); p += 2) {
+        if (entry->num_bytes == CMD_MAX_BYTES) {
+            return -1;
+        }
+        unsigned byte;
+        sscanf(p, "%2x", &byte);
+        entry->payload[entry->num_bytes++] = byte;
+    }
+    return 0;
+}
+
+void attr_cache_open(const char *device_key)
+{
+    char line[ATTR_CACHE_LINE_CHARS];
+    num_entries = 0;
+    cache_open = 0;
+    if (!cache_enabled || get_cache_path() != 0) {
+        return;
+    }
+    // keep the key on one line with no blank spaces
+    snprintf(cache_key, sizeof(cache_key), "%s", device_key);
+    for (char *c = cache_key; *c != '\0'; c++) {
+        if (!isgraph((unsigned char)*c)) {
+            *c = '_';
+        }
+    }
+    cache_open = 1;
+
+    FILE *fp = fopen(cache_path, "r");
+    if (fp == NULL) {
+        return;
+    }
+    unsigned in_section = 0;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        line[strcspn(line, "\r\n")] = '\0';
+        if (line[0] == '#') {
+            in_section = (strcmp(line + 2, cache_key) == 0);
+        } else if (in_section && num_entries < ATTR_CACHE_MAX_ENTRIES) {
+            if (parse_entry(line, &entries[num_entries]) == 0) {
+                num_entries++;
+            }
+        }
+    }
+    fclose(fp);
+}
+
+// Rewrite the file with the other devices unchanged and the current entries of this device
+static void save_cache(void)
+{
+    char line[ATTR_CACHE_LINE_CHARS];
+    char tmp_path[ATTR_CACHE_PATH_CHARS + 32];
+    // one temporary file per process, several vfctrl can save at the same time
+    snprintf(tmp_path, sizeof(tmp_path), "%s.%d.tmp", cache_path, (int)getpid());
+    FILE *out = fopen(tmp_path, "w");
+    if (out == NULL) {
+        return;
+    }
+    FILE *in = fopen(cache_path, "r");
+    if (in != NULL) {
+        unsigned in_section = 0;
+        while (fgets(line, sizeof(line), in) != NULL) {
+            if (line[0] == '#') {
+                line[strcspn(line, "\r\n")] = '\0';
+                in_section = (strcmp(line + 2, cache_key) == 0);
+                if (!in_section) {
+                    fprintf(out, "%s\n", line);
+                }
+            } else if (!in_section) {
+                fputs(line, out);
+            }
+        }
+        fclose(in);
+    }
+    if (num_entries > 0) {
+        fprintf(out, "# %s\n", cache_key);
+        for (unsigned i=0; i<num_entries; i++) {
+            fprintf(out, "%u %u ", entries[i].resid, entries[i].cmd);
+            for (unsigned b=0; b<entries[i].num_bytes; b++) {
+                fprintf(out, "%02x", entries[i].payload[b]);
+            }
+            fprintf(out, "\n");
+        }
+    }
+    fclose(out);
+    remove(cache_path);
+    rename(tmp_path, cache_path);
+}
+
+int attr_cache_get(uint8_t resid, uint8_t cmd, uint8_t *payload, unsigned num_bytes)
+{
+    if (!cache_open) {
+        return -1;
+    }
+    for (unsigned i=0; i<num_entries; i++) {
+        if (entries[i].resid == resid && entries[i].cmd == cmd && entries[i].num_bytes == num_bytes) {
+            memcpy(payload, entries[i].payload, num_bytes);
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void attr_cache_put(uint8_t resid, uint8_t cmd, const uint8_t *payload, unsigned num_bytes)
+{
+    if (!cache_open || num_bytes > CMD_MAX_BYTES) {
+        return;
+    }
+    unsigned i;
+    for (i=0; i<num_entries; i++) {
+        if (entries[i].resid == resid && entries[i].cmd == cmd) {
+            break;
+        }
+    }
+    if (i == ATTR_CACHE_MAX_ENTRIES) {
+        return;
+    }
+    if (i < num_entries && entries[i].num_bytes == num_bytes && memcmp(entries[i].payload, payload, num_bytes) == 0) {
+        return;
+    }
+    entries[i].resid = resid;
+    entries[i].cmd = cmd;
+    entries[i].num_bytes = num_bytes;
+    memcpy(entries[i].payload, payload, num_bytes);
+    if (i == num_entries) {
+        num_entries++;
+    }
+    save_cache();
+}
+
+void attr_cache_invalidate(void)
+{
+    if (!cache_open || num_entries == 0) {
+        return;
+    }
+    num_entries = 0;
+    save_cache();
+}
@@ -0,0 +1,30 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#ifndef ATTR_CACHE_H
+#define ATTR_CACHE_H
+
+#include <stdint.h>
+
+// On-disk cache of the device attributes which only change with the firmware or the data partition,
+// like the version and the build and USB strings.
+// The values of all the devices are kept in one text file with a section per device:
+//   # <device key>
+//   <resid> <cmd> <payload bytes in hex>
+// The file is deleted by the DFU host app after an upgrade, see VFCTRL_ATTR_CACHE_FILE_NAME in dfu_control.
+
+// Directory of the cache file, used when VFCTRL_CACHE_DIR is not set.
+// Relative to LOCALAPPDATA on Windows, to XDG_CACHE_HOME or HOME/.cache otherwise.
+#define ATTR_CACHE_DIR_NAME   "xmos"
+#define ATTR_CACHE_FILE_NAME  "vfctrl_attr_cache.txt"
+#define ATTR_CACHE_KEY_MAX_CHARS (128)
+
+void attr_cache_enable(unsigned enable);
+// Load the cached values of the device identified by device_key
+void attr_cache_open(const char *device_key);
+// Returns 0 and copies the cached payload if the value is in the cache
+int attr_cache_get(uint8_t resid, uint8_t cmd, uint8_t *payload, unsigned num_bytes);
+// Add a value to the cache and save the file
+void attr_cache_put(uint8_t resid, uint8_t cmd, const uint8_t *payload, unsigned num_bytes);
+// Remove all the values of the device
+void attr_cache_invalidate(void);
+
+#endif
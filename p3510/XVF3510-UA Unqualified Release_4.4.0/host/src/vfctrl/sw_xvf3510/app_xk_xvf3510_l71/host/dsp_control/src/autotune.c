@@ -0,0 +1,490 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+// Coordinate descent autotuner for the AGC and ADEC settings, on the device or on a host side AGC simulator
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include "host_control_api.h"
+#include "wav_file.h"
+#include "autotune.h"
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
+#define AGC_FRAME_MS            (15.0)  // 240 samples at 16 kHz
+#define AGC_VAD_THRESHOLD_DBFS  (-50.0) // frames below this are not adapted on nor scored
+#define AGC_MIN_GAIN            (1.0)
+#define SIM_LEVEL_WEIGHT        (0.5)   // cost per dB of mean level error
+#define SIM_CLIP_WEIGHT         (100.0) // cost per fraction of clipped frames
+#define DEVICE_SAMPLE_MS        (100)
+#define DEVICE_ERLE_WEIGHT      (0.5)   // cost per dB of ERLE
+#define MIN_STEP_FRACTION       (0.01)  // a parameter is converged when its step is below this fraction of the initial step
+#define INVALID_COST            (1e30)
+
+typedef struct {
+    const char *name;           // command name without the SET_ or GET_ prefix
+    vfctrl_cmd_id_t set_id;
+    vfctrl_cmd_id_t get_id;
+    double min;
+    double max;
+    double step;                // initial step, a factor for the log scaled parameters
+    unsigned log_scale;
+    unsigned is_int;
+    unsigned simulated;         // used by the AGC simulator
+    double sim_default;
+} tune_param_t;
+
+enum {
+    P_GAIN, P_MAX_GAIN, P_UPPER_THRESHOLD, P_LOWER_THRESHOLD, P_INCREMENT, P_DECREMENT, P_ADAPT,
+    P_ERLE_GOOD_BITS, P_ERLE_BAD_BITS, P_ERLE_BAD_GAIN, P_ADEC_FAR_THRESHOLD, NUM_TUNE_PARAMS
+};
+
+static const tune_param_t tune_params[NUM_TUNE_PARAMS] = {
+    {"GAIN_CH0_AGC", VFCTRL_SET_GAIN_CH0_AGC, VFCTRL_GET_GAIN_CH0_AGC, 1.0, 1000.0, 2.0, 1, 0, 1, 10.0},
+    {"MAX_GAIN_CH0_AGC", VFCTRL_SET_MAX_GAIN_CH0_AGC, VFCTRL_GET_MAX_GAIN_CH0_AGC, 1.0, 1000.0, 2.0, 1, 0, 1, 1000.0},
+    {"UPPER_THRESHOLD_CH0_AGC", VFCTRL_SET_UPPER_THRESHOLD_CH0_AGC, VFCTRL_GET_UPPER_THRESHOLD_CH0_AGC, 0.01, 0.99, 1.4, 1, 0, 1, 0.4},
+    {"LOWER_THRESHOLD_CH0_AGC", VFCTRL_SET_LOWER_THRESHOLD_CH0_AGC, VFCTRL_GET_LOWER_THRESHOLD_CH0_AGC, 0.001, 0.99, 1.4, 1, 0, 1, 0.2},
+    {"INCREMENT_GAIN_STEPSIZE_CH0_AGC", VFCTRL_SET_INCREMENT_GAIN_STEPSIZE_CH0_AGC, VFCTRL_GET_INCREMENT_GAIN_STEPSIZE_CH0_AGC, 1.0, 1.05, 0.004, 0, 0, 1, 1.0034},
+    {"DECREMENT_GAIN_STEPSIZE_CH0_AGC", VFCTRL_SET_DECREMENT_GAIN_STEPSIZE_CH0_AGC, VFCTRL_GET_DECREMENT_GAIN_STEPSIZE_CH0_AGC, 0.5, 1.0, 0.05, 0, 0, 1, 0.87},
+    {"ADAPT_CH0_AGC", VFCTRL_SET_ADAPT_CH0_AGC, VFCTRL_GET_ADAPT_CH0_AGC, 0, 1, 1, 0, 1, 1, 1},
+    {"ERLE_GOOD_BITS", VFCTRL_SET_ERLE_GOOD_BITS, VFCTRL_GET_ERLE_GOOD_BITS, 0.0, 10.0, 1.0, 0, 0, 0, 0},
+    {"ERLE_BAD_BITS", VFCTRL_SET_ERLE_BAD_BITS, VFCTRL_GET_ERLE_BAD_BITS, 0.0, 10.0, 1.0, 0, 0, 0, 0},
+    {"ERLE_BAD_GAIN", VFCTRL_SET_ERLE_BAD_GAIN, VFCTRL_GET_ERLE_BAD_GAIN, 0.0, 10.0, 0.5, 0, 0, 0, 0},
+    {"ADEC_FAR_THRESHOLD", VFCTRL_SET_ADEC_FAR_THRESHOLD, VFCTRL_GET_ADEC_FAR_THRESHOLD, 1e-9, 1.0, 4.0, 1, 0, 0, 0},
+};
+
+typedef struct {
+    unsigned num_params;
+    unsigned param_idx[AUTOTUNE_MAX_PARAMS];  // indices in tune_params
+    double values[NUM_TUNE_PARAMS];           // all the parameters, the ones which are not tuned keep their value
+    const int32_t *samples;                   // simulator input
+    uint64_t num_samples;
+    unsigned sample_rate;
+    autotune_config_t *config;
+} tune_state_t;
+
+typedef struct {
+    const tune_state_t *state;
+    double values[NUM_TUNE_PARAMS];
+    double cost;
+} tune_candidate_t;
+
+static unsigned num_evaluations;
+
+static int parse_params(tune_state_t *state, const char *param_list, unsigned simulate)
+{
+    state->num_params = 0;
+    if (param_list == NULL) {
+        for (unsigned p=0; p<NUM_TUNE_PARAMS; p++) {
+            if (!simulate || tune_params[p].simulated) {
+                state->param_idx[state->num_params++] = p;
+            }
+        }
+        return 0;
+    }
+    char *list = strdup(param_list);
+    int ret = 0;
+    for (char *name = strtok(list, ","); name != NULL; name = strtok(NULL, ",")) {
+        unsigned p;
+        for (p=0; p<NUM_TUNE_PARAMS && strcmp(name, tune_params[p].name) != 0; p++);
+        if (p == NUM_TUNE_PARAMS) {
+            printf("Error: %s cannot be tuned, the parameters are:", name);
+            for (p=0; p<NUM_TUNE_PARAMS; p++) {
+                printf(" %s", tune_params[p].name);
+            }
+            printf("\n");
+            ret = -1;
+        } else if (simulate && !tune_params[p].simulated) {
+            printf("Error: %s is not modelled by the AGC simulator and can only be tuned on the device\n", name);
+            ret = -1;
+        } else if (state->num_params < AUTOTUNE_MAX_PARAMS) {
+            state->param_idx[state->num_params++] = p;
+        }
+    }
+    free(list);
+    return ret;
+}
+
+static double clamp_value(const tune_param_t *param, double value)
+{
+    if (param->is_int) {
+        value = floor(value + 0.5);
+    }
+    return (value < param->min) ? param->min : (value > param->max) ? param->max : value;
+}
+
+static double step_value(const tune_param_t *param, double value, double step, int k)
+{
+    return clamp_value(param, param->log_scale ? value * pow(step, k) : value + step * k);
+}
+
+static unsigned is_converged(const tune_param_t *param, double step)
+{
+    if (param->is_int) {
+        return step < 1;
+    }
+    return param->log_scale ? step < pow(param->step, MIN_STEP_FRACTION) : step < param->step * MIN_STEP_FRACTION;
+}
+
+static unsigned is_valid(const double values[NUM_TUNE_PARAMS])
+{
+    return values[P_LOWER_THRESHOLD] < values[P_UPPER_THRESHOLD] && values[P_GAIN] <= values[P_MAX_GAIN];
+}
+
+// Host side model of the AGC of channel 0: the gain follows the frame peaks into the range between the
+// lower and upper thresholds, by the increment and decrement step sizes, on the frames with voice.
+// The cost is the spread of the output level in dB plus penalties for missing the target level and clipping.
+static double simulate_agc(const tune_state_t *state, const double values[NUM_TUNE_PARAMS])
+{
+    unsigned frame_samples = (unsigned)(state->sample_rate * AGC_FRAME_MS / 1000.0);
+    double vad_threshold = pow(10.0, AGC_VAD_THRESHOLD_DBFS / 20.0);
+    double gain = values[P_GAIN];
+    double sum_db = 0, sum_db2 = 0;
+    uint64_t num_active = 0, num_clipped = 0;
+
+    for (uint64_t start=0; start + frame_samples <= state->num_samples; start+=frame_samples) {
+        double peak = 0, energy = 0;
+        for (unsigned n=0; n<frame_samples; n++) {
+            double x = state->samples[start + n] / 2147483648.0;
+            energy += x * x;
+            if (fabs(x) > peak) {
+                peak = fabs(x);
+            }
+        }
+        double rms = sqrt(energy / frame_samples);
+        if (rms < vad_threshold) {
+            continue;
+        }
+        if (values[P_ADAPT] != 0) {
+            double gained_peak = peak * gain;
+            if (gained_peak > values[P_UPPER_THRESHOLD]) {
+                gain *= values[P_DECREMENT];
+            } else if (gained_peak < values[P_LOWER_THRESHOLD]) {
+                gain *= values[P_INCREMENT];
+            }
+            gain = (gain > values[P_MAX_GAIN]) ? values[P_MAX_GAIN] : (gain < AGC_MIN_GAIN) ? AGC_MIN_GAIN : gain;
+        }
+        if (peak * gain > 1.0) {
+            num_clipped++;
+        }
+        double level_db = 20 * log10(rms * gain);
+        sum_db += level_db;
+        sum_db2 += level_db * level_db;
+        num_active++;
+    }
+    if (num_active == 0) {
+        return INVALID_COST;
+    }
+    double mean_db = sum_db / num_active;
+    double var_db = sum_db2 / num_active - mean_db * mean_db;
+    return sqrt((var_db > 0) ? var_db : 0) + SIM_LEVEL_WEIGHT * fabs(mean_db - state->config->level_dbfs) +
+           SIM_CLIP_WEIGHT * (double)num_clipped / num_active;
+}
+
+#if defined(_WIN32)
+static DWORD WINAPI simulate_thread(LPVOID arg)
+#else
+static void *simulate_thread(void *arg)
+#endif
+{
+    tune_candidate_t *candidate = (tune_candidate_t *)arg;
+    candidate->cost = simulate_agc(candidate->state, candidate->values);
+    return 0;
+}
+
+static int apply_values(const tune_state_t *state, const double values[NUM_TUNE_PARAMS])
+{
+    for (unsigned i=0; i<state->num_params; i++) {
+        const tune_param_t *param = &tune_params[state->param_idx[i]];
+        double value = values[state->param_idx[i]];
+        int ret = param->is_int ? vfctrl_set_int(param->set_id, (int32_t)value) : vfctrl_set_float(param->set_id, (float)value);
+        if (ret != 0) {
+            printf("Error: SET_%s returned %d\n", param->name, ret);
+            return ret;
+        }
+    }
+    return 0;
+}
+
+// Device objective: the spread of the AGC gain in dB, which is the level correction the AGC keeps making,
+// minus the mean ERLE, measured on whatever audio is playing
+static double evaluate_on_device(const tune_state_t *state, const double values[NUM_TUNE_PARAMS])
+{
+    if (apply_values(state, values) != 0) {
+        return INVALID_COST;
+    }
+    vfctrl_sleep_us(state->config->settle_ms * 1000);
+    double sum_db = 0, sum_db2 = 0, sum_erle = 0;
+    unsigned num_gains = 0, num_erles = 0;
+    uint64_t end_us = vfctrl_get_time_us() + (uint64_t)state->config->window_ms * 1000;
+    while (vfctrl_get_time_us() < end_us) {
+        float gain, erle;
+        if (vfctrl_get_float(VFCTRL_GET_GAIN_CH0_AGC, &gain) == 0 && gain > 0) {
+            double gain_db = 20 * log10(gain);
+            sum_db += gain_db;
+            sum_db2 += gain_db * gain_db;
+            num_gains++;
+        }
+        if (vfctrl_get_float(VFCTRL_GET_ERLE_CH0_AEC, &erle) == 0 && isfinite(erle)) {
+            sum_erle += erle;
+            num_erles++;
+        }
+        vfctrl_sleep_us(DEVICE_SAMPLE_MS * 1000);
+    }
+    if (num_gains == 0) {
+        return INVALID_COST;
+    }
+    double mean_db = sum_db / num_gains;
+    double var_db = sum_db2 / num_gains - mean_db * mean_db;
+    double cost = sqrt((var_db > 0) ? var_db : 0);
+    if (num_erles > 0) {
+        cost -= DEVICE_ERLE_WEIGHT * sum_erle / num_erles;
+    }
+    return cost;
+}
+
+static void evaluate(tune_candidate_t candidates[], unsigned num_candidates, unsigned num_jobs)
+{
+    const tune_state_t *state = candidates[0].state;
+    for (unsigned c=0; c<num_candidates; c++) {
+        candidates[c].cost = INVALID_COST;
+    }
+    num_evaluations += num_candidates;
+    if (state->samples == NULL) {
+        for (unsigned c=0; c<num_candidates; c++) {
+            if (is_valid(candidates[c].values)) {
+                candidates[c].cost = evaluate_on_device(state, candidates[c].values);
+            }
+        }
+        return;
+    }
+    // the simulations are independent, run num_jobs of them at a time
+    for (unsigned first=0; first<num_candidates; first+=num_jobs) {
+        unsigned num_threads = (num_candidates - first < num_jobs) ? num_candidates - first : num_jobs;
+#if defined(_WIN32)
+        HANDLE threads[AUTOTUNE_MAX_PARAMS * 2];
+#else
+        pthread_t threads[AUTOTUNE_MAX_PARAMS * 2];
+#endif
+        unsigned started[AUTOTUNE_MAX_PARAMS * 2];
+        for (unsigned t=0; t<num_threads; t++) {
+            tune_candidate_t *candidate = &candidates[first + t];
+            started[t] = 0;
+            if (!is_valid(candidate->values)) {
+                continue;
+            }
+#if defined(_WIN32)
+            threads[t] = CreateThread(NULL, 0, simulate_thread, candidate, 0, NULL);
+            started[t] = (threads[t] != NULL);
+#else
+            started[t] = (pthread_create(&threads[t], NULL, simulate_thread, candidate) == 0);
+#endif
+            if (!started[t]) {
+                simulate_thread(candidate);
+            }
+        }
+        for (unsigned t=0; t<num_threads; t++) {
+            if (started[t]) {
+#if defined(_WIN32)
+                WaitForSingleObject(threads[t], INFINITE);
+                CloseHandle(threads[t]);
+#else
+                pthread_join(threads[t], NULL);
+#endif
+            }
+        }
+    }
+}
+
+// The parameters which are not tuned are read too, for the threshold and gain checks of the candidates
+static int read_device_values(tune_state_t *state)
+{
+    for (unsigned p=0; p<NUM_TUNE_PARAMS; p++) {
+        const tune_param_t *param = &tune_params[p];
+        unsigned tuned = 0;
+        for (unsigned i=0; i<state->num_params; i++) {
+            tuned |= (state->param_idx[i] == p);
+        }
+        int ret;
+        if (param->is_int) {
+            int32_t value;
+            ret = vfctrl_get_int(param->get_id, &value);
+            state->values[p] = value;
+        } else {
+            float value;
+            ret = vfctrl_get_float(param->get_id, &value);
+            state->values[p] = value;
+        }
+        if (ret != 0 && tuned) {
+            printf("Error: GET_%s returned %d\n", param->name, ret);
+            return ret;
+        } else if (ret != 0) {
+            state->values[p] = param->sim_default;
+        }
+    }
+    return 0;
+}
+
+static int write_settings(const tune_state_t *state, const char *filename)
+{
+    FILE *fp = fopen(filename, "w");
+    if (fp == NULL) {
+        printf("Error: cannot open %s\n", filename);
+        return -1;
+    }
+    fprintf(fp, "# Settings found by vfctrl --autotune\n");
+    for (unsigned i=0; i<state->num_params; i++) {
+        unsigned p = state->param_idx[i];
+        fprintf(fp, "SET_%s %.9g\n", tune_params[p].name, state->values[p]);
+    }
+    fclose(fp);
+    return 0;
+}
+
+int run_autotune(autotune_config_t *config)
+{
+    static tune_state_t state;
+    int32_t *samples = NULL;
+    unsigned simulate = (config->wav_file != NULL);
+    unsigned num_jobs = simulate ? config->num_jobs : 1;
+    if (num_jobs < 1) {
+        num_jobs = 1;
+    } else if (num_jobs > AUTOTUNE_MAX_PARAMS * 2) {
+        num_jobs = AUTOTUNE_MAX_PARAMS * 2;
+    }
+
+    memset(&state, 0, sizeof(state));
+    state.config = config;
+    if (parse_params(&state, config->param_list, simulate) != 0) {
+        return 1;
+    }
+    if (simulate) {
+        wav_info_t info;
+        if (wav_load_channel(config->wav_file, 0, &samples, &info) != 0) {
+            return 1;
+        }
+        state.samples = samples;
+        state.num_samples = info.num_frames;
+        state.sample_rate = info.sample_rate;
+        for (unsigned p=0; p<NUM_TUNE_PARAMS; p++) {
+            state.values[p] = tune_params[p].sim_default;
+        }
+        printf("Tuning the AGC simulator on %.1f s of %s, %u simulations in parallel\n",
+               (double)info.num_frames / info.sample_rate, config->wav_file, num_jobs);
+    } else {
+        if (read_device_values(&state) != 0) {
+            return 1;
+        }
+        printf("Tuning the device, %u ms per setting. Keep the test audio playing until the end\n",
+               config->settle_ms + config->window_ms);
+    }
+
+    // the device is measured with two candidates per parameter, the simulator with one per job
+    unsigned num_candidates = (num_jobs < 2) ? 2 : num_jobs & ~1u;
+    double steps[NUM_TUNE_PARAMS];
+    tune_candidate_t candidates[AUTOTUNE_MAX_PARAMS * 2];
+    tune_candidate_t current = {&state, {0}, 0};
+    for (unsigned p=0; p<NUM_TUNE_PARAMS; p++) {
+        steps[p] = tune_params[p].step;
+    }
+    memcpy(current.values, state.values, sizeof(current.values));
+    evaluate(&current, 1, 1);
+    double start_cost = current.cost;
+    if (start_cost >= INVALID_COST) {
+        printf("Warning: the start settings cannot be evaluated\n");
+    } else {
+        printf("Start cost %.4f\n", start_cost);
+    }
+    uint64_t start_us = vfctrl_get_time_us();
+
+    for (unsigned pass=0; pass<config->num_passes; pass++) {
+        unsigned num_moved = 0;
+        for (unsigned i=0; i<state.num_params; i++) {
+            unsigned p = state.param_idx[i];
+            const tune_param_t *param = &tune_params[p];
+            if (is_converged(param, steps[p])) {
+                continue;
+            }
+            // candidates on both sides, the ones clamped onto the current value or onto each other are dropped
+            unsigned n = 0;
+            for (int k=1; k<=(int)num_candidates; k++) {
+                for (int sign=-1; sign<=1 && n<num_candidates; sign+=2) {
+                    double value = step_value(param, current.values[p], steps[p], sign * k);
+                    unsigned duplicate = (value == current.values[p]);
+                    for (unsigned c=0; c<n; c++) {
+                        duplicate |= (value == candidates[c].values[p]);
+                    }
+                    if (!duplicate) {
+                        candidates[n] = current;
+                        candidates[n].values[p] = value;
+                        n++;
+                    }
+                }
+            }
+            if (n == 0) {
+                steps[p] = 0;
+                continue;
+            }
+            evaluate(candidates, n, num_jobs);
+            int best = -1;
+            for (unsigned c=0; c<n; c++) {
+                if (candidates[c].cost < current.cost && (best < 0 || candidates[c].cost < candidates[best].cost)) {
+                    best = c;
+                }
+            }
+            if (best >= 0) {
+                printf("Pass %u: %s %.6g -> %.6g, cost %.4f -> %.4f\n", pass + 1, param->name,
+                       current.values[p], candidates[best].values[p], current.cost, candidates[best].cost);
+                current = candidates[best];
+                num_moved++;
+            } else {
+                steps[p] = param->log_scale ? sqrt(steps[p]) : steps[p] / 2;
+            }
+        }
+        if (num_moved == 0 && pass > 0) {
+            unsigned converged = 1;
+            for (unsigned i=0; i<state.num_params; i++) {
+                unsigned p = state.param_idx[i];
+                converged &= is_converged(&tune_params[p], steps[p]);
+            }
+            if (converged) {
+                break;
+            }
+        }
+    }
+    double elapsed_s = (vfctrl_get_time_us() - start_us) / 1e6;
+    memcpy(state.values, current.values, sizeof(state.values));
+    if (current.cost >= INVALID_COST) {
+        printf("Error: no setting could be evaluated in %u evaluations\n", num_evaluations);
+        free(samples);
+        return 1;
+    }
+    if (start_cost < INVALID_COST) {
+        printf("Cost %.4f -> ", start_cost);
+    } else {
+        printf("Cost ");
+    }
+    printf("%.4f after %u evaluations in %.1f s\n", current.cost, num_evaluations, elapsed_s);
+
+    int ret = 0;
+    if (!simulate) {
+        // leave the device with the best settings
+        ret = apply_values(&state, state.values);
+    }
+    for (unsigned i=0; i<state.num_params; i++) {
+        unsigned p = state.param_idx[i];
+        printf("SET_%s %.9g\n", tune_params[p].name, state.values[p]);
+    }
+    if (ret == 0 && config->output_file != NULL) {
+        ret = write_settings(&state, config->output_file);
+        if (ret == 0) {
+            printf("Settings written to %s\n", config->output_file);
+        }
+    }
+    free(samples);
+    return (ret != 0) ? 1 : 0;
+}
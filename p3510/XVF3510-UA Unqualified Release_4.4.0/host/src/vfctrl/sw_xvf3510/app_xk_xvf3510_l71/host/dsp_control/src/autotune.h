@@ -0,0 +1,29 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#define AUTOTUNE_DEFAULT_PASSES     (4)
+#define AUTOTUNE_DEFAULT_JOBS       (4)
+#define AUTOTUNE_DEFAULT_WINDOW_MS  (5000)
+#define AUTOTUNE_DEFAULT_SETTLE_MS  (2000)
+#define AUTOTUNE_DEFAULT_LEVEL_DBFS (-20.0)
+#define AUTOTUNE_MAX_PARAMS         (16)
+
+typedef struct {
+    unsigned enabled;
+    const char *param_list;   // comma separated parameter names, all the parameters of the evaluator if NULL
+    const char *wav_file;     // tune the AGC simulator on this recording instead of the device
+    unsigned num_passes;      // coordinate descent passes over all the parameters
+    unsigned num_jobs;        // simulations run in parallel
+    unsigned window_ms;       // device measurement time of each setting
+    unsigned settle_ms;       // device time allowed for the setting to take effect before measuring
+    double level_dbfs;        // simulator target speech level
+    const char *output_file;  // best settings as SET_ commands, for --batch or --apply
+} autotune_config_t;
+
+// Search the AGC and ADEC settings which minimise the level instability and maximise the ERLE.
+// Each parameter in turn is moved to the best of a set of candidate values around it, and the
+// candidate spread is halved when none of them improves the objective.
+int run_autotune(autotune_config_t *config);
+
+#endif
@@ -0,0 +1,217 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+// Fixed point model of the output filter biquads, to check coefficients before they are written
+#include <math.h>
+#include <string.h>
+#include "biquad_sim.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define RESPONSE_NUM_POINTS   (1024)
+#define IMPULSE_NUM_SAMPLES   (16384)
+
+int biquad_coeffs_to_q28(const double coeffs[BIQUAD_NUM_COEFFS], int32_t q_coeffs[BIQUAD_NUM_COEFFS])
+{
+    const double max_coeff = (double)INT32_MAX / (1 << BIQUAD_Q_FORMAT);
+    const double min_coeff = (double)INT32_MIN / (1 << BIQUAD_Q_FORMAT);
+    int num_out_of_range = 0;
+    for (unsigned i=0; i<BIQUAD_NUM_COEFFS; i++) {
+        double f = coeffs[i];
+        unsigned write_idx = i;
+        if (((i%5) == 0) || ((i%5) == 1)) {
+            f = -f;          // a1 and a2 are negated
+            write_idx += 3;  // reorder to b0,b1,b2,a1,a2
+        } else {
+            write_idx -= 2;
+        }
+        if (f > max_coeff || f < min_coeff) {
+            f = (f > 0) ? max_coeff : min_coeff;
+            num_out_of_range++;
+        }
+        // round to nearest, computed with 20 extra bits as the firmware tools do
+        q_coeffs[write_idx] = (int32_t)((int64_t)(f * ((uint64_t)1 << (BIQUAD_Q_FORMAT + 20)) + (1 << 19)) >> 20);
+    }
+    return num_out_of_range;
+}
+
+void biquad_cascade_init(biquad_cascade_t *bq, const int32_t q_coeffs[BIQUAD_NUM_COEFFS])
+{
+    memset(bq, 0, sizeof(biquad_cascade_t));
+    memcpy(bq->coeffs, q_coeffs, sizeof(bq->coeffs));
+}
+
+// 64-bit multiply accumulate which wraps like the device accumulator and counts the wraps
+static inline int64_t mac_wrap(int64_t acc, int32_t a, int32_t b, uint64_t *num_overflows)
+{
+    int64_t p = (int64_t)a * b;
+    int64_t sum = (int64_t)((uint64_t)acc + (uint64_t)p);
+    // the sum wrapped if both terms have the same sign and the result has the other one
+    if (((acc ^ sum) & (p ^ sum)) < 0) {
+        (*num_overflows)++;
+    }
+    return sum;
+}
+
+void biquad_cascade_process(biquad_cascade_t *bq, const int32_t *in, int32_t *out, size_t num_samples)
+{
+    for (size_t n=0; n<num_samples; n++) {
+        int32_t x = in[n];
+        for (unsigned s=0; s<BIQUAD_NUM_STAGES; s++) {
+            const int32_t *c = bq->coeffs[s];
+            int32_t *st = bq->state[s];
+            int64_t acc = (int64_t)1 << (BIQUAD_Q_FORMAT - 1);
+            acc = mac_wrap(acc, c[0], x, &bq->num_overflows[s]);
+            acc = mac_wrap(acc, c[1], st[0], &bq->num_overflows[s]);
+            acc = mac_wrap(acc, c[2], st[1], &bq->num_overflows[s]);
+            acc = mac_wrap(acc, c[3], st[2], &bq->num_overflows[s]);
+            acc = mac_wrap(acc, c[4], st[3], &bq->num_overflows[s]);
+            acc >>= BIQUAD_Q_FORMAT;
+            int32_t y;
+            if (acc > INT32_MAX) {
+                y = INT32_MAX;
+                bq->num_saturations[s]++;
+            } else if (acc < INT32_MIN) {
+                y = INT32_MIN;
+                bq->num_saturations[s]++;
+            } else {
+                y = (int32_t)acc;
+            }
+            st[1] = st[0];
+            st[0] = x;
+            st[3] = st[2];
+            st[2] = y;
+            x = y;
+        }
+        out[n] = x;
+    }
+    bq->num_samples += num_samples;
+}
+
+// Value and group delay contribution of 1 + p1 z^-1 + p2 z^-2 style polynomials at z = e^(jw)
+static void poly_response(const double p[3], double w, double *re, double *im, double *delay)
+{
+    double r = 0, i = 0, dr = 0, di = 0;
+    for (unsigned n=0; n<3; n++) {
+        double c = cos(w * n);
+        double s = -sin(w * n);
+        r += p[n] * c;
+        i += p[n] * s;
+        dr += n * p[n] * c;
+        di += n * p[n] * s;
+    }
+    *re = r;
+    *im = i;
+    // group delay of a polynomial in z^-1: Re(sum n p[n] z^-n / P(z))
+    double mag2 = r * r + i * i;
+    *delay = (mag2 > 0) ? (dr * r + di * i) / mag2 : 0;
+}
+
+static void stage_polys(const int32_t *c, double num[3], double den[3])
+{
+    const double scale = 1.0 / (1 << BIQUAD_Q_FORMAT);
+    num[0] = c[0] * scale;
+    num[1] = c[1] * scale;
+    num[2] = c[2] * scale;
+    den[0] = 1.0;
+    den[1] = -c[3] * scale;
+    den[2] = -c[4] * scale;
+}
+
+static void stages_response(const int32_t q_coeffs[BIQUAD_NUM_COEFFS], unsigned num_stages, double w,
+                            double *mag_db, double *phase_rad, double *group_delay)
+{
+    double re = 1, im = 0, delay = 0;
+    for (unsigned s=0; s<num_stages; s++) {
+        double num[3], den[3];
+        double nr, ni, nd, dr, di, dd;
+        stage_polys(&q_coeffs[s * BIQUAD_COEFFS_PER_STAGE], num, den);
+        poly_response(num, w, &nr, &ni, &nd);
+        poly_response(den, w, &dr, &di, &dd);
+        // H = N / D
+        double d2 = dr * dr + di * di;
+        double hr = (nr * dr + ni * di) / d2;
+        double hi = (ni * dr - nr * di) / d2;
+        double tr = re * hr - im * hi;
+        im = re * hi + im * hr;
+        re = tr;
+        delay += nd - dd;
+    }
+    *mag_db = 10 * log10(re * re + im * im + 1e-300);
+    *phase_rad = atan2(im, re);
+    *group_delay = delay;
+}
+
+void biquad_cascade_response(const int32_t q_coeffs[BIQUAD_NUM_COEFFS], double freq, double sample_rate,
+                             double *mag_db, double *phase_rad, double *group_delay)
+{
+    stages_response(q_coeffs, BIQUAD_NUM_STAGES, 2 * M_PI * freq / sample_rate, mag_db, phase_rad, group_delay);
+}
+
+// Largest magnitude of the roots of z^2 + d1 z + d2
+static double pole_radius(double d1, double d2)
+{
+    double disc = d1 * d1 - 4 * d2;
+    if (disc >= 0) {
+        double r1 = fabs((-d1 + sqrt(disc)) / 2);
+        double r2 = fabs((-d1 - sqrt(disc)) / 2);
+        return (r1 > r2) ? r1 : r2;
+    }
+    // complex conjugate poles
+    return sqrt(d2);
+}
+
+int biquad_cascade_check(const double coeffs[BIQUAD_NUM_COEFFS], biquad_check_t *check)
+{
+    int32_t q_coeffs[BIQUAD_NUM_COEFFS];
+    int ret = 0;
+    memset(check, 0, sizeof(biquad_check_t));
+    check->num_out_of_range = biquad_coeffs_to_q28(coeffs, q_coeffs);
+    if (check->num_out_of_range > 0) {
+        ret = -1;
+    }
+
+    for (unsigned s=0; s<BIQUAD_NUM_STAGES; s++) {
+        double num[3], den[3];
+        stage_polys(&q_coeffs[s * BIQUAD_COEFFS_PER_STAGE], num, den);
+        check->pole_radius[s] = pole_radius(den[1], den[2]);
+        if (check->pole_radius[s] >= 1.0) {
+            ret = -1;
+        }
+        check->peak_gain_db[s] = -INFINITY;
+        for (unsigned k=0; k<=RESPONSE_NUM_POINTS; k++) {
+            double mag_db, phase, delay;
+            stages_response(q_coeffs, s + 1, M_PI * k / RESPONSE_NUM_POINTS, &mag_db, &phase, &delay);
+            if (mag_db > check->peak_gain_db[s]) {
+                check->peak_gain_db[s] = mag_db;
+            }
+        }
+    }
+    if (ret < 0) {
+        return ret;
+    }
+
+    // worst case gain from the impulse response, in floating point to see past the quantisation
+    double state[BIQUAD_NUM_STAGES][4] = {{0}};
+    for (unsigned n=0; n<IMPULSE_NUM_SAMPLES; n++) {
+        double x = (n == 0) ? 1.0 : 0.0;
+        for (unsigned s=0; s<BIQUAD_NUM_STAGES; s++) {
+            double num[3], den[3];
+            double *st = state[s];
+            stage_polys(&q_coeffs[s * BIQUAD_COEFFS_PER_STAGE], num, den);
+            double y = num[0] * x + num[1] * st[0] + num[2] * st[1] - den[1] * st[2] - den[2] * st[3];
+            st[1] = st[0];
+            st[0] = x;
+            st[3] = st[2];
+            st[2] = y;
+            check->l1_gain[s] += fabs(y);
+            x = y;
+        }
+    }
+    for (unsigned s=0; s<BIQUAD_NUM_STAGES; s++) {
+        if (check->l1_gain[s] > 1.0) {
+            ret = 1;
+        }
+    }
+    return ret;
+}
@@ -0,0 +1,48 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#ifndef BIQUAD_SIM_H
+#define BIQUAD_SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Host model of the output filters set by SET_FILTER_COEFF: a cascade of biquads with Q28 coefficients.
+// The arithmetic follows the device: the five products are accumulated in 64 bits starting from the
+// rounding constant 1 << (Q - 1), the sum is shifted right by Q and saturated to 32 bits, and the
+// saturated output is kept as the feedback state (direct form I).
+#define BIQUAD_Q_FORMAT           (28) // Must match Q_FORMAT_FILTER
+#define BIQUAD_NUM_STAGES         (2)  // Must match NUM_STAGES_PER_FILTER
+#define BIQUAD_COEFFS_PER_STAGE   (5)
+#define BIQUAD_NUM_COEFFS         (BIQUAD_NUM_STAGES * BIQUAD_COEFFS_PER_STAGE)
+
+typedef struct {
+    int32_t coeffs[BIQUAD_NUM_STAGES][BIQUAD_COEFFS_PER_STAGE]; // b0, b1, b2, -a1, -a2
+    int32_t state[BIQUAD_NUM_STAGES][4];                        // x[n-1], x[n-2], y[n-1], y[n-2]
+    uint64_t num_saturations[BIQUAD_NUM_STAGES];                // outputs clipped to 32 bits
+    uint64_t num_overflows[BIQUAD_NUM_STAGES];                  // 64-bit accumulator wrap arounds
+    uint64_t num_samples;
+} biquad_cascade_t;
+
+// Convert the coefficients in the order of SET_FILTER_COEFF, (a1, a2, b0, b1, b2) per stage with a0 = 1,
+// into the Q28 words sent to the device, (b0, b1, b2, -a1, -a2) per stage.
+// Returns the number of coefficients which do not fit the Q28 range, those are clipped.
+int biquad_coeffs_to_q28(const double coeffs[BIQUAD_NUM_COEFFS], int32_t q_coeffs[BIQUAD_NUM_COEFFS]);
+
+void biquad_cascade_init(biquad_cascade_t *bq, const int32_t q_coeffs[BIQUAD_NUM_COEFFS]);
+void biquad_cascade_process(biquad_cascade_t *bq, const int32_t *in, int32_t *out, size_t num_samples);
+
+// Response of the quantised cascade at freq / sample_rate. The group delay is in samples.
+void biquad_cascade_response(const int32_t q_coeffs[BIQUAD_NUM_COEFFS], double freq, double sample_rate,
+                             double *mag_db, double *phase_rad, double *group_delay);
+
+typedef struct {
+    unsigned num_out_of_range;                 // coefficients clipped to the Q28 range
+    double pole_radius[BIQUAD_NUM_STAGES];     // largest pole magnitude, unstable from 1.0
+    double peak_gain_db[BIQUAD_NUM_STAGES];    // peak gain of the cascade up to each stage
+    double l1_gain[BIQUAD_NUM_STAGES];         // worst case gain up to each stage, sum of |h[n]|
+} biquad_check_t;
+
+// Check the coefficients before they are written. Returns -1 if they must not be used,
+// coefficients out of range or an unstable stage, 1 if a full scale input can saturate and 0 otherwise.
+int biquad_cascade_check(const double coeffs[BIQUAD_NUM_COEFFS], biquad_check_t *check);
+
+#endif
@@ -0,0 +1,171 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+// Binary data partition output, rendered by the data partition generator without the JSON text
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdbool.h>
+#include "host_control_api.h"
+#include "data_image_layout.h"
+#include "inputs.h"
+#include "input_reader.h"
+#include "renderer.h"
+#include "dp_capture.h"
+
+// item type of the control commands, as in the JSON printed with --log-data-partition
+#define DP_ITEM_TYPE_CONTROL    (3)
+
+// used by the data partition generator sources
+bool verbose = false;
+
+static struct item *item_list = NULL;
+static struct item **item_list_end = &item_list;
+static unsigned num_items = 0;
+
+static void append_item(unsigned type, const uint8_t *bytes, unsigned num_bytes)
+{
+    struct item *item = malloc(sizeof(struct item));
+    item->type = type;
+    item->bytes = NULL;
+    if (num_bytes > 0) {
+        item->bytes = malloc(num_bytes);
+        memcpy(item->bytes, bytes, num_bytes);
+    }
+    item->num_bytes = num_bytes;
+    item->next = NULL;
+    *item_list_end = item;
+    item_list_end = &item->next;
+    num_items++;
+}
+
+static void add_item(const uint8_t *bytes, unsigned num_bytes)
+{
+    append_item(DP_ITEM_TYPE_CONTROL, bytes, num_bytes);
+}
+
+static void free_items(void)
+{
+    while (item_list != NULL) {
+        struct item *next = item_list->next;
+        free(item_list->bytes);
+        free(item_list);
+        item_list = next;
+    }
+    item_list_end = &item_list;
+    num_items = 0;
+}
+
+int parse_dp_format(const char *format, dp_format_t *dp_format)
+{
+    if (strcmp(format, "items") == 0) {
+        *dp_format = DP_FORMAT_ITEMS;
+    } else if (strcmp(format, "upgrade") == 0) {
+        *dp_format = DP_FORMAT_UPGRADE;
+    } else if (strcmp(format, "factory") == 0) {
+        *dp_format = DP_FORMAT_FACTORY;
+    } else {
+        printf("Error: unknown data partition format %s, use items, upgrade or factory\n", format);
+        return -1;
+    }
+    return 0;
+}
+
+int dp_capture_start(dp_capture_config_t *config)
+{
+    if (config->format == DP_FORMAT_FACTORY && (config->hardware_build == 0 || config->spispec_file == NULL)) {
+        printf("Error: a factory image needs --dp-hardware-build and --dp-spispec\n");
+        return -1;
+    }
+    if (config->format != DP_FORMAT_ITEMS && config->sector_size == 0) {
+        printf("Error: invalid sector size\n");
+        return -1;
+    }
+    if (config->output_file != NULL) {
+        vfctrl_set_data_partition_sink(add_item);
+    }
+    return 0;
+}
+
+static int write_stream(const char *file_name, struct byte_stream *stream)
+{
+    FILE *fp = fopen(file_name, "wb");
+    if (fp == NULL) {
+        printf("Error: cannot open %s\n", file_name);
+        return -1;
+    }
+    int ret = (fwrite(stream->bytes, 1, stream->length, fp) == stream->length) ? 0 : -1;
+    if (fclose(fp) != 0 || ret != 0) {
+        printf("Error: cannot write %s\n", file_name);
+        return -1;
+    }
+    return 0;
+}
+
+int dp_capture_finish(dp_capture_config_t *config)
+{
+    int ret = 0;
+    if (config->output_file == NULL) {
+        return 0;
+    }
+    vfctrl_set_data_partition_sink(NULL);
+
+    struct images images;
+    memset(&images, 0, sizeof(images));
+    struct image *image = (config->format == DP_FORMAT_FACTORY) ? &images.factory : &images.upgrade;
+    image->in_use = true;
+    image->item_list = item_list;
+    if (config->version != NULL) {
+        if (sscanf(config->version, "%d.%d.%d", &image->compatibility_version.major,
+                   &image->compatibility_version.minor, &image->compatibility_version.patch) != 3) {
+            printf("Error: invalid compatibility version %s, X.Y.Z expected\n", config->version);
+            free_items();
+            return -1;
+        }
+    } else {
+        vfctrl_get_host_version(&image->compatibility_version.major, &image->compatibility_version.minor,
+                                &image->compatibility_version.patch);
+    }
+
+    struct byte_stream stream;
+    if (config->format == DP_FORMAT_ITEMS) {
+        // no terminator, so the items can be combined with others
+        stream = render_item_list(item_list);
+    } else {
+        struct spispec spispec = {false, "", NULL, 0};
+        unsigned num_control_items = num_items;
+        append_item(DP_IMAGE_TYPE_TERMINATOR, NULL, 0);
+        num_items = num_control_items;
+        if (config->format == DP_FORMAT_FACTORY) {
+            spispec = read_flash_specification(config->spispec_file);
+        }
+        stream = render_byte_stream(&images, config->hardware_build, NULL, spispec, config->sector_size, false, false);
+        if (spispec.valid) {
+            free(spispec.bytes);
+        }
+    }
+    ret = write_stream(config->output_file, &stream);
+    if (ret == 0) {
+        printf("Wrote %u items, %u bytes to %s\n", num_items, (unsigned)stream.length, config->output_file);
+    }
+    cleanup_byte_stream(stream);
+    free_items();
+    return ret;
+}
+
+int run_dp_capture(dp_capture_config_t *config)
+{
+    unsigned num_captured;
+    if (dp_capture_start(config) != 0) {
+        return 1;
+    }
+    uint64_t start_us = vfctrl_get_time_us();
+    int ret = vfctrl_capture_params(&num_captured);
+    printf("Captured %u settings in %.1f ms\n", num_captured, (vfctrl_get_time_us() - start_us) / 1000.0);
+    if (ret != 0) {
+        // a partial configuration is not written
+        vfctrl_set_data_partition_sink(NULL);
+        free_items();
+        return 1;
+    }
+    return (dp_capture_finish(config) != 0) ? 1 : 0;
+}
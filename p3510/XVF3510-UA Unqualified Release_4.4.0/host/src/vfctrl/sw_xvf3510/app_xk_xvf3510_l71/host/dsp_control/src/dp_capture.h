@@ -0,0 +1,30 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#ifndef DP_CAPTURE_H
+#define DP_CAPTURE_H
+
+#define DP_CAPTURE_DEFAULT_SECTOR_SIZE  (4096)
+
+typedef enum {
+    DP_FORMAT_ITEMS,    // TLV items only, with no terminator
+    DP_FORMAT_UPGRADE,  // upgrade image
+    DP_FORMAT_FACTORY,  // factory image, with the hardware build and serial number sections
+} dp_format_t;
+
+typedef struct {
+    const char *output_file;    // binary output, the items are printed as JSON if not set
+    dp_format_t format;
+    unsigned sector_size;
+    unsigned hardware_build;    // factory image only
+    const char *spispec_file;   // factory image only, flash specification as made by flash_specification_serialiser.py
+    const char *version;        // compatibility version X.Y.Z, the host app version if not set
+} dp_capture_config_t;
+
+int parse_dp_format(const char *format, dp_format_t *dp_format);
+// Collect the items logged by the commands run after this call
+int dp_capture_start(dp_capture_config_t *config);
+// Render the collected items with the data partition generator and write them to the output file
+int dp_capture_finish(dp_capture_config_t *config);
+// Capture the current settings of the device, see vfctrl_capture_params()
+int run_dp_capture(dp_capture_config_t *config);
+
+#endif
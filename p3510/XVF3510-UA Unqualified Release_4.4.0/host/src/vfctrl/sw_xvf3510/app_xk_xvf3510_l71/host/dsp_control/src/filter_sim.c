@@ -0,0 +1,240 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+// Offline check of the output filter coefficients: response and bit exact simulation on WAV files
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include <math.h>
+#include "host_control_api.h"
+#include "biquad_sim.h"
+#include "filter_sim.h"
+#include "wav_file.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define RESPONSE_TABLE_POINTS   (16)
+#define RESPONSE_FILE_POINTS    (1024)
+#define WAV_BLOCK_FRAMES        (4096)
+
+static int parse_coeffs(int num_args, char **args, double coeffs[BIQUAD_NUM_COEFFS])
+{
+    if (num_args != BIQUAD_NUM_COEFFS + 1 || strcmp(args[0], "SET_FILTER_COEFF") != 0) {
+        fprintf(stderr, "Error: --filter-sim expects SET_FILTER_COEFF followed by %d values\n", BIQUAD_NUM_COEFFS);
+        return -1;
+    }
+    for (unsigned i=0; i<BIQUAD_NUM_COEFFS; i++) {
+        char *end;
+        coeffs[i] = strtod(args[i + 1], &end);
+        if (end == args[i + 1] || *end != '\0') {
+            fprintf(stderr, "Error: invalid coefficient %s\n", args[i + 1]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static void print_check(const double coeffs[BIQUAD_NUM_COEFFS], const int32_t q_coeffs[BIQUAD_NUM_COEFFS],
+                        biquad_check_t *check)
+{
+    const double scale = 1.0 / (1 << BIQUAD_Q_FORMAT);
+    for (unsigned s=0; s<BIQUAD_NUM_STAGES; s++) {
+        const int32_t *q = &q_coeffs[s * BIQUAD_COEFFS_PER_STAGE];
+        const double *c = &coeffs[s * BIQUAD_COEFFS_PER_STAGE];
+        printf("Stage %u\n", s);
+        printf("    Q%d words (b0,b1,b2,-a1,-a2): %d %d %d %d %d\n", BIQUAD_Q_FORMAT, q[0], q[1], q[2], q[3], q[4]);
+        printf("    quantisation error (a1,a2,b0,b1,b2): %.3g %.3g %.3g %.3g %.3g\n",
+               -q[3] * scale - c[0], -q[4] * scale - c[1], q[0] * scale - c[2], q[1] * scale - c[3], q[2] * scale - c[4]);
+        printf("    pole radius %.6f%s\n", check->pole_radius[s], (check->pole_radius[s] >= 1.0) ? " UNSTABLE" : "");
+        printf("    peak gain %.2f dB", check->peak_gain_db[s]);
+        // the worst case gain is only computed for stable filters
+        if (check->l1_gain[s] > 0) {
+            printf(", worst case gain %.2f dB%s", 20 * log10(check->l1_gain[s]), (check->l1_gain[s] > 1.0) ? " CAN SATURATE" : "");
+        }
+        printf("\n");
+    }
+    if (check->num_out_of_range > 0) {
+        printf("%u coefficients do not fit Q%d, the range is [%.1f, %.1f)\n", check->num_out_of_range, BIQUAD_Q_FORMAT,
+               (double)INT32_MIN * scale, (double)INT32_MAX * scale + scale);
+    }
+}
+
+static int write_response(filter_sim_config_t *config, const int32_t q_coeffs[BIQUAD_NUM_COEFFS])
+{
+    double nyquist = config->sample_rate / 2;
+    if (config->response_file == NULL) {
+        // log spaced table from 20 Hz up to the Nyquist frequency
+        printf("%10s %10s %10s %12s\n", "freq Hz", "gain dB", "phase deg", "delay ms");
+        for (unsigned k=0; k<RESPONSE_TABLE_POINTS; k++) {
+            double f = 20 * pow(nyquist / 20, (double)k / (RESPONSE_TABLE_POINTS - 1));
+            double mag_db, phase, delay;
+            biquad_cascade_response(q_coeffs, f, config->sample_rate, &mag_db, &phase, &delay);
+            printf("%10.1f %10.2f %10.1f %12.4f\n", f, mag_db, phase * 180 / M_PI, delay * 1000 / config->sample_rate);
+        }
+        return 0;
+    }
+    FILE *fp = fopen(config->response_file, "w");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: cannot open %s\n", config->response_file);
+        return -1;
+    }
+    fprintf(fp, "freq_hz,gain_db,phase_deg,group_delay_samples\n");
+    for (unsigned k=0; k<=RESPONSE_FILE_POINTS; k++) {
+        double f = nyquist * k / RESPONSE_FILE_POINTS;
+        double mag_db, phase, delay;
+        biquad_cascade_response(q_coeffs, f, config->sample_rate, &mag_db, &phase, &delay);
+        fprintf(fp, "%.3f,%.4f,%.3f,%.4f\n", f, mag_db, phase * 180 / M_PI, delay);
+    }
+    fclose(fp);
+    printf("Response written to %s\n", config->response_file);
+    return 0;
+}
+
+static int simulate_wav(filter_sim_config_t *config, const int32_t q_coeffs[BIQUAD_NUM_COEFFS])
+{
+    static biquad_cascade_t cascades[WAV_MAX_CHANNELS];
+    static uint8_t raw[WAV_BLOCK_FRAMES * WAV_MAX_CHANNELS * 4];
+    static int32_t samples[WAV_MAX_CHANNELS][WAV_BLOCK_FRAMES];
+    wav_info_t info;
+    int ret = 0;
+
+    FILE *in = fopen(config->wav_in, "rb");
+    if (in == NULL) {
+        fprintf(stderr, "Error: cannot open %s\n", config->wav_in);
+        return -1;
+    }
+    if (wav_read_header(in, &info) != 0) {
+        fprintf(stderr, "Error: %s is not a 16, 24 or 32-bit PCM WAV file\n", config->wav_in);
+        fclose(in);
+        return -1;
+    }
+    FILE *out = NULL;
+    if (config->wav_out != NULL) {
+        out = fopen(config->wav_out, "wb");
+        if (out == NULL) {
+            fprintf(stderr, "Error: cannot open %s\n", config->wav_out);
+            fclose(in);
+            return -1;
+        }
+        wav_write_header(out, info.num_channels, info.sample_rate, info.num_frames);
+    }
+    for (unsigned ch=0; ch<info.num_channels; ch++) {
+        biquad_cascade_init(&cascades[ch], q_coeffs);
+    }
+
+    unsigned bytes_per_sample = info.bits_per_sample / 8;
+    unsigned frame_bytes = bytes_per_sample * info.num_channels;
+    uint64_t frames_left = info.num_frames;
+    int32_t peak_out = 0;
+    uint64_t start_us = vfctrl_get_time_us();
+    while (frames_left > 0) {
+        size_t num_frames = (frames_left < WAV_BLOCK_FRAMES) ? (size_t)frames_left : WAV_BLOCK_FRAMES;
+        num_frames = fread(raw, frame_bytes, num_frames, in);
+        if (num_frames == 0) {
+            break;
+        }
+        frames_left -= num_frames;
+        // deinterleave, left justified to 32 bits as the samples are on the device
+        const uint8_t *p = raw;
+        for (size_t n=0; n<num_frames; n++) {
+            for (unsigned ch=0; ch<info.num_channels; ch++) {
+                samples[ch][n] = (int32_t)(wav_get_le(p, bytes_per_sample) << (32 - info.bits_per_sample));
+                p += bytes_per_sample;
+            }
+        }
+        for (unsigned ch=0; ch<info.num_channels; ch++) {
+            biquad_cascade_process(&cascades[ch], samples[ch], samples[ch], num_frames);
+            for (size_t n=0; n<num_frames; n++) {
+                int32_t mag = (samples[ch][n] == INT32_MIN) ? INT32_MAX : abs(samples[ch][n]);
+                if (mag > peak_out) {
+                    peak_out = mag;
+                }
+            }
+        }
+        if (out != NULL) {
+            uint8_t *q = raw;
+            for (size_t n=0; n<num_frames; n++) {
+                for (unsigned ch=0; ch<info.num_channels; ch++) {
+                    wav_put_le(q, (uint32_t)samples[ch][n], 4);
+                    q += 4;
+                }
+            }
+            fwrite(raw, info.num_channels * 4, num_frames, out);
+        }
+    }
+    double elapsed_s = (vfctrl_get_time_us() - start_us) / 1e6;
+    uint64_t num_done = info.num_frames - frames_left;
+    if (frames_left > 0) {
+        fprintf(stderr, "Warning: %s is truncated, %" PRIu64 " frames missing\n", config->wav_in, frames_left);
+    }
+
+    double audio_s = (double)num_done / info.sample_rate;
+    printf("Simulated %" PRIu64 " frames x %u channels (%.1f s of audio) in %.2f s, %.0fx real time\n",
+           num_done, info.num_channels, audio_s, elapsed_s, (elapsed_s > 0) ? audio_s / elapsed_s : 0.0);
+    printf("Peak output %.2f dBFS\n", 20 * log10((peak_out + 1.0) / 2147483648.0));
+    for (unsigned ch=0; ch<info.num_channels; ch++) {
+        for (unsigned s=0; s<BIQUAD_NUM_STAGES; s++) {
+            if (cascades[ch].num_saturations[s] > 0 || cascades[ch].num_overflows[s] > 0) {
+                printf("Channel %u stage %u: %" PRIu64 " saturated samples, %" PRIu64 " accumulator overflows\n",
+                       ch, s, cascades[ch].num_saturations[s], cascades[ch].num_overflows[s]);
+                ret = 1;
+            }
+        }
+    }
+    if (ret == 0) {
+        printf("No saturation or overflow\n");
+    }
+    if (out != NULL) {
+        if (num_done != info.num_frames) {
+            fseek(out, 0, SEEK_SET);
+            wav_write_header(out, info.num_channels, info.sample_rate, num_done);
+        }
+        fclose(out);
+        printf("Output written to %s\n", config->wav_out);
+    }
+    fclose(in);
+    return ret;
+}
+
+int run_filter_sim(filter_sim_config_t *config, int num_args, char **args)
+{
+    double coeffs[BIQUAD_NUM_COEFFS];
+    int32_t q_coeffs[BIQUAD_NUM_COEFFS];
+    biquad_check_t check;
+
+    if (parse_coeffs(num_args, args, coeffs) != 0) {
+        return 1;
+    }
+    int ret = biquad_cascade_check(coeffs, &check);
+    biquad_coeffs_to_q28(coeffs, q_coeffs);
+    print_check(coeffs, q_coeffs, &check);
+    if (ret < 0) {
+        printf("These coefficients would be refused by SET_FILTER_COEFF\n");
+        return 1;
+    }
+
+    if (config->wav_in != NULL) {
+        // the response is given at the rate of the audio being filtered
+        FILE *fp = fopen(config->wav_in, "rb");
+        wav_info_t info;
+        if (fp != NULL && wav_read_header(fp, &info) == 0) {
+            config->sample_rate = info.sample_rate;
+        }
+        if (fp != NULL) {
+            fclose(fp);
+        }
+    }
+    printf("Response at %.0f Hz\n", config->sample_rate);
+    if (write_response(config, q_coeffs) != 0) {
+        return 1;
+    }
+    if (config->wav_in != NULL) {
+        ret = simulate_wav(config, q_coeffs);
+        // 2 tells scripts that the coefficients are valid but the audio saturated
+        return (ret < 0) ? 1 : (ret > 0) ? 2 : 0;
+    }
+    return 0;
+}
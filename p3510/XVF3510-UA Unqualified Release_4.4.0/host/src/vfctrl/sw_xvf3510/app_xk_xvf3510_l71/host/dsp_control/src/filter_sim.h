@@ -0,0 +1,19 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#ifndef FILTER_SIM_H
+#define FILTER_SIM_H
+
+// The filters run on the 16 kHz pipeline signals unless told otherwise
+#define FILTER_SIM_DEFAULT_FS   (16000.0)
+
+typedef struct {
+    unsigned enabled;
+    double sample_rate;         // used for the response, the WAV input sets its own
+    const char *wav_in;         // PCM WAV file filtered by the simulator
+    const char *wav_out;        // 32-bit PCM WAV file with the simulated device output
+    const char *response_file;  // CSV with the magnitude, phase and group delay
+} filter_sim_config_t;
+
+// Simulate SET_FILTER_COEFF with the values given on the command line, nothing is sent to the device
+int run_filter_sim(filter_sim_config_t *config, int num_args, char **args);
+
+#endif
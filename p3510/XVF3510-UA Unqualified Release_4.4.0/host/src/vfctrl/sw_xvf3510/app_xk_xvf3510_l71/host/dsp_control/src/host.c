@@ -18,6 +18,15 @@
 #endif
 #include "host_control_api.h"
 #include "host_control.h"
+#include "attr_cache.h"
+#include "qformat.h"
+#include "biquad_sim.h"
+#include "watch.h"
+#include "profile.h"
+#include "filter_sim.h"
+#include "dp_capture.h"
+#include "autotune.h"
+#include "aec_ir.h"
 #include <math.h>
 
 #define MAX_INT32   (0x7FFFFFFF)
@@ -31,6 +40,22 @@ HANDLE lock;
 #define LOCK_MUTEX lock=CreateMutexW(NULL, TRUE, NULL);
 #define UNLOCK_MUTEX ReleaseMutex(lock);
 
+// The Windows scheduler cannot sleep for less than a millisecond
+void vfctrl_sleep_us(unsigned microseconds)
+{
+    Sleep((microseconds + 999) / 1000);
+}
+
+uint64_t vfctrl_get_time_us(void)
+{
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    // split so that the multiplication cannot overflow after days of uptime
+    return (uint64_t)((count.QuadPart / freq.QuadPart) * 1000000 +
+                      (count.QuadPart % freq.QuadPart) * 1000000 / freq.QuadPart);
+}
+
 #else
 #include <pthread.h>
 pthread_mutex_t lock;
@@ -47,6 +72,18 @@ void Sleep(unsigned milliseconds)
 {
     usleep(milliseconds*1000);
 }
+
+void vfctrl_sleep_us(unsigned microseconds)
+{
+    usleep(microseconds);
+}
+
+uint64_t vfctrl_get_time_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
 #endif
 
 // htonll() and ntohll() are not available on same OS, for example Raspian
@@ -71,25 +108,23 @@ int g_vendor_id;
 
 #define TEMP_STR_MAX_CHARS  (1000)
 #define CMD_LIST_MAX_CHARS  (10000)
+// maximum number of coefficient reads in flight in get_multiple_struct_val_from_device()
+#define MAX_SIMULTANEOUS_CMDS (8)
 
 
 int total_num_commands;
 cmdspec_t *cmdspec_ap = NULL;
+// storage of the command table, no command is allocated on the heap
+cmdspec_t cmdspec_table[VFCTRL_NUM_CMDS];
+// index in cmdspec_ap of each command id, -1 for the commands not in this build
+int cmd_id_to_num[VFCTRL_NUM_CMDS];
 int setup_err = 1;
 char cmd_list[CMD_LIST_MAX_CHARS];
 
 // number of bytes per line shown in the JSON data partition file
 #define LOG_BYTES_PER_LINE (16)
-
-void host_shutdown(int exit_code){
-    #if USE_USB
-    control_cleanup_usb();
-    #elif USE_I2C
-    control_cleanup_i2c();
-    #endif
-    UNLOCK_MUTEX
-    exit(exit_code);
-}
+// receives the data partition items instead of print_log_partition_info() when set
+vfctrl_dp_item_sink_t dp_item_sink = NULL;
 
 int get_size_from_type(param_type type)
 {
@@ -116,7 +151,6 @@ int get_size_from_type(param_type type)
             break;
         default:
             printf("Error: invalid type %d\n", type);
-            host_shutdown(1);
     }
     return ret_val;
 }
@@ -148,7 +182,6 @@ int get_app_read_result_size(param_type type)
             break;
         default:
             printf("Error: invalid type %d\n", type);
-            host_shutdown(1);
     }
     return ret_val;
 }
@@ -187,20 +220,21 @@ cmdspec_t cmd_con(control_resid_t resid,
     return cmd;
 }
 
-void print_set_io_map(int_float* vals)
+int print_set_io_map(int_float* vals)
 {
     int max_value = sizeof(output_io_map_str)/sizeof(char*) - 1;
     if (vals[0].ui8 > max_value) {
         fprintf(stderr, "Error: first argument is invalid: max value %d, given value: %d\n", max_value, vals[0].ui8);
-        host_shutdown(-1);
+        return -1;
     }
     max_value = sizeof(input_io_map_str)/sizeof(char*) - 1;
     if (vals[1].ui8 > max_value) {
         fprintf(stderr, "Error: second argument is invalid: max value %d, given value: %d\n", max_value, vals[1].ui8);
-        host_shutdown(-1);
+        return -1;
     }
 
     printf("\n******* set_io_map %s %s ******\n\n", output_io_map_str[vals[0].ui8], input_io_map_str[vals[1].ui8]);
+    return 0;
 }
 
 char* format_io_map(uint8_t *vals, char *io_map_string)
@@ -274,6 +308,7 @@ char* format_locker_state(uint32_t *vals, char *state_string)
 
 #if USE_I2C
     #define MAX_NUM_OF_INT_PER_TRANSFER ( I2C_DATA_MAX_BYTES/sizeof(unsigned) )
+    void open_i2c_attr_cache(unsigned i2c_address);
     int i2c_setup(void)
     {
 
@@ -281,22 +316,25 @@ char* format_locker_state(uint32_t *vals, char *state_string)
         unsigned i2c_shift = 0;
         if (control_init_i2c(i2c_address << i2c_shift) != CONTROL_SUCCESS) { //Note on some RPI the I2C address needs left shifting by one
             fprintf(stderr, "Error: Control initialisation over I2C failed, address 0x%02x<<%d\n", i2c_address, i2c_shift);
-            host_shutdown(-1);
+            return -1;
         }
 
         unsigned char data[3];
         control_ret_t connected = control_read_command(CONTROL_SPECIAL_RESID, CONTROL_GET_VERSION, data, sizeof(control_version_t));
         if (connected != CONTROL_SUCCESS) {
             fprintf(stderr, "Error: Unable to find I2C device at address 0x%02x\n", i2c_address);
-            host_shutdown(-1);
+            control_cleanup_i2c();
+            return -1;
         }
         control_version_t version = data[0];
 
         if (version != CONTROL_VERSION) {
             fprintf(stderr, "Error: Mismatch of the control version between host and device. Expected 0x%X, received 0x%X\n", CONTROL_VERSION, version);
-            host_shutdown(-1);
+            control_cleanup_i2c();
+            return -1;
         }
 
+        open_i2c_attr_cache(i2c_address);
         return 0;
     }
 #elif USE_USB
@@ -307,17 +345,33 @@ char* format_locker_state(uint32_t *vals, char *state_string)
 
         if(control_init_usb(g_vendor_id, g_product_id, 3) != CONTROL_SUCCESS) {
             fprintf(stderr, "Error: Control initialisation over USB failed\n");
-            host_shutdown(-1);
+            return -1;
+        }
+
+#ifndef __ANDROID__
+        // the serial number and bcdDevice identify the device in the attribute cache
+        char serial[CMD_MAX_BYTES];
+        unsigned bcd_device;
+        if (control_get_usb_device_id(serial, sizeof(serial), &bcd_device) == CONTROL_SUCCESS && serial[0] != '\0') {
+            char key[ATTR_CACHE_KEY_MAX_CHARS];
+            snprintf(key, sizeof(key), "usb:%04x:%04x:%s:%04x", g_vendor_id, g_product_id, serial, bcd_device);
+            attr_cache_open(key);
         }
+#endif
 
-        if (control_query_version(&version) != CONTROL_SUCCESS) {
-            fprintf(stderr, "Error: Control query version failed\n");
-            host_shutdown(-1);
+        if (attr_cache_get(CONTROL_SPECIAL_RESID, CONTROL_GET_VERSION, &version, sizeof(version)) != 0) {
+            if (control_query_version(&version) != CONTROL_SUCCESS) {
+                fprintf(stderr, "Error: Control query version failed\n");
+                control_cleanup_usb();
+                return -1;
+            }
+            attr_cache_put(CONTROL_SPECIAL_RESID, CONTROL_GET_VERSION, &version, sizeof(version));
         }
 
         if (version != CONTROL_VERSION) {
             fprintf(stderr, "Error: Mismatch of the control version between host and device. Expected 0x%X, received 0x%X\n", CONTROL_VERSION, version);
-            host_shutdown(-1);
+            control_cleanup_usb();
+            return -1;
         }
 
         return 0;
@@ -420,6 +474,39 @@ uint8_t is_same_string_ending(const char * const full_string, const char * const
     return is_same_ending;
 }
 
+// Values which only change with the firmware or the data partition, served from the attribute cache
+static const char *cacheable_cmds[] = {
+    "GET_VERSION",
+    "GET_BLD_MSG",
+    "GET_BLD_HOST",
+    "GET_BLD_REPO_HASH",
+    "GET_BLD_XGIT_VIEW",
+    "GET_BLD_XGIT_HASH",
+    "GET_BLD_MODIFIED",
+    "GET_USB_VENDOR_ID",
+    "GET_USB_PRODUCT_ID",
+    "GET_USB_BCD_DEVICE",
+    "GET_USB_VENDOR_STRING",
+    "GET_USB_PRODUCT_STRING",
+    "GET_SERIAL_NUMBER",
+};
+
+uint8_t is_cacheable(cmdspec_t current)
+{
+    for (unsigned i=0; i<sizeof(cacheable_cmds)/sizeof(cacheable_cmds[0]); i++) {
+        if (strcmp(current.par_name, cacheable_cmds[i]) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Writes which can change the cached values, the USB descriptors are set from the flash
+uint8_t invalidates_cache(cmdspec_t current)
+{
+    return !strncmp(current.par_name, "SET_USB_", strlen("SET_USB_")) || !strcmp(current.par_name, "SET_SERIAL_NUMBER");
+}
+
 int write_payload_byte_array(cmdspec_t current, int num_values, int_float *ptr_data, uint8_t *payload)
 {
     unsigned data_size = current.device_rw_size;
@@ -525,7 +612,17 @@ control_ret_t set_struct_val_on_device(cmdspec_t current, int_float *ptr_struct_
     write_payload_byte_array(current, num_values, ptr_struct_val, payload);
 
     if (log_for_data_partition) {
-        print_log_partition_info(current, num_values, payload_bytes, payload);
+        if (dp_item_sink != NULL) {
+            // the same bytes as the JSON item
+            uint8_t item_bytes[3 + CMD_MAX_BYTES];
+            item_bytes[0] = current.resid;
+            item_bytes[1] = current.offset;
+            item_bytes[2] = num_values*get_size_from_type(current.type);
+            memcpy(&item_bytes[3], payload, payload_bytes);
+            dp_item_sink(item_bytes, 3 + payload_bytes);
+        } else {
+            print_log_partition_info(current, num_values, payload_bytes, payload);
+        }
         return 0;
     }
 
@@ -547,103 +644,91 @@ control_ret_t set_struct_val_on_device(cmdspec_t current, int_float *ptr_struct_
             Sleep(15);
         }
     }while((ret != CONTROL_SUCCESS) && (tries < NUM_WRITE_RETRIES));
+    if (invalidates_cache(current)) {
+        attr_cache_invalidate();
+    }
 #endif
 
     return ret;
 }
 
-control_ret_t get_single_struct_val_from_device(cmdspec_t current, int_float *ret_vals, ctrl_flag *done_flag) {
-    control_ret_t ret = CONTROL_SUCCESS;
-    unsigned char cmd = (unsigned char) current.offset;
-    control_resid_t resid = current.resid;
-    unsigned payload_bytes = (current.num_values * current.device_rw_size) + 1; //1 extra byte for status
-    uint8_t payload[CMD_MAX_BYTES];
-
-#if !JSON_ONLY
-    ret = control_read_command(resid, cmd, (unsigned char *) payload, payload_bytes);
-    if(ret != CONTROL_SUCCESS)
-    {
-      return ret;
+// Completion time model for read commands.
+// A read which the device cannot answer straight away returns CTRL_WAIT and must be polled
+// until it returns CTRL_DONE. How long that takes depends on which resource services the
+// command and on how often the audio loop runs, so the time is learnt per (resid, cmd).
+// The first poll is scheduled at the expected completion time and the following ones back off
+// exponentially from POLL_MIN_SLEEP_US up to POLL_MAX_SLEEP_US.
+#define POLL_MODEL_SIZE      (512) // must be a power of 2
+#define POLL_SPIN_US         (100) // expected waits shorter than this are re-polled straight away
+#define POLL_MIN_SLEEP_US    (50)
+#define POLL_MAX_SLEEP_US    (2000)
+#define POLL_EWMA_SHIFT      (3)   // new samples are weighted 1/8
+#define POLL_WARNING_US      (1000000)
+
+typedef struct {
+    uint8_t valid;
+    control_resid_t resid;
+    uint8_t cmd;
+    unsigned num_reads;     // reads completed
+    unsigned num_waits;     // reads which returned CTRL_WAIT at least once
+    uint64_t num_polls;     // reads issued after the first one
+    uint64_t expected_us;   // moving average of the wait, 0 until the first wait is seen
+    uint64_t min_us;
+    uint64_t max_us;
+} poll_model_t;
+
+poll_model_t poll_model[POLL_MODEL_SIZE];
+
+poll_model_t* get_poll_model(control_resid_t resid, uint8_t cmd)
+{
+    unsigned key = ((unsigned)resid << 8) | cmd;
+    unsigned idx = (key * 2654435761u) >> 23; // 9-bit multiplicative hash
+    for (unsigned i=0; i<POLL_MODEL_SIZE; i++) {
+        poll_model_t *model = &poll_model[(idx + i) & (POLL_MODEL_SIZE-1)];
+        if (!model->valid) {
+            model->valid = 1;
+            model->resid = resid;
+            model->cmd = cmd;
+            return model;
+        }
+        if (model->resid == resid && model->cmd == cmd) {
+            return model;
+        }
     }
+    return NULL;
+}
 
-    if (ret == CONTROL_SUCCESS && payload[0] == CTRL_DONE) {
-        read_payload_byte_array(current, current.num_values, &payload[1]/*byte 0 is status*/, ret_vals);
+void update_poll_model(poll_model_t *model, unsigned polls, uint64_t wait_us)
+{
+    if (model == NULL) {
+        return;
+    }
+    model->num_reads++;
+    model->num_polls += polls;
+    if (polls == 0) {
+        return;
+    }
+    if (model->num_waits == 0) {
+        model->expected_us = wait_us;
+        model->min_us = wait_us;
+        model->max_us = wait_us;
+    } else {
+        // expected += (sample - expected) / 2^POLL_EWMA_SHIFT
+        model->expected_us = ((model->expected_us << POLL_EWMA_SHIFT) - model->expected_us + wait_us) >> POLL_EWMA_SHIFT;
+        if (wait_us < model->min_us) model->min_us = wait_us;
+        if (wait_us > model->max_us) model->max_us = wait_us;
     }
-    *done_flag = (ctrl_flag) payload[0];
-#endif
-    return ret;
+    model->num_waits++;
 }
 
-void get_multiple_struct_val_from_device(cmdspec_t current[], int_float *ret_vals[], unsigned num_cmds, cmdspec_t write_before_retrying[], unsigned *write_val)
+// number of values the device returns for a read command
+uint8_t get_read_num_values(cmdspec_t current)
 {
-    int *completed = (int *) calloc(num_cmds, sizeof(int));
-    int *sent = (int *) calloc(num_cmds, sizeof(int));
-    ctrl_flag *flags = (ctrl_flag*) calloc(num_cmds, sizeof(ctrl_flag));
-
-    int reset_index = 0;
-
-    int running = 1;
-    while (running) {
-        for (uint32_t i=0; i<num_cmds; i++) {
-            if (!completed[i] && ( i == 0 || sent[i-1])) {
-                int try_count = 0;
-                control_ret_t ret;
-                do
-                {
-                    try_count += 1;
-                    ret = get_single_struct_val_from_device(current[i], ret_vals[i], &flags[i]);
-                    if(ret != CONTROL_SUCCESS)
-                    {
-                        if(num_cmds > 1)
-                        {
-                            printf("Error: resetting start_index not supported when num_simultaneous_cmds is greater than 1\n");
-                            host_shutdown(1);
-                        }
-                        //set coeff index inside the device before retrying read again.
-                        int_float val;
-                        val.ui = write_val[i];
-                        control_ret_t ret_write = set_struct_val_on_device(write_before_retrying[i], &val, 0);
-                        if(ret_write != CONTROL_SUCCESS)
-                        {
-                            printf("Error: cannot write index to the device before retrying coefficients read.\n");
-                            host_shutdown(1);
-                        }
-                        reset_index = 1;
-                    }
-                }while((ret != CONTROL_SUCCESS) && (try_count < 5));
-                if(ret != CONTROL_SUCCESS)
-                {
-                    printf("error while reading coefficients from device even after %d tries. Exiting\n", try_count);
-                    host_shutdown(1);
-                }
-                sent[i] = (flags[i] == CTRL_DONE || flags[i] == CTRL_WAIT);
-                completed[i] = (flags[i] == CTRL_DONE);
-            }
-            if(reset_index == 1)
-            {
-                int_float val;
-                val.ui = write_val[i] + (AEC_COEFFICIENT_CHUNK_SIZE / sizeof(uint32_t));
-                control_ret_t ret_write = set_struct_val_on_device(write_before_retrying[i], &val, 0);
-                if(ret_write != CONTROL_SUCCESS)
-                {
-                    printf("Error: cannot write index to the device.\n");
-                    host_shutdown(1);
-                }
-            }
-#if USE_I2C
-            Sleep(1);
-#endif
-        }
-
-        running = 0;
-        for (uint32_t i=0; i<num_cmds; i++) {
-            running |= !completed[i];
-        }
+    if (!strncmp(current.par_name, "GET_", strlen("GET_")) && \
+        ( is_same_string_ending(current.par_name, "_CH0_AGC") || is_same_string_ending(current.par_name, "_CH1_AGC"))) {
+        return AGC_INPUT_CHANNELS;
     }
-
-    free(completed);
-    free(sent);
-    free(flags);
+    return current.num_values;
 }
 
 control_ret_t get_struct_val_from_device(cmdspec_t current, int_float *ret_vals)
@@ -651,20 +736,23 @@ control_ret_t get_struct_val_from_device(cmdspec_t current, int_float *ret_vals)
     control_ret_t ret = CONTROL_SUCCESS;
     unsigned char cmd = (unsigned char) current.offset;
     control_resid_t resid = current.resid;
-    uint8_t num_values = current.num_values;
-    if (!strncmp(current.par_name, "GET_", strlen("GET_")) && \
-        ( is_same_string_ending(current.par_name, "_CH0_AGC") || is_same_string_ending(current.par_name, "_CH1_AGC"))) {
-        num_values = AGC_INPUT_CHANNELS;
-    }
+    uint8_t num_values = get_read_num_values(current);
     unsigned payload_bytes = (num_values * current.device_rw_size) + 1; //1 extra byte for status
     uint8_t payload[CMD_MAX_BYTES];
-    unsigned read_attempts = 0;
-    //clock_t start = clock();
 #if !JSON_ONLY
+    if (is_cacheable(current) && attr_cache_get(resid, cmd, &payload[1], payload_bytes-1) == 0) {
+        read_payload_byte_array(current, num_values, &payload[1], ret_vals);
+        return CONTROL_SUCCESS;
+    }
+    poll_model_t *model = get_poll_model(resid, cmd);
+    unsigned polls = 0;
+    unsigned sleep_time_us = POLL_MIN_SLEEP_US;
+    uint8_t warning_printed = 0;
+
     ret = control_read_command(resid, cmd, (unsigned char *) payload, payload_bytes);
-    //clock_t end = clock();
-    //double time_diff = (((double)end - (double)start)*1000)/(double)CLOCKS_PER_SEC;
-    read_attempts += 1;
+    // The wait is measured from the first response, which is when the device queued the read
+    uint64_t first_response_us = vfctrl_get_time_us();
+    uint64_t last_wait_us = first_response_us;
     while(1)
     {
         if(ret != CONTROL_SUCCESS)
@@ -672,33 +760,297 @@ control_ret_t get_struct_val_from_device(cmdspec_t current, int_float *ret_vals)
             printf("control_read_command() returned error %d\n",ret);
             break;
         }
-        else
+        uint64_t now_us = vfctrl_get_time_us();
+        if(payload[0] == CTRL_DONE)
         {
-            if (read_attempts == 1000) {
-                printf("Taking a while... Device status: %d (1:wait, 2:control busy, 3:invalid command)\n", payload[0]);
+            // the read completed somewhere between the last CTRL_WAIT and this response
+            uint64_t wait_us = (polls == 0) ? 0 : ((last_wait_us + now_us) / 2) - first_response_us;
+            update_poll_model(model, polls, wait_us);
+            read_payload_byte_array(current, num_values, &payload[1]/*byte 0 is status*/, ret_vals);
+            if (is_cacheable(current)) {
+                attr_cache_put(resid, cmd, &payload[1], payload_bytes-1);
+            }
+            break;
+        }
+        last_wait_us = now_us;
+        if (!warning_printed && (now_us - first_response_us) >= POLL_WARNING_US) {
+            printf("Taking a while... Device status: %d (1:wait, 2:control busy, 3:invalid command)\n", payload[0]);
 #ifdef USE_I2C
-               printf("NOTE: Control will hang if I2S audio is not playing/recording.\n");
+            printf("NOTE: Control will hang if I2S audio is not playing/recording.\n");
 #endif
+            warning_printed = 1;
+        }
+        if (polls == 0 && model != NULL && model->num_waits > 0) {
+            // first poll: aim just after the expected completion time
+            uint64_t elapsed_us = now_us - first_response_us;
+            if (model->expected_us > elapsed_us + POLL_SPIN_US) {
+                vfctrl_sleep_us((unsigned)MIN(model->expected_us - elapsed_us, POLL_WARNING_US));
             }
-            if(payload[0] != CTRL_DONE)
-            {
-                Sleep(1);
-                ret = control_read_command(resid, cmd, (unsigned char *) payload, payload_bytes);
-                //printf("control_read_command() returned ret = %d payload[0] = %d\n",ret, payload[0]);
-                read_attempts += 1;
-            }
-            else
-            {
-                read_payload_byte_array(current, num_values, &payload[1]/*byte 0 is status*/, ret_vals);
+        } else {
+            vfctrl_sleep_us(sleep_time_us);
+            sleep_time_us = MIN(sleep_time_us * 2, POLL_MAX_SLEEP_US);
+        }
+        ret = control_read_command(resid, cmd, (unsigned char *) payload, payload_bytes);
+        polls += 1;
+    }
+#endif
+    return ret;
+}
+
+// Maximum number of commands read by one call to get_struct_vals_pipelined()
+#define PIPELINE_MAX_CMDS (32)
+
+typedef enum {
+    READ_NOT_QUEUED,
+    READ_QUEUED,
+    READ_COMPLETED,
+    READ_FAILED,
+} pipelined_read_state_t;
+
+// Read several commands with all of them queued on the device at the same time.
+// The first read of every command is sent before any of them is polled, so the device can
+// service them in the same frame instead of one frame per command. The commands are queued in
+// order: once one finds the device queue full, it and the following ones are sent again on the
+// next round. When merge_same_reads is set, commands with the same resid and cmd, like the
+// _CH0_AGC and _CH1_AGC variants, are read once.
+// done_us is optional and receives the time each value was returned by the device.
+static control_ret_t read_struct_vals(cmdspec_t current[], int_float *ret_vals[], control_ret_t cmd_ret[], uint64_t done_us[], unsigned num_cmds, int merge_same_reads)
+{
+    control_ret_t ret = CONTROL_SUCCESS;
+    if (num_cmds > PIPELINE_MAX_CMDS) {
+        fprintf(stderr, "Error: %s: cannot read more than %d commands at once\n", __func__, PIPELINE_MAX_CMDS);
+        return CONTROL_ERROR;
+    }
+#if !JSON_ONLY
+    pipelined_read_state_t state[PIPELINE_MAX_CMDS];
+    int same_read_as[PIPELINE_MAX_CMDS];
+    unsigned polls[PIPELINE_MAX_CMDS];
+    uint64_t first_response_us[PIPELINE_MAX_CMDS];
+    uint64_t last_wait_us[PIPELINE_MAX_CMDS];
+    poll_model_t *model[PIPELINE_MAX_CMDS];
+    uint8_t payload[CMD_MAX_BYTES];
+    unsigned sleep_time_us = POLL_MIN_SLEEP_US;
+    uint8_t warning_printed = 0;
+    uint64_t start_us = vfctrl_get_time_us();
+
+    for (unsigned i=0; i<num_cmds; i++) {
+        state[i] = READ_NOT_QUEUED;
+        same_read_as[i] = -1;
+        polls[i] = 0;
+        model[i] = get_poll_model(current[i].resid, (uint8_t)current[i].offset);
+        for (unsigned j=0; merge_same_reads && j<i; j++) {
+            if (same_read_as[j] == -1 && current[j].resid == current[i].resid && current[j].offset == current[i].offset) {
+                same_read_as[i] = j;
                 break;
             }
         }
+        uint8_t num_values = get_read_num_values(current[i]);
+        if (same_read_as[i] == -1 && is_cacheable(current[i]) &&
+            attr_cache_get(current[i].resid, (uint8_t)current[i].offset, payload, num_values * current[i].device_rw_size) == 0) {
+            read_payload_byte_array(current[i], num_values, payload, ret_vals[i]);
+            if (done_us != NULL) {
+                done_us[i] = start_us;
+            }
+            state[i] = READ_COMPLETED;
+            cmd_ret[i] = CONTROL_SUCCESS;
+        }
+    }
+
+    unsigned outstanding = num_cmds;
+    while (outstanding > 0) {
+        uint64_t next_completion_us = UINT64_MAX;
+        uint8_t queue_full = 0;
+        outstanding = 0;
+        for (unsigned i=0; i<num_cmds; i++) {
+            if (same_read_as[i] != -1 || state[i] == READ_COMPLETED || state[i] == READ_FAILED) {
+                continue;
+            }
+            if (queue_full && state[i] == READ_NOT_QUEUED) {
+                // queued after the command which found the queue full
+                outstanding++;
+                continue;
+            }
+            uint8_t num_values = get_read_num_values(current[i]);
+            unsigned payload_bytes = (num_values * current[i].device_rw_size) + 1; //1 extra byte for status
+            control_ret_t read_ret = control_read_command(current[i].resid, (unsigned char) current[i].offset, (unsigned char *) payload, payload_bytes);
+            uint64_t now_us = vfctrl_get_time_us();
+            if (state[i] == READ_QUEUED) {
+                polls[i]++;
+            }
+            if (read_ret != CONTROL_SUCCESS) {
+                printf("control_read_command() returned error %d for %s\n", read_ret, current[i].par_name);
+                state[i] = READ_FAILED;
+                cmd_ret[i] = read_ret;
+                ret = read_ret;
+            } else if (payload[0] == CTRL_DONE) {
+                uint64_t wait_us = 0;
+                if (state[i] == READ_QUEUED) {
+                    wait_us = ((last_wait_us[i] + now_us) / 2) - first_response_us[i];
+                } else {
+                    polls[i] = 0;
+                }
+                update_poll_model(model[i], polls[i], wait_us);
+                read_payload_byte_array(current[i], num_values, &payload[1]/*byte 0 is status*/, ret_vals[i]);
+                if (is_cacheable(current[i])) {
+                    attr_cache_put(current[i].resid, (uint8_t)current[i].offset, &payload[1], payload_bytes-1);
+                }
+                if (done_us != NULL) {
+                    done_us[i] = now_us;
+                }
+                state[i] = READ_COMPLETED;
+                cmd_ret[i] = CONTROL_SUCCESS;
+            } else if (payload[0] == CTRL_WAIT) {
+                if (state[i] != READ_QUEUED) {
+                    first_response_us[i] = now_us;
+                    state[i] = READ_QUEUED;
+                }
+                last_wait_us[i] = now_us;
+                outstanding++;
+                if (model[i] != NULL && model[i]->num_waits > 0 && polls[i] == 0) {
+                    uint64_t expected_us = first_response_us[i] + model[i]->expected_us;
+                    if (expected_us < next_completion_us) {
+                        next_completion_us = expected_us;
+                    }
+                }
+            } else if (payload[0] == CTRL_QUEUE_FULL) {
+                // not queued, send it again on the next round
+                if (state[i] == READ_NOT_QUEUED) {
+                    queue_full = 1;
+                }
+                outstanding++;
+            } else {
+                printf("Error: device returned status %d for %s\n", payload[0], current[i].par_name);
+                state[i] = READ_FAILED;
+                cmd_ret[i] = CONTROL_ERROR;
+                ret = CONTROL_ERROR;
+            }
+        }
+        if (outstanding == 0) {
+            break;
+        }
+        uint64_t now_us = vfctrl_get_time_us();
+        if (!warning_printed && (now_us - start_us) >= POLL_WARNING_US) {
+            printf("Taking a while... %u reads outstanding\n", outstanding);
+#ifdef USE_I2C
+            printf("NOTE: Control will hang if I2S audio is not playing/recording.\n");
+#endif
+            warning_printed = 1;
+        }
+        if (next_completion_us != UINT64_MAX) {
+            // first poll of a read with a known completion time
+            if (next_completion_us > now_us + POLL_SPIN_US) {
+                vfctrl_sleep_us((unsigned)MIN(next_completion_us - now_us, POLL_WARNING_US));
+            }
+        } else {
+            vfctrl_sleep_us(sleep_time_us);
+            sleep_time_us = MIN(sleep_time_us * 2, POLL_MAX_SLEEP_US);
+        }
+    }
+
+    for (unsigned i=0; i<num_cmds; i++) {
+        int j = same_read_as[i];
+        if (j != -1) {
+            cmd_ret[i] = cmd_ret[j];
+            if (done_us != NULL) {
+                done_us[i] = done_us[j];
+            }
+            if (cmd_ret[j] == CONTROL_SUCCESS) {
+                memcpy(ret_vals[i], ret_vals[j], get_read_num_values(current[i]) * sizeof(int_float));
+            }
+        }
+    }
+#else
+    for (unsigned i=0; i<num_cmds; i++) {
+        cmd_ret[i] = CONTROL_SUCCESS;
     }
-    //printf("read_result returning ret=%d after %d read attempts, time_msec = %lf\n",ret, read_attempts, time_diff);
 #endif
     return ret;
 }
 
+control_ret_t get_struct_vals_pipelined(cmdspec_t current[], int_float *ret_vals[], control_ret_t cmd_ret[], uint64_t done_us[], unsigned num_cmds)
+{
+    return read_struct_vals(current, ret_vals, cmd_ret, done_us, num_cmds, 1);
+}
+
+// Reads the coefficient chunks, every command is a separate read even when they are the same.
+// A failed read of a single command is retried after writing its start index again.
+// Returns 0 once all the commands completed, -1 on error
+int get_multiple_struct_val_from_device(cmdspec_t current[], int_float *ret_vals[], unsigned num_cmds, cmdspec_t write_before_retrying[], unsigned *write_val)
+{
+    control_ret_t cmd_ret[MAX_SIMULTANEOUS_CMDS];
+    int reset_index = 0;
+    int try_count = 0;
+
+    if (num_cmds > MAX_SIMULTANEOUS_CMDS) {
+        printf("Error: %d simultaneous commands requested, the maximum is %d\n", num_cmds, MAX_SIMULTANEOUS_CMDS);
+        return -1;
+    }
+
+    while (read_struct_vals(current, ret_vals, cmd_ret, NULL, num_cmds, 0) != CONTROL_SUCCESS) {
+        try_count += 1;
+        if (try_count == 5) {
+            printf("Error: cannot read the coefficients from the device after %d tries\n", try_count);
+            return -1;
+        }
+        if (num_cmds > 1) {
+            printf("Error: resetting start_index not supported when num_simultaneous_cmds is greater than 1\n");
+            return -1;
+        }
+        //set coeff index inside the device before retrying read again.
+        int_float val;
+        val.ui = write_val[0];
+        if (set_struct_val_on_device(write_before_retrying[0], &val, 0) != CONTROL_SUCCESS) {
+            printf("Error: cannot write index to the device before retrying coefficients read.\n");
+            return -1;
+        }
+        reset_index = 1;
+    }
+
+    if (reset_index == 1) {
+        int_float val;
+        val.ui = write_val[0] + (AEC_COEFFICIENT_CHUNK_SIZE / sizeof(uint32_t));
+        if (set_struct_val_on_device(write_before_retrying[0], &val, 0) != CONTROL_SUCCESS) {
+            printf("Error: cannot write index to the device.\n");
+            return -1;
+        }
+    }
+    return 0;
+}
+
+#if USE_I2C
+// There are no descriptors over I2C so the version and serial number are read to identify the device
+void open_i2c_attr_cache(unsigned i2c_address)
+{
+    int_float vals[2][CMD_MAX_BYTES];
+    int_float *vals_ptrs[2] = {vals[0], vals[1]};
+    control_ret_t cmd_ret[2];
+    cmdspec_t cmds[2];
+    uint8_t payload[2][CMD_MAX_BYTES];
+    char serial[CMD_MAX_BYTES];
+    char key[ATTR_CACHE_KEY_MAX_CHARS];
+
+    if (vfctrl_get_cmdspec(1, "GET_VERSION", &cmds[0], 0) != 0 || vfctrl_get_cmdspec(1, "GET_SERIAL_NUMBER", &cmds[1], 0) != 0) {
+        return;
+    }
+    if (get_struct_vals_pipelined(cmds, vals_ptrs, cmd_ret, NULL, 2) != CONTROL_SUCCESS) {
+        return;
+    }
+    for (unsigned i=0; i<2; i++) {
+        write_payload_byte_array(cmds[i], cmds[i].num_values, vals[i], payload[i]);
+    }
+    memcpy(serial, payload[1], cmds[1].num_values);
+    serial[MIN(cmds[1].num_values, CMD_MAX_BYTES-1)] = '\0';
+    if (serial[0] == '\0') {
+        return;
+    }
+    snprintf(key, sizeof(key), "i2c:%02x:%s:%08x", i2c_address, serial, vals[0][0].ui);
+    attr_cache_open(key);
+    for (unsigned i=0; i<2; i++) {
+        attr_cache_put(cmds[i].resid, (uint8_t)cmds[i].offset, payload[i], cmds[i].num_values * cmds[i].device_rw_size);
+    }
+}
+#endif
+
 uint64_t convert_energy_to_uint64(float in_val) {
     uint64_t out_val;
     int exp = 0;
@@ -839,13 +1191,65 @@ int update_read_results(cmdspec_t cmd_spec, int_float *vals, void *data_out_ptr)
     return err;
 }
 
-int do_command(cmdspec_t current, const char ** val_1, void *data_out_ptr, uint8_t log_for_data_partition) {
-    unsigned num_values;
-    control_ret_t ret = CONTROL_SUCCESS;
+// The AGC reads return the values of both channels, keep the one of the channel in the command name
+void select_agc_channel(cmdspec_t current, int_float *vals)
+{
+    if (!strncmp(current.par_name, "GET_", strlen("GET_")) && is_same_string_ending(current.par_name, "_CH1_AGC")) {
+        vals[0] = vals[1];
+    }
+}
 
-    //TODO support --HELP
-    num_values = current.num_values;
-    int_float vals[CMD_MAX_BYTES] = {0};
+int convert_read_result(cmdspec_t current, int_float *vals, void *data_out_ptr)
+{
+    select_agc_channel(current, vals);
+    //copy read results from local output buffer to the output buffer the app sent
+    //convert fixed point read results into floating point.
+    //convert energy values into dB
+    return update_read_results(current, vals, data_out_ptr);
+}
+
+// Convert a floating point value into the fixed point or energy value of the given type
+void float_to_device_value(param_type type, float f, int_float *val)
+{
+    switch (type) {
+        case TYPE_FIXED_0_32:
+            val->f0_32 = (uint64_t)(f * SCALE_Q_32);
+            break;
+        case TYPE_FIXED_1_31:
+            val->f1_31 = (uint32_t)(f * (SCALE_Q(31)));
+            break;
+        case TYPE_FIXED_7_24:
+            val->f7_24 = (int32_t)(f * (SCALE_Q(24)));
+            break;
+        case TYPE_FIXED_8_24:
+            val->f8_24 = (uint32_t)(f * (SCALE_Q(24)));
+            break;
+        case TYPE_FIXED_16_16:
+            val->f16_16 = (uint32_t)(f * (SCALE_Q(16)));
+            break;
+        case TYPE_ENERGY:
+            val->i_long = convert_energy_to_uint64(f);
+            break;
+        default:
+            printf("Error: type %d is not a floating point type\n", type);
+    }
+}
+
+// The AGC writes take the channel index after the values
+void add_agc_channel_index(cmdspec_t current, int_float *vals)
+{
+    if (!strncmp(current.par_name, "SET_", strlen("SET_"))) {
+        if (is_same_string_ending(current.par_name, "_CH0_AGC")) {
+            vals[current.num_values].ui = 0;
+        } else if (is_same_string_ending(current.par_name, "_CH1_AGC")) {
+            vals[current.num_values].ui = 1;
+        }
+    }
+}
+
+// Convert the values given as strings for a write command into the values sent to the device
+int parse_write_values(cmdspec_t current, const char ** val_1, int_float *vals) {
+    unsigned num_values = current.num_values;
     float f = 0;
 
     bool is_set_string =
@@ -854,11 +1258,11 @@ int do_command(cmdspec_t current, const char ** val_1, void *data_out_ptr, uint8
       strcmp("SET_SERIAL_NUMBER", current.par_name) == 0;
 
     // remove quotation marks from string argument and check the string size is correct
-    char * new_argument_string = NULL;
+    char new_argument_string[TEMP_STR_MAX_CHARS + 1];
     if (is_set_string) {
         uint8_t quotation_marks_count = 0;
-        new_argument_string = calloc(TEMP_STR_MAX_CHARS, 1);
         uint32_t new_string_idx = 0;
+        memset(new_argument_string, 0, sizeof(new_argument_string));
         for (int string_check_idx=0; string_check_idx < (int)strlen(val_1[0]); string_check_idx++) {
             if (val_1[0][string_check_idx] == '"') {
                 quotation_marks_count++;
@@ -867,75 +1271,74 @@ int do_command(cmdspec_t current, const char ** val_1, void *data_out_ptr, uint8
                 new_string_idx++;
                 if (new_string_idx>TEMP_STR_MAX_CHARS) {
                     printf("Error: String in %s is too long and it doesn't fit in the %d-byte buffer, max length is %d\n", current.par_name, TEMP_STR_MAX_CHARS, num_values-1);
-                    host_shutdown(1);
+                    return -1;
                 }
             }
         }
         // Reserve last char in array for null-terminator
         if (strlen(new_argument_string) > num_values-1) {
             printf("Error: String in %s is too long, max length is %d, given length is %ld\n", current.par_name, num_values-1, strlen(new_argument_string));
-            host_shutdown(1);
+            return -1;
         }
     }
 
-    if(current.rw == WRITE) //read the values that the host wants to write
+    for(uint32_t i=0; i<num_values; i++)
     {
-        for(uint32_t i=0; i<num_values; i++)
-        {
-            switch (current.type) {
-                case TYPE_INT8:
-                case TYPE_UINT8:
-                    if (is_set_string) {
-                        vals[i].ui8 = new_argument_string[i];
-                    } else {
-                        sscanf(val_1[i], "%" SCNu8, &(vals[i].ui8));
-                    }
-                    break;
-                case TYPE_INT32:
-                case TYPE_UINT32:
-                    sscanf(val_1[i], "%d", &(vals[i].i));
-                    break;
-                case TYPE_FIXED_0_32:
-                    sscanf(val_1[i], "%10f", &(f));
-                    vals[i].f0_32 = (uint64_t)(f * SCALE_Q_32);
-                    break;
-                case TYPE_FIXED_1_31:
-                    sscanf(val_1[i], "%10f", &(f));
-                    vals[i].f1_31 = (uint32_t)(f * (SCALE_Q(31)));
-                    break;
-                case TYPE_FIXED_7_24:
-                    sscanf(val_1[i], "%8f", &(f));
-                    vals[i].f7_24 = (int32_t)(f * (SCALE_Q(24)));
-                    break;
-                case TYPE_FIXED_8_24:
-                    sscanf(val_1[i], "%8f", &(f));
-                    vals[i].f8_24 = (uint32_t)(f * (SCALE_Q(24)));
-                    break;
-                case TYPE_FIXED_16_16:
-                    sscanf(val_1[i], "%5f", &(f));
-                    vals[i].f16_16 = (uint32_t)(f * (SCALE_Q(16)));
-                    break;
-                case TYPE_INT64:
-                case TYPE_UINT64:
-                    sscanf(val_1[i], "%lld", &(vals[i].i_long));
-                    break;
-                case TYPE_ENERGY:
-                    sscanf(val_1[i], "%e", &(f));
-                    vals[i].i_long = convert_energy_to_uint64(f);
-                    break;
-                default:
-                  printf("Error: invalid type %d\n", current.type);
-                  host_shutdown(1);
-            }
+        switch (current.type) {
+            case TYPE_INT8:
+            case TYPE_UINT8:
+                if (is_set_string) {
+                    vals[i].ui8 = new_argument_string[i];
+                } else {
+                    sscanf(val_1[i], "%" SCNu8, &(vals[i].ui8));
+                }
+                break;
+            case TYPE_INT32:
+            case TYPE_UINT32:
+                sscanf(val_1[i], "%d", &(vals[i].i));
+                break;
+            case TYPE_FIXED_0_32:
+            case TYPE_FIXED_1_31:
+                sscanf(val_1[i], "%10f", &(f));
+                float_to_device_value(current.type, f, &vals[i]);
+                break;
+            case TYPE_FIXED_7_24:
+            case TYPE_FIXED_8_24:
+                sscanf(val_1[i], "%8f", &(f));
+                float_to_device_value(current.type, f, &vals[i]);
+                break;
+            case TYPE_FIXED_16_16:
+                sscanf(val_1[i], "%5f", &(f));
+                float_to_device_value(current.type, f, &vals[i]);
+                break;
+            case TYPE_INT64:
+            case TYPE_UINT64:
+                sscanf(val_1[i], "%lld", &(vals[i].i_long));
+                break;
+            case TYPE_ENERGY:
+                sscanf(val_1[i], "%e", &(f));
+                float_to_device_value(current.type, f, &vals[i]);
+                break;
+            default:
+              printf("Error: invalid type %d\n", current.type);
+              return -1;
         }
     }
 
-    // add the channel index for the commands with specific endings
-    if (!strncmp(current.par_name, "SET_", strlen("SET_"))) {
-        if (is_same_string_ending(current.par_name, "_CH0_AGC")) {
-            vals[num_values].ui = 0;
-        } else if (is_same_string_ending(current.par_name, "_CH1_AGC")) {
-            vals[num_values].ui = 1;
+    add_agc_channel_index(current, vals);
+    return 0;
+}
+
+int do_command(cmdspec_t current, const char ** val_1, void *data_out_ptr, uint8_t log_for_data_partition) {
+    control_ret_t ret = CONTROL_SUCCESS;
+
+    //TODO support --HELP
+    int_float vals[CMD_MAX_BYTES] = {0};
+
+    if(current.rw == WRITE) //read the values that the host wants to write
+    {
+        if (parse_write_values(current, val_1, vals) != 0) {
+            return CONTROL_ERROR;
         }
     }
 
@@ -945,9 +1348,9 @@ int do_command(cmdspec_t current, const char ** val_1, void *data_out_ptr, uint8
     }
     // Get or set result
     if (current.rw == WRITE) {
-        if(strcmp("SET_IO_MAP", current.par_name) == 0)
+        if(strcmp("SET_IO_MAP", current.par_name) == 0 && print_set_io_map((int_float*)vals) != 0)
         {
-            print_set_io_map((int_float*)vals);
+            return CONTROL_ERROR;
         }
         ret = set_struct_val_on_device(current, vals, log_for_data_partition); //write to device
 
@@ -965,33 +1368,35 @@ int do_command(cmdspec_t current, const char ** val_1, void *data_out_ptr, uint8
         ret = get_struct_val_from_device(current, vals); //read from device
     }
 
-    if (!strncmp(current.par_name, "GET_", strlen("GET_")) && is_same_string_ending(current.par_name, "_CH1_AGC")) {
-        vals[0] = vals[1];
-    }
     //for read commands, copy read values into the output array
     if(!ret && current.rw == READ)
     {
-        //copy read results from local output buffer to the output buffer the app sent
-        //convert fixed point read results into floating point.
-        //convert energy values into dB
-        ret = update_read_results(current, vals, data_out_ptr);
-
+        ret = convert_read_result(current, vals, data_out_ptr);
     }
-    free(new_argument_string);
     return ret;
 }
 
-double att_int32_to_double(int32_t x, int x_exp){
-    return ldexp((double)x, x_exp);
-}
+
+#define PRINT_FD_CHUNK_PAIRS (64)
 
 void print_python_fd(FILE *fp, vtb_ch_pair_t * d, size_t length, int d_exp){
-    fprintf(fp, "np.asarray([%.12f, ", att_int32_to_double( d[0].ch_a, d_exp));
-    for(size_t i=1;i<length;i++){
-        fprintf(fp, "%.12f + %.12fj, ", att_int32_to_double( d[i].ch_a, d_exp),
-                att_int32_to_double( d[i].ch_b, d_exp));
+    // the pairs are converted a chunk at a time, ch_a and ch_b are interleaved like in vtb_ch_pair_t
+    double vals[2 * PRINT_FD_CHUNK_PAIRS];
+    qformat_q_to_double(&d[0].ch_a, vals, 2, d_exp);
+    double dc = vals[0];
+    double nyquist = vals[1];
+    fprintf(fp, "np.asarray([%.12f, ", dc);
+    for(size_t start=1; start<length; start+=PRINT_FD_CHUNK_PAIRS){
+        size_t num_pairs = length - start;
+        if (num_pairs > PRINT_FD_CHUNK_PAIRS) {
+            num_pairs = PRINT_FD_CHUNK_PAIRS;
+        }
+        qformat_q_to_double(&d[start].ch_a, vals, 2 * num_pairs, d_exp);
+        for(size_t i=0; i<num_pairs; i++){
+            fprintf(fp, "%.12f + %.12fj, ", vals[2*i], vals[2*i+1]);
+        }
     }
-    fprintf(fp, "%.12f])\n", att_int32_to_double( d[0].ch_b, d_exp));
+    fprintf(fp, "%.12f])\n", nyquist);
 }
 
 int get_aec_coefficients(cmdspec_t cmdspec_ap[], int num_commands, const char* filename) {
@@ -1103,6 +1508,7 @@ int get_aec_coefficients(cmdspec_t cmdspec_ap[], int num_commands, const char* f
         set_index_cmdspec_arr[i] = set_coeff_index_cmdspec;
     }
 
+    int read_ret = 0;
     int print_i = 0;
     int print_period = 5;
     for (uint32_t i=0; i<coeff_size; i++) {
@@ -1112,7 +1518,10 @@ int get_aec_coefficients(cmdspec_t cmdspec_ap[], int num_commands, const char* f
                 start_index[index] = i + (index*num_coefficients_per_chunk);
             }
             // Receive coefficients
-            get_multiple_struct_val_from_device(cmdspec_arr, vals_arr, num_simultaneous_cmds, set_index_cmdspec_arr, start_index);
+            read_ret = get_multiple_struct_val_from_device(cmdspec_arr, vals_arr, num_simultaneous_cmds, set_index_cmdspec_arr, start_index);
+            if (read_ret != 0) {
+                break;
+            }
             for (int c=0; c<num_simultaneous_cmds; c++) {
                 for (uint32_t j=0; j<num_coefficients_per_chunk; j++) {
                     coeff_buffer[i+j+c*num_coefficients_per_chunk] = vals_arr[c][j].i;
@@ -1126,9 +1535,18 @@ int get_aec_coefficients(cmdspec_t cmdspec_ap[], int num_commands, const char* f
             print_i--;
         }
     }
-    printf("\r%d / %d\n", coeff_size, coeff_size);
+    if (read_ret == 0) {
+        printf("\r%d / %d\n", coeff_size, coeff_size);
+    }
+    free(cmdspec_arr);
+    for (int c=0; c<num_simultaneous_cmds; c++) {
+        free(vals_arr[c]);
+    }
+    free(vals_arr);
+    free(start_index);
+    free(set_index_cmdspec_arr);
 
-    // Revert adaption
+    // Revert adaption, also when the read failed
     vals[0].i = prev_adaption;
     ret = set_struct_val_on_device(set_adaption_cmdspec, vals, 0);
     printf("AEC adaption: ");
@@ -1143,6 +1561,11 @@ int get_aec_coefficients(cmdspec_t cmdspec_ap[], int num_commands, const char* f
             printf("force off\n");
             break;
     }
+    if (read_ret != 0) {
+        free(vals);
+        free(coeff_buffer);
+        return 1;
+    }
 
     vtb_ch_pair_t ***H_hat = (vtb_ch_pair_t ***) calloc(y_channels, sizeof(vtb_ch_pair_t **));
 
@@ -1216,13 +1639,6 @@ int get_aec_coefficients(cmdspec_t cmdspec_ap[], int num_commands, const char* f
 
     // Free everything
 
-    free(cmdspec_arr);
-
-    for (int c=0; c<num_simultaneous_cmds; c++) {
-        free(vals_arr[c]);
-    }
-    free(vals_arr);
-
     free(vals);
 
     for(unsigned y_ch=0;y_ch<y_channels;y_ch++) {
@@ -1240,10 +1656,6 @@ int get_aec_coefficients(cmdspec_t cmdspec_ap[], int num_commands, const char* f
 
     free(coeff_buffer);
 
-    free(start_index);
-
-    free(set_index_cmdspec_arr);
-
     return 0;
 }
 
@@ -1324,6 +1736,7 @@ int get_ic_coefficients(cmdspec_t cmdspec_ap[], int num_commands, const char* fi
         set_index_cmdspec_arr[i] = set_coeff_index_cmdspec;
     }
 
+    int read_ret = 0;
     int print_i = 0;
     int print_period = 5;
     for (uint32_t i=0; i<coeff_size; i++) {
@@ -1333,7 +1746,10 @@ int get_ic_coefficients(cmdspec_t cmdspec_ap[], int num_commands, const char* fi
                 start_index[index] = i + (index*num_coefficients_per_chunk);
             }
             // Receive coefficients
-            get_multiple_struct_val_from_device(cmdspec_arr, vals_arr, num_simultaneous_cmds, set_index_cmdspec_arr, start_index);
+            read_ret = get_multiple_struct_val_from_device(cmdspec_arr, vals_arr, num_simultaneous_cmds, set_index_cmdspec_arr, start_index);
+            if (read_ret != 0) {
+                break;
+            }
             for (int c=0; c<num_simultaneous_cmds; c++) {
                 for (uint32_t j=0; j<num_coefficients_per_chunk; j++) {
                     coeff_buffer[i+j+c*num_coefficients_per_chunk] = vals_arr[c][j].i;
@@ -1347,9 +1763,18 @@ int get_ic_coefficients(cmdspec_t cmdspec_ap[], int num_commands, const char* fi
             print_i--;
         }
     }
-    printf("\r%d / %d\n", coeff_size, coeff_size);
+    if (read_ret == 0) {
+        printf("\r%d / %d\n", coeff_size, coeff_size);
+    }
+    free(cmdspec_arr);
+    for (int c=0; c<num_simultaneous_cmds; c++) {
+        free(vals_arr[c]);
+    }
+    free(vals_arr);
+    free(start_index);
+    free(set_index_cmdspec_arr);
 
-    // Revert adaption
+    // Revert adaption, also when the read failed
     vals[0].i = prev_adaption;
     ret = set_struct_val_on_device(set_adaption_cmdspec, vals, 0);
     printf("IC adaption: ");
@@ -1361,6 +1786,11 @@ int get_ic_coefficients(cmdspec_t cmdspec_ap[], int num_commands, const char* fi
             printf("force off\n");
             break;
     }
+    if (read_ret != 0) {
+        free(vals);
+        free(coeff_buffer);
+        return 1;
+    }
     vtb_ch_pair_t **H_hat = (vtb_ch_pair_t **) calloc(phases, sizeof(vtb_ch_pair_t *));
 
     for(unsigned p=0; p<phases; p++) {
@@ -1405,13 +1835,6 @@ int get_ic_coefficients(cmdspec_t cmdspec_ap[], int num_commands, const char* fi
 
     // Free everything
 
-    free(cmdspec_arr);
-
-    for (int c=0; c<num_simultaneous_cmds; c++) {
-        free(vals_arr[c]);
-    }
-    free(vals_arr);
-
     free(vals);
 
     for(unsigned p=0; p<phases; p++) {
@@ -1423,16 +1846,13 @@ int get_ic_coefficients(cmdspec_t cmdspec_ap[], int num_commands, const char* fi
 
     free(coeff_buffer);
 
-    free(start_index);
-
-    free(set_index_cmdspec_arr);
-
     return 0;
 }
 
 
 
-int vfctrl_get_filter_coefficients_human_readable(cmdspec_t *cmd_original){
+// Reads the filter selected by SET_FILTER_INDEX, in the human readable order a1,a2,b0,b1,b2 for each stage
+int get_filter_coefficients_human_readable(double float_vals[NUM_FILTER_COEFFS]){
     cmdspec_t raw_cmd_spec;
     raw_cmd_spec.resid = GPIO_RESID;
     strcpy(raw_cmd_spec.par_name, "GET_FILTER_COEFF_RAW");
@@ -1444,17 +1864,16 @@ int vfctrl_get_filter_coefficients_human_readable(cmdspec_t *cmd_original){
     raw_cmd_spec.device_rw_size = sizeof(int32_t);
     raw_cmd_spec.app_read_result_size = get_app_read_result_size(raw_cmd_spec.type);
 
-    void* data_out_ptr = calloc(raw_cmd_spec.num_values, raw_cmd_spec.app_read_result_size);
+    int32_t raw_vals[NUM_FILTER_COEFFS];
     const unsigned log_for_data_partition = 0; //It's a read so no need to log
 
-    int ret = vfctrl_do_command(&raw_cmd_spec, (const char **)&raw_cmd_spec.par_name, data_out_ptr, log_for_data_partition);
+    int ret = vfctrl_do_command(&raw_cmd_spec, (const char **)&raw_cmd_spec.par_name, raw_vals, log_for_data_partition);
 
-    if(!ret && (raw_cmd_spec.rw == READ)){
-        printf("%s: ", cmd_original->par_name);
-        double float_vals[MAX_PAYLOAD_BYTES / sizeof(int32_t)];
+    if(!ret){
+        double q_vals[NUM_FILTER_COEFFS];
+        qformat_q_to_double(raw_vals, q_vals, NUM_FILTER_COEFFS, -Q_FORMAT_FILTER);
         for(unsigned i=0; i<raw_cmd_spec.num_values; i++){
-            #define FVAL(Q, x) ((double)(x)/(double)(1<<Q))
-            double float_val = FVAL(Q_FORMAT_FILTER, ((int32_t*)data_out_ptr)[i]);
+            double float_val = q_vals[i];
             unsigned write_idx = i;
             if(((i%5) == 3) || ((i%5) == 4)){
                 float_val = -float_val; //a1 and a2 are negated
@@ -1465,12 +1884,28 @@ int vfctrl_get_filter_coefficients_human_readable(cmdspec_t *cmd_original){
             }
             float_vals[write_idx] = float_val;
         }
-        for(unsigned i=0; i<raw_cmd_spec.num_values; i++){
-            printf("%1.8f ", float_vals[i]);
+    }
+    return ret;
+}
+
+int vfctrl_get_filter_coefficients_to_string(char *output_string){
+    double float_vals[NUM_FILTER_COEFFS];
+    output_string[0] = '\0';
+    int ret = get_filter_coefficients_human_readable(float_vals);
+    if(!ret){
+        for(unsigned i=0; i<NUM_FILTER_COEFFS; i++){
+            sprintf(output_string + strlen(output_string), " %1.8f", float_vals[i]);
         }
-        printf("\n");
     }
-    free(data_out_ptr);
+    return ret;
+}
+
+int vfctrl_get_filter_coefficients_human_readable(cmdspec_t *cmd_original){
+    char output_string[TEMP_STR_MAX_CHARS];
+    int ret = vfctrl_get_filter_coefficients_to_string(output_string);
+    if(!ret){
+        printf("%s:%s\n", cmd_original->par_name, output_string);
+    }
     return ret;
 }
 
@@ -1490,25 +1925,41 @@ int vfctrl_set_filter_coefficients_human_readable(cmdspec_t *cmd_original, const
     char raw_vals_str[10+1][32] = {{0}};
     strcpy(raw_vals_str[0], raw_cmd_spec.par_name);
 
-    //Grab float values from command and convert to int
-    for(unsigned i=0; i<cmd_original->num_values;i++){
+    if (cmd_original->num_values != NUM_FILTER_COEFFS) {
+        printf("Error: %s takes %d coefficients\n", cmd_original->par_name, NUM_FILTER_COEFFS);
+        return -1;
+    }
+
+    //Grab float values from command and check them before anything is written
+    double set_vals[NUM_FILTER_COEFFS];
+    int32_t q_vals[NUM_FILTER_COEFFS];
+    for(unsigned i=0; i<NUM_FILTER_COEFFS;i++){
         const char * param_str_ptr = command_plus_values[i+1]; //+1 because it's argv
-        double set_val;
-        sscanf(param_str_ptr, "%le", &set_val);
-        unsigned write_idx = i;
-        if(((i%5) == 0) || ((i%5) == 1)){
-            set_val = -set_val; //a1 and a2 are negated
-            write_idx += 3;    //reorder to b0,b1,b2,a1,a2
+        if (sscanf(param_str_ptr, "%le", &set_vals[i]) != 1) {
+            printf("Error: invalid coefficient %s\n", param_str_ptr);
+            return -1;
         }
-        else{
-            write_idx -= 2;
+    }
+    biquad_check_t check;
+    int check_ret = biquad_cascade_check(set_vals, &check);
+    if (check.num_out_of_range > 0) {
+        printf("Error: %u coefficients are out of the Q%d range\n", check.num_out_of_range, Q_FORMAT_FILTER);
+        return -1;
+    }
+    for (unsigned s=0; s<NUM_STAGES_PER_FILTER; s++) {
+        if (check.pole_radius[s] >= 1.0) {
+            printf("Error: stage %u is unstable, pole radius %f\n", s, check.pole_radius[s]);
+            return -1;
         }
-        #define QVAL(Q, f) (int)((signed long long)((f) * ((unsigned long long)1 << (Q+20)) + (1<<19)) >> 20)
-        int32_t q_val = QVAL(Q_FORMAT_FILTER, set_val);
-        char number_str[32];
-        sprintf(number_str, "%d", q_val);
-        strcpy(raw_vals_str[write_idx+1], number_str);
-        // printf("%lf@@@%s\n", set_val, raw_vals_str[i+1]);
+    }
+    if (check_ret > 0) {
+        printf("Warning: a full scale input can saturate the filter output, use --filter-sim to check\n");
+    }
+
+    //Convert to Q28 in the raw order b0,b1,b2,-a1,-a2
+    biquad_coeffs_to_q28(set_vals, q_vals);
+    for(unsigned i=0; i<NUM_FILTER_COEFFS;i++){
+        sprintf(raw_vals_str[i+1], "%d", q_vals[i]);
     }
 
     //Now build an array of pointers pointing into the str arrays so it looks like *argv[]
@@ -1529,6 +1980,55 @@ char* print_help(char* bin_name, cmdspec_t *cmdspec_ap, unsigned num_commands, u
     printf("Use -p or --product-id to set the product ID. Default value is 0x0014\n");
     printf("Use -d or --dump-params to read all the available parameters.\n");
     printf("Use -l or --log-data-partition to generate the json item to use in the flash data-partition\n");
+    printf("Use --stats to print the measured completion time of the read commands on exit\n");
+    printf("Use --watch CMD[,CMD...] to sample read commands periodically. Options:\n");
+    printf("    --rate RATE        sampling rate, e.g. 50Hz. Default is %.0fHz\n", WATCH_DEFAULT_RATE_HZ);
+    printf("    --duration SECONDS, --samples N   stop after the given time or number of samples\n");
+    printf("    --output FILE      binary time-series file, used as a ring buffer of --ring-size records\n");
+    printf("    --ring-size N      default is %d\n", WATCH_DEFAULT_RING_SIZE);
+    printf("    --csv FILE         CSV time-series file. Samples are printed as CSV if no file is given\n");
+    printf("Use --profile WINDOW_MS to measure the per-stage frame timings over a window. Options:\n");
+    printf("    --profile-windows N  number of windows, the worst case is reported. Default is 1\n");
+    printf("    --frame-ms MS        frame budget. Default is %.1f ms\n", PROFILE_FRAME_BUDGET_MS);
+    printf("    --report FILE        JSON report. Default is %s\n", PROFILE_DEFAULT_REPORT);
+    printf("Use --filter-sim SET_FILTER_COEFF VALUES... to check filter coefficients on the host, nothing is written. Options:\n");
+    printf("    --fs HZ            sample rate of the response. Default is %.0f Hz\n", FILTER_SIM_DEFAULT_FS);
+    printf("    --response FILE    CSV with the gain, phase and group delay. A table is printed if no file is given\n");
+    printf("    --wav-in FILE      PCM WAV file to filter with the device arithmetic, exits with 2 if it saturates\n");
+    printf("    --wav-out FILE     32-bit WAV file with the simulated output\n");
+    printf("Use --autotune to search the AGC and ADEC settings, on the device while test audio is playing. Options:\n");
+    printf("    --tune-params P,...  parameters to tune, e.g. UPPER_THRESHOLD_CH0_AGC. Default is all of them\n");
+    printf("    --tune-wav FILE      tune the AGC settings on a host simulation of FILE instead of the device\n");
+    printf("    --tune-passes N      passes over the parameters. Default is %d\n", AUTOTUNE_DEFAULT_PASSES);
+    printf("    --tune-jobs N        simulations run in parallel. Default is %d\n", AUTOTUNE_DEFAULT_JOBS);
+    printf("    --tune-settle MS, --tune-window MS   device time before and for the measure of each setting. Default is %d and %d\n",
+            AUTOTUNE_DEFAULT_SETTLE_MS, AUTOTUNE_DEFAULT_WINDOW_MS);
+    printf("    --tune-level DBFS    simulator target speech level. Default is %.0f dBFS\n", AUTOTUNE_DEFAULT_LEVEL_DBFS);
+    printf("    --tune-out FILE      best settings as SET_ commands, for --batch or --apply\n");
+    printf("Use --aec-ir FILE to report the delay, direct path peak and tail energy of the AEC filter saved in FILE\n");
+    printf("    --aec-ir-read      read the filter from the device into FILE first. FILE defaults to %s\n", AEC_IR_DEFAULT_FILE);
+    printf("    --ir-out FILE      CSV with the impulse response of each mic and reference pair\n");
+    printf("Use --capture to log the current settings of the device for the data partition. Options:\n");
+    printf("    --dp-out FILE      binary output, also for the commands logged with -l or --batch. JSON is printed if not given\n");
+    printf("    --dp-format FMT    items (TLV items only), upgrade or factory image. Default is items\n");
+    printf("    --dp-sector-size N  image sector size. Default is %d\n", DP_CAPTURE_DEFAULT_SECTOR_SIZE);
+    printf("    --dp-hardware-build WORD, --dp-spispec FILE   required for a factory image\n");
+    printf("    --dp-version X.Y.Z  compatibility version of the image. Default is the host app version\n");
+    printf("Use --i2c-script FILE to run a register script through the I2C passthrough on a single connection. Options:\n");
+    printf("    --i2c-sim          run the script on a simulated register map and print it, nothing is sent\n");
+    printf("    --no-coalesce      send each write of the script as a separate command\n");
+    printf("    The statements are device, page, volatile, write, update, read, poll and delay, see i2c_script.h\n");
+    printf("Use --spi-write FILE to write the bytes of FILE as one SPI transaction, of any length. Use - to read stdin\n");
+    printf("Use --spi-read ADDR COUNT to read COUNT bytes from the SPI address ADDR. Options:\n");
+    printf("    --spi-out FILE     binary output. The bytes are printed as hex if not given\n");
+    printf("Use --batch FILE to run the commands in FILE, one per line, on a single connection. Use - to read stdin\n");
+    printf("    Each command prints a status line \"OK NAME[:RESULT]\" or \"ERR NAME CODE\", lines starting with # are ignored\n");
+    printf("Use --repl to enter commands interactively, type quit to exit\n");
+    printf("Use --apply FILE to write the SET_ commands in FILE which change the device values and verify them\n");
+    printf("    --dry-run          only list the commands which would be written\n");
+    printf("Use --no-cache to read the version, build and USB attributes from the device instead of the local cache\n");
+    printf("Use --snapshot FILE to read all the parameters in one go and save them as JSON\n");
+    printf("    --freeze           turn off the AEC, IC and AGC adaptation while the values are read\n");
 
     if (!full) {
         return "";
@@ -1590,313 +2090,45 @@ void populate_cmd_table()
     if(cmdspec_ap == NULL)
     {
         cmdspec_t cmdspec_ap_local[] = {
-            cmd_con(AP_CONTROL_RESID, "GET_VERSION", TYPE_UINT32, AP_CONTROL_CMD_GET_VERSION, READ, 1, "CONTROL: get version"),
-            cmd_con(AP_CONTROL_RESID, "GET_STATUS", TYPE_UINT8, AP_CONTROL_CMD_GET_STATUS, READ, 1, "CONTROL: get status"),
-            cmd_con(AP_CONTROL_RESID, "GET_DELAY_SAMPLES", TYPE_UINT32, AP_CONTROL_CMD_GET_DELAY_SAMPLES, READ, 1, "CONTROL: get configurable delay in samples"),
-            cmd_con(AP_CONTROL_RESID, "GET_BLD_MSG", TYPE_UINT8, AP_CONTROL_CMD_GET_BLD_MSG, READ, BLD_MSG_LEN, "CONTROL: get build message"),
-            cmd_con(AP_CONTROL_RESID, "GET_BLD_HOST", TYPE_UINT8, AP_CONTROL_CMD_GET_BLD_HOST, READ, BLD_HOST_LEN, "CONTROL: get build host"),
-            cmd_con(AP_CONTROL_RESID, "GET_BLD_REPO_HASH", TYPE_UINT8, AP_CONTROL_CMD_GET_BLD_REPO_HASH, READ, BLD_REPO_HASH_LEN, "CONTROL: get repo hash"),
-            cmd_con(AP_CONTROL_RESID, "GET_BLD_XGIT_VIEW", TYPE_UINT8, AP_CONTROL_CMD_GET_BLD_XGIT_VIEW, READ, BLD_XGIT_VIEW_LEN, "CONTROL: get xgit view"),
-            cmd_con(AP_CONTROL_RESID, "GET_BLD_XGIT_HASH", TYPE_UINT8, AP_CONTROL_CMD_GET_BLD_XGIT_HASH, READ, BLD_XGIT_HASH_LEN, "CONTROL: get xgit hash"),
-            cmd_con(AP_CONTROL_RESID, "GET_BLD_MODIFIED", TYPE_UINT8, AP_CONTROL_CMD_GET_BLD_MODIFIED, READ, BLD_MODIFIED_LEN, "CONTROL: get build modified from given view/hash"),
-#if !USE_I2C
-            cmd_con(GPIO_RESID, "GET_I2C", TYPE_UINT8, GPIO_CMD_GET_I2C, READ, I2C_MAX_CMD_SIZE, "GPIO: Read from an I2C device connected to the xvf device"),
-            cmd_con(GPIO_RESID, "GET_I2C_WITH_REG", TYPE_UINT8, GPIO_CMD_GET_I2C_WITH_REG, READ, I2C_MAX_CMD_SIZE, "GPIO: Read from the register of an I2C device connected to the xvf device"),
-            cmd_con(GPIO_RESID, "GET_I2C_READ_HEADER", TYPE_UINT8, GPIO_CMD_GET_I2C_READ_HEADER, READ, 3, "GPIO: Get the address, register address, and count of next I2C read"),
-            cmd_con(GPIO_RESID, "SET_I2C", TYPE_UINT8, GPIO_CMD_SET_I2C, WRITE, I2C_MAX_CMD_SIZE, "GPIO: Write to an I2C device connected to the xvf device"),
-            cmd_con(GPIO_RESID, "SET_I2C_WITH_REG", TYPE_UINT8, GPIO_CMD_SET_I2C_WITH_REG, WRITE, I2C_MAX_CMD_SIZE, "GPIO: Write to the register of an I2C device connected to the xvf device"),
-            cmd_con(GPIO_RESID, "SET_I2C_READ_HEADER", TYPE_UINT8, GPIO_CMD_SET_I2C_READ_HEADER, WRITE, 3, "GPIO: Set address, register address, and count of next I2C read"),
-
-#endif // !USE_I2C
-            cmd_con(GPIO_RESID, "GET_SPI", TYPE_UINT8, GPIO_CMD_GET_SPI, READ, SPI_READ_BUF_SIZE, "GPIO: Gets the contents of the SPI read buffer"),
-            cmd_con(GPIO_RESID, "GET_SPI_READ_HEADER", TYPE_UINT8, GPIO_CMD_GET_SPI_READ_HEADER, READ, 2, "GPIO: Get the address and count of next SPI read"),
-            cmd_con(GPIO_RESID, "SET_SPI_PUSH", TYPE_UINT8, GPIO_CMD_SET_SPI_PUSH, WRITE, SPI_MAX_CMD_SIZE, "GPIO: Push SPI command data onto the execution queue"),
-            cmd_con(GPIO_RESID, "SET_SPI_PUSH_AND_EXEC", TYPE_UINT8, GPIO_CMD_SET_SPI_PUSH_AND_EXEC, WRITE, SPI_MAX_CMD_SIZE, "GPIO: Push SPI command data and execute the command from the stack"),
-            cmd_con(GPIO_RESID, "SET_SPI_READ_HEADER", TYPE_UINT8, GPIO_CMD_SET_SPI_READ_HEADER, WRITE, 2, "GPIO: Set address and count of next SPI read"),
-
-            cmd_con(GPIO_RESID, "GET_GPI_PORT", TYPE_UINT32, GPIO_CMD_GET_GPI_PORT, READ, 1, "GPIO: Read current state of the selected GPIO port"),
-            cmd_con(GPIO_RESID, "GET_GPI_PIN", TYPE_UINT32, GPIO_CMD_GET_GPI_PIN, READ, 1, "GPIO: Read current state of the selected GPIO pin"),
-            cmd_con(GPIO_RESID, "GET_GPI_INT_PENDING_PIN", TYPE_UINT32, GPIO_CMD_GET_GPI_INT_PENDING_PIN, READ, 1, "GPIO: Read whether interrupt was triggered for selected pin"),
-            cmd_con(GPIO_RESID, "GET_GPI_INT_PENDING_PORT", TYPE_UINT32, GPIO_CMD_GET_GPI_INT_PENDING_PORT, READ, 1, "GPIO: Read whether interrupt was triggered for all pins on selected port"),
-            cmd_con(GPIO_RESID, "GET_KWD_HID_EVENT_CNT", TYPE_UINT32, GPIO_CMD_GET_KWD_HID_EVENT_CNT, READ, 1, "GPIO: read number of KWD HID events detected"),
-            cmd_con(GPIO_RESID, "SET_KWD_HID_EVENT_CNT", TYPE_UINT32, GPIO_CMD_SET_KWD_HID_EVENT_CNT, WRITE, 1, "GPIO: write number of KWD HID events detected"),
-            cmd_con(GPIO_RESID, "SET_GPO_PORT", TYPE_UINT32, GPIO_CMD_SET_GPO_PORT, WRITE, 2, "GPIO: Write to all pins of a GPIO port"),
-            cmd_con(GPIO_RESID, "SET_GPO_PIN", TYPE_UINT8, GPIO_CMD_SET_GPO_PIN, WRITE, 3, "GPIO: Write to a specific GPIO pin"),
-            cmd_con(GPIO_RESID, "SET_GPO_PIN_ACTIVE_LEVEL", TYPE_UINT8, GPIO_CMD_SET_GPO_PIN_ACTIVE_LEVEL, WRITE, 3, "GPIO: Set the active level for a specific GPO pin. 0: active low, 1: active high"),
-            cmd_con(GPIO_RESID, "SET_GPI_PIN_ACTIVE_LEVEL", TYPE_UINT8, GPIO_CMD_SET_GPI_PIN_ACTIVE_LEVEL, WRITE, 3, "GPIO: Set the active level for a specific GPI pin. 0: active low, 1: active high"),
-            cmd_con(GPIO_RESID, "SET_GPI_INT_CONFIG", TYPE_UINT8, GPIO_CMD_SET_GPI_INT_CONFIG, WRITE, 3, "GPIO: Sets the interrupt config for a specific pin"),
-            cmd_con(GPIO_RESID, "SET_GPI_READ_HEADER", TYPE_UINT8, GPIO_CMD_SET_GPI_READ_HEADER, WRITE, 2, "GPIO: Sets the selected port and pin for the next GPIO read"),
-            cmd_con(GPIO_RESID, "GET_GPI_READ_HEADER", TYPE_UINT8, GPIO_CMD_GET_GPI_READ_HEADER, READ, 2, "GPIO: Gets the currently selected port and pin"),
-            cmd_con(GPIO_RESID, "SET_GPO_PWM_DUTY", TYPE_UINT8, GPIO_CMD_SET_GPO_PWM_DUTY, WRITE, 3, "GPIO: Set the pwm duty for a specific pin. Value given as an integer percentage"),
-            cmd_con(GPIO_RESID, "SET_GPO_FLASHING", TYPE_UINT32, GPIO_CMD_SET_GPO_FLASHING, WRITE, 3, "GPIO: Set the serial flash mask for a specific pin. Each bit in the mask describes the GPO state for 100ms intervals"),
-
-            cmd_con(GPIO_RESID, "GET_KWD_BOOT_STATUS", TYPE_UINT8, GPIO_CMD_GET_KWD_BOOT_STATUS, READ, 1, "GPIO: Gets boot status for keyword detectors"),
-            cmd_con(GPIO_RESID, "GET_RUN_STATUS", TYPE_UINT8, GPIO_CMD_GET_RUN_STATUS, READ, 1, "GPIO: Gets run status for the device"),
-            cmd_con(GPIO_RESID, "GET_IO_MAP_AND_SHIFT", TYPE_UINT8, GPIO_CMD_GET_IO_MAP_AND_SHIFT, READ, NUM_IO_MAP_OUTPUTS*sizeof(io_map_and_output_shift_t), "Get IO map and output shift values for the device"),
-            cmd_con(GPIO_RESID, "SET_IO_MAP", TYPE_UINT8, GPIO_CMD_SET_IO_MAP, WRITE, 2, "Set IO map for the device. arg1: dest(output_io_map_t), arg2: source(input_io_map_t)"),
-
-            cmd_con(GPIO_RESID, "SET_FILTER_INDEX", TYPE_UINT8, GPIO_CMD_SET_FILTER_INDEX, WRITE, 1, "Set filter index. Selects which filter block will be read from/written to arg1: dest(filter_block_map_t)"),
-            cmd_con(GPIO_RESID, "SET_FILTER_BYPASS", TYPE_UINT8, GPIO_CMD_SET_FILTER_BYPASS, WRITE, 1, "Set filter bypass state. arg1: 0 - filter enabled, 1 - bypassed"),
-            cmd_con(GPIO_RESID, "SET_FILTER_COEFF", TYPE_ENERGY, GPIO_CMD_SET_FILTER_COEFF, WRITE, NUM_FILTER_COEFFS, "Set biquad coeffs for a selected filter using floating point. arg1..10: 5x2 float coeffs in forward order (a1,a2,b0,b1,b2) where a0 always is 1.0"),
-            cmd_con(GPIO_RESID, "SET_FILTER_COEFF_RAW", TYPE_INT32, GPIO_CMD_SET_FILTER_COEFF, WRITE, NUM_FILTER_COEFFS, "Set raw biquad coeffs for a selected filters. arg1..10: 2 sets of coeffs in forward order (b0,b1,b2,-a1,-a2) signed Q28 format"),
-
-            cmd_con(GPIO_RESID, "GET_FILTER_INDEX", TYPE_UINT8, GPIO_CMD_GET_FILTER_INDEX, READ, 1, "Get filter index. Selects which filter block will be read from/written to"),
-            cmd_con(GPIO_RESID, "GET_FILTER_BYPASS", TYPE_UINT8, GPIO_CMD_GET_FILTER_BYPASS, READ, 1, "Get filter bypass state. 0 - filter enabled, 1 - bypassed"),
-            cmd_con(GPIO_RESID, "GET_FILTER_COEFF", TYPE_ENERGY, GPIO_CMD_GET_FILTER_COEFF, READ, NUM_FILTER_COEFFS, "Get biquad coeffs for a selected filter using floating point. arg1..10: 5x2 float coeffs in forward order (a1,a2,b0,b1,b2) where a0 always is 1.0"),
-            cmd_con(GPIO_RESID, "GET_FILTER_COEFF_RAW", TYPE_INT32, GPIO_CMD_GET_FILTER_COEFF, READ, NUM_FILTER_COEFFS, "Get raw biquad coeffs for a selected filters. arg1..10: 2 sets of coeffs in forward order (b0,b1,b2,-a1,-a2) signed Q28 format"),
-
-            cmd_con(GPIO_RESID, "SET_OUTPUT_SHIFT", TYPE_INT32, GPIO_CMD_SET_OUTPUT_SHIFT, WRITE, 2, "For a selected output(output_io_map_t), set the no. of bits the output samples will be shifted by. Postive shift value indicates left shift, negative indicates right shift"),
-            cmd_con(GPIO_RESID, "GET_MAX_UBM_CYCLES", TYPE_UINT32, GPIO_CMD_GET_MAX_UBM_CYCLES, READ, 1, "Get maximum no. of cycles taken by the user buffer management function"),
-            cmd_con(GPIO_RESID, "RESET_MAX_UBM_CYCLES", TYPE_UINT8, GPIO_CMD_RESET_MAX_UBM_CYCLES, WRITE, 1, "reset the max user buffer management cycles count"),
-            cmd_con(GPIO_RESID, "GET_I2S_RATE", TYPE_UINT32, GPIO_CMD_GET_I2S_RATE, READ, 1, "Get I2S rate"),
-            cmd_con(GPIO_RESID, "SET_I2S_RATE", TYPE_UINT32, GPIO_CMD_SET_I2S_RATE, WRITE, 1, "Set I2S rate. This command is only run from the flash. Run it only with -l option to generate what goes in the flash data-partition."),
-            cmd_con(GPIO_RESID, "SET_I2S_START_STATUS", TYPE_UINT8, GPIO_CMD_SET_I2S_START_STATUS, WRITE, 1, "Start I2S. This command is only run from the flash. Run it only with -l option to generate the json item to use in the flash data-partition"),
-            cmd_con(GPIO_RESID, "GET_I2S_START_STATUS", TYPE_UINT8, GPIO_CMD_GET_I2S_START_STATUS, READ, 1, "Get I2S start status"),
-            cmd_con(GPIO_RESID, "GET_USB_VENDOR_ID", TYPE_UINT32, GPIO_CMD_GET_USB_VENDOR_ID, READ, 1, "Get USB Vendor ID"),
-            cmd_con(GPIO_RESID, "GET_USB_PRODUCT_ID", TYPE_UINT32, GPIO_CMD_GET_USB_PRODUCT_ID, READ, 1, "Get USB Product ID"),
-            cmd_con(GPIO_RESID, "GET_USB_BCD_DEVICE", TYPE_UINT32, GPIO_CMD_GET_USB_BCD_DEVICE, READ, 1, "Get USB Device Release Number (bcdDevice)"),
-            cmd_con(GPIO_RESID, "GET_USB_VENDOR_STRING", TYPE_UINT8, GPIO_CMD_GET_USB_VENDOR_STRING, READ, USB_STR_MAX_BYTES, "Get USB Vendor string"),
-            cmd_con(GPIO_RESID, "GET_USB_PRODUCT_STRING", TYPE_UINT8, GPIO_CMD_GET_USB_PRODUCT_STRING, READ, USB_STR_MAX_BYTES, "Get USB Product string"),
-            cmd_con(GPIO_RESID, "GET_SERIAL_NUMBER", TYPE_UINT8, GPIO_CMD_GET_SERIAL_NUMBER, READ, USB_STR_MAX_BYTES, "Read serial number from USB descriptor (normally initialised from flash)."),
-            cmd_con(GPIO_RESID, "GET_HARDWARE_BUILD", TYPE_UINT32, GPIO_CMD_GET_HARDWARE_BUILD, READ, 1, "Get the build number from the hardware build section of the flash data partition."),
-
-            cmd_con(GPIO_RESID, "SET_USB_VENDOR_ID", TYPE_UINT32, GPIO_CMD_SET_USB_VENDOR_ID, WRITE, 1, "Set USB Vendor ID. This command is only run from the flash. Run it only with -l option to generate the json item to use in the flash data-partition"),
-            cmd_con(GPIO_RESID, "SET_USB_PRODUCT_ID", TYPE_UINT32, GPIO_CMD_SET_USB_PRODUCT_ID, WRITE, 1, "Set USB Product ID. This command is only run from the flash. Run it only with -l option to generate the json item to use in the flash data-partition"),
-            cmd_con(GPIO_RESID, "SET_USB_VENDOR_STRING", TYPE_UINT8, GPIO_CMD_SET_USB_VENDOR_STRING, WRITE, USB_STR_MAX_BYTES, "Set USB Vendor string. This command is only run from the flash. Run it only with -l option to generate the json item to use in the flash data-partition"),
-            cmd_con(GPIO_RESID, "SET_USB_PRODUCT_STRING", TYPE_UINT8, GPIO_CMD_SET_USB_PRODUCT_STRING, WRITE, USB_STR_MAX_BYTES, "Set USB Product string. This command is only run from the flash. Run it only with -l option to generate the json item to use in the flash data-partition"),
-            cmd_con(GPIO_RESID, "SET_SERIAL_NUMBER", TYPE_UINT8, GPIO_CMD_SET_SERIAL_NUMBER, WRITE, USB_STR_MAX_BYTES, "Program serial number to flash"),
-            cmd_con(GPIO_RESID, "SET_USB_SERIAL_NUMBER", TYPE_UINT8, GPIO_CMD_SET_USB_SERIAL_NUMBER, WRITE, 1, "Load serial number from flash and initialise USB device descriptor with it. Will not work after boot since descriptor is populated only once, with USB start."),
-
-            cmd_con(GPIO_RESID, "SET_USB_BCD_DEVICE", TYPE_UINT32, GPIO_CMD_SET_USB_BCD_DEVICE, WRITE, 1, "Set USB Device Release Number (bcdDevice)"),
-#if !USE_I2C
-            cmd_con(GPIO_RESID, "SET_USB_START_STATUS", TYPE_UINT8, GPIO_CMD_SET_USB_START_STATUS, WRITE, 1, "Start USB. This command is only run from the flash. Run it only with -l option to generate the json item to use in the flash data-partition"),
-            cmd_con(GPIO_RESID, "GET_USB_START_STATUS", TYPE_UINT8, GPIO_CMD_GET_USB_START_STATUS, READ, 1, "Get USB start status"),
-#endif // !USE_I2C
-            cmd_con(GPIO_RESID, "GET_USB_TO_DEVICE_RATE", TYPE_UINT32, GPIO_CMD_GET_USB_TO_DEVICE_RATE, READ, 1, "Get USB to device rate"),
-            cmd_con(GPIO_RESID, "GET_DEVICE_TO_USB_RATE", TYPE_UINT32, GPIO_CMD_GET_DEVICE_TO_USB_RATE, READ, 1, "Get device to USB rate"),
-            cmd_con(GPIO_RESID, "GET_USB_TO_DEVICE_BIT_RES", TYPE_UINT32, GPIO_CMD_GET_USB_TO_DEVICE_BIT_RES, READ, 1, "Get USB to device bit resolution"),
-            cmd_con(GPIO_RESID, "GET_DEVICE_TO_USB_BIT_RES", TYPE_UINT32, GPIO_CMD_GET_DEVICE_TO_USB_BIT_RES, READ, 1, "Get device to USB bit resolution"),
-            cmd_con(GPIO_RESID, "SET_USB_TO_DEVICE_RATE", TYPE_UINT32, GPIO_CMD_SET_USB_TO_DEVICE_RATE, WRITE, 1, "Set USB to device rate"),
-            cmd_con(GPIO_RESID, "SET_DEVICE_TO_USB_RATE", TYPE_UINT32, GPIO_CMD_SET_DEVICE_TO_USB_RATE, WRITE, 1, "Set device to USB rate"),
-            cmd_con(GPIO_RESID, "SET_USB_TO_DEVICE_BIT_RES", TYPE_UINT32, GPIO_CMD_SET_USB_TO_DEVICE_BIT_RES, WRITE, 1, "Set USB to device bit resolution"),
-            cmd_con(GPIO_RESID, "SET_DEVICE_TO_USB_BIT_RES", TYPE_UINT32, GPIO_CMD_SET_DEVICE_TO_USB_BIT_RES, WRITE, 1, "Set device to USB bit resolution"),
-
-            cmd_con(GPIO_RESID, "GET_MCLK_IN_TO_PDM_CLK_DIVIDER", TYPE_UINT8, GPIO_CMD_GET_MCLK_IN_TO_PDM_CLK_DIVIDER, READ, 1, "Get XCore divider from input master clock to 6.144MHz DDR PDM microphone clock"),
-            cmd_con(GPIO_RESID, "GET_SYS_CLK_TO_MCLK_OUT_DIVIDER", TYPE_UINT8, GPIO_CMD_GET_SYS_CLK_TO_MCLK_OUT_DIVIDER, READ, 1, "Get XCore divider from system clock to output master clock"),
-            cmd_con(GPIO_RESID, "SET_MCLK_IN_TO_PDM_CLK_DIVIDER", TYPE_UINT8, GPIO_CMD_SET_MCLK_IN_TO_PDM_CLK_DIVIDER, WRITE, 1, "Set XCore divider from input master clock to 6.144MHz DDR PDM microphone clock (when master clock is slaved). Run it only with -l option to generate the json item to use in the flash data-partition"),
-            cmd_con(GPIO_RESID, "SET_SYS_CLK_TO_MCLK_OUT_DIVIDER", TYPE_UINT8, GPIO_CMD_SET_SYS_CLK_TO_MCLK_OUT_DIVIDER, WRITE, 1, "Set XCore divider from system clock to output master clock (where master clock output is used). Run it only with -l option to generate the json item to use in the flash data-partition"),
-            cmd_con(GPIO_RESID, "GET_MIC_START_STATUS", TYPE_UINT8, GPIO_CMD_GET_MIC_START_STATUS, READ, 1, "Get microphone client start status."),
-            cmd_con(GPIO_RESID, "SET_MIC_START_STATUS", TYPE_UINT8, GPIO_CMD_SET_MIC_START_STATUS, WRITE, 1, "Start microphone client (audio frontend).  This command is only run from the flash. Run it only with -l option to generate the json item to use in the flash data-partition"),
-            cmd_con(GPIO_RESID, "SET_MONITOR_STATE_USING_GPO_ENABLED", TYPE_UINT8, GPIO_CMD_SET_MONITOR_STATE_USING_GPO_ENABLED, WRITE, 1, "enable monitoring of state on GPO. This command is only run from the flash. Run it only with -l option to generate the json item to use in the flash data-partition"),
-            cmd_con(GPIO_RESID, "SET_KWD_INTERRUPT_PIN", TYPE_UINT8, GPIO_CMD_SET_KWD_INTERRUPT_PIN, WRITE, 1, "set gpi pin index to receive kwd interrupt on"),
-            cmd_con(GPIO_RESID, "GET_KWD_INTERRUPT_PIN", TYPE_UINT8, GPIO_CMD_GET_KWD_INTERRUPT_PIN, READ, 1, "get gpi pin index to receive kwd interrupt on"),
-
-            cmd_con(AEC_RESID,      "GET_BYPASS_AEC", TYPE_INT32, AEC_CMD_GET_BYPASS, READ, 1, "AEC: get bypass"),
-            cmd_con(AEC_RESID,      "GET_X_ENERGY_DELTA_AEC", TYPE_ENERGY, AEC_CMD_GET_X_ENERGY_DELTA, READ, 1, "AEC: get X energy delta"),
-            cmd_con(AEC_RESID,      "GET_X_ENERGY_GAMMA_LOG2_AEC", TYPE_INT32, AEC_CMD_GET_X_ENERGY_GAMMA_LOG2, READ, 1, "AEC: get X energy gamma log2"),
-            cmd_con(AEC_RESID,      "GET_FORCED_MU_VALUE_AEC", TYPE_FIXED_1_31, AEC_CMD_GET_FORCED_MU_VALUE, READ, 1, "AEC: get forced mu value"),
-            cmd_con(AEC_RESID,      "GET_ADAPTATION_CONFIG_AEC", TYPE_INT32, AEC_CMD_GET_ADAPTION_CONFIG, READ, 1, "AEC: get adaptation config"),
-            cmd_con(AEC_RESID,      "GET_MU_SCALAR_AEC", TYPE_FIXED_8_24, AEC_CMD_GET_MU_SCALAR, READ, 1, "AEC: get mu_scalar"),
-            cmd_con(AEC_RESID,      "GET_MU_LIMITS_AEC", TYPE_FIXED_1_31, AEC_CMD_GET_MU_LIMITS, READ, 2, "AEC: get mu_high and mu_low"),
-            cmd_con(AEC_RESID,      "GET_SIGMA_ALPHAS_AEC", TYPE_UINT32, AEC_CMD_GET_SIGMA_ALPHAS, READ, 3, "AEC: get sigma alphas"),
-            cmd_con(AEC_RESID,      "GET_ERLE_CH0_AEC", TYPE_ENERGY, AEC_CMD_GET_ERLE_CH0, READ, 2, "AEC: get channel 0 ERLE"),
-            cmd_con(AEC_RESID,      "GET_ERLE_CH1_AEC", TYPE_ENERGY, AEC_CMD_GET_ERLE_CH1, READ, 2, "AEC: get channel 1 ERLE"),
-            cmd_con(AEC_RESID,      "GET_FRAME_ADVANCE_AEC", TYPE_UINT32, AEC_CMD_GET_FRAME_ADVANCE, READ, 1, "AEC: get frame advance"),
-            cmd_con(AEC_RESID,      "GET_Y_CHANNELS_AEC", TYPE_UINT32, AEC_CMD_GET_Y_CHANNELS, READ, 1, "AEC: get y channels"),
-            cmd_con(AEC_RESID,      "GET_X_CHANNELS_AEC", TYPE_UINT32, AEC_CMD_GET_X_CHANNELS, READ, 1, "AEC: get x channels"),
-            cmd_con(AEC_RESID,      "GET_X_CHANNEL_PHASES_AEC", TYPE_UINT8, AEC_CMD_GET_X_CHANNEL_PHASES, READ, AEC_MAX_X_CHANNELS, "AEC: get x channel phases"),
-            cmd_con(AEC_RESID,      "GET_F_BIN_COUNT_AEC", TYPE_UINT32, AEC_CMD_GET_F_BIN_COUNT, READ, 1, "AEC: get f bin count"),
-            cmd_con(AEC_RESID,      "GET_FILTER_COEFFICIENTS_AEC", TYPE_INT32, AEC_CMD_GET_FILTER_COEFFICIENTS, READ, AEC_COEFFICIENT_CHUNK_SIZE/sizeof(uint32_t), "AEC: get filter coefficients"),
-            cmd_con(AEC_RESID,      "GET_COEFF_INDEX_AEC", TYPE_UINT32, AEC_CMD_GET_COEFFICIENT_INDEX, READ, 1, "AEC: get coefficient index"),
-            cmd_con(IC_RESID,      "GET_CH1_BEAMFORM_ENABLE", TYPE_UINT8, IC_CMD_GET_CH1_BEAMFORM_ENABLE, READ, 1, "get if beamforming is enabled on channel1. default:enable"),
-
-            cmd_con(AP_STAGE_A_RESID, "GET_DELAY_ESTIMATOR_ENABLED", TYPE_UINT32, AP_STAGE_A_CMD_GET_DELAY_ESTIMATOR_ENABLED, READ, 1, "CONTROL: enable/disable delay estimation"),
-            cmd_con(AP_STAGE_A_RESID, "GET_DELAY_ESTIMATE", TYPE_INT32, AP_STAGE_A_CMD_GET_DELAY_ESTIMATE, READ, 1, "CONTROL: get delay estimate"),
-            cmd_con(AP_STAGE_A_RESID, "GET_DELAY_DIRECTION", TYPE_UINT32, AP_STAGE_A_CMD_GET_DELAY_DIRECTION, READ, 1, "CONTROL: get configurable delay direction: 0: delay references, 1: delay mics"),
-            cmd_con(AP_STAGE_A_RESID, "GET_MIC_SHIFT_SATURATE", TYPE_UINT32, AP_STAGE_A_CMD_GET_MIC_SHIFT_SATURATE, READ, 2, "CONTROL: get the shift value and saturation (1=enable) to be applied to the input mic samples"),
-            cmd_con(AP_STAGE_A_RESID, "GET_ALT_ARCH_ENABLED", TYPE_UINT32, AP_STAGE_A_CMD_GET_ALT_ARCH_ENABLED, READ, 1, "stage A: Get state of xvf3510 alternate architecture setting: 0: normal, 1: alt-arch"),
-
-            cmd_con(AP_STAGE_A_RESID, "GET_ADEC_ENABLED", TYPE_UINT32, AP_STAGE_A_CMD_GET_ADEC_ENABLED, READ, 1, "stage A: get automatic delay estimator controller enabled: 0: off, 1: on"),
-            cmd_con(AP_STAGE_A_RESID, "GET_ADEC_MODE", TYPE_UINT32, AP_STAGE_A_CMD_GET_ADEC_MODE, READ, 1, "stage A: get automatic delay estimator controller mode: 0: normal AEC mode, 1: delay estimation mode"),
-            cmd_con(AP_STAGE_A_RESID, "GET_ADEC_TIME_SINCE_RESET", TYPE_UINT32, AP_STAGE_A_CMD_GET_ADEC_TIME_SINCE_RESET, READ, 1, "stage A: get time in milliseconds since last automatic delay change by ADEC"),
-            cmd_con(AP_STAGE_A_RESID, "GET_AGM", TYPE_FIXED_7_24, AP_STAGE_A_CMD_GET_AGM, READ, 1, "stage A: get AEC Goodness Metric estimate (0.0 - 1.0"),
-            cmd_con(AP_STAGE_A_RESID, "GET_ERLE_BAD_BITS", TYPE_FIXED_7_24, AP_STAGE_A_CMD_GET_ERLE_BAD_BITS, READ, 1, "stage A: get ERLE bad threshold in bits (log2)"),
-            cmd_con(AP_STAGE_A_RESID, "GET_ERLE_GOOD_BITS", TYPE_FIXED_7_24, AP_STAGE_A_CMD_GET_ERLE_GOOD_BITS, READ, 1, "stage A: get ERLE good threshold in bits (log2)"),
-            cmd_con(AP_STAGE_A_RESID, "GET_PEAK_PHASE_ENERGY_TREND_GAIN", TYPE_FIXED_7_24, AP_STAGE_A_CMD_GET_PEAK_PHASE_ENERGY_TREND_GAIN, READ, 1, "stage A: get value which sets AGM sensitivity to peak phase energy slope"),
-            cmd_con(AP_STAGE_A_RESID, "GET_ERLE_BAD_GAIN", TYPE_FIXED_7_24, AP_STAGE_A_CMD_GET_ERLE_BAD_GAIN, READ, 1, "stage A: set how steeply AGM drops off when ERLE below threshold"),
-            cmd_con(AP_STAGE_A_RESID, "GET_ADEC_FAR_THRESHOLD", TYPE_ENERGY, AP_STAGE_A_CMD_GET_ADEC_FAR_THRESHOLD, READ, 1, "stage A: get far signal energy threshold above which we update AGM"),
-            cmd_con(AP_STAGE_A_RESID, "GET_AEC_PEAK_TO_AVERAGE_RATIO", TYPE_ENERGY, AP_STAGE_A_CMD_GET_AEC_PEAK_TO_AVERAGE_RATIO, READ, 1, "stage A: get AEC coefficients peak to average ratio"),
-            cmd_con(AP_STAGE_A_RESID, "GET_PHASE_POWERS", TYPE_ENERGY, AP_STAGE_A_CMD_GET_PHASE_POWERS, READ, ADEC_READ_PHASE_POWER_CHUNK_SIZE/sizeof(uint32_t)/2, "stage A: get 5 phase powers (240 samples per phase) used in delay estimation from the index set."),
-            cmd_con(AP_STAGE_A_RESID, "GET_PHASE_POWER_INDEX", TYPE_UINT32, AP_STAGE_A_CMD_GET_PHASE_POWER_INDEX, READ, 1, "stage A: get GERLE gain (how strongly it responds either side of mid point)"),
-            cmd_con(AP_STAGE_A_RESID, "GET_LOCKER_ENABLED", TYPE_UINT32, AP_STAGE_A_CMD_GET_LOCKER_ENABLED, READ, 1, "stage A: get locker delay detection and control enabled enabled: 0: off, 1: on"),
-
-            cmd_con(AP_STAGE_A_RESID, "GET_LOCKER_STATE", TYPE_UINT32, AP_STAGE_A_CMD_GET_LOCKER_STATE, READ, 1, "stage A: get locker state"),
-            cmd_con(AP_STAGE_A_RESID, "GET_MIN_RX_TIME_STAGE_A", TYPE_TICKS, AP_STAGE_A_CMD_GET_MIN_TIME_RX, READ, 1, "stage A min rx time per frame"),
-            cmd_con(AP_STAGE_A_RESID, "GET_MAX_RX_TIME_STAGE_A", TYPE_TICKS, AP_STAGE_A_CMD_GET_MAX_TIME_RX, READ, 1, "stage A max rx time per frame"),
-            cmd_con(AP_STAGE_A_RESID, "GET_MIN_CONTROL_TIME_STAGE_A", TYPE_TICKS, AP_STAGE_A_CMD_GET_MIN_TIME_CONTROL, READ, 1, "stage A min control time per frame"),
-            cmd_con(AP_STAGE_A_RESID, "GET_MAX_CONTROL_TIME_STAGE_A", TYPE_TICKS, AP_STAGE_A_CMD_GET_MAX_TIME_CONTROL, READ, 1, "stage A max control time per frame"),
-            cmd_con(AP_STAGE_A_RESID, "GET_MIN_DSP_TIME_STAGE_A", TYPE_TICKS, AP_STAGE_A_CMD_GET_MIN_TIME_DSP, READ, 1, "stage A min dsp time per frame"),
-            cmd_con(AP_STAGE_A_RESID, "GET_MAX_DSP_TIME_STAGE_A", TYPE_TICKS, AP_STAGE_A_CMD_GET_MAX_TIME_DSP, READ, 1, "stage A max dsp time per frame"),
-            cmd_con(AP_STAGE_A_RESID, "GET_MIN_TX_TIME_STAGE_A", TYPE_TICKS, AP_STAGE_A_CMD_GET_MIN_TIME_TX, READ, 1, "stage A min tx time per frame"),
-            cmd_con(AP_STAGE_A_RESID, "GET_MAX_TX_TIME_STAGE_A", TYPE_TICKS, AP_STAGE_A_CMD_GET_MAX_TIME_TX, READ, 1, "stage A max tx time per frame"),
-            cmd_con(AP_STAGE_A_RESID, "GET_MIN_IDLE_TIME_STAGE_A", TYPE_TICKS, AP_STAGE_A_CMD_GET_MIN_TIME_IDLE, READ, 1, "stage A min idle time per frame"),
-            cmd_con(AP_STAGE_A_RESID, "GET_MAX_IDLE_TIME_STAGE_A", TYPE_TICKS, AP_STAGE_A_CMD_GET_MAX_TIME_IDLE, READ, 1, "stage A max idle time per frame"),
-
-            cmd_con(AP_STAGE_A_RESID, "GET_LOCKER_NUM_BAD_FRAMES_THRESHOLD", TYPE_UINT32, AP_STAGE_A_CMD_GET_LOCKER_NUM_BAD_FRAMES_THRESHOLD, READ, 1, "stage A: get no. of bad peak to avg erle frames that locker sees before it triggers adec. Default: 666"),
-            cmd_con(AP_STAGE_A_RESID, "GET_LOCKER_DELAY_SETPOINT_ENABLED", TYPE_UINT32, AP_STAGE_A_CMD_GET_LOCKER_DELAY_SETPOINT_ENABLED, READ, 1, "Get delay setpoint enabled"),
-            cmd_con(AP_STAGE_A_RESID, "GET_LOCKER_DELAY_SETPOINT_SAMPLES", TYPE_UINT32, AP_STAGE_A_CMD_GET_LOCKER_DELAY_SETPOINT_SAMPLES, READ, 1, "Get delay setpoint samples"),
-            cmd_con(AP_STAGE_A_RESID, "GET_LOCKER_DELAY_SETPOINT_DIRECTION", TYPE_UINT32, AP_STAGE_A_CMD_GET_LOCKER_DELAY_SETPOINT_DIRECTION, READ, 1, "Get delay setpoint direction"),
-            cmd_con(AP_STAGE_A_RESID, "GET_ADEC_PEAK_TO_AVERAGE_GOOD_AEC", TYPE_ENERGY, AP_STAGE_A_CMD_GET_ADEC_PEAK_TO_AVERAGE_GOOD_AEC, READ, 1, "stage A: get the peak to average ratio that is considered good when in normal AEC mode"),
-
-            cmd_con(AP_STAGE_A_RESID, "SET_LOCKER_NUM_BAD_FRAMES_THRESHOLD", TYPE_UINT32, AP_STAGE_A_CMD_SET_LOCKER_NUM_BAD_FRAMES_THRESHOLD, WRITE, 1, "stage A: set no. of bad peak to avg erle frames that locker sees before it triggers adec. Default: 666"),
-            cmd_con(AP_STAGE_A_RESID, "SET_LOCKER_DELAY_SETPOINT_ENABLED", TYPE_UINT32, AP_STAGE_A_CMD_SET_LOCKER_DELAY_SETPOINT_ENABLED, WRITE, 1, "Set delay setpoint enabled"),
-            cmd_con(AP_STAGE_A_RESID, "SET_LOCKER_DELAY_SETPOINT_SAMPLES", TYPE_UINT32, AP_STAGE_A_CMD_SET_LOCKER_DELAY_SETPOINT_SAMPLES, WRITE, 1, "Set delay setpoint samples"),
-            cmd_con(AP_STAGE_A_RESID, "SET_LOCKER_DELAY_SETPOINT_DIRECTION", TYPE_UINT32, AP_STAGE_A_CMD_SET_LOCKER_DELAY_SETPOINT_DIRECTION, WRITE, 1, "Set delay setpoint direction"),
-            cmd_con(AP_STAGE_A_RESID, "SET_ADEC_PEAK_TO_AVERAGE_GOOD_AEC", TYPE_ENERGY, AP_STAGE_A_CMD_SET_ADEC_PEAK_TO_AVERAGE_GOOD_AEC, WRITE, 1, "stage A: set the peak to average ratio that is considered good when in normal AEC mode"),
-
-            cmd_con(AP_STAGE_B_RESID, "GET_MIN_RX_TIME_STAGE_B", TYPE_TICKS, AP_STAGE_B_CMD_GET_MIN_TIME_RX, READ, 1, "stage B min rx time per frame"),
-            cmd_con(AP_STAGE_B_RESID, "GET_MAX_RX_TIME_STAGE_B", TYPE_TICKS, AP_STAGE_B_CMD_GET_MAX_TIME_RX, READ, 1, "stage B max rx time per frame"),
-            cmd_con(AP_STAGE_B_RESID, "GET_MIN_CONTROL_TIME_STAGE_B", TYPE_TICKS, AP_STAGE_B_CMD_GET_MIN_TIME_CONTROL, READ, 1, "stage B min control time per frame"),
-            cmd_con(AP_STAGE_B_RESID, "GET_MAX_CONTROL_TIME_STAGE_B", TYPE_TICKS, AP_STAGE_B_CMD_GET_MAX_TIME_CONTROL, READ, 1, "stage B max control time per frame"),
-            cmd_con(AP_STAGE_B_RESID, "GET_MIN_DSP_TIME_STAGE_B", TYPE_TICKS, AP_STAGE_B_CMD_GET_MIN_TIME_DSP, READ, 1, "stage B min dsp time per frame"),
-            cmd_con(AP_STAGE_B_RESID, "GET_MAX_DSP_TIME_STAGE_B", TYPE_TICKS, AP_STAGE_B_CMD_GET_MAX_TIME_DSP, READ, 1, "stage B max dsp time per frame"),
-            cmd_con(AP_STAGE_B_RESID, "GET_MIN_TX_TIME_STAGE_B", TYPE_TICKS, AP_STAGE_B_CMD_GET_MIN_TIME_TX, READ, 1, "stage B min tx time per frame"),
-            cmd_con(AP_STAGE_B_RESID, "GET_MAX_TX_TIME_STAGE_B", TYPE_TICKS, AP_STAGE_B_CMD_GET_MAX_TIME_TX, READ, 1, "stage B max tx time per frame"),
-            cmd_con(AP_STAGE_B_RESID, "GET_MIN_IDLE_TIME_STAGE_B", TYPE_TICKS, AP_STAGE_B_CMD_GET_MIN_TIME_IDLE, READ, 1, "stage B min idle time per frame"),
-            cmd_con(AP_STAGE_B_RESID, "GET_MAX_IDLE_TIME_STAGE_B", TYPE_TICKS, AP_STAGE_B_CMD_GET_MAX_TIME_IDLE, READ, 1, "stage B max idle time per frame"),
-
-            cmd_con(AP_STAGE_C_RESID, "GET_MIN_RX_TIME_STAGE_C", TYPE_TICKS, AP_STAGE_C_CMD_GET_MIN_TIME_RX, READ, 1, "stage C min rx time per frame"),
-            cmd_con(AP_STAGE_C_RESID, "GET_MAX_RX_TIME_STAGE_C", TYPE_TICKS, AP_STAGE_C_CMD_GET_MAX_TIME_RX, READ, 1, "stage C max rx time per frame"),
-            cmd_con(AP_STAGE_C_RESID, "GET_MIN_CONTROL_TIME_STAGE_C", TYPE_TICKS, AP_STAGE_C_CMD_GET_MIN_TIME_CONTROL, READ, 1, "stage C min control time per frame"),
-            cmd_con(AP_STAGE_C_RESID, "GET_MAX_CONTROL_TIME_STAGE_C", TYPE_TICKS, AP_STAGE_C_CMD_GET_MAX_TIME_CONTROL, READ, 1, "stage C max control time per frame"),
-            cmd_con(AP_STAGE_C_RESID, "GET_MIN_DSP_TIME_STAGE_C", TYPE_TICKS, AP_STAGE_C_CMD_GET_MIN_TIME_DSP, READ, 1, "stage C min dsp time per frame"),
-            cmd_con(AP_STAGE_C_RESID, "GET_MAX_DSP_TIME_STAGE_C", TYPE_TICKS, AP_STAGE_C_CMD_GET_MAX_TIME_DSP, READ, 1, "stage C max dsp time per frame"),
-            cmd_con(AP_STAGE_C_RESID, "GET_MIN_TX_TIME_STAGE_C", TYPE_TICKS, AP_STAGE_C_CMD_GET_MIN_TIME_TX, READ, 1, "stage C min tx time per frame"),
-            cmd_con(AP_STAGE_C_RESID, "GET_MAX_TX_TIME_STAGE_C", TYPE_TICKS, AP_STAGE_C_CMD_GET_MAX_TIME_TX, READ, 1, "stage C max tx time per frame"),
-            cmd_con(AP_STAGE_C_RESID, "GET_MIN_IDLE_TIME_STAGE_C", TYPE_TICKS, AP_STAGE_C_CMD_GET_MIN_TIME_IDLE, READ, 1, "stage C min idle time per frame"),
-            cmd_con(AP_STAGE_C_RESID, "GET_MAX_IDLE_TIME_STAGE_C", TYPE_TICKS, AP_STAGE_C_CMD_GET_MAX_TIME_IDLE, READ, 1, "stage C max idle time per frame"),
-            cmd_con(AGC_RESID, "GET_GAIN_CH0_AGC", TYPE_FIXED_16_16, AGC_CMD_GET_GAIN, READ, 1, "get gain for channel 0"),
-            cmd_con(AGC_RESID, "GET_GAIN_CH1_AGC", TYPE_FIXED_16_16, AGC_CMD_GET_GAIN, READ, 1, "get gain for channel 1"),
-            cmd_con(AGC_RESID, "GET_MAX_GAIN_CH0_AGC", TYPE_FIXED_16_16, AGC_CMD_GET_MAX_GAIN, READ, 1, "get max gain for channel 0"),
-            cmd_con(AGC_RESID, "GET_MAX_GAIN_CH1_AGC", TYPE_FIXED_16_16, AGC_CMD_GET_MAX_GAIN, READ, 1, "get max gain for channel 1"),
-            cmd_con(AGC_RESID, "GET_MIN_GAIN_CH0_AGC", TYPE_FIXED_16_16, AGC_CMD_GET_MIN_GAIN, READ, 1, "get min gain for channel 0"),
-            cmd_con(AGC_RESID, "GET_MIN_GAIN_CH1_AGC", TYPE_FIXED_16_16, AGC_CMD_GET_MIN_GAIN, READ, 1, "get min gain for channel 1"),
-            cmd_con(AGC_RESID, "GET_UPPER_THRESHOLD_CH0_AGC", TYPE_FIXED_1_31, AGC_CMD_GET_DESIRED_UPPER_THRESHOLD, READ, 1, "get upper threshold of desired level for channel 0"),
-            cmd_con(AGC_RESID, "GET_UPPER_THRESHOLD_CH1_AGC", TYPE_FIXED_1_31, AGC_CMD_GET_DESIRED_UPPER_THRESHOLD, READ, 1, "get upper threshold of desired level for channel 1"),
-            cmd_con(AGC_RESID, "GET_LOWER_THRESHOLD_CH0_AGC", TYPE_FIXED_1_31, AGC_CMD_GET_DESIRED_LOWER_THRESHOLD, READ, 1, "get lower threshold of desired level for channel 0"),
-            cmd_con(AGC_RESID, "GET_LOWER_THRESHOLD_CH1_AGC", TYPE_FIXED_1_31, AGC_CMD_GET_DESIRED_LOWER_THRESHOLD, READ, 1, "get lower threshold of desired level for channel 1"),
-            cmd_con(AGC_RESID, "GET_ADAPT_CH0_AGC", TYPE_UINT32, AGC_CMD_GET_ADAPT, READ, 1, "get AGC adaptation for channel 0"),
-            cmd_con(AGC_RESID, "GET_ADAPT_CH1_AGC", TYPE_UINT32, AGC_CMD_GET_ADAPT, READ, 1, "get AGC adaptation for channel 1"),
-            cmd_con(AGC_RESID, "GET_ADAPT_ON_VAD_CH0_AGC", TYPE_UINT32, AGC_CMD_GET_ADAPT_ON_VAD, READ, 1, "get AGC adaptation using VAD data for channel 0"),
-            cmd_con(AGC_RESID, "GET_ADAPT_ON_VAD_CH1_AGC", TYPE_UINT32, AGC_CMD_GET_ADAPT_ON_VAD, READ, 1, "get AGC adaptation using VAD data for channel 1"),
-
-            cmd_con(AGC_RESID, "GET_SOFT_CLIPPING_CH0_AGC", TYPE_UINT32, AGC_CMD_GET_SOFT_CLIPPING, READ, 1, "get AGC soft clipping for channel 0"),
-            cmd_con(AGC_RESID, "GET_SOFT_CLIPPING_CH1_AGC", TYPE_UINT32, AGC_CMD_GET_SOFT_CLIPPING, READ, 1, "get AGC soft clipping  for channel 1"),
-            cmd_con(AGC_RESID, "GET_LC_ENABLED_CH0_AGC", TYPE_UINT32, AGC_CMD_GET_LC_ENABLED, READ, 1, "get loss control enable for channel 0"),
-            cmd_con(AGC_RESID, "GET_LC_ENABLED_CH1_AGC", TYPE_UINT32, AGC_CMD_GET_LC_ENABLED, READ, 1, "get loss control enable for channel 1"),
-
-            cmd_con(AGC_RESID, "GET_INCREMENT_GAIN_STEPSIZE_CH0_AGC", TYPE_FIXED_16_16, AGC_CMD_GET_GAIN_INCREMENT_STEPSIZE, READ, 1, "get stepsize with which gain is incremented for AGC ch0"),
-            cmd_con(AGC_RESID, "GET_INCREMENT_GAIN_STEPSIZE_CH1_AGC", TYPE_FIXED_16_16, AGC_CMD_GET_GAIN_INCREMENT_STEPSIZE, READ, 1, "get stepsize with which gain is incremented for AGC ch1"),
-            cmd_con(AGC_RESID, "GET_DECREMENT_GAIN_STEPSIZE_CH0_AGC", TYPE_FIXED_16_16, AGC_CMD_GET_GAIN_DECREMENT_STEPSIZE, READ, 1, "get stepsize with which gain is decremented for AGC ch0"),
-            cmd_con(AGC_RESID, "GET_DECREMENT_GAIN_STEPSIZE_CH1_AGC", TYPE_FIXED_16_16, AGC_CMD_GET_GAIN_DECREMENT_STEPSIZE, READ, 1, "get stepsize with which gain is decremented for AGC ch1"),
-
-            cmd_con(IC_RESID,      "GET_BYPASS_IC", TYPE_INT32, IC_CMD_GET_BYPASS, READ, 1, "IC: get bypass state"),
-            cmd_con(IC_RESID,      "GET_X_ENERGY_DELTA_IC", TYPE_ENERGY, IC_CMD_GET_X_ENERGY_DELTA, READ, 1, "IC: get X energy delta"),
-            cmd_con(IC_RESID,      "GET_X_ENERGY_GAMMA_LOG2_IC", TYPE_UINT32, IC_CMD_GET_X_ENERGY_GAMMA_LOG2, READ, 1, "IC: get X energy gamma log2"),
-            cmd_con(IC_RESID,      "GET_FORCED_MU_VALUE_IC", TYPE_FIXED_1_31, IC_CMD_GET_FORCED_MU_VALUE, READ, 1, "IC: get forced mu value"),
-            cmd_con(IC_RESID,      "GET_ADAPTATION_CONFIG_IC", TYPE_INT32, IC_CMD_GET_ADAPTION_CONFIG, READ, 1, "IC: get adaptation config"),
-            cmd_con(IC_RESID,      "GET_SIGMA_ALPHA_IC", TYPE_UINT32, IC_CMD_GET_SIGMA_ALPHA, READ, 1, "IC: get adaptation config"),
-            cmd_con(IC_RESID,      "GET_PHASES_IC", TYPE_UINT32, IC_CMD_GET_PHASES, READ, 1, "IC: get phases"),
-            cmd_con(IC_RESID,      "GET_PROC_FRAME_BINS_IC", TYPE_UINT32, IC_CMD_GET_PROC_FRAME_BINS, READ, 1, "IC: get proc frame bins"),
-            cmd_con(IC_RESID,      "GET_FILTER_COEFFICIENTS_IC", TYPE_UINT32, IC_CMD_GET_FILTER_COEFFICIENTS, READ, IC_COEFFICIENT_CHUNK_SIZE/sizeof(uint32_t), "IC: get filter coefficients"),
-            cmd_con(IC_RESID,      "GET_COEFFICIENT_INDEX_IC", TYPE_UINT32, IC_CMD_GET_COEFFICIENT_INDEX, READ, 1, "IC: get coefficient index"),
-
-            cmd_con(SUP_RESID,      "GET_BYPASS_SUP", TYPE_INT32, SUP_CMD_GET_BYPASS, READ, 1, "SUP: get bypass"),
-            cmd_con(SUP_RESID,      "GET_ENABLED_AES", TYPE_INT32, SUP_CMD_GET_ECHO_SUPPRESSION_ENABLED, READ, 1, "SUP: get echo suppresion enabled"),
-            cmd_con(SUP_RESID,      "GET_ENABLED_NS", TYPE_INT32, SUP_CMD_GET_NOISE_SUPPRESSION_ENABLED, READ, 1, "SUP: get noise suppresion enabled"),
-            cmd_con(SUP_RESID,      "GET_NOISE_FLOOR_NS", TYPE_FIXED_0_32, SUP_CMD_GET_NOISE_MCRA_NOISE_FLOOR, READ, 1, "SUP: get noise suppression noise floor"),
-
-
-            cmd_con(AEC_RESID,      "SET_BYPASS_AEC", TYPE_INT32, AEC_CMD_SET_BYPASS, WRITE, 1, "AEC: set bypass"),
-            cmd_con(AEC_RESID,      "SET_X_ENERGY_DELTA_AEC", TYPE_ENERGY, AEC_CMD_SET_X_ENERGY_DELTA, WRITE, 1, "AEC: set X energy delta"),
-            cmd_con(AEC_RESID,      "SET_X_ENERGY_GAMMA_LOG2_AEC", TYPE_INT32, AEC_CMD_SET_X_ENERGY_GAMMA_LOG2, WRITE, 1, "AEC: set X energy gamma log2"),
-            cmd_con(AEC_RESID,      "SET_FORCED_MU_VALUE_AEC", TYPE_FIXED_1_31, AEC_CMD_SET_FORCED_MU_VALUE, WRITE, 1, "AEC: set forced mu value"),
-            cmd_con(AEC_RESID,      "SET_ADAPTATION_CONFIG_AEC", TYPE_INT32, AEC_CMD_SET_ADAPTION_CONFIG, WRITE, 1, "AEC: set adaptation config"),
-            cmd_con(AEC_RESID,      "SET_MU_SCALAR_AEC", TYPE_FIXED_8_24, AEC_CMD_SET_MU_SCALAR, WRITE, 1, "AEC: set mu_scalar"),
-            cmd_con(AEC_RESID,      "SET_MU_LIMITS_AEC", TYPE_FIXED_1_31, AEC_CMD_SET_MU_LIMITS, WRITE, 2, "AEC: set mu_high and mu_low"),
-            cmd_con(AEC_RESID,      "SET_SIGMA_ALPHAS_AEC", TYPE_UINT32, AEC_CMD_SET_SIGMA_ALPHAS, WRITE, 3, "AEC: set sigma alphas"),
-            cmd_con(AEC_RESID,      "RESET_FILTER_AEC", TYPE_UINT8, AEC_CMD_RESET_FILTER, WRITE, 1, "AEC: reset filter"),
-
-            cmd_con(AEC_RESID,      "SET_COEFF_INDEX_AEC", TYPE_UINT32, AEC_CMD_SET_COEFFICIENT_INDEX, WRITE, 1, "AEC: set coefficient index"),
-
-            cmd_con(AP_STAGE_A_RESID, "SET_DELAY_DIRECTION", TYPE_UINT32, AP_STAGE_A_CMD_SET_DELAY_DIRECTION, WRITE, 1, "set configurable delay direction: 0: delay references, 1: delay mics "),
-            cmd_con(AP_CONTROL_RESID, "SET_DELAY_SAMPLES", TYPE_UINT32, AP_CONTROL_CMD_SET_DELAY_SAMPLES, WRITE, 1, "CONTROL: set configurable delay in samples"),
-            cmd_con(AP_STAGE_A_RESID, "SET_DELAY_ESTIMATOR_ENABLED", TYPE_UINT32, AP_STAGE_A_CMD_SET_DELAY_ESTIMATOR_ENABLED, WRITE, 1, "set delay estimator enabled"),
-            cmd_con(AP_STAGE_A_RESID, "SET_MIC_SHIFT_SATURATE", TYPE_UINT32, AP_STAGE_A_CMD_SET_MIC_SHIFT_SATURATE, WRITE, 2, "CONTROL: set the shift value and saturation (1=enable) to be applied to the input mic samples"),
-            cmd_con(AP_STAGE_A_RESID, "SET_ALT_ARCH_ENABLED", TYPE_UINT32, AP_STAGE_A_CMD_SET_ALT_ARCH_ENABLED, WRITE, 1, "stage A: Set state of xvf3510 alternate architecture setting: 0: normal, 1: alt-arch"),
-
-
-            cmd_con(AP_STAGE_A_RESID, "SET_ADEC_ENABLED", TYPE_UINT32, AP_STAGE_A_CMD_SET_ADEC_ENABLED, WRITE, 1, "set delay estimator controller enabled: 0: off, 1: on"),
-            cmd_con(AP_STAGE_A_RESID, "SET_MANUAL_ADEC_CYCLE_TRIGGER", TYPE_UINT32, AP_STAGE_A_CMD_SET_MANUAL_ADEC_CYCLE_TRIGGER, WRITE, 1, "trigger a delay estimate + delay configure cycle when 1 is written"),
-            cmd_con(AP_STAGE_A_RESID, "SET_ERLE_BAD_BITS", TYPE_FIXED_7_24, AP_STAGE_A_CMD_SET_ERLE_BAD_BITS, WRITE, 1, "set ERLE threshold at which AGM is decreased"),
-            cmd_con(AP_STAGE_A_RESID, "SET_ERLE_GOOD_BITS", TYPE_FIXED_7_24, AP_STAGE_A_CMD_SET_ERLE_GOOD_BITS, WRITE, 1, "set ERLE threshold at which AGM is increased"),
-            cmd_con(AP_STAGE_A_RESID, "SET_ERLE_BAD_GAIN", TYPE_FIXED_7_24, AP_STAGE_A_CMD_SET_ERLE_BAD_GAIN, WRITE, 1, "set how strongly AGM is updated when ERLE below threshold"),
-            cmd_con(AP_STAGE_A_RESID, "SET_PEAK_PHASE_ENERGY_TREND_GAIN", TYPE_FIXED_7_24, AP_STAGE_A_CMD_SET_PEAK_PHASE_ENERGY_TREND_GAIN, WRITE, 1, "set how strongly AGM is updated by the peak phase slope"),
-            cmd_con(AP_STAGE_A_RESID, "SET_ADEC_FAR_THRESHOLD", TYPE_ENERGY, AP_STAGE_A_CMD_SET_ADEC_FAR_THRESHOLD, WRITE, 1, "set energy threshold of far signal above which AGM is updated"),
-            cmd_con(AP_STAGE_A_RESID, "SET_PHASE_POWER_INDEX", TYPE_UINT32, AP_STAGE_A_CMD_SET_PHASE_POWER_INDEX, WRITE, 1, "set index for reading phase powers"),
-            cmd_con(AP_STAGE_A_RESID, "SET_LOCKER_ENABLED", TYPE_UINT32, AP_STAGE_A_CMD_SET_LOCKER_ENABLED, WRITE, 1, "stage A: set locker delay detection and control enabled enabled: 0: off, 1: on"),
-
-            cmd_con(AP_STAGE_A_RESID, "RESET_TIME_STAGE_A", TYPE_UINT8, AP_STAGE_A_CMD_RESET_TIME, WRITE, 1, "reset stage A frame time"),
-            cmd_con(AP_STAGE_B_RESID, "RESET_TIME_STAGE_B", TYPE_UINT8, AP_STAGE_B_CMD_RESET_TIME, WRITE, 1, "reset stage B frame time"),
-            cmd_con(AP_STAGE_C_RESID, "RESET_TIME_STAGE_C", TYPE_UINT8, AP_STAGE_C_CMD_RESET_TIME, WRITE, 1, "reset stage C frame time"),
-
-            cmd_con(AGC_RESID, "SET_GAIN_CH0_AGC", TYPE_FIXED_16_16, AGC_CMD_SET_GAIN, WRITE, 1, "set gain for channel 0"),
-            cmd_con(AGC_RESID, "SET_GAIN_CH1_AGC", TYPE_FIXED_16_16, AGC_CMD_SET_GAIN, WRITE, 1, "set gain for channel 1"),
-            cmd_con(AGC_RESID, "SET_MAX_GAIN_CH0_AGC", TYPE_FIXED_16_16, AGC_CMD_SET_MAX_GAIN, WRITE, 1, "set max gain for channel 0"),
-            cmd_con(AGC_RESID, "SET_MAX_GAIN_CH1_AGC", TYPE_FIXED_16_16, AGC_CMD_SET_MAX_GAIN, WRITE, 1, "set gain for channel 1"),
-            cmd_con(AGC_RESID, "SET_MAX_GAIN_CH1_AGC", TYPE_FIXED_16_16, AGC_CMD_SET_MAX_GAIN, WRITE, 1, "set max gain for channel 1"),
-            cmd_con(AGC_RESID, "SET_MIN_GAIN_CH0_AGC", TYPE_FIXED_16_16, AGC_CMD_SET_MIN_GAIN, WRITE, 1, "set min gain for channel 0"),
-            cmd_con(AGC_RESID, "SET_MIN_GAIN_CH1_AGC", TYPE_FIXED_16_16, AGC_CMD_SET_MIN_GAIN, WRITE, 1, "set min gain for channel 1"),
-            cmd_con(AGC_RESID, "SET_UPPER_THRESHOLD_CH0_AGC", TYPE_FIXED_1_31, AGC_CMD_SET_DESIRED_UPPER_THRESHOLD, WRITE, 1, "set upper threshold of desired level for channel 0"),
-            cmd_con(AGC_RESID, "SET_UPPER_THRESHOLD_CH1_AGC", TYPE_FIXED_1_31, AGC_CMD_SET_DESIRED_UPPER_THRESHOLD, WRITE, 1, "set upper threshold of desired level for channel 1"),
-            cmd_con(AGC_RESID, "SET_LOWER_THRESHOLD_CH0_AGC", TYPE_FIXED_1_31, AGC_CMD_SET_DESIRED_LOWER_THRESHOLD, WRITE, 1, "set lower threshold of desired level for channel 0"),
-            cmd_con(AGC_RESID, "SET_LOWER_THRESHOLD_CH1_AGC", TYPE_FIXED_1_31, AGC_CMD_SET_DESIRED_LOWER_THRESHOLD, WRITE, 1, "set lower threshold of desired level for channel 1"),
-            cmd_con(AGC_RESID, "SET_ADAPT_CH0_AGC", TYPE_UINT32, AGC_CMD_SET_ADAPT, WRITE, 1, "set AGC adaptation for channel 0"),
-            cmd_con(AGC_RESID, "SET_ADAPT_CH1_AGC", TYPE_UINT32, AGC_CMD_SET_ADAPT, WRITE, 1, "set AGC adaptation for channel 1"),
-            cmd_con(AGC_RESID, "SET_ADAPT_ON_VAD_CH0_AGC", TYPE_UINT32, AGC_CMD_SET_ADAPT_ON_VAD, WRITE, 1, "set AGC adaptation using VAD data for channel 0"),
-            cmd_con(AGC_RESID, "SET_ADAPT_ON_VAD_CH1_AGC", TYPE_UINT32, AGC_CMD_SET_ADAPT_ON_VAD, WRITE, 1, "set AGC adaptation using VAD data for channel 1"),
-
-            cmd_con(AGC_RESID, "SET_SOFT_CLIPPING_CH0_AGC", TYPE_UINT32, AGC_CMD_SET_SOFT_CLIPPING, WRITE, 1, "set AGC soft clipping for channel 0"),
-            cmd_con(AGC_RESID, "SET_SOFT_CLIPPING_CH1_AGC", TYPE_UINT32, AGC_CMD_SET_SOFT_CLIPPING, WRITE, 1, "set AGC soft clipping for channel 1"),
-            cmd_con(AGC_RESID, "SET_LC_ENABLED_CH0_AGC", TYPE_UINT32, AGC_CMD_SET_LC_ENABLED, WRITE, 1, "enable loss control for channel 0"),
-            cmd_con(AGC_RESID, "SET_LC_ENABLED_CH1_AGC", TYPE_UINT32, AGC_CMD_SET_LC_ENABLED, WRITE, 1, "enable loss control for channel 1"),
-            cmd_con(AGC_RESID, "SET_INCREMENT_GAIN_STEPSIZE_CH0_AGC", TYPE_FIXED_16_16, AGC_CMD_SET_GAIN_INCREMENT_STEPSIZE, WRITE, 1, "set stepsize with which gain is incremented for AGC ch0"),
-            cmd_con(AGC_RESID, "SET_INCREMENT_GAIN_STEPSIZE_CH1_AGC", TYPE_FIXED_16_16, AGC_CMD_SET_GAIN_INCREMENT_STEPSIZE, WRITE, 1, "set stepsize with which gain is incremented for AGC ch1"),
-            cmd_con(AGC_RESID, "SET_DECREMENT_GAIN_STEPSIZE_CH0_AGC", TYPE_FIXED_16_16, AGC_CMD_SET_GAIN_DECREMENT_STEPSIZE, WRITE, 1, "set stepsize with which gain is decremented for AGC ch0"),
-            cmd_con(AGC_RESID, "SET_DECREMENT_GAIN_STEPSIZE_CH1_AGC", TYPE_FIXED_16_16, AGC_CMD_SET_GAIN_DECREMENT_STEPSIZE, WRITE, 1, "set stepsize with which gain is decremented for AGC ch1"),
-
-            cmd_con(IC_RESID,      "SET_BYPASS_IC", TYPE_INT32, IC_CMD_SET_BYPASS, WRITE, 1, "IC: set bypass"),
-            cmd_con(IC_RESID,      "SET_X_ENERGY_DELTA_IC", TYPE_ENERGY, IC_CMD_SET_X_ENERGY_DELTA, WRITE, 1, "IC: set X energy delta"),
-            cmd_con(IC_RESID,      "SET_X_ENERGY_GAMMA_LOG2_IC", TYPE_UINT32, IC_CMD_SET_X_ENERGY_GAMMA_LOG2, WRITE, 1, "IC: set X energy gamma log2"),
-            cmd_con(IC_RESID,      "SET_FORCED_MU_VALUE_IC", TYPE_FIXED_1_31, IC_CMD_SET_FORCED_MU_VALUE, WRITE, 1, "IC: set forced mu value"),
-            cmd_con(IC_RESID,      "SET_ADAPTATION_CONFIG_IC", TYPE_INT32, IC_CMD_SET_ADAPTION_CONFIG, WRITE, 1, "IC: set adaptation config"),
-            cmd_con(IC_RESID,      "SET_SIGMA_ALPHA_IC", TYPE_UINT32, IC_CMD_SET_SIGMA_ALPHA, WRITE, 1, "IC: set adaptation config"),
-            cmd_con(IC_RESID,      "SET_COEFFICIENT_INDEX_IC", TYPE_UINT32, IC_CMD_SET_COEFFICIENT_INDEX, WRITE, 1, "IC: set coefficient index"),
-            cmd_con(IC_RESID,      "RESET_FILTER_IC", TYPE_UINT8, IC_CMD_RESET_FILTER, WRITE, 1, "IC: reset filter"),
-            cmd_con(IC_RESID,      "SET_CH1_BEAMFORM_ENABLE", TYPE_UINT8, IC_CMD_SET_CH1_BEAMFORM_ENABLE, WRITE, 1, "set if beamforming is enabled on channel1"),
-
-            cmd_con(SUP_RESID,      "SET_BYPASS_SUP", TYPE_INT32, SUP_CMD_SET_BYPASS, WRITE, 1, "SUP: set bypass"),
-            cmd_con(SUP_RESID,      "SET_ENABLED_AES", TYPE_INT32, SUP_CMD_SET_ECHO_SUPPRESSION_ENABLED, WRITE, 1, "SUP: set echo suppresion enabled"),
-            cmd_con(SUP_RESID,      "SET_ENABLED_NS", TYPE_INT32, SUP_CMD_SET_NOISE_SUPPRESSION_ENABLED, WRITE, 1, "SUP: set noise suppresion enabled"),
-            cmd_con(SUP_RESID,      "SET_NOISE_FLOOR_NS", TYPE_FIXED_0_32, SUP_CMD_SET_NOISE_MCRA_NOISE_FLOOR, WRITE, 1, "SUP: set noise suppression noise floor"),
+#define VFCTRL_CMD(name, resid, type, offset, rw, num_values, info) cmd_con(resid, #name, type, offset, rw, num_values, info),
+#if USE_I2C
+#define VFCTRL_CMD_NOT_I2C(name, resid, type, offset, rw, num_values, info)
+#else
+#define VFCTRL_CMD_NOT_I2C VFCTRL_CMD
+#endif
+#include "host_control_cmds.h"
+#undef VFCTRL_CMD
+#undef VFCTRL_CMD_NOT_I2C
+        };
+        // command id of each entry of the table
+        const vfctrl_cmd_id_t cmd_ids_local[] = {
+#define VFCTRL_CMD(name, resid, type, offset, rw, num_values, info) VFCTRL_##name,
+#if USE_I2C
+#define VFCTRL_CMD_NOT_I2C(name, resid, type, offset, rw, num_values, info)
+#else
+#define VFCTRL_CMD_NOT_I2C VFCTRL_CMD
+#endif
+#include "host_control_cmds.h"
+#undef VFCTRL_CMD
+#undef VFCTRL_CMD_NOT_I2C
         };
         total_num_commands = sizeof(cmdspec_ap_local)/sizeof(cmdspec_t);
-        cmdspec_ap = (cmdspec_t*)calloc(total_num_commands, sizeof(cmdspec_t));
+        cmdspec_ap = cmdspec_table;
         memcpy(cmdspec_ap, cmdspec_ap_local, total_num_commands * sizeof(cmdspec_t));
+        for (int i=0; i<VFCTRL_NUM_CMDS; i++) {
+            cmd_id_to_num[i] = -1;
+        }
+        for (int i=0; i<total_num_commands; i++) {
+            cmd_id_to_num[cmd_ids_local[i]] = i;
+        }
     }
 }
 
 void open_device() {
+    // the connection is kept open until the app exits
+    if (setup_err == 0) {
+        return;
+    }
 #if USE_I2C
     setup_err = i2c_setup();
 #elif USE_USB
@@ -1938,24 +2170,34 @@ int vfctrl_check_version(unsigned print_version_only) {
     int_float cmd_output[CMD_MAX_BYTES];
 
     open_device();
+    if (setup_err != 0) {
+        UNLOCK_MUTEX
+        return -1;
+    }
 
     // GET_VERSION
     cmdspec_t cmd;;
     int ret = vfctrl_get_cmdspec(1, "GET_VERSION", &cmd, 0);
+    if (ret == 0) {
+        ret = get_struct_val_from_device(cmd, cmd_output);
+    }
     if(ret != 0) {
-        exit(ret);
+        UNLOCK_MUTEX
+        return ret;
     }
-    get_struct_val_from_device(cmd, cmd_output);
     format_version(cmd_output, firmware_version);
 
     // if the version must be printed only, retrieve the XGIT hash as well
     if (print_version_only) {
         // GET_BLD_XGIT_HASH
         ret = vfctrl_get_cmdspec(1, "GET_BLD_XGIT_HASH", &cmd, 0);
+        if (ret == 0) {
+            ret = get_struct_val_from_device(cmd, cmd_output);
+        }
         if(ret != 0) {
-            exit(ret);
+            UNLOCK_MUTEX
+            return ret;
         }
-        get_struct_val_from_device(cmd, cmd_output);
         update_read_results(cmd, cmd_output, xgit_hash);
 
         printf("Firmware version: %s - build identifier %s\n", firmware_version, (char*) xgit_hash);
@@ -1964,7 +2206,8 @@ int vfctrl_check_version(unsigned print_version_only) {
             printf("Error: Your firmware version (%s) is incompatible with this vfctrl version (%s).\n",
                 firmware_version, good_version);
             printf("To disable this check, use --no-check-version or -n\n");
-            host_shutdown(1);
+            UNLOCK_MUTEX
+            return 1;
         }
     }
     UNLOCK_MUTEX
@@ -1979,19 +2222,21 @@ int vfctrl_check_run_status(cmdspec_t cmd) {
 
     if(setup_err != 0)
     {
-        printf("control initialization returned error");
-        host_shutdown(-1);
+        printf("control initialization returned error\n");
+        UNLOCK_MUTEX
+        return -1;
     }
-    void *data_out_ptr = calloc(cmd.app_read_result_size, 1);
+    int_float vals[CMD_MAX_BYTES] = {{0}};
 
-    int ret = get_struct_val_from_device(cmd, data_out_ptr);
+    int ret = get_struct_val_from_device(cmd, vals);
 
     if(ret != 0)
     {
-        host_shutdown(ret);
+        UNLOCK_MUTEX
+        return ret;
     }
 
-    uint8_t run_status_val = ((char*)data_out_ptr)[0];
+    uint8_t run_status_val = vals[0].ui8;
 
     if (run_status_val != RUN_FACTORY_DATA_SUCCESS &&\
         run_status_val != RUN_UPGRADE_DATA_SUCCESS)
@@ -2001,7 +2246,6 @@ int vfctrl_check_run_status(cmdspec_t cmd) {
         format_run_status(&run_status_val, output_str);
         printf("Warning: RUN STATUS is%s, the data partition has not been read\n", output_str);
     }
-    free(data_out_ptr);
     UNLOCK_MUTEX
     return 0;
 }
@@ -2025,36 +2269,374 @@ char* vfctrl_print_help(unsigned full)
     return ret_string;
 }
 
+typedef struct {
+    cmdspec_t cmd;
+    int_float vals[CMD_MAX_BYTES];
+    control_ret_t ret;
+    uint64_t time_us;  // time the value was returned by the device
+} dump_value_t;
+
+// GET_FILTER_COEFF is read in the human readable order, the other commands skipped here cannot be read in one go
+uint8_t is_dump_command(cmdspec_t cmd)
+{
+    return strstr(cmd.par_name, "GET_") == cmd.par_name &&
+        (cmd.offset != GPIO_CMD_GET_FILTER_COEFF || cmd.resid != GPIO_RESID || strstr(cmd.par_name, "_RAW") != NULL) &&
+        (cmd.offset != AEC_CMD_GET_FILTER_COEFFICIENTS || cmd.resid != AEC_RESID) &&
+        (cmd.offset != IC_CMD_GET_FILTER_COEFFICIENTS || cmd.resid != IC_RESID);
+}
+
+int compare_dump_resid(const void *a, const void *b)
+{
+    const dump_value_t *value_a = *(const dump_value_t **)a;
+    const dump_value_t *value_b = *(const dump_value_t **)b;
+    if (value_a->cmd.resid != value_b->cmd.resid) {
+        return (value_a->cmd.resid < value_b->cmd.resid) ? -1 : 1;
+    }
+    // keep the table order within a resource
+    return (value_a < value_b) ? -1 : (value_a > value_b);
+}
+
+// Read all the GET_ commands into dump, in the order of the command table.
+// The reads are grouped by resource ID and pipelined, so all the values of a resource are
+// read within a few frames of each other. Returns the number of values.
+unsigned read_all_params(dump_value_t *dump)
+{
+    unsigned num_values = 0;
+    for (int i=0; i<total_num_commands; i++) {
+        if (is_dump_command(cmdspec_ap[i])) {
+            memset(&dump[num_values], 0, sizeof(dump_value_t));
+            dump[num_values].cmd = cmdspec_ap[i];
+            dump[num_values].ret = CONTROL_ERROR;
+            num_values++;
+        }
+    }
+    if (setup_err != 0) {
+        printf("control initialization returned error\n");
+        return num_values;
+    }
+
+    dump_value_t **order = calloc(num_values, sizeof(dump_value_t *));
+    for (unsigned i=0; i<num_values; i++) {
+        order[i] = &dump[i];
+    }
+    qsort(order, num_values, sizeof(dump_value_t *), compare_dump_resid);
+
+    cmdspec_t chunk_cmds[PIPELINE_MAX_CMDS];
+    int_float *chunk_vals[PIPELINE_MAX_CMDS];
+    control_ret_t chunk_ret[PIPELINE_MAX_CMDS];
+    uint64_t chunk_time_us[PIPELINE_MAX_CMDS];
+    for (unsigned start=0; start<num_values; start+=PIPELINE_MAX_CMDS) {
+        unsigned chunk_size = MIN(num_values - start, PIPELINE_MAX_CMDS);
+        for (unsigned i=0; i<chunk_size; i++) {
+            chunk_cmds[i] = order[start+i]->cmd;
+            chunk_vals[i] = order[start+i]->vals;
+        }
+        get_struct_vals_pipelined(chunk_cmds, chunk_vals, chunk_ret, chunk_time_us, chunk_size);
+        for (unsigned i=0; i<chunk_size; i++) {
+            order[start+i]->ret = chunk_ret[i];
+            order[start+i]->time_us = chunk_time_us[i];
+        }
+    }
+    free(order);
+    return num_values;
+}
+
+// Format a value read by read_all_params(), returns the error code of the read
+int format_dump_value(dump_value_t *value, char *output_string)
+{
+    // large enough for the longest result and the string terminator added by vfctrl_format_read_result()
+    uint8_t data_out[CMD_MAX_BYTES * sizeof(int64_t)];
+    int_float vals[CMD_MAX_BYTES];
+    output_string[0] = '\0';
+    if (value->ret != CONTROL_SUCCESS) {
+        return value->ret;
+    }
+    memcpy(vals, value->vals, sizeof(vals));
+    int ret = convert_read_result(value->cmd, vals, data_out);
+    if (!ret) {
+        vfctrl_format_read_result(&value->cmd, data_out, output_string);
+    }
+    return ret;
+}
+
 void vfctrl_dump_params(void)
 {
+    char temp_string[TEMP_STR_MAX_CHARS];
     LOCK_MUTEX
     populate_cmd_table();
     open_device();
+#if !JSON_ONLY
+    if (setup_err != 0) {
+        printf("control initialization returned error\n");
+        UNLOCK_MUTEX
+        return;
+    }
+#endif
+    dump_value_t *dump = calloc(total_num_commands, sizeof(dump_value_t));
+    read_all_params(dump);
+    unsigned dump_idx = 0;
     for (int i=0; i<total_num_commands; i++) {
         cmdspec_t cmd = cmdspec_ap[i];
         // GET_FILTER_COEFF must be handled separately
         if (cmd.offset == GPIO_CMD_GET_FILTER_COEFF && cmd.resid == GPIO_RESID && strstr(cmd.par_name, "_RAW")==0) {
-            UNLOCK_MUTEX // The mutex is locked inside vfctrl_get_filter_coefficients_human_readable()
+            UNLOCK_MUTEX // The mutex is locked inside vfctrl_do_command()
             vfctrl_get_filter_coefficients_human_readable(&cmd);
             LOCK_MUTEX
-        // check if we have command with GET_ at the start of the parameter name and exclude AEC_CMD_GET_FILTER_COEFFICIENTS and IC_CMD_GET_FILTER_COEFFICIENTS
-        } else if (strstr(cmd.par_name, "GET_") == cmd.par_name &&\
-            (cmd.offset != AEC_CMD_GET_FILTER_COEFFICIENTS || cmd.resid != AEC_RESID) &&\
-            (cmd.offset != IC_CMD_GET_FILTER_COEFFICIENTS || cmd.resid != IC_RESID)) {
-            const char* a[1] = {cmd.par_name};
-            void *outptr = calloc(cmd.app_read_result_size, 1);
-            int ret = do_command(cmd, a, outptr, 0);
+        } else if (is_dump_command(cmd)) {
+            int ret = format_dump_value(&dump[dump_idx++], temp_string);
             if (!ret) {
-                char temp_string[TEMP_STR_MAX_CHARS];
-                vfctrl_format_read_result(&cmd, outptr, temp_string);
-                printf("%s\n", temp_string);
+                printf("%s:%s\n", cmd.par_name, temp_string);
             } else {
                 printf("%s: ERROR (%d)\n", cmd.par_name, ret);
             }
-            free(outptr);
         }
     }
+    free(dump);
+    UNLOCK_MUTEX
+}
+
+// Adaptation which is forced off by vfctrl_dump_snapshot() while the values are read
+static const struct {
+    const char *get_name;
+    const char *set_name;
+    int off_value;
+} freeze_cmds[] = {
+    {"GET_ADAPTATION_CONFIG_AEC", "SET_ADAPTATION_CONFIG_AEC", AEC_ADAPTION_FORCE_OFF},
+    {"GET_ADAPTATION_CONFIG_IC", "SET_ADAPTATION_CONFIG_IC", IC_ADAPTION_FORCE_OFF},
+    {"GET_ADAPT_CH0_AGC", "SET_ADAPT_CH0_AGC", 0},
+    {"GET_ADAPT_CH1_AGC", "SET_ADAPT_CH1_AGC", 0},
+};
+#define NUM_FREEZE_CMDS (sizeof(freeze_cmds) / sizeof(freeze_cmds[0]))
+
+static int find_freeze_cmds(unsigned i, int *get_idx, int *set_idx)
+{
+    *get_idx = -1;
+    *set_idx = -1;
+    for (int c=0; c<total_num_commands; c++) {
+        if (strcmp(cmdspec_ap[c].par_name, freeze_cmds[i].get_name) == 0) *get_idx = c;
+        if (strcmp(cmdspec_ap[c].par_name, freeze_cmds[i].set_name) == 0) *set_idx = c;
+    }
+    return (*get_idx < 0 || *set_idx < 0) ? -1 : 0;
+}
+
+static int write_adaptation(int set_idx, int32_t value)
+{
+    char value_string[TEMP_STR_MAX_CHARS];
+    const char *a[1] = {value_string};
+    sprintf(value_string, "%d", value);
+    return do_command(cmdspec_ap[set_idx], a, NULL, 0);
+}
+
+// Set back the adaptation of the freeze_cmds marked in changed to their previous values
+int restore_adaptation(const int32_t prev_values[], const uint8_t changed[])
+{
+    int ret = 0;
+    for (unsigned i=0; i<NUM_FREEZE_CMDS; i++) {
+        int get_idx, set_idx;
+        if (!changed[i] || find_freeze_cmds(i, &get_idx, &set_idx) != 0) {
+            continue;
+        }
+        if (write_adaptation(set_idx, prev_values[i]) != 0) {
+            printf("Error: cannot restore %s\n", freeze_cmds[i].set_name);
+            ret = -1;
+        }
+    }
+    return ret;
+}
+
+// Force the adaptation of the freeze_cmds off, returning their previous values and which were changed.
+// On an error the ones already changed are restored.
+int force_adaptation_off(int32_t prev_values[], uint8_t changed[])
+{
+    for (unsigned i=0; i<NUM_FREEZE_CMDS; i++) {
+        changed[i] = 0;
+    }
+    for (unsigned i=0; i<NUM_FREEZE_CMDS; i++) {
+        int get_idx, set_idx;
+        if (find_freeze_cmds(i, &get_idx, &set_idx) != 0) {
+            continue;
+        }
+        int_float vals[CMD_MAX_BYTES] = {0};
+        if (get_struct_val_from_device(cmdspec_ap[get_idx], vals) != CONTROL_SUCCESS ||
+            convert_read_result(cmdspec_ap[get_idx], vals, &prev_values[i]) != 0) {
+            printf("Error: cannot read %s\n", freeze_cmds[i].get_name);
+            restore_adaptation(prev_values, changed);
+            return -1;
+        }
+        // a failed write may still have reached the device, it is restored too
+        changed[i] = 1;
+        if (write_adaptation(set_idx, freeze_cmds[i].off_value) != 0) {
+            printf("Error: cannot write %s\n", freeze_cmds[i].set_name);
+            restore_adaptation(prev_values, changed);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Print a string as a JSON string, escaping the characters which need it
+void print_json_string(FILE *fp, const char *str)
+{
+    fputc('"', fp);
+    for (const char *c = str; *c != '\0'; c++) {
+        if (*c == '"' || *c == '\\') {
+            fprintf(fp, "\\%c", *c);
+        } else if ((unsigned char)*c < 0x20) {
+            fprintf(fp, "\\u%04x", (unsigned char)*c);
+        } else {
+            fputc(*c, fp);
+        }
+    }
+    fputc('"', fp);
+}
+
+int vfctrl_dump_snapshot(const char *snapshot_file, unsigned freeze_adaptation)
+{
+    char temp_string[TEMP_STR_MAX_CHARS];
+    int32_t prev_adaptation[NUM_FREEZE_CMDS];
+    uint8_t changed_adaptation[NUM_FREEZE_CMDS];
+    int ret = 0;
+
+    FILE *fp = fopen(snapshot_file, "w");
+    if (fp == NULL) {
+        printf("Error: cannot open %s\n", snapshot_file);
+        return -1;
+    }
+    LOCK_MUTEX
+    populate_cmd_table();
+    open_device();
+    if (setup_err != 0) {
+        printf("control initialization returned error\n");
+        fclose(fp);
+        UNLOCK_MUTEX
+        return -1;
+    }
+    if (freeze_adaptation) {
+        ret = force_adaptation_off(prev_adaptation, changed_adaptation);
+        if (ret != 0) {
+            fclose(fp);
+            UNLOCK_MUTEX
+            return ret;
+        }
+        printf("Adaptation: off\n");
+    }
+
+    dump_value_t *dump = calloc(total_num_commands, sizeof(dump_value_t));
+    uint64_t start_us = vfctrl_get_time_us();
+    unsigned num_values = read_all_params(dump);
+    uint64_t end_us = vfctrl_get_time_us();
+
+    if (freeze_adaptation) {
+        ret = restore_adaptation(prev_adaptation, changed_adaptation);
+        printf("Adaptation: restored\n");
+    }
+
+    // values are timestamped in us from the start of the capture
+    unsigned num_errors = 0;
+    fprintf(fp, "{\n");
+    fprintf(fp, "    \"capture_us\": %llu,\n", (unsigned long long)(end_us - start_us));
+    fprintf(fp, "    \"adaptation_frozen\": %s,\n", freeze_adaptation ? "true" : "false");
+    fprintf(fp, "    \"values\": [\n");
+    for (unsigned i=0; i<num_values; i++) {
+        dump_value_t *value = &dump[i];
+        int value_ret = format_dump_value(value, temp_string);
+        fprintf(fp, "        {\"name\": \"%s\", \"resid\": %d, \"cmd\": %d, ", value->cmd.par_name, value->cmd.resid, value->cmd.offset);
+        if (value_ret) {
+            fprintf(fp, "\"error\": %d}", value_ret);
+            num_errors++;
+        } else {
+            // strip the blank spaces around the formatted values
+            char *value_string = temp_string;
+            while (*value_string == ' ') {
+                value_string++;
+            }
+            for (size_t len = strlen(value_string); len > 0 && value_string[len-1] == ' '; len--) {
+                value_string[len-1] = '\0';
+            }
+            fprintf(fp, "\"t_us\": %llu, \"raw\": [", (unsigned long long)(value->time_us - start_us));
+            unsigned num_raw = get_read_num_values(value->cmd);
+            for (unsigned v=0; v<num_raw; v++) {
+                if (value->cmd.type == TYPE_UINT32) {
+                    fprintf(fp, "%s%u", v ? ", " : "", (unsigned)value->vals[v].ui);
+                } else if (value->cmd.type == TYPE_UINT64) {
+                    fprintf(fp, "%s%llu", v ? ", " : "", (unsigned long long)value->vals[v].i_long);
+                } else {
+                    int64_t raw = (value->cmd.device_rw_size == 1) ? value->vals[v].ui8 :
+                                  (value->cmd.device_rw_size == 4) ? value->vals[v].i : value->vals[v].i_long;
+                    fprintf(fp, "%s%lld", v ? ", " : "", (long long)raw);
+                }
+            }
+            fprintf(fp, "], \"value\": ");
+            print_json_string(fp, value_string);
+            fprintf(fp, "}");
+        }
+        fprintf(fp, "%s\n", (i == num_values-1) ? "" : ",");
+    }
+    fprintf(fp, "    ]\n");
+    fprintf(fp, "}\n");
+    fclose(fp);
+    free(dump);
     UNLOCK_MUTEX
+
+    printf("Read %u values in %.1f ms, %u errors\n", num_values, (end_us - start_us) / 1000.0, num_errors);
+    if (ret == 0 && num_errors > 0) {
+        ret = 1;
+    }
+    return ret;
+}
+
+// Throughput of vfctrl_spi_write() and vfctrl_spi_read(), also printed by vfctrl_print_poll_stats()
+static vfctrl_spi_stats_t spi_stats;
+
+int compare_poll_model(const void *a, const void *b)
+{
+    const poll_model_t *model_a = (const poll_model_t *)a;
+    const poll_model_t *model_b = (const poll_model_t *)b;
+    unsigned key_a = model_a->valid ? ((unsigned)model_a->resid << 8) | model_a->cmd : UINT_MAX;
+    unsigned key_b = model_b->valid ? ((unsigned)model_b->resid << 8) | model_b->cmd : UINT_MAX;
+    return (key_a > key_b) - (key_a < key_b);
+}
+
+// Not protected by the mutex since this is called from atexit(), possibly while exiting from a locked section
+void vfctrl_print_poll_stats(void)
+{
+    populate_cmd_table();
+    printf("\nRead completion model:\n");
+    printf("%-34s %5s %5s %8s %8s %10s %10s %10s\n",
+            "Command", "Resid", "Cmd", "Reads", "Waits", "Polls/read", "Wait (us)", "Min-max (us)");
+    // sort by resid and cmd, unused entries go last
+    poll_model_t sorted_model[POLL_MODEL_SIZE];
+    memcpy(sorted_model, poll_model, sizeof(poll_model));
+    qsort(sorted_model, POLL_MODEL_SIZE, sizeof(poll_model_t), compare_poll_model);
+    for (unsigned i=0; i<POLL_MODEL_SIZE; i++) {
+        poll_model_t model = sorted_model[i];
+        if (!model.valid || model.num_reads == 0) {
+            continue;
+        }
+        char *name = "?";
+        for (int c=0; c<total_num_commands; c++) {
+            if (cmdspec_ap[c].resid == model.resid && cmdspec_ap[c].offset == model.cmd && cmdspec_ap[c].rw == READ) {
+                name = cmdspec_ap[c].par_name;
+                break;
+            }
+        }
+        printf("%-34s  0x%02x  0x%02x %8u %8u %10.2f %10" PRIu64 " %5" PRIu64 "-%" PRIu64 "\n",
+                name, model.resid, model.cmd, model.num_reads, model.num_waits,
+                (double)model.num_polls / model.num_reads, model.expected_us, model.min_us, model.max_us);
+    }
+    if (spi_stats.num_commands > 0) {
+        double busy_s = spi_stats.busy_us / 1e6;
+        printf("\nSPI passthrough: %u transactions, %u commands, %u retries, %u errors\n",
+                spi_stats.num_transactions, spi_stats.num_commands, spi_stats.num_retries, spi_stats.num_errors);
+        printf("    %" PRIu64 " bytes written, %" PRIu64 " bytes read in %.3f s, %.1f kB/s\n",
+                spi_stats.bytes_written, spi_stats.bytes_read, busy_s,
+                (busy_s > 0) ? (spi_stats.bytes_written + spi_stats.bytes_read) / busy_s / 1000 : 0);
+    }
+}
+
+void vfctrl_set_attribute_cache(unsigned enable)
+{
+    attr_cache_enable(enable);
 }
 
 int vfctrl_get_cmdspec(int num_args, const char *command, cmdspec_t *cmd_spec, uint8_t log_for_data_partition)
@@ -2071,6 +2653,333 @@ int vfctrl_get_cmdspec(int num_args, const char *command, cmdspec_t *cmd_spec, u
     return 0;
 }
 
+int vfctrl_do_read_commands(cmdspec_t cmd_specs[], void *data_out_ptrs[], int cmd_ret[], unsigned num_cmds)
+{
+    static int_float vals[PIPELINE_MAX_CMDS][CMD_MAX_BYTES];
+    int_float *vals_ptrs[PIPELINE_MAX_CMDS];
+    control_ret_t chunk_ret[PIPELINE_MAX_CMDS];
+    int ret = 0;
+
+    LOCK_MUTEX
+    populate_cmd_table();
+    open_device();
+    if(setup_err != 0)
+    {
+        printf("control initialization returned error\n");
+        UNLOCK_MUTEX
+        return -1;
+    }
+    for (unsigned i=0; i<PIPELINE_MAX_CMDS; i++) {
+        vals_ptrs[i] = vals[i];
+    }
+    for (unsigned start=0; start<num_cmds; start+=PIPELINE_MAX_CMDS) {
+        unsigned chunk_size = MIN(num_cmds - start, PIPELINE_MAX_CMDS);
+        for (unsigned i=0; i<chunk_size; i++) {
+            if (cmd_specs[start+i].rw != READ) {
+                fprintf(stderr, "Error: %s is not a read command\n", cmd_specs[start+i].par_name);
+                UNLOCK_MUTEX
+                return -2;
+            }
+            memset(vals[i], 0, sizeof(vals[i]));
+        }
+        get_struct_vals_pipelined(&cmd_specs[start], vals_ptrs, chunk_ret, NULL, chunk_size);
+        for (unsigned i=0; i<chunk_size; i++) {
+            int cmd_ret_val = chunk_ret[i];
+            if (cmd_ret_val == CONTROL_SUCCESS) {
+                cmd_ret_val = convert_read_result(cmd_specs[start+i], vals[i], data_out_ptrs[start+i]);
+            }
+            if (cmd_ret != NULL) {
+                cmd_ret[start+i] = cmd_ret_val;
+            }
+            if (cmd_ret_val != 0 && ret == 0) {
+                ret = cmd_ret_val;
+            }
+        }
+    }
+    UNLOCK_MUTEX
+    return ret;
+}
+
+// Find the GET_ command reading back the values written by a SET_ command.
+// first_value is the index of the first value to compare in the read back values, the GET_ command of
+// the AGC commands returns the values of both channels.
+int get_read_counterpart(cmdspec_t set_cmd, unsigned *first_value)
+{
+    char get_name[MAX_PAR_NAME_CHARS];
+    if (strncmp(set_cmd.par_name, "SET_", strlen("SET_")) != 0) {
+        return -1;
+    }
+    // the coefficients read back depend on SET_FILTER_INDEX and are not in the order they are written
+    if (strcmp(set_cmd.par_name, "SET_FILTER_COEFF") == 0) {
+        return -1;
+    }
+    // GET_ is as long as SET_, the name always fits
+    memcpy(get_name, set_cmd.par_name, sizeof(get_name));
+    get_name[0] = 'G';
+    *first_value = is_same_string_ending(set_cmd.par_name, "_CH1_AGC") ? 1 : 0;
+    for (int i=0; i<total_num_commands; i++) {
+        cmdspec_t *get_cmd = &cmdspec_ap[i];
+        if (strcmp(get_cmd->par_name, get_name) == 0) {
+            if (get_cmd->rw == READ && get_cmd->type == set_cmd.type &&
+                get_read_num_values(*get_cmd) >= *first_value + set_cmd.num_values) {
+                return i;
+            }
+            return -1;
+        }
+    }
+    return -1;
+}
+
+// Commands selecting the block or the address of the commands which follow them. They are always written, in
+// the order of the list, and so are the commands of their group if the list has the selector: the device
+// would read them back from the block selected before the list, and a later write can be to another block.
+// The commands of a passthrough group write to a bus or trigger an action rather than hold a value, they are
+// always written and never read back, with or without their selector. A group without a selector only
+// holds such commands. None of these commands is captured into a data partition.
+typedef struct {
+    const char *selector;
+    uint8_t passthrough;
+    const char *dependents[4];
+} selector_group_t;
+
+static const selector_group_t selector_groups[] = {
+    {"SET_FILTER_INDEX", 0, {"SET_FILTER_BYPASS", "SET_FILTER_COEFF_RAW", "SET_FILTER_COEFF", NULL}},
+    {"SET_COEFF_INDEX_AEC", 0, {NULL}},
+    {"SET_COEFFICIENT_INDEX_IC", 0, {NULL}},
+    {"SET_SPI_READ_HEADER", 1, {"SET_SPI_PUSH", "SET_SPI_PUSH_AND_EXEC", NULL}},
+    {"SET_GPI_READ_HEADER", 1, {NULL}},
+    {"SET_I2C_READ_HEADER", 1, {"SET_I2C", "SET_I2C_WITH_REG", NULL}},
+    {NULL, 1, {"SET_MANUAL_ADEC_CYCLE_TRIGGER", "SET_KWD_HID_EVENT_CNT", NULL}},
+};
+#define NUM_SELECTOR_GROUPS (sizeof(selector_groups)/sizeof(selector_groups[0]))
+
+static int get_selector_group(cmdspec_t cmd)
+{
+    for (unsigned g=0; g<NUM_SELECTOR_GROUPS; g++) {
+        if (selector_groups[g].selector != NULL && strcmp(cmd.par_name, selector_groups[g].selector) == 0) {
+            return g;
+        }
+    }
+    return -1;
+}
+
+static int get_dependent_group(cmdspec_t cmd)
+{
+    for (unsigned g=0; g<NUM_SELECTOR_GROUPS; g++) {
+        for (unsigned d=0; selector_groups[g].dependents[d] != NULL; d++) {
+            if (strcmp(cmd.par_name, selector_groups[g].dependents[d]) == 0) {
+                return g;
+            }
+        }
+    }
+    return -1;
+}
+
+int vfctrl_diff_commands(cmdspec_t cmd_specs[], const char **command_plus_values[], int diff[], unsigned num_cmds)
+{
+    static int_float vals[PIPELINE_MAX_CMDS][CMD_MAX_BYTES];
+    int_float *vals_ptrs[PIPELINE_MAX_CMDS];
+    control_ret_t chunk_ret[PIPELINE_MAX_CMDS];
+    cmdspec_t read_specs[PIPELINE_MAX_CMDS];
+    unsigned read_cmd_idx[PIPELINE_MAX_CMDS];
+    int counterpart[PIPELINE_MAX_CMDS];
+    unsigned first_value[PIPELINE_MAX_CMDS];
+    int ret = 0;
+
+    LOCK_MUTEX
+    populate_cmd_table();
+    open_device();
+    if(setup_err != 0)
+    {
+        printf("control initialization returned error\n");
+        UNLOCK_MUTEX
+        return -1;
+    }
+    for (unsigned i=0; i<PIPELINE_MAX_CMDS; i++) {
+        vals_ptrs[i] = vals[i];
+    }
+    uint8_t has_selector[NUM_SELECTOR_GROUPS] = {0};
+    for (unsigned i=0; i<num_cmds; i++) {
+        int group = get_selector_group(cmd_specs[i]);
+        if (group >= 0) {
+            has_selector[group] = 1;
+        }
+    }
+    for (unsigned start=0; start<num_cmds; start+=PIPELINE_MAX_CMDS) {
+        unsigned chunk_size = MIN(num_cmds - start, PIPELINE_MAX_CMDS);
+        unsigned num_reads = 0;
+        for (unsigned i=0; i<chunk_size; i++) {
+            cmdspec_t *cmd = &cmd_specs[start+i];
+            diff[start+i] = 1;
+            if (cmd->rw != WRITE) {
+                fprintf(stderr, "Error: %s is not a write command\n", cmd->par_name);
+                UNLOCK_MUTEX
+                return -2;
+            }
+            int group = get_dependent_group(*cmd);
+            if (get_selector_group(*cmd) >= 0 ||
+                (group >= 0 && (has_selector[group] || selector_groups[group].passthrough))) {
+                diff[start+i] = -1;
+                continue;
+            }
+            counterpart[i] = get_read_counterpart(*cmd, &first_value[i]);
+            if (counterpart[i] < 0) {
+                diff[start+i] = -1;
+                continue;
+            }
+            // only the last write of a value matters
+            for (unsigned j=start+i+1; j<num_cmds; j++) {
+                unsigned later_first_value;
+                if (get_read_counterpart(cmd_specs[j], &later_first_value) == counterpart[i] && later_first_value == first_value[i]) {
+                    diff[start+i] = 2;
+                    break;
+                }
+            }
+            if (diff[start+i] == 2) {
+                continue;
+            }
+            read_specs[num_reads] = cmdspec_ap[counterpart[i]];
+            read_cmd_idx[num_reads] = i;
+            memset(vals[num_reads], 0, sizeof(vals[num_reads]));
+            num_reads++;
+        }
+        get_struct_vals_pipelined(read_specs, vals_ptrs, chunk_ret, NULL, num_reads);
+
+        // compare the values as they are encoded on the device
+        for (unsigned r=0; r<num_reads; r++) {
+            unsigned i = read_cmd_idx[r];
+            cmdspec_t *cmd = &cmd_specs[start+i];
+            if (chunk_ret[r] != CONTROL_SUCCESS) {
+                if (ret == 0) {
+                    ret = chunk_ret[r];
+                }
+                continue;
+            }
+            int_float write_vals[CMD_MAX_BYTES] = {0};
+            uint8_t write_payload[CMD_MAX_BYTES];
+            uint8_t read_payload[CMD_MAX_BYTES];
+            if (parse_write_values(*cmd, &command_plus_values[start+i][1], write_vals) != 0) {
+                diff[start+i] = -1;
+                continue;
+            }
+            write_payload_byte_array(*cmd, cmd->num_values, write_vals, write_payload);
+            write_payload_byte_array(read_specs[r], cmd->num_values, &vals[r][first_value[i]], read_payload);
+            diff[start+i] = memcmp(write_payload, read_payload, cmd->num_values * cmd->device_rw_size) != 0;
+        }
+    }
+    UNLOCK_MUTEX
+    return ret;
+}
+
+// Settings which are not captured by vfctrl_capture_params(): the start up commands, which the data partition
+// must issue in a set order, and the commands of selector_groups
+static const char *capture_skip_cmds[] = {
+    "SET_MCLK_IN_TO_PDM_CLK_DIVIDER",
+    "SET_SYS_CLK_TO_MCLK_OUT_DIVIDER",
+    "SET_MIC_START_STATUS",
+    "SET_USB_SERIAL_NUMBER",
+    "SET_SERIAL_NUMBER",
+    "SET_USB_VENDOR_ID",
+    "SET_USB_PRODUCT_ID",
+    "SET_USB_BCD_DEVICE",
+    "SET_USB_VENDOR_STRING",
+    "SET_USB_PRODUCT_STRING",
+    "SET_USB_TO_DEVICE_RATE",
+    "SET_DEVICE_TO_USB_RATE",
+    "SET_USB_TO_DEVICE_BIT_RES",
+    "SET_DEVICE_TO_USB_BIT_RES",
+    "SET_USB_START_STATUS",
+    "SET_I2S_RATE",
+    "SET_I2S_START_STATUS",
+};
+
+uint8_t is_capture_command(cmdspec_t cmd)
+{
+    if (cmd.rw != WRITE || get_selector_group(cmd) >= 0 || get_dependent_group(cmd) >= 0) {
+        return 0;
+    }
+    for (unsigned i=0; i<sizeof(capture_skip_cmds)/sizeof(capture_skip_cmds[0]); i++) {
+        if (strcmp(cmd.par_name, capture_skip_cmds[i]) == 0) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+void vfctrl_set_data_partition_sink(vfctrl_dp_item_sink_t sink)
+{
+    dp_item_sink = sink;
+}
+
+void vfctrl_get_host_version(int *major, int *minor, int *patch)
+{
+    *major = DEVICE_VERSION_MAJOR;
+    *minor = DEVICE_VERSION_MINOR;
+    *patch = DEVICE_VERSION_PATCH;
+}
+
+int vfctrl_capture_params(unsigned *num_captured)
+{
+    static int_float vals[PIPELINE_MAX_CMDS][CMD_MAX_BYTES];
+    int_float *vals_ptrs[PIPELINE_MAX_CMDS];
+    control_ret_t chunk_ret[PIPELINE_MAX_CMDS];
+    cmdspec_t read_specs[PIPELINE_MAX_CMDS];
+    cmdspec_t write_specs[PIPELINE_MAX_CMDS];
+    unsigned first_value[PIPELINE_MAX_CMDS];
+    int ret = 0;
+
+    *num_captured = 0;
+    LOCK_MUTEX
+    populate_cmd_table();
+    open_device();
+    if(setup_err != 0)
+    {
+        printf("control initialization returned error\n");
+        UNLOCK_MUTEX
+        return -1;
+    }
+    for (unsigned i=0; i<PIPELINE_MAX_CMDS; i++) {
+        vals_ptrs[i] = vals[i];
+    }
+    // read the settings in the order of the command table, which is the order they are logged in
+    int cmd_idx = 0;
+    while (cmd_idx < total_num_commands) {
+        unsigned num_reads = 0;
+        for (; cmd_idx<total_num_commands && num_reads<PIPELINE_MAX_CMDS; cmd_idx++) {
+            cmdspec_t cmd = cmdspec_ap[cmd_idx];
+            if (!is_capture_command(cmd)) {
+                continue;
+            }
+            int counterpart = get_read_counterpart(cmd, &first_value[num_reads]);
+            if (counterpart < 0) {
+                continue;
+            }
+            write_specs[num_reads] = cmd;
+            read_specs[num_reads] = cmdspec_ap[counterpart];
+            memset(vals[num_reads], 0, sizeof(vals[num_reads]));
+            num_reads++;
+        }
+        get_struct_vals_pipelined(read_specs, vals_ptrs, chunk_ret, NULL, num_reads);
+        for (unsigned r=0; r<num_reads; r++) {
+            if (chunk_ret[r] != CONTROL_SUCCESS) {
+                printf("Error: %s returned %d, %s not captured\n", read_specs[r].par_name, chunk_ret[r], write_specs[r].par_name);
+                if (ret == 0) {
+                    ret = chunk_ret[r];
+                }
+                continue;
+            }
+            // the values written are the values read back, followed by the AGC channel index
+            int_float write_vals[CMD_MAX_BYTES + 1] = {{0}};
+            memcpy(write_vals, &vals[r][first_value[r]], write_specs[r].num_values * sizeof(int_float));
+            add_agc_channel_index(write_specs[r], write_vals);
+            set_struct_val_on_device(write_specs[r], write_vals, 1);
+            (*num_captured)++;
+        }
+    }
+    UNLOCK_MUTEX
+    return ret;
+}
+
 int vfctrl_do_command(cmdspec_t *cmd_spec, const char **command_plus_values, void *data_out_ptr, uint8_t log_for_data_partition)
 {
     LOCK_MUTEX
@@ -2082,6 +2991,241 @@ int vfctrl_do_command(cmdspec_t *cmd_spec, const char **command_plus_values, voi
     UNLOCK_MUTEX
     return ret;
 }
+
+int vfctrl_execute_command(cmdspec_t *cmd_spec, const char **command_plus_values, void *data_out_ptr, uint8_t log_for_data_partition, char *output_string)
+{
+    int ret = 0;
+    output_string[0] = '\0';
+
+    if (strcmp("GET_FILTER_COEFFICIENTS_AEC", cmd_spec->par_name) == 0) {
+        ret = vfctrl_get_aec_coefficients_to_file("aec_coefficients.py");
+    } else if (strcmp("GET_FILTER_COEFFICIENTS_IC", cmd_spec->par_name) == 0) {
+        ret = vfctrl_get_ic_coefficients_to_file("ic_coefficients.py");
+    } else if (strcmp("GET_FILTER_COEFF", cmd_spec->par_name) == 0) {
+        ret = vfctrl_get_filter_coefficients_to_string(output_string);
+    } else if (strcmp("SET_FILTER_COEFF", cmd_spec->par_name) == 0) {
+        ret = vfctrl_set_filter_coefficients_human_readable(cmd_spec, command_plus_values, log_for_data_partition);
+    } else {
+        // large enough for CMD_MAX_BYTES values of any type
+        int64_t data_out[CMD_MAX_BYTES] = {0};
+        ret = vfctrl_do_command(cmd_spec, command_plus_values, data_out, log_for_data_partition);
+        if (!ret && (cmd_spec->rw == READ)) {
+            vfctrl_format_read_result(cmd_spec, data_out, output_string);
+            if (data_out_ptr != NULL) {
+                memcpy(data_out_ptr, data_out, cmd_spec->app_read_result_size);
+            }
+        }
+    }
+    return ret;
+}
+
+// Typed API: the values are exchanged in binary, without the string parsing and formatting of vfctrl_do_command()
+
+#define VALUE_CLASS_INT     (0)
+#define VALUE_CLASS_FLOAT   (1)
+#define VALUE_CLASS_Q       (2)
+
+uint8_t is_value_class(param_type type, unsigned value_class)
+{
+    switch (type) {
+        case TYPE_INT8:
+        case TYPE_UINT8:
+        case TYPE_INT32:
+        case TYPE_UINT32:
+        case TYPE_TICKS:
+            return value_class == VALUE_CLASS_INT;
+        case TYPE_FIXED_0_32:
+        case TYPE_FIXED_1_31:
+        case TYPE_FIXED_7_24:
+        case TYPE_FIXED_8_24:
+        case TYPE_FIXED_16_16:
+            return value_class == VALUE_CLASS_FLOAT || value_class == VALUE_CLASS_Q;
+        case TYPE_ENERGY:
+            return value_class == VALUE_CLASS_FLOAT;
+        default:
+            return 0;
+    }
+}
+
+// Find the command of a typed call and check it takes num_values values of the given class.
+// Returns NULL and prints the reason if it does not.
+cmdspec_t *get_typed_cmdspec(vfctrl_cmd_id_t cmd_id, param_rw rw, unsigned value_class, unsigned num_values)
+{
+    if ((unsigned)cmd_id >= VFCTRL_NUM_CMDS || cmd_id_to_num[cmd_id] < 0) {
+        fprintf(stderr, "Error: command id %d is not available in this build\n", cmd_id);
+        return NULL;
+    }
+    cmdspec_t *current = &cmdspec_ap[cmd_id_to_num[cmd_id]];
+    if (current->rw != rw) {
+        fprintf(stderr, "Error: %s is not a %s command\n", current->par_name, (rw == READ) ? "read" : "write");
+        return NULL;
+    }
+    // the floating point filter coefficients are converted by the *_filter_coefficients_human_readable functions
+    if (current->offset == GPIO_CMD_GET_FILTER_COEFF || current->offset == GPIO_CMD_SET_FILTER_COEFF) {
+        if (current->resid == GPIO_RESID && current->type == TYPE_ENERGY) {
+            fprintf(stderr, "Error: %s is not supported by the typed API, use the _RAW command\n", current->par_name);
+            return NULL;
+        }
+    }
+    if (!is_value_class(current->type, value_class)) {
+        fprintf(stderr, "Error: %s does not take %s values\n", current->par_name,
+                (value_class == VALUE_CLASS_INT) ? "integer" : (value_class == VALUE_CLASS_FLOAT) ? "floating point" : "fixed point");
+        return NULL;
+    }
+    unsigned expected = current->num_values;
+    if (rw == READ) {
+        expected = current->app_read_result_size / get_app_read_result_size(current->type);
+    }
+    if (num_values != expected) {
+        fprintf(stderr, "Error: %s takes %u values, %u given\n", current->par_name, expected, num_values);
+        return NULL;
+    }
+    return current;
+}
+
+int get_typed_values(vfctrl_cmd_id_t cmd_id, unsigned value_class, void *values, unsigned num_values)
+{
+    int_float vals[CMD_MAX_BYTES] = {{0}};
+    int ret;
+    LOCK_MUTEX
+    populate_cmd_table();
+    open_device();
+#if !JSON_ONLY
+    if (setup_err != 0) {
+        UNLOCK_MUTEX
+        return -1;
+    }
+#endif
+    cmdspec_t *current = get_typed_cmdspec(cmd_id, READ, value_class, num_values);
+    if (current == NULL) {
+        UNLOCK_MUTEX
+        return -2;
+    }
+    if (setup_err != 0) {
+        printf("control initialization returned error\n");
+        UNLOCK_MUTEX
+        return -1;
+    }
+    ret = get_struct_val_from_device(*current, vals);
+    if (ret == CONTROL_SUCCESS) {
+        if (value_class == VALUE_CLASS_FLOAT) {
+            ret = convert_read_result(*current, vals, values);
+        } else {
+            select_agc_channel(*current, vals);
+            for (unsigned i=0; i<num_values; i++) {
+                switch (current->type) {
+                    case TYPE_INT8:
+                        ((int32_t*)values)[i] = vals[i].i8;
+                        break;
+                    case TYPE_UINT8:
+                        ((int32_t*)values)[i] = vals[i].ui8;
+                        break;
+                    default:
+                        ((int32_t*)values)[i] = vals[i].i;
+                }
+            }
+        }
+    }
+    UNLOCK_MUTEX
+    return ret;
+}
+
+int set_typed_values(vfctrl_cmd_id_t cmd_id, unsigned value_class, const void *values, unsigned num_values)
+{
+    int_float vals[CMD_MAX_BYTES] = {{0}};
+    int ret;
+    LOCK_MUTEX
+    populate_cmd_table();
+    open_device();
+#if !JSON_ONLY
+    if (setup_err != 0) {
+        printf("control initialization returned error\n");
+        UNLOCK_MUTEX
+        return -1;
+    }
+#endif
+    cmdspec_t *current = get_typed_cmdspec(cmd_id, WRITE, value_class, num_values);
+    if (current == NULL) {
+        UNLOCK_MUTEX
+        return -2;
+    }
+    for (unsigned i=0; i<num_values; i++) {
+        if (value_class == VALUE_CLASS_FLOAT) {
+            float_to_device_value(current->type, ((const float*)values)[i], &vals[i]);
+        } else if (current->device_rw_size == 1) {
+            vals[i].ui8 = (uint8_t)((const int32_t*)values)[i];
+        } else {
+            vals[i].i = ((const int32_t*)values)[i];
+        }
+    }
+    add_agc_channel_index(*current, vals);
+    ret = set_struct_val_on_device(*current, vals, 0);
+    UNLOCK_MUTEX
+    return ret;
+}
+
+int vfctrl_get_cmdspec_by_id(vfctrl_cmd_id_t cmd_id, cmdspec_t *cmd_spec)
+{
+    LOCK_MUTEX
+    populate_cmd_table();
+    int ret = -1;
+    if ((unsigned)cmd_id < VFCTRL_NUM_CMDS && cmd_id_to_num[cmd_id] >= 0) {
+        *cmd_spec = cmdspec_ap[cmd_id_to_num[cmd_id]];
+        ret = 0;
+    }
+    UNLOCK_MUTEX
+    return ret;
+}
+
+int vfctrl_get_float(vfctrl_cmd_id_t cmd_id, float *value)
+{
+    return get_typed_values(cmd_id, VALUE_CLASS_FLOAT, value, 1);
+}
+
+int vfctrl_get_float_array(vfctrl_cmd_id_t cmd_id, float *values, unsigned num_values)
+{
+    return get_typed_values(cmd_id, VALUE_CLASS_FLOAT, values, num_values);
+}
+
+int vfctrl_set_float(vfctrl_cmd_id_t cmd_id, float value)
+{
+    return set_typed_values(cmd_id, VALUE_CLASS_FLOAT, &value, 1);
+}
+
+int vfctrl_set_float_array(vfctrl_cmd_id_t cmd_id, const float *values, unsigned num_values)
+{
+    return set_typed_values(cmd_id, VALUE_CLASS_FLOAT, values, num_values);
+}
+
+int vfctrl_get_int(vfctrl_cmd_id_t cmd_id, int32_t *value)
+{
+    return get_typed_values(cmd_id, VALUE_CLASS_INT, value, 1);
+}
+
+int vfctrl_get_int_array(vfctrl_cmd_id_t cmd_id, int32_t *values, unsigned num_values)
+{
+    return get_typed_values(cmd_id, VALUE_CLASS_INT, values, num_values);
+}
+
+int vfctrl_set_int(vfctrl_cmd_id_t cmd_id, int32_t value)
+{
+    return set_typed_values(cmd_id, VALUE_CLASS_INT, &value, 1);
+}
+
+int vfctrl_set_int_array(vfctrl_cmd_id_t cmd_id, const int32_t *values, unsigned num_values)
+{
+    return set_typed_values(cmd_id, VALUE_CLASS_INT, values, num_values);
+}
+
+int vfctrl_get_q(vfctrl_cmd_id_t cmd_id, int32_t *values, unsigned num_values)
+{
+    return get_typed_values(cmd_id, VALUE_CLASS_Q, values, num_values);
+}
+
+int vfctrl_set_q(vfctrl_cmd_id_t cmd_id, const int32_t *values, unsigned num_values)
+{
+    return set_typed_values(cmd_id, VALUE_CLASS_Q, values, num_values);
+}
 /*
 int vfctrl_do_command_write_bytes(cmdspec_t *cmd_spec, uint8_t *write_bytes)
 {
@@ -2094,11 +3238,163 @@ int vfctrl_do_command_write_bytes(cmdspec_t *cmd_spec, uint8_t *write_bytes)
     return ret;
 }*/
 
+// SPI passthrough streaming. A write transaction is pushed onto the device SPI stack with SET_SPI_PUSH
+// commands and run by the SET_SPI_PUSH_AND_EXEC carrying its last bytes. The pushes are written back to back
+// without reading anything in between, and a push which finds the device queue full is sent again after a
+// short back-off instead of the fixed 15ms of set_struct_val_on_device().
+// As on the command line, each push carries SPI_MAX_CMD_SIZE raw bytes, the last one is padded with zeros.
+#define SPI_NUM_ADDRESSES       (256)
+#define SPI_WRITE_TIMEOUT_US    (NUM_WRITE_RETRIES * 15000)
+
+control_ret_t write_spi_command(cmdspec_t current, int_float *vals, uint8_t log_for_data_partition)
+{
+    spi_stats.num_commands++;
+#if !JSON_ONLY
+    if (!log_for_data_partition && setup_err == 0) {
+        uint8_t payload[CMD_MAX_BYTES];
+        unsigned payload_bytes = current.num_values * current.device_rw_size;
+        unsigned sleep_time_us = POLL_MIN_SLEEP_US;
+        uint64_t start_us = vfctrl_get_time_us();
+        write_payload_byte_array(current, current.num_values, vals, payload);
+        while (1) {
+            control_ret_t ret = control_write_command(current.resid, (control_cmd_t)current.offset, payload, payload_bytes);
+            if (ret != CONTROL_ERROR || vfctrl_get_time_us() - start_us >= SPI_WRITE_TIMEOUT_US) {
+                return ret;
+            }
+            spi_stats.num_retries++;
+            vfctrl_sleep_us(sleep_time_us);
+            sleep_time_us = MIN(sleep_time_us * 2, POLL_MAX_SLEEP_US);
+        }
+    }
+#endif
+    return set_struct_val_on_device(current, vals, log_for_data_partition);
+}
+
+int vfctrl_spi_write(const uint8_t *data, unsigned num_bytes, uint8_t log_for_data_partition)
+{
+    int ret = 0;
+    if (num_bytes == 0) {
+        return 0;
+    }
+    LOCK_MUTEX
+    populate_cmd_table();
+    if (!log_for_data_partition) {
+        open_device();
+    }
+    if (cmd_id_to_num[VFCTRL_SET_SPI_PUSH] < 0 || cmd_id_to_num[VFCTRL_SET_SPI_PUSH_AND_EXEC] < 0) {
+        UNLOCK_MUTEX
+        return -2;
+    }
+    cmdspec_t push = cmdspec_ap[cmd_id_to_num[VFCTRL_SET_SPI_PUSH]];
+    cmdspec_t push_and_exec = cmdspec_ap[cmd_id_to_num[VFCTRL_SET_SPI_PUSH_AND_EXEC]];
+    uint64_t start_us = vfctrl_get_time_us();
+    unsigned offset = 0;
+    while (offset < num_bytes) {
+        unsigned chunk_bytes = MIN(num_bytes - offset, SPI_MAX_CMD_SIZE);
+        int_float vals[CMD_MAX_BYTES] = {{0}};
+        for (unsigned i=0; i<chunk_bytes; i++) {
+            vals[i].ui8 = data[offset + i];
+        }
+        uint8_t last = (offset + chunk_bytes == num_bytes);
+        ret = write_spi_command(last ? push_and_exec : push, vals, log_for_data_partition);
+        if (ret != CONTROL_SUCCESS) {
+            printf("Error: SPI write failed after %u of %u bytes (%d)\n", offset, num_bytes, ret);
+            break;
+        }
+        offset += chunk_bytes;
+        spi_stats.bytes_written += chunk_bytes;
+    }
+    if (ret == 0) {
+        spi_stats.num_transactions++;
+    } else {
+        spi_stats.num_errors++;
+    }
+    spi_stats.busy_us += vfctrl_get_time_us() - start_us;
+    UNLOCK_MUTEX
+    return ret;
+}
+
+int vfctrl_spi_read(uint8_t address, uint8_t *data, unsigned num_bytes)
+{
+    int ret = 0;
+    if (num_bytes == 0) {
+        return 0;
+    }
+    if (num_bytes > (unsigned)(SPI_NUM_ADDRESSES - address)) {
+        printf("Error: SPI read of %u bytes from address 0x%02x is past the last address\n", num_bytes, address);
+        return -1;
+    }
+    LOCK_MUTEX
+    populate_cmd_table();
+    open_device();
+#if !JSON_ONLY
+    if (setup_err != 0) {
+        UNLOCK_MUTEX
+        return -1;
+    }
+#endif
+    if (cmd_id_to_num[VFCTRL_SET_SPI_READ_HEADER] < 0 || cmd_id_to_num[VFCTRL_GET_SPI] < 0) {
+        UNLOCK_MUTEX
+        return -2;
+    }
+    cmdspec_t read_header = cmdspec_ap[cmd_id_to_num[VFCTRL_SET_SPI_READ_HEADER]];
+    cmdspec_t get_spi = cmdspec_ap[cmd_id_to_num[VFCTRL_GET_SPI]];
+    uint64_t start_us = vfctrl_get_time_us();
+    // each GET_SPI returns the read selected by the header written just before it, so the chunks are not overlapped
+    for (unsigned offset=0; offset<num_bytes; offset+=SPI_READ_BUF_SIZE) {
+        unsigned chunk_bytes = MIN(num_bytes - offset, SPI_READ_BUF_SIZE);
+        int_float vals[CMD_MAX_BYTES] = {{0}};
+        vals[0].ui8 = (uint8_t)(address + offset);
+        vals[1].ui8 = (uint8_t)chunk_bytes;
+        ret = write_spi_command(read_header, vals, 0);
+        if (ret == CONTROL_SUCCESS) {
+            spi_stats.num_commands++;
+            ret = get_struct_val_from_device(get_spi, vals);
+        }
+        if (ret != CONTROL_SUCCESS) {
+            printf("Error: SPI read failed after %u of %u bytes (%d)\n", offset, num_bytes, ret);
+            break;
+        }
+        for (unsigned i=0; i<chunk_bytes; i++) {
+            data[offset + i] = vals[i].ui8;
+        }
+        spi_stats.bytes_read += chunk_bytes;
+    }
+    if (ret == 0) {
+        spi_stats.num_transactions++;
+    } else {
+        spi_stats.num_errors++;
+    }
+    spi_stats.busy_us += vfctrl_get_time_us() - start_us;
+    UNLOCK_MUTEX
+    return ret;
+}
+
+void vfctrl_get_spi_stats(vfctrl_spi_stats_t *stats)
+{
+    LOCK_MUTEX
+    *stats = spi_stats;
+    UNLOCK_MUTEX
+}
+
+void vfctrl_reset_spi_stats(void)
+{
+    LOCK_MUTEX
+    memset(&spi_stats, 0, sizeof(spi_stats));
+    UNLOCK_MUTEX
+}
+
 int vfctrl_get_aec_coefficients_to_file(const char* aec_coeffs_file)
 {
     LOCK_MUTEX
     populate_cmd_table();
     open_device();
+#if !JSON_ONLY
+    if (setup_err != 0) {
+        UNLOCK_MUTEX
+        return -1;
+    }
+#endif
     int ret = get_aec_coefficients(cmdspec_ap, total_num_commands, aec_coeffs_file);
     UNLOCK_MUTEX
     return ret;
@@ -2109,6 +3405,12 @@ int vfctrl_get_ic_coefficients_to_file(const char* ic_coeffs_file)
     LOCK_MUTEX
     populate_cmd_table();
     open_device();
+#if !JSON_ONLY
+    if (setup_err != 0) {
+        UNLOCK_MUTEX
+        return -1;
+    }
+#endif
     int ret = get_ic_coefficients(cmdspec_ap, total_num_commands, ic_coeffs_file);
     UNLOCK_MUTEX
     return ret;
@@ -2116,7 +3418,6 @@ int vfctrl_get_ic_coefficients_to_file(const char* ic_coeffs_file)
 
 int vfctrl_format_read_result(cmdspec_t *cmd_spec_ptr, void* data_out_ptr, char* output_string) {
     cmdspec_t cmd_spec = *cmd_spec_ptr;
-    printf("%s:", cmd_spec.par_name);
     output_string[0] = '\0';
     // Special cases
     if (strcmp("GET_VERSION", cmd_spec.par_name) == 0) {
@@ -2193,8 +3494,8 @@ int vfctrl_format_read_result(cmdspec_t *cmd_spec_ptr, void* data_out_ptr, char*
                 sprintf(temp_string, " %i (%.2f ms)", ((uint32_t*)data_out_ptr)[i], (float) (((uint32_t*)data_out_ptr)[i]) / 100000.0 );
                 break;
             default:
-                sprintf(temp_string, "Error: invalid type %d\n", cmd_spec.type);
-                host_shutdown(1);
+                printf("Error: invalid type %d\n", cmd_spec.type);
+                return -1;
         }
         strcat(output_string, temp_string);
     }
@@ -0,0 +1,558 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+// Register script compiler for the I2C passthrough: codec bring-up in one session
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "host_control_api.h"
+#include "i2c_script.h"
+
+#define SCRIPT_LINE_MAX_CHARS   (4096)
+#define SCRIPT_MAX_ARGS         (I2C_SCRIPT_PAYLOAD_BYTES + 2)
+#define NUM_I2C_ADDRESSES       (128)
+#define NUM_REGISTERS           (256)
+#define NO_PAGE_REGISTER        (-1)
+#define POLL_INTERVAL_US        (1000)
+
+// Access to the registers, the device through the passthrough commands or the simulated register map
+typedef struct i2c_target {
+    int (*write)(struct i2c_target *target, uint8_t addr, uint8_t reg, const uint8_t *data, unsigned count);
+    int (*read)(struct i2c_target *target, uint8_t addr, uint8_t reg, uint8_t *data, unsigned count);
+    void (*delay)(struct i2c_target *target, unsigned ms);
+    unsigned num_writes;
+    unsigned num_reads;
+    unsigned num_bytes;
+} i2c_target_t;
+
+// Register values known from the writes and reads of the script, to resolve updates without a read.
+// Only the page 0 values are kept for the devices with a page register.
+typedef struct {
+    int page_reg[NUM_I2C_ADDRESSES];
+    uint8_t page[NUM_I2C_ADDRESSES];
+    uint8_t *values[NUM_I2C_ADDRESSES];
+    uint8_t *known[NUM_I2C_ADDRESSES];   // 0 unknown, 1 known, 2 volatile
+} i2c_shadow_t;
+
+static unsigned long parse_number(const char *str, unsigned long max, unsigned line, int *err)
+{
+    char *end;
+    unsigned long value = strtoul(str, &end, 0);
+    if (end == str || *end != '\0' || value > max) {
+        printf("Error: line %u: invalid value %s\n", line, str);
+        *err = 1;
+    }
+    return value;
+}
+
+static int tokenize(char *line, char **args)
+{
+    int num_args = 0;
+    char *comment = strstr(line, "//");
+    if (comment != NULL) {
+        *comment = '\0';
+    }
+    for (char *tok = strtok(line, " \t\r\n"); tok != NULL && tok[0] != '#'; tok = strtok(NULL, " \t\r\n")) {
+        if (num_args == SCRIPT_MAX_ARGS) {
+            return -1;
+        }
+        args[num_args++] = tok;
+    }
+    return num_args;
+}
+
+static i2c_op_t *add_op(i2c_script_t *script, i2c_op_type_t type, unsigned addr, unsigned line)
+{
+    if (script->num_ops == script->max_ops) {
+        script->max_ops = (script->max_ops == 0) ? 64 : script->max_ops * 2;
+        script->ops = realloc(script->ops, script->max_ops * sizeof(i2c_op_t));
+    }
+    i2c_op_t *op = &script->ops[script->num_ops++];
+    memset(op, 0, sizeof(i2c_op_t));
+    op->type = type;
+    op->addr = addr;
+    op->line = line;
+    op->num_merged = 1;
+    return op;
+}
+
+int i2c_script_compile(FILE *fp, i2c_script_t *script)
+{
+    static char line[SCRIPT_LINE_MAX_CHARS];
+    char *tokens[SCRIPT_MAX_ARGS];
+    int addr = -1;
+    unsigned line_num = 0;
+    unsigned num_errors = 0;
+
+    memset(script, 0, sizeof(i2c_script_t));
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        int err = 0;
+        line_num++;
+        char **args = tokens;
+        int num_args = tokenize(line, args);
+        if (num_args < 0) {
+            printf("Error: line %u: too many values\n", line_num);
+            num_errors++;
+            continue;
+        }
+        if (num_args == 0) {
+            continue;
+        }
+        // vfctrl command lines, with or without the path to the app
+        if (num_args > 1 && strstr(args[0], "vfctrl") != NULL) {
+            args++;
+            num_args--;
+        }
+        const char *cmd = args[0];
+
+        if (strcmp(cmd, "SET_I2C_WITH_REG") == 0) {
+            if (num_args != I2C_SCRIPT_PAYLOAD_BYTES + 1) {
+                printf("Error: line %u: SET_I2C_WITH_REG takes %d values\n", line_num, I2C_SCRIPT_PAYLOAD_BYTES);
+                num_errors++;
+                continue;
+            }
+            unsigned cmd_addr = parse_number(args[1], NUM_I2C_ADDRESSES - 1, line_num, &err);
+            unsigned reg = parse_number(args[2], NUM_REGISTERS - 1, line_num, &err);
+            unsigned count = parse_number(args[3], I2C_SCRIPT_MAX_DATA_BYTES, line_num, &err);
+            i2c_op_t *op = add_op(script, I2C_OP_WRITE, cmd_addr, line_num);
+            op->reg = reg;
+            op->count = count;
+            for (unsigned i=0; i<count && !err; i++) {
+                op->data[i] = parse_number(args[4 + i], 0xff, line_num, &err);
+            }
+        } else if (strcmp(cmd, "device") == 0 && num_args == 2) {
+            addr = parse_number(args[1], NUM_I2C_ADDRESSES - 1, line_num, &err);
+        } else if (addr < 0) {
+            printf("Error: line %u: %s before the device address is set\n", line_num, cmd);
+            err = 1;
+        } else if (strcmp(cmd, "page") == 0 && num_args == 2) {
+            i2c_op_t *op = add_op(script, I2C_OP_PAGE, addr, line_num);
+            op->reg = parse_number(args[1], NUM_REGISTERS - 1, line_num, &err);
+        } else if (strcmp(cmd, "volatile") == 0 && num_args >= 2) {
+            for (int i=1; i<num_args; i++) {
+                i2c_op_t *op = add_op(script, I2C_OP_VOLATILE, addr, line_num);
+                op->reg = parse_number(args[i], NUM_REGISTERS - 1, line_num, &err);
+            }
+        } else if (strcmp(cmd, "write") == 0 && num_args >= 3 && num_args - 2 <= I2C_SCRIPT_MAX_DATA_BYTES) {
+            i2c_op_t *op = add_op(script, I2C_OP_WRITE, addr, line_num);
+            op->reg = parse_number(args[1], NUM_REGISTERS - 1, line_num, &err);
+            op->count = num_args - 2;
+            for (unsigned i=0; i<op->count; i++) {
+                op->data[i] = parse_number(args[2 + i], 0xff, line_num, &err);
+            }
+        } else if (strcmp(cmd, "update") == 0 && num_args == 4) {
+            i2c_op_t *op = add_op(script, I2C_OP_UPDATE, addr, line_num);
+            op->reg = parse_number(args[1], NUM_REGISTERS - 1, line_num, &err);
+            op->mask = parse_number(args[2], 0xff, line_num, &err);
+            op->value = parse_number(args[3], 0xff, line_num, &err);
+        } else if (strcmp(cmd, "read") == 0 && (num_args == 2 || num_args == 3)) {
+            i2c_op_t *op = add_op(script, I2C_OP_READ, addr, line_num);
+            op->reg = parse_number(args[1], NUM_REGISTERS - 1, line_num, &err);
+            op->count = (num_args == 3) ? parse_number(args[2], I2C_SCRIPT_MAX_DATA_BYTES, line_num, &err) : 1;
+        } else if (strcmp(cmd, "poll") == 0 && (num_args == 4 || num_args == 5)) {
+            i2c_op_t *op = add_op(script, I2C_OP_POLL, addr, line_num);
+            op->reg = parse_number(args[1], NUM_REGISTERS - 1, line_num, &err);
+            op->mask = parse_number(args[2], 0xff, line_num, &err);
+            op->value = parse_number(args[3], 0xff, line_num, &err);
+            op->time_ms = (num_args == 5) ? parse_number(args[4], 3600000, line_num, &err) : I2C_SCRIPT_POLL_TIMEOUT_MS;
+        } else if (strcmp(cmd, "delay") == 0 && num_args == 2) {
+            i2c_op_t *op = add_op(script, I2C_OP_DELAY, addr, line_num);
+            op->time_ms = parse_number(args[1], 3600000, line_num, &err);
+        } else {
+            printf("Error: line %u: invalid statement %s\n", line_num, cmd);
+            err = 1;
+        }
+        if (err) {
+            num_errors++;
+        }
+    }
+    return (num_errors > 0) ? -1 : 0;
+}
+
+void i2c_script_coalesce(i2c_script_t *script)
+{
+    unsigned num_ops = 0;
+    for (unsigned i=0; i<script->num_ops; i++) {
+        i2c_op_t *op = &script->ops[i];
+        i2c_op_t *prev = (num_ops > 0) ? &script->ops[num_ops - 1] : NULL;
+        if (prev != NULL && op->type == I2C_OP_WRITE && prev->type == I2C_OP_WRITE && op->addr == prev->addr &&
+            prev->reg + prev->count == op->reg && prev->count + op->count <= I2C_SCRIPT_MAX_DATA_BYTES) {
+            memcpy(&prev->data[prev->count], op->data, op->count);
+            prev->count += op->count;
+            prev->num_merged += op->num_merged;
+            continue;
+        }
+        if (num_ops != i) {
+            script->ops[num_ops] = *op;
+        }
+        num_ops++;
+    }
+    script->num_ops = num_ops;
+}
+
+void i2c_script_free(i2c_script_t *script)
+{
+    free(script->ops);
+    memset(script, 0, sizeof(i2c_script_t));
+}
+
+static void shadow_init(i2c_shadow_t *shadow)
+{
+    memset(shadow, 0, sizeof(i2c_shadow_t));
+    for (unsigned a=0; a<NUM_I2C_ADDRESSES; a++) {
+        shadow->page_reg[a] = NO_PAGE_REGISTER;
+    }
+}
+
+static void shadow_free(i2c_shadow_t *shadow)
+{
+    for (unsigned a=0; a<NUM_I2C_ADDRESSES; a++) {
+        free(shadow->values[a]);
+        free(shadow->known[a]);
+    }
+}
+
+static uint8_t *shadow_known(i2c_shadow_t *shadow, uint8_t addr)
+{
+    if (shadow->known[addr] == NULL) {
+        shadow->known[addr] = calloc(NUM_REGISTERS, 1);
+        shadow->values[addr] = calloc(NUM_REGISTERS, 1);
+    }
+    return shadow->known[addr];
+}
+
+// Record the values written to or read from the device, following the page changes
+static void shadow_store(i2c_shadow_t *shadow, uint8_t addr, uint8_t reg, const uint8_t *data, unsigned count)
+{
+    uint8_t *known = shadow_known(shadow, addr);
+    for (unsigned i=0; i<count && reg + i < NUM_REGISTERS; i++) {
+        unsigned r = reg + i;
+        if ((int)r == shadow->page_reg[addr]) {
+            shadow->page[addr] = data[i];
+        } else if (shadow->page[addr] == 0 && known[r] != 2) {
+            known[r] = 1;
+            shadow->values[addr][r] = data[i];
+        }
+    }
+}
+
+static int shadow_lookup(i2c_shadow_t *shadow, uint8_t addr, uint8_t reg, uint8_t *value)
+{
+    uint8_t *known = shadow_known(shadow, addr);
+    if (shadow->page[addr] != 0 || known[reg] != 1) {
+        return -1;
+    }
+    *value = shadow->values[addr][reg];
+    return 0;
+}
+
+static int read_registers(i2c_target_t *target, i2c_shadow_t *shadow, i2c_op_t *op, uint8_t *data, unsigned count)
+{
+    int ret = target->read(target, op->addr, op->reg, data, count);
+    target->num_reads++;
+    if (ret != 0) {
+        printf("Error: line %u: read of 0x%02x register 0x%02x failed (%d)\n", op->line, op->addr, op->reg, ret);
+        return ret;
+    }
+    shadow_store(shadow, op->addr, op->reg, data, count);
+    return 0;
+}
+
+static int write_registers(i2c_target_t *target, i2c_shadow_t *shadow, i2c_op_t *op, const uint8_t *data, unsigned count)
+{
+    int ret = target->write(target, op->addr, op->reg, data, count);
+    target->num_writes++;
+    target->num_bytes += count;
+    if (ret != 0) {
+        printf("Error: line %u: write of 0x%02x register 0x%02x failed (%d)\n", op->line, op->addr, op->reg, ret);
+        return ret;
+    }
+    shadow_store(shadow, op->addr, op->reg, data, count);
+    return 0;
+}
+
+static int execute_op(i2c_target_t *target, i2c_shadow_t *shadow, i2c_op_t *op)
+{
+    uint8_t data[I2C_SCRIPT_MAX_DATA_BYTES];
+    switch (op->type) {
+        case I2C_OP_WRITE:
+            return write_registers(target, shadow, op, op->data, op->count);
+        case I2C_OP_UPDATE: {
+            uint8_t value;
+            if (shadow_lookup(shadow, op->addr, op->reg, &value) != 0) {
+                int ret = read_registers(target, shadow, op, &value, 1);
+                if (ret != 0) {
+                    return ret;
+                }
+            }
+            value = (value & ~op->mask) | (op->value & op->mask);
+            return write_registers(target, shadow, op, &value, 1);
+        }
+        case I2C_OP_READ: {
+            int ret = read_registers(target, shadow, op, data, op->count);
+            if (ret == 0) {
+                printf("0x%02x[0x%02x]:", op->addr, op->reg);
+                for (unsigned i=0; i<op->count; i++) {
+                    printf(" 0x%02x", data[i]);
+                }
+                printf("\n");
+            }
+            return ret;
+        }
+        case I2C_OP_POLL: {
+            uint64_t start_us = vfctrl_get_time_us();
+            while (1) {
+                int ret = target->read(target, op->addr, op->reg, data, 1);
+                target->num_reads++;
+                if (ret != 0) {
+                    printf("Error: line %u: poll of 0x%02x register 0x%02x failed (%d)\n", op->line, op->addr, op->reg, ret);
+                    return ret;
+                }
+                if ((data[0] & op->mask) == op->value) {
+                    return 0;
+                }
+                if (vfctrl_get_time_us() - start_us > (uint64_t)op->time_ms * 1000) {
+                    printf("Error: line %u: timeout, register 0x%02x of 0x%02x is 0x%02x\n", op->line, op->reg, op->addr, data[0]);
+                    return -1;
+                }
+                vfctrl_sleep_us(POLL_INTERVAL_US);
+            }
+        }
+        case I2C_OP_DELAY:
+            target->delay(target, op->time_ms);
+            return 0;
+        case I2C_OP_PAGE:
+            shadow->page_reg[op->addr] = op->reg;
+            return 0;
+        case I2C_OP_VOLATILE:
+            shadow_known(shadow, op->addr)[op->reg] = 2;
+            return 0;
+    }
+    return -1;
+}
+
+// Device target: SET_I2C_WITH_REG for the writes, SET_I2C_READ_HEADER then GET_I2C_WITH_REG for the reads
+
+typedef struct {
+    i2c_target_t target;
+    cmdspec_t write_cmd;
+    uint8_t log_for_data_partition;
+} device_target_t;
+
+static int device_write(i2c_target_t *target, uint8_t addr, uint8_t reg, const uint8_t *data, unsigned count)
+{
+    device_target_t *device = (device_target_t *)target;
+    char values[I2C_SCRIPT_PAYLOAD_BYTES][4];
+    const char *args[I2C_SCRIPT_PAYLOAD_BYTES + 1];
+    args[0] = device->write_cmd.par_name;
+    for (unsigned i=0; i<I2C_SCRIPT_PAYLOAD_BYTES; i++) {
+        unsigned v = 0;
+        if (i == 0) v = addr;
+        else if (i == 1) v = reg;
+        else if (i == 2) v = count;
+        else if (i - 3 < count) v = data[i - 3];
+        sprintf(values[i], "%u", v);
+        args[i + 1] = values[i];
+    }
+    return vfctrl_do_command(&device->write_cmd, args, NULL, device->log_for_data_partition);
+}
+
+static int device_read(i2c_target_t *target, uint8_t addr, uint8_t reg, uint8_t *data, unsigned count)
+{
+    (void)target;
+    int32_t header[3] = {addr, reg, count};
+    int32_t values[I2C_SCRIPT_PAYLOAD_BYTES];
+    int ret = vfctrl_set_int_array(VFCTRL_SET_I2C_READ_HEADER, header, 3);
+    if (ret == 0) {
+        ret = vfctrl_get_int_array(VFCTRL_GET_I2C_WITH_REG, values, I2C_SCRIPT_PAYLOAD_BYTES);
+    }
+    for (unsigned i=0; i<count && ret==0; i++) {
+        data[i] = (uint8_t)values[i];
+    }
+    return ret;
+}
+
+static void device_delay(i2c_target_t *target, unsigned ms)
+{
+    (void)target;
+    vfctrl_sleep_us(ms * 1000);
+}
+
+// Simulated target: a register map per device with auto increment and the page registers of the script
+
+typedef struct {
+    i2c_target_t target;
+    i2c_shadow_t *shadow;                     // the page registers
+    uint8_t *regs[NUM_I2C_ADDRESSES];         // NUM_REGISTERS pages of NUM_REGISTERS registers
+    uint8_t *written[NUM_I2C_ADDRESSES];
+    uint8_t page[NUM_I2C_ADDRESSES];
+    unsigned delay_ms;
+} sim_target_t;
+
+static void sim_access(sim_target_t *sim, uint8_t addr, uint8_t reg, uint8_t *data, unsigned count, unsigned write)
+{
+    if (sim->regs[addr] == NULL) {
+        sim->regs[addr] = calloc(NUM_REGISTERS * NUM_REGISTERS, 1);
+        sim->written[addr] = calloc(NUM_REGISTERS * NUM_REGISTERS, 1);
+    }
+    for (unsigned i=0; i<count; i++) {
+        unsigned r = (reg + i) % NUM_REGISTERS;
+        unsigned idx = sim->page[addr] * NUM_REGISTERS + r;
+        if (write) {
+            sim->regs[addr][idx] = data[i];
+            sim->written[addr][idx] = 1;
+            if ((int)r == sim->shadow->page_reg[addr]) {
+                sim->page[addr] = data[i];
+            }
+        } else {
+            data[i] = sim->regs[addr][idx];
+        }
+    }
+}
+
+static int sim_write(i2c_target_t *target, uint8_t addr, uint8_t reg, const uint8_t *data, unsigned count)
+{
+    sim_access((sim_target_t *)target, addr, reg, (uint8_t *)data, count, 1);
+    return 0;
+}
+
+static int sim_read(i2c_target_t *target, uint8_t addr, uint8_t reg, uint8_t *data, unsigned count)
+{
+    sim_access((sim_target_t *)target, addr, reg, data, count, 0);
+    return 0;
+}
+
+static void sim_delay(i2c_target_t *target, unsigned ms)
+{
+    ((sim_target_t *)target)->delay_ms += ms;
+}
+
+static void sim_print_map(sim_target_t *sim)
+{
+    for (unsigned a=0; a<NUM_I2C_ADDRESSES; a++) {
+        if (sim->regs[a] == NULL) {
+            continue;
+        }
+        for (unsigned p=0; p<NUM_REGISTERS; p++) {
+            const uint8_t *written = &sim->written[a][p * NUM_REGISTERS];
+            const uint8_t *regs = &sim->regs[a][p * NUM_REGISTERS];
+            unsigned any = 0;
+            for (unsigned r=0; r<NUM_REGISTERS; r++) {
+                any |= written[r];
+            }
+            if (!any) {
+                continue;
+            }
+            printf("Device 0x%02x page %u:\n", a, p);
+            for (unsigned row=0; row<NUM_REGISTERS; row+=16) {
+                unsigned row_written = 0;
+                for (unsigned r=row; r<row+16; r++) {
+                    row_written |= written[r];
+                }
+                if (!row_written) {
+                    continue;
+                }
+                printf("    0x%02x:", row);
+                for (unsigned r=row; r<row+16; r++) {
+                    if (written[r]) {
+                        printf(" %02x", regs[r]);
+                    } else {
+                        printf(" --");
+                    }
+                }
+                printf("\n");
+            }
+        }
+        free(sim->regs[a]);
+        free(sim->written[a]);
+    }
+}
+
+int run_i2c_script(i2c_script_config_t *config, uint8_t log_for_data_partition)
+{
+    i2c_script_t script;
+    FILE *fp = stdin;
+    if (strcmp(config->script_file, "-") != 0) {
+        fp = fopen(config->script_file, "r");
+        if (fp == NULL) {
+            printf("Error: cannot open %s\n", config->script_file);
+            return 1;
+        }
+    }
+    int ret = i2c_script_compile(fp, &script);
+    if (fp != stdin) {
+        fclose(fp);
+    }
+    if (ret != 0) {
+        i2c_script_free(&script);
+        return 1;
+    }
+    unsigned num_script_ops = script.num_ops;
+    if (config->coalesce) {
+        i2c_script_coalesce(&script);
+    }
+    if (log_for_data_partition) {
+        // the data partition can only hold the writes
+        for (unsigned i=0; i<script.num_ops; i++) {
+            i2c_op_type_t type = script.ops[i].type;
+            if (type == I2C_OP_UPDATE || type == I2C_OP_READ || type == I2C_OP_POLL || type == I2C_OP_DELAY) {
+                printf("Error: line %u: only writes can be logged for the data partition\n", script.ops[i].line);
+                i2c_script_free(&script);
+                return 1;
+            }
+        }
+    }
+
+    i2c_shadow_t *shadow = malloc(sizeof(i2c_shadow_t));
+    shadow_init(shadow);
+    device_target_t device;
+    sim_target_t sim;
+    i2c_target_t *target;
+    if (config->simulate) {
+        memset(&sim, 0, sizeof(sim));
+        sim.target.write = sim_write;
+        sim.target.read = sim_read;
+        sim.target.delay = sim_delay;
+        sim.shadow = shadow;
+        target = &sim.target;
+    } else {
+        memset(&device, 0, sizeof(device));
+        device.target.write = device_write;
+        device.target.read = device_read;
+        device.target.delay = device_delay;
+        device.log_for_data_partition = log_for_data_partition;
+        if (vfctrl_get_cmdspec(I2C_SCRIPT_PAYLOAD_BYTES + 1, "SET_I2C_WITH_REG", &device.write_cmd, log_for_data_partition) != 0) {
+            printf("Error: the I2C passthrough is not available in this build\n");
+            shadow_free(shadow);
+            free(shadow);
+            i2c_script_free(&script);
+            return 1;
+        }
+        target = &device.target;
+    }
+
+    uint64_t start_us = vfctrl_get_time_us();
+    for (unsigned i=0; i<script.num_ops && ret==0; i++) {
+        ret = execute_op(target, shadow, &script.ops[i]);
+    }
+    double elapsed_ms = (vfctrl_get_time_us() - start_us) / 1000.0;
+
+    unsigned num_script_writes = 0;
+    for (unsigned i=0; i<script.num_ops; i++) {
+        if (script.ops[i].type == I2C_OP_WRITE) {
+            num_script_writes += script.ops[i].num_merged;
+        }
+    }
+    printf("%u statements: %u script writes sent as %u commands (%u bytes), %u reads",
+           num_script_ops, num_script_writes, target->num_writes, target->num_bytes, target->num_reads);
+    if (config->simulate) {
+        printf(", %u ms of delays\n", sim.delay_ms);
+        sim_print_map(&sim);
+    } else {
+        printf(" in %.1f ms\n", elapsed_ms);
+    }
+    shadow_free(shadow);
+    free(shadow);
+    i2c_script_free(&script);
+    return (ret != 0) ? 1 : 0;
+}
@@ -0,0 +1,67 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#ifndef I2C_SCRIPT_H
+#define I2C_SCRIPT_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// Payload of SET_I2C_WITH_REG and GET_I2C_WITH_REG: address, register, count and data
+#define I2C_SCRIPT_PAYLOAD_BYTES    (56) // I2C_MAX_CMD_SIZE, must match firmware
+#define I2C_SCRIPT_MAX_DATA_BYTES   (I2C_SCRIPT_PAYLOAD_BYTES - 3)
+#define I2C_SCRIPT_POLL_TIMEOUT_MS  (1000)
+
+// Register script, one statement per line, # and // start a comment:
+//   device ADDR                  7-bit address of the device accessed by the following lines
+//   page REG                     REG of the current device selects the register page
+//   volatile REG...              registers which change on their own, update always reads them
+//   write REG VALUE...           write VALUE... to consecutive registers from REG
+//   update REG MASK VALUE        read-modify-write, REG = (REG & ~MASK) | (VALUE & MASK)
+//   read REG [COUNT]             read and print COUNT registers from REG
+//   poll REG MASK VALUE [MS]     read REG until (REG & MASK) == VALUE, fail after MS ms
+//   delay MS
+// The lines of vfctrl command files, [path/vfctrl_usb] SET_I2C_WITH_REG ADDR REG COUNT DATA..., are writes.
+
+typedef enum {
+    I2C_OP_WRITE,
+    I2C_OP_UPDATE,
+    I2C_OP_READ,
+    I2C_OP_POLL,
+    I2C_OP_DELAY,
+    I2C_OP_PAGE,
+    I2C_OP_VOLATILE,
+} i2c_op_type_t;
+
+typedef struct {
+    uint8_t type;
+    uint8_t addr;
+    uint8_t reg;
+    uint8_t count;        // number of data bytes of a write, registers of a read
+    uint8_t mask;
+    uint8_t value;
+    unsigned time_ms;     // delay or poll timeout
+    unsigned line;        // script line, for the error messages
+    unsigned num_merged;  // number of script writes in a coalesced write
+    uint8_t data[I2C_SCRIPT_MAX_DATA_BYTES];
+} i2c_op_t;
+
+typedef struct {
+    i2c_op_t *ops;
+    unsigned num_ops;
+    unsigned max_ops;
+} i2c_script_t;
+
+typedef struct {
+    const char *script_file;
+    unsigned coalesce;        // merge the writes to contiguous registers
+    unsigned simulate;        // run on a simulated register map instead of the device
+} i2c_script_config_t;
+
+// Parse a script into ops. Returns 0 on success, the errors are printed with their line number.
+int i2c_script_compile(FILE *fp, i2c_script_t *script);
+// Merge the consecutive writes to contiguous registers of a device, up to I2C_SCRIPT_MAX_DATA_BYTES
+void i2c_script_coalesce(i2c_script_t *script);
+void i2c_script_free(i2c_script_t *script);
+
+int run_i2c_script(i2c_script_config_t *config, uint8_t log_for_data_partition);
+
+#endif
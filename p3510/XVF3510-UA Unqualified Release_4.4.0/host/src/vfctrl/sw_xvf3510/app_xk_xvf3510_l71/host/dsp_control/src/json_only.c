@@ -9,4 +9,3 @@ control_ret_t control_write_command(control_resid_t resid, control_cmd_t cmd,
                       const uint8_t payload[], size_t payload_len){
     return CONTROL_SUCCESS;
 };
-void host_shutdown(void) {};
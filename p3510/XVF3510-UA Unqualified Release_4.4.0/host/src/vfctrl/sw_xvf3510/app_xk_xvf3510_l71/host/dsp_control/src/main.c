@@ -3,12 +3,263 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <assert.h>
 #include "host_control_api.h"
+#include "watch.h"
+#include "profile.h"
+#include "filter_sim.h"
+#include "dp_capture.h"
+#include "i2c_script.h"
+#include "spi_stream.h"
+#include "autotune.h"
+#include "aec_ir.h"
 #include <math.h>
+#if defined(_MSC_VER)
+#include <io.h>
+#define isatty _isatty
+#define fileno _fileno
+#define dup _dup
+#define dup2 _dup2
+#define fdopen _fdopen
+#else
+#include <unistd.h>
+#endif
 
 #define MAX_NUM_ARGUMENTS (100)
-#define OUTPUT_STR_MAX_CHARS  (1000)
+#define BATCH_LINE_MAX_CHARS  (4096)
+#define APPLY_MAX_CMDS        (256)
+
+// Split a line into whitespace separated arguments, double quotes group an argument containing spaces.
+// Returns the number of arguments or -1 if there are too many.
+static int tokenize_line(char *line, char **args)
+{
+    int num_args = 0;
+    char *p = line;
+    while (1) {
+        while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n') {
+            p++;
+        }
+        if (*p == '\0' || *p == '#') {
+            break;
+        }
+        if (num_args == MAX_NUM_ARGUMENTS) {
+            return -1;
+        }
+        if (*p == '"') {
+            args[num_args++] = ++p;
+            while (*p != '\0' && *p != '"') {
+                p++;
+            }
+        } else {
+            args[num_args++] = p;
+            while (*p != '\0' && *p != ' ' && *p != '\t' && *p != '\r' && *p != '\n') {
+                p++;
+            }
+        }
+        if (*p == '\0') {
+            break;
+        }
+        *p++ = '\0';
+    }
+    return num_args;
+}
+
+// Run the commands read from fp one per line on a single connection to the device.
+// Each command prints a status line to out: "OK <name>[:<result>]" or "ERR <name> <code>".
+// Returns 0 if all the commands succeeded.
+static int run_batch(FILE *fp, FILE *out, unsigned interactive, uint8_t log_for_data_partition)
+{
+    static char line[BATCH_LINE_MAX_CHARS];
+    char output_string[MAX_OUTPUT_STR_CHARS];
+    char *args[MAX_NUM_ARGUMENTS];
+    unsigned line_num = 0;
+    unsigned num_errors = 0;
+
+    while (1) {
+        if (interactive) {
+            fprintf(stderr, "> ");
+            fflush(stderr);
+        }
+        if (fgets(line, sizeof(line), fp) == NULL) {
+            break;
+        }
+        line_num++;
+        size_t len = strlen(line);
+        if (len == sizeof(line) - 1 && line[len-1] != '\n' && !feof(fp)) {
+            int c;
+            while ((c = fgetc(fp)) != EOF && c != '\n');
+            fprintf(out, "ERR line %u is longer than %d characters\n", line_num, BATCH_LINE_MAX_CHARS - 1);
+            num_errors++;
+            continue;
+        }
+        int num_args = tokenize_line(line, args);
+        if (num_args < 0) {
+            fprintf(out, "ERR line %u has more than %d arguments\n", line_num, MAX_NUM_ARGUMENTS);
+            num_errors++;
+            continue;
+        }
+        if (num_args == 0) {
+            continue;
+        }
+        if (strcmp(args[0], "quit") == 0 || strcmp(args[0], "exit") == 0) {
+            break;
+        }
+
+        cmdspec_t cmd_spec;
+        int ret = vfctrl_get_cmdspec(num_args, args[0], &cmd_spec, log_for_data_partition);
+        if (ret == 0) {
+            ret = vfctrl_execute_command(&cmd_spec, (const char**)args, NULL, log_for_data_partition, output_string);
+        }
+        if (ret != 0) {
+            fprintf(out, "ERR %s %d\n", args[0], ret);
+            num_errors++;
+        } else if (output_string[0] != '\0') {
+            // keep one status line per command
+            for (char *c = output_string; *c != '\0'; c++) {
+                if (*c == '\n' || *c == '\r') {
+                    *c = ' ';
+                }
+            }
+            fprintf(out, "OK %s:%s\n", cmd_spec.par_name, output_string);
+        } else {
+            fprintf(out, "OK %s\n", cmd_spec.par_name);
+        }
+        fflush(out);
+    }
+    if (interactive) {
+        fprintf(stderr, "\n");
+    }
+    return (num_errors > 0) ? 1 : 0;
+}
+
+// Write the SET_ commands read from fp, skipping the ones the device already holds, and verify the written values.
+// With dry_run set, only print the commands which would be written.
+static int run_apply(FILE *fp, unsigned dry_run)
+{
+    static cmdspec_t cmd_specs[APPLY_MAX_CMDS];
+    static char *lines[APPLY_MAX_CMDS];
+    static char *args[APPLY_MAX_CMDS][MAX_NUM_ARGUMENTS];
+    static const char **cmd_args[APPLY_MAX_CMDS];
+    static int diff[APPLY_MAX_CMDS];
+    static cmdspec_t verify_specs[APPLY_MAX_CMDS];
+    static const char **verify_args[APPLY_MAX_CMDS];
+    static unsigned verify_idx[APPLY_MAX_CMDS];
+    char line[BATCH_LINE_MAX_CHARS];
+    char output_string[MAX_OUTPUT_STR_CHARS];
+    unsigned num_cmds = 0;
+    unsigned line_num = 0;
+    int ret = 0;
+
+    // parse the whole file first so nothing is written if it has errors
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        line_num++;
+        if (num_cmds == APPLY_MAX_CMDS) {
+            printf("Error: too many commands, max is %d\n", APPLY_MAX_CMDS);
+            ret = -1;
+            break;
+        }
+        lines[num_cmds] = strdup(line);
+        int n = tokenize_line(lines[num_cmds], args[num_cmds]);
+        if (n == 0) {
+            free(lines[num_cmds]);
+            continue;
+        }
+        if (n < 0 || vfctrl_get_cmdspec(n, args[num_cmds][0], &cmd_specs[num_cmds], 0) != 0) {
+            printf("Error: invalid command on line %u\n", line_num);
+            free(lines[num_cmds]);
+            ret = -1;
+            continue;
+        }
+        if (cmd_specs[num_cmds].rw != WRITE) {
+            printf("Error: %s on line %u is not a write command\n", cmd_specs[num_cmds].par_name, line_num);
+            free(lines[num_cmds]);
+            ret = -1;
+            continue;
+        }
+        cmd_args[num_cmds] = (const char **)args[num_cmds];
+        num_cmds++;
+    }
+
+    uint64_t start_us = vfctrl_get_time_us();
+    if (ret == 0) {
+        ret = vfctrl_diff_commands(cmd_specs, cmd_args, diff, num_cmds);
+        if (ret != 0) {
+            printf("Error: cannot read the current values from the device\n");
+        }
+    }
+    if (ret != 0) {
+        for (unsigned i=0; i<num_cmds; i++) {
+            free(lines[i]);
+        }
+        return ret;
+    }
+
+    unsigned num_written = 0;
+    unsigned num_unchanged = 0;
+    unsigned num_verify = 0;
+    for (unsigned i=0; i<num_cmds; i++) {
+        if (diff[i] == 0 || diff[i] == 2) {
+            printf("SKIP %s\n", cmd_specs[i].par_name);
+            num_unchanged++;
+            continue;
+        }
+        if (dry_run) {
+            printf("%s %s\n", (diff[i] == 1) ? "CHANGE" : "WRITE", cmd_specs[i].par_name);
+            continue;
+        }
+        ret = vfctrl_execute_command(&cmd_specs[i], (const char**)cmd_args[i], NULL, 0, output_string);
+        if (ret != 0) {
+            printf("ERR %s %d\n", cmd_specs[i].par_name, ret);
+            break;
+        }
+        printf("WRITE %s\n", cmd_specs[i].par_name);
+        num_written++;
+        if (diff[i] == 1) {
+            verify_specs[num_verify] = cmd_specs[i];
+            verify_args[num_verify] = cmd_args[i];
+            verify_idx[num_verify] = i;
+            num_verify++;
+        }
+    }
+
+    // read back the written values
+    unsigned num_mismatches = 0;
+    if (ret == 0 && num_verify > 0) {
+        ret = vfctrl_diff_commands(verify_specs, verify_args, diff, num_verify);
+        for (unsigned v=0; v<num_verify && ret==0; v++) {
+            if (diff[v] != 0) {
+                printf("ERR %s verify failed\n", cmd_specs[verify_idx[v]].par_name);
+                num_mismatches++;
+            }
+        }
+        if (ret != 0) {
+            printf("Error: cannot read back the written values\n");
+        }
+    }
+
+    double elapsed_ms = (vfctrl_get_time_us() - start_us) / 1000.0;
+    if (dry_run) {
+        printf("%u of %u commands to write, %u unchanged\n", num_cmds - num_unchanged, num_cmds, num_unchanged);
+    } else {
+        printf("Wrote %u of %u commands, %u unchanged, %u verified with %u mismatches in %.1f ms\n",
+                num_written, num_cmds, num_unchanged, num_verify, num_mismatches, elapsed_ms);
+    }
+    for (unsigned i=0; i<num_cmds; i++) {
+        free(lines[i]);
+    }
+    if (ret == 0 && num_mismatches > 0) {
+        ret = 1;
+    }
+    return ret;
+}
+
+// The app stops when the device cannot be opened or its firmware is not compatible
+static void check_version(void)
+{
+    int ret = vfctrl_check_version(0);
+    if (ret != 0) {
+        exit(ret);
+    }
+}
 
 int main(int argc, char **argv)
 {
@@ -28,6 +279,22 @@ int main(int argc, char **argv)
     vfctrl_set_product_id(XVF3510_PID_DEFAULT);
     char* final_argv[MAX_NUM_ARGUMENTS];
     int final_argc = 0;
+    watch_config_t watch_config = {NULL, WATCH_DEFAULT_RATE_HZ, 0, 0, NULL, WATCH_DEFAULT_RING_SIZE, NULL};
+    profile_config_t profile_config = {0, 1, PROFILE_FRAME_BUDGET_MS, PROFILE_DEFAULT_REPORT};
+    filter_sim_config_t filter_sim_config = {0, FILTER_SIM_DEFAULT_FS, NULL, NULL, NULL};
+    dp_capture_config_t dp_config = {NULL, DP_FORMAT_ITEMS, DP_CAPTURE_DEFAULT_SECTOR_SIZE, 0, NULL, NULL};
+    unsigned capture = 0;
+    i2c_script_config_t i2c_script_config = {NULL, 1, 0};
+    spi_stream_config_t spi_config = {NULL, -1, 0, NULL};
+    autotune_config_t autotune_config = {0, NULL, NULL, AUTOTUNE_DEFAULT_PASSES, AUTOTUNE_DEFAULT_JOBS,
+                                         AUTOTUNE_DEFAULT_WINDOW_MS, AUTOTUNE_DEFAULT_SETTLE_MS, AUTOTUNE_DEFAULT_LEVEL_DBFS, NULL};
+    aec_ir_config_t aec_ir_config = {NULL, 0, NULL};
+    const char *batch_file = NULL;
+    const char *apply_file = NULL;
+    unsigned dry_run = 0;
+    const char *snapshot_file = NULL;
+    unsigned freeze_adaptation = 0;
+    unsigned repl = 0;
     // look for optional arguments and store the other arguments in the reduce argument list
     for (int arg_idx=0; arg_idx<argc; arg_idx++) {
         if ( (strcmp(argv[arg_idx], "--no-check-version") == 0 ) || (strcmp(argv[arg_idx], "-n") == 0) ) {
@@ -39,6 +306,15 @@ int main(int argc, char **argv)
             log_for_data_partition = 1;
             continue;
         }
+        if (strcmp(argv[arg_idx], "--no-cache") == 0) {
+            vfctrl_set_attribute_cache(0);
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--stats") == 0) {
+            // print the read completion model however the app exits
+            atexit(vfctrl_print_poll_stats);
+            continue;
+        }
         if ( ( (strcmp(argv[arg_idx], "--product-id") == 0)  || (strcmp(argv[arg_idx], "-p") == 0 ) ) && arg_idx + 1 <= argc - 1 ) {
             int product_id = strtol(argv[arg_idx + 1], NULL, 0);
             printf("Setting product id 0x%04x\n", product_id);
@@ -53,11 +329,370 @@ int main(int argc, char **argv)
             arg_idx++;
             continue;
         }
+        if (strcmp(argv[arg_idx], "--watch") == 0 && arg_idx + 1 <= argc - 1) {
+            watch_config.cmd_list = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--rate") == 0 && arg_idx + 1 <= argc - 1) {
+            if (parse_watch_rate(argv[++arg_idx], &watch_config.rate_hz) != 0) {
+                exit(1);
+            }
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--duration") == 0 && arg_idx + 1 <= argc - 1) {
+            watch_config.duration_s = atof(argv[++arg_idx]);
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--samples") == 0 && arg_idx + 1 <= argc - 1) {
+            watch_config.num_samples = strtoul(argv[++arg_idx], NULL, 0);
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--output") == 0 && arg_idx + 1 <= argc - 1) {
+            watch_config.output_file = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--ring-size") == 0 && arg_idx + 1 <= argc - 1) {
+            watch_config.ring_size = strtoul(argv[++arg_idx], NULL, 0);
+            if (watch_config.ring_size == 0) {
+                printf("Error: --ring-size must be greater than 0\n");
+                exit(1);
+            }
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--csv") == 0 && arg_idx + 1 <= argc - 1) {
+            watch_config.csv_file = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--profile") == 0 && arg_idx + 1 <= argc - 1) {
+            profile_config.window_ms = strtoul(argv[++arg_idx], NULL, 0);
+            if (profile_config.window_ms == 0) {
+                printf("Error: --profile expects a window length in ms\n");
+                exit(1);
+            }
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--profile-windows") == 0 && arg_idx + 1 <= argc - 1) {
+            profile_config.num_windows = strtoul(argv[++arg_idx], NULL, 0);
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--frame-ms") == 0 && arg_idx + 1 <= argc - 1) {
+            profile_config.frame_budget_ms = atof(argv[++arg_idx]);
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--report") == 0 && arg_idx + 1 <= argc - 1) {
+            profile_config.report_file = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--filter-sim") == 0) {
+            filter_sim_config.enabled = 1;
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--fs") == 0 && arg_idx + 1 <= argc - 1) {
+            filter_sim_config.sample_rate = atof(argv[++arg_idx]);
+            if (filter_sim_config.sample_rate <= 0) {
+                printf("Error: --fs expects a sample rate in Hz\n");
+                exit(1);
+            }
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--wav-in") == 0 && arg_idx + 1 <= argc - 1) {
+            filter_sim_config.wav_in = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--wav-out") == 0 && arg_idx + 1 <= argc - 1) {
+            filter_sim_config.wav_out = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--response") == 0 && arg_idx + 1 <= argc - 1) {
+            filter_sim_config.response_file = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--capture") == 0) {
+            capture = 1;
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--dp-out") == 0 && arg_idx + 1 <= argc - 1) {
+            dp_config.output_file = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--dp-format") == 0 && arg_idx + 1 <= argc - 1) {
+            if (parse_dp_format(argv[++arg_idx], &dp_config.format) != 0) {
+                exit(1);
+            }
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--dp-sector-size") == 0 && arg_idx + 1 <= argc - 1) {
+            dp_config.sector_size = strtoul(argv[++arg_idx], NULL, 0);
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--dp-hardware-build") == 0 && arg_idx + 1 <= argc - 1) {
+            dp_config.hardware_build = strtoul(argv[++arg_idx], NULL, 0);
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--dp-spispec") == 0 && arg_idx + 1 <= argc - 1) {
+            dp_config.spispec_file = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--dp-version") == 0 && arg_idx + 1 <= argc - 1) {
+            dp_config.version = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--i2c-script") == 0 && arg_idx + 1 <= argc - 1) {
+            i2c_script_config.script_file = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--i2c-sim") == 0) {
+            i2c_script_config.simulate = 1;
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--no-coalesce") == 0) {
+            i2c_script_config.coalesce = 0;
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--spi-write") == 0 && arg_idx + 1 <= argc - 1) {
+            spi_config.write_file = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--spi-read") == 0 && arg_idx + 2 <= argc - 1) {
+            spi_config.read_address = strtol(argv[++arg_idx], NULL, 0);
+            spi_config.read_count = strtoul(argv[++arg_idx], NULL, 0);
+            if (spi_config.read_address < 0 || spi_config.read_address > 255) {
+                printf("Error: --spi-read expects an address from 0 to 255\n");
+                exit(1);
+            }
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--spi-out") == 0 && arg_idx + 1 <= argc - 1) {
+            spi_config.read_file = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--autotune") == 0) {
+            autotune_config.enabled = 1;
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--tune-params") == 0 && arg_idx + 1 <= argc - 1) {
+            autotune_config.param_list = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--tune-wav") == 0 && arg_idx + 1 <= argc - 1) {
+            autotune_config.wav_file = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--tune-passes") == 0 && arg_idx + 1 <= argc - 1) {
+            autotune_config.num_passes = atoi(argv[++arg_idx]);
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--tune-jobs") == 0 && arg_idx + 1 <= argc - 1) {
+            autotune_config.num_jobs = atoi(argv[++arg_idx]);
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--tune-window") == 0 && arg_idx + 1 <= argc - 1) {
+            autotune_config.window_ms = atoi(argv[++arg_idx]);
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--tune-settle") == 0 && arg_idx + 1 <= argc - 1) {
+            autotune_config.settle_ms = atoi(argv[++arg_idx]);
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--tune-level") == 0 && arg_idx + 1 <= argc - 1) {
+            autotune_config.level_dbfs = atof(argv[++arg_idx]);
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--tune-out") == 0 && arg_idx + 1 <= argc - 1) {
+            autotune_config.output_file = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--aec-ir") == 0 && arg_idx + 1 <= argc - 1) {
+            aec_ir_config.coeff_file = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--aec-ir-read") == 0) {
+            aec_ir_config.read_device = 1;
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--ir-out") == 0 && arg_idx + 1 <= argc - 1) {
+            aec_ir_config.ir_file = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--batch") == 0 && arg_idx + 1 <= argc - 1) {
+            batch_file = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--apply") == 0 && arg_idx + 1 <= argc - 1) {
+            apply_file = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--dry-run") == 0) {
+            dry_run = 1;
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--snapshot") == 0 && arg_idx + 1 <= argc - 1) {
+            snapshot_file = argv[++arg_idx];
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--freeze") == 0) {
+            freeze_adaptation = 1;
+            continue;
+        }
+        if (strcmp(argv[arg_idx], "--repl") == 0) {
+            repl = 1;
+            continue;
+        }
         // all the arguments not parsed above will be part of the final argument list
         final_argv[final_argc] = argv[arg_idx];
         final_argc++;
     }
 
+    if (filter_sim_config.enabled) {
+        // runs on the host only, no device is needed
+        exit(run_filter_sim(&filter_sim_config, final_argc - 1, &final_argv[1]));
+    }
+
+    if (autotune_config.enabled) {
+        // the simulator runs on the host only, no device is needed
+        if (autotune_config.wav_file == NULL && do_version_check) {
+            check_version();
+        }
+        exit(run_autotune(&autotune_config));
+    }
+
+    if (aec_ir_config.coeff_file != NULL || aec_ir_config.read_device) {
+        // recorded coefficients are analysed on the host only, no device is needed
+        if (aec_ir_config.coeff_file == NULL) {
+            aec_ir_config.coeff_file = AEC_IR_DEFAULT_FILE;
+        }
+        if (aec_ir_config.read_device && do_version_check) {
+            check_version();
+        }
+        exit(run_aec_ir(&aec_ir_config));
+    }
+
+    if (watch_config.cmd_list != NULL) {
+        if (do_version_check) {
+            check_version();
+        }
+        exit(run_watch(&watch_config));
+    }
+
+    if (profile_config.window_ms > 0) {
+        if (do_version_check) {
+            check_version();
+        }
+        exit(run_profile(&profile_config));
+    }
+
+    if (capture) {
+        if (do_version_check) {
+            check_version();
+        }
+        exit(run_dp_capture(&dp_config));
+    }
+
+    // the commands are logged for the data partition into the binary output
+    if (dp_config.output_file != NULL) {
+        log_for_data_partition = 1;
+        if (dp_capture_start(&dp_config) != 0) {
+            exit(1);
+        }
+    }
+
+    if (i2c_script_config.script_file != NULL) {
+        if (!i2c_script_config.simulate && do_version_check) {
+            check_version();
+        }
+        // the simulation runs on the host only, nothing is logged
+        int ret = run_i2c_script(&i2c_script_config, i2c_script_config.simulate ? 0 : log_for_data_partition);
+        if (ret == 0 && dp_config.output_file != NULL && dp_capture_finish(&dp_config) != 0) {
+            ret = 1;
+        }
+        exit(ret);
+    }
+
+    if (spi_config.write_file != NULL || spi_config.read_address >= 0) {
+        if (!log_for_data_partition && do_version_check) {
+            check_version();
+        }
+        int ret = run_spi_stream(&spi_config, log_for_data_partition);
+        if (ret == 0 && dp_config.output_file != NULL && dp_capture_finish(&dp_config) != 0) {
+            ret = 1;
+        }
+        exit(ret);
+    }
+
+    if (snapshot_file != NULL) {
+        if (do_version_check) {
+            check_version();
+        }
+        exit(vfctrl_dump_snapshot(snapshot_file, freeze_adaptation));
+    }
+
+    if (apply_file != NULL) {
+        if (log_for_data_partition) {
+            printf("Error: --apply compares the commands with the device values and cannot be used to log the data partition\n");
+            exit(1);
+        }
+        FILE *fp = stdin;
+        if (strcmp(apply_file, "-") != 0) {
+            fp = fopen(apply_file, "r");
+            if (fp == NULL) {
+                printf("Error: cannot open %s\n", apply_file);
+                exit(1);
+            }
+        }
+        if (do_version_check) {
+            check_version();
+        }
+        ret = run_apply(fp, dry_run);
+        if (fp != stdin) {
+            fclose(fp);
+        }
+        exit(ret);
+    }
+
+    if (batch_file != NULL || repl) {
+        FILE *fp = stdin;
+        FILE *out = stdout;
+        // the status lines keep stdout, the diagnostics printed by the library go to stderr,
+        // unless stdout is where the data partition items are logged
+        if (!log_for_data_partition) {
+            fflush(stdout);
+            out = fdopen(dup(fileno(stdout)), "w");
+            if (out == NULL || dup2(fileno(stderr), fileno(stdout)) < 0) {
+                fprintf(stderr, "Error: cannot redirect the diagnostics to stderr\n");
+                exit(1);
+            }
+        }
+        if (batch_file != NULL && strcmp(batch_file, "-") != 0) {
+            fp = fopen(batch_file, "r");
+            if (fp == NULL) {
+                printf("Error: cannot open %s\n", batch_file);
+                exit(1);
+            }
+        }
+        // connect and check the device once for all the commands
+        if (!log_for_data_partition) {
+            if (do_version_check) {
+                check_version();
+            }
+            cmdspec_t cmd;
+            if (vfctrl_get_cmdspec(1, "GET_RUN_STATUS", &cmd, 0) == 0 && vfctrl_check_run_status(cmd)) {
+                printf("Error: Cannot read run status\n");
+                exit(1);
+            }
+        }
+        ret = run_batch(fp, out, repl && isatty(fileno(fp)), log_for_data_partition);
+        if (fp != stdin) {
+            fclose(fp);
+        }
+        if (out != stdout) {
+            fclose(out);
+        }
+        if (ret == 0 && dp_capture_finish(&dp_config) != 0) {
+            ret = 1;
+        }
+        exit(ret);
+    }
+
     if (final_argc < 2) {
         vfctrl_print_help(0);
         vfctrl_check_version(1);
@@ -81,10 +716,7 @@ int main(int argc, char **argv)
     }
 
     if (do_version_check && !log_for_data_partition) {
-        ret = vfctrl_check_version(0);
-        if (ret) {
-            printf("Error: Cannot read device version\n");
-        }
+        check_version();
     }
 
     if (!log_for_data_partition) {
@@ -98,39 +730,24 @@ int main(int argc, char **argv)
         ret = vfctrl_check_run_status(cmd);
         if (ret) {
             printf("Error: Cannot read run status\n");
+            exit(ret);
         }
     }
 
-    //sanity check final_argv
-    if(cmd_spec.rw == WRITE)
+    char* output_string = calloc(MAX_OUTPUT_STR_CHARS, 1);
+    ret = vfctrl_execute_command(&cmd_spec, (const char**)&final_argv[1], NULL, log_for_data_partition, output_string);
+    if(ret != 0)
     {
-        assert(cmd_spec.num_values == (final_argc - 2));
+        printf("vfctrl_do_command() returned error\n");
     }
-
-    //allocate memory for do_command
-    void* data_out_ptr = calloc(cmd_spec.app_read_result_size, 1);
-    char* output_string = calloc(OUTPUT_STR_MAX_CHARS, 1);
-
-    if (strcmp("GET_FILTER_COEFFICIENTS_AEC", cmd_spec.par_name) == 0) {
-        ret = vfctrl_get_aec_coefficients_to_file("aec_coefficients.py");
-    } else if (strcmp("GET_FILTER_COEFFICIENTS_IC", cmd_spec.par_name) == 0) {
-        ret = vfctrl_get_ic_coefficients_to_file("ic_coefficients.py");
-    } else if (strcmp("GET_FILTER_COEFF", cmd_spec.par_name) == 0) {
-        ret = vfctrl_get_filter_coefficients_human_readable(&cmd_spec);
-    } else if (strcmp("SET_FILTER_COEFF", cmd_spec.par_name) == 0) {
-        ret = vfctrl_set_filter_coefficients_human_readable(&cmd_spec, (const char**)&final_argv[1], log_for_data_partition);
-    } else {
-        ret = vfctrl_do_command(&cmd_spec, (const char**)&final_argv[1], data_out_ptr, log_for_data_partition);
-        if(!ret && (cmd_spec.rw == READ)){
-            vfctrl_format_read_result(&cmd_spec, data_out_ptr, output_string);
-            printf("%s\n", output_string);
-        }
+    else if (output_string[0] != '\0')
+    {
+        printf("%s:%s\n", cmd_spec.par_name, output_string);
     }
-    if(ret != 0)
+    else if (dp_capture_finish(&dp_config) != 0)
     {
-        printf("vfctrl_do_command() returned error\n");
+        ret = 1;
     }
-    free(data_out_ptr);
     free(output_string);
     exit(ret);
 }
@@ -0,0 +1,236 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+// Audio pipeline timing profiler built on the per-stage frame time counters
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "host_control_api.h"
+#include "profile.h"
+
+#define NUM_STAGES          (3)
+#define NUM_SEGMENTS        (5)
+#define SEGMENT_IDLE        (4)
+#define NUM_PROFILE_CMDS    (NUM_STAGES * NUM_SEGMENTS * 2 + 1)
+#define FLAME_WIDTH         (60)
+
+static const char *stage_names[NUM_STAGES] = {"A", "B", "C"};
+static const char *segment_names[NUM_SEGMENTS] = {"RX", "CONTROL", "DSP", "TX", "IDLE"};
+static const char segment_symbols[NUM_SEGMENTS] = {'R', 'C', 'D', 'T', '.'};
+
+typedef struct {
+    uint32_t min[NUM_SEGMENTS];
+    uint32_t max[NUM_SEGMENTS];
+    unsigned valid;
+} stage_times_t;
+
+static int do_write(const char *name, const char *value)
+{
+    cmdspec_t cmd;
+    const char *argv[2] = {name, value};
+    int ret = vfctrl_get_cmdspec(2, name, &cmd, 0);
+    if (ret != 0) {
+        return ret;
+    }
+    ret = vfctrl_do_command(&cmd, argv, NULL, 0);
+    if (ret != 0) {
+        fprintf(stderr, "Error: %s failed (%d)\n", name, ret);
+    }
+    return ret;
+}
+
+static int reset_counters(void)
+{
+    char name[MAX_PAR_NAME_CHARS];
+    for (unsigned s=0; s<NUM_STAGES; s++) {
+        snprintf(name, sizeof(name), "RESET_TIME_STAGE_%s", stage_names[s]);
+        if (do_write(name, "1") != 0) {
+            return -1;
+        }
+    }
+    return do_write("RESET_MAX_UBM_CYCLES", "1");
+}
+
+static double ticks_to_ms(uint64_t ticks)
+{
+    return (double)ticks / PROFILE_TICKS_PER_MS;
+}
+
+static void print_flame_bar(stage_times_t *stage, double budget_ticks)
+{
+    char bar[FLAME_WIDTH + 1];
+    unsigned pos = 0;
+    // the busy segments use their worst case, whatever is left of the frame is idle
+    for (unsigned seg=0; seg<SEGMENT_IDLE; seg++) {
+        unsigned width = (unsigned)((stage->max[seg] * FLAME_WIDTH) / budget_ticks + 0.5);
+        for (unsigned i=0; i<width && pos<FLAME_WIDTH; i++) {
+            bar[pos++] = segment_symbols[seg];
+        }
+    }
+    while (pos < FLAME_WIDTH) {
+        bar[pos++] = segment_symbols[SEGMENT_IDLE];
+    }
+    bar[FLAME_WIDTH] = '\0';
+    printf("|%s|", bar);
+}
+
+static int write_report(profile_config_t *config, stage_times_t stages[], uint32_t max_ubm_cycles, double budget_ticks)
+{
+    FILE *fp = fopen(config->report_file, "w");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: cannot open %s\n", config->report_file);
+        return -1;
+    }
+    fprintf(fp, "{\n");
+    fprintf(fp, "    \"window_ms\": %u,\n", config->window_ms);
+    fprintf(fp, "    \"num_windows\": %u,\n", config->num_windows);
+    fprintf(fp, "    \"frame_budget_ms\": %.3f,\n", config->frame_budget_ms);
+    fprintf(fp, "    \"ticks_per_ms\": %d,\n", PROFILE_TICKS_PER_MS);
+    fprintf(fp, "    \"max_ubm_cycles\": %u,\n", max_ubm_cycles);
+    fprintf(fp, "    \"stages\": {\n");
+    for (unsigned s=0; s<NUM_STAGES; s++) {
+        stage_times_t *stage = &stages[s];
+        uint64_t busy_max = 0;
+        uint64_t busy_min = 0;
+        fprintf(fp, "        \"%s\": {\n", stage_names[s]);
+        fprintf(fp, "            \"valid\": %s,\n", stage->valid ? "true" : "false");
+        for (unsigned seg=0; seg<NUM_SEGMENTS; seg++) {
+            fprintf(fp, "            \"%s\": {\"min_ticks\": %u, \"max_ticks\": %u},\n",
+                    segment_names[seg], stage->min[seg], stage->max[seg]);
+            if (seg != SEGMENT_IDLE) {
+                busy_max += stage->max[seg];
+                busy_min += stage->min[seg];
+            }
+        }
+        fprintf(fp, "            \"busy_min_ms\": %.4f,\n", ticks_to_ms(busy_min));
+        fprintf(fp, "            \"busy_max_ms\": %.4f,\n", ticks_to_ms(busy_max));
+        fprintf(fp, "            \"utilization_max\": %.4f,\n", busy_max / budget_ticks);
+        fprintf(fp, "            \"idle_min_ms\": %.4f,\n", ticks_to_ms(stage->min[SEGMENT_IDLE]));
+        fprintf(fp, "            \"headroom_min\": %.4f\n", stage->min[SEGMENT_IDLE] / budget_ticks);
+        fprintf(fp, "        }%s\n", (s == NUM_STAGES-1) ? "" : ",");
+    }
+    fprintf(fp, "    }\n");
+    fprintf(fp, "}\n");
+    fclose(fp);
+    return 0;
+}
+
+int run_profile(profile_config_t *config)
+{
+    cmdspec_t cmd_specs[NUM_PROFILE_CMDS];
+    uint32_t results[NUM_PROFILE_CMDS];
+    void *data_out_ptrs[NUM_PROFILE_CMDS];
+    int cmd_ret[NUM_PROFILE_CMDS];
+    stage_times_t stages[NUM_STAGES];
+    uint32_t max_ubm_cycles = 0;
+    double budget_ticks = config->frame_budget_ms * PROFILE_TICKS_PER_MS;
+    char name[MAX_PAR_NAME_CHARS];
+
+    // GET_MIN_<segment>_TIME_STAGE_<stage> and GET_MAX_<segment>_TIME_STAGE_<stage>, then GET_MAX_UBM_CYCLES
+    unsigned num_cmds = 0;
+    for (unsigned s=0; s<NUM_STAGES; s++) {
+        for (unsigned seg=0; seg<NUM_SEGMENTS; seg++) {
+            for (unsigned is_max=0; is_max<2; is_max++) {
+                snprintf(name, sizeof(name), "GET_%s_%s_TIME_STAGE_%s", is_max ? "MAX" : "MIN", segment_names[seg], stage_names[s]);
+                if (vfctrl_get_cmdspec(1, name, &cmd_specs[num_cmds], 0) != 0) {
+                    return -1;
+                }
+                num_cmds++;
+            }
+        }
+    }
+    if (vfctrl_get_cmdspec(1, "GET_MAX_UBM_CYCLES", &cmd_specs[num_cmds], 0) != 0) {
+        return -1;
+    }
+    num_cmds++;
+    for (unsigned i=0; i<num_cmds; i++) {
+        data_out_ptrs[i] = &results[i];
+    }
+    for (unsigned s=0; s<NUM_STAGES; s++) {
+        memset(&stages[s], 0, sizeof(stage_times_t));
+        for (unsigned seg=0; seg<NUM_SEGMENTS; seg++) {
+            stages[s].min[seg] = UINT32_MAX;
+        }
+    }
+
+    for (unsigned w=0; w<config->num_windows; w++) {
+        if (reset_counters() != 0) {
+            return -1;
+        }
+        printf("\rProfiling window %u / %u (%u ms)", w+1, config->num_windows, config->window_ms);
+        fflush(stdout);
+        vfctrl_sleep_us(config->window_ms * 1000);
+        int ret = vfctrl_do_read_commands(cmd_specs, data_out_ptrs, cmd_ret, num_cmds);
+        if (ret != 0) {
+            printf("\n");
+            fprintf(stderr, "Error: cannot read the stage timings (%d)\n", ret);
+            return ret;
+        }
+        // keep the worst case over all the windows
+        unsigned i = 0;
+        for (unsigned s=0; s<NUM_STAGES; s++) {
+            for (unsigned seg=0; seg<NUM_SEGMENTS; seg++) {
+                uint32_t min_val = results[i++];
+                uint32_t max_val = results[i++];
+                // a stage which did not process a frame since the reset reports min above max
+                if (min_val > max_val) {
+                    continue;
+                }
+                stages[s].valid = 1;
+                if (min_val < stages[s].min[seg]) stages[s].min[seg] = min_val;
+                if (max_val > stages[s].max[seg]) stages[s].max[seg] = max_val;
+            }
+        }
+        if (results[i] > max_ubm_cycles) {
+            max_ubm_cycles = results[i];
+        }
+    }
+    printf("\n\n");
+
+    printf("Frame budget %.2f ms, worst case over %u window(s) of %u ms\n", config->frame_budget_ms, config->num_windows, config->window_ms);
+    printf("Legend: ");
+    for (unsigned seg=0; seg<NUM_SEGMENTS; seg++) {
+        printf("%c %s  ", segment_symbols[seg], segment_names[seg]);
+    }
+    printf("\n\n");
+
+    int tightest_stage = -1;
+    for (unsigned s=0; s<NUM_STAGES; s++) {
+        stage_times_t *stage = &stages[s];
+        for (unsigned seg=0; seg<NUM_SEGMENTS; seg++) {
+            if (stage->min[seg] == UINT32_MAX) {
+                stage->min[seg] = 0;
+            }
+        }
+        if (!stage->valid) {
+            printf("Stage %s: no frames processed during the window\n", stage_names[s]);
+            continue;
+        }
+        uint64_t busy_max = 0;
+        for (unsigned seg=0; seg<SEGMENT_IDLE; seg++) {
+            busy_max += stage->max[seg];
+        }
+        printf("Stage %s ", stage_names[s]);
+        print_flame_bar(stage, budget_ticks);
+        printf(" %5.1f%% busy, %5.1f%% idle headroom\n", 100.0 * busy_max / budget_ticks, 100.0 * stage->min[SEGMENT_IDLE] / budget_ticks);
+        for (unsigned seg=0; seg<NUM_SEGMENTS; seg++) {
+            printf("    %-8s min %7.3f ms  max %7.3f ms  (%5.1f%% of frame)\n", segment_names[seg],
+                    ticks_to_ms(stage->min[seg]), ticks_to_ms(stage->max[seg]), 100.0 * stage->max[seg] / budget_ticks);
+        }
+        if (tightest_stage < 0 || stage->min[SEGMENT_IDLE] < stages[tightest_stage].min[SEGMENT_IDLE]) {
+            tightest_stage = s;
+        }
+    }
+    printf("\nMax user buffer management cycles: %u\n", max_ubm_cycles);
+    if (tightest_stage >= 0) {
+        printf("Least headroom: stage %s with %.3f ms (%.1f%% of the frame) idle in the worst frame\n",
+                stage_names[tightest_stage], ticks_to_ms(stages[tightest_stage].min[SEGMENT_IDLE]),
+                100.0 * stages[tightest_stage].min[SEGMENT_IDLE] / budget_ticks);
+    }
+
+    if (write_report(config, stages, max_ubm_cycles, budget_ticks) != 0) {
+        return -1;
+    }
+    printf("Report written to %s\n", config->report_file);
+    return 0;
+}
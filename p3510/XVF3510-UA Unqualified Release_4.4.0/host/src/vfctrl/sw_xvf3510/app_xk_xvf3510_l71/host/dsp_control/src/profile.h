@@ -0,0 +1,20 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#ifndef PROFILE_H
+#define PROFILE_H
+
+// Timing values are reported in ticks of the 100 MHz reference clock
+#define PROFILE_TICKS_PER_MS      (100000)
+// Each stage processes a frame of 240 samples at 16 kHz
+#define PROFILE_FRAME_BUDGET_MS   (15.0)
+#define PROFILE_DEFAULT_REPORT    "vfctrl_profile.json"
+
+typedef struct {
+    unsigned window_ms;       // time to sample for after resetting the counters
+    unsigned num_windows;     // the worst case over all the windows is reported
+    double frame_budget_ms;
+    const char *report_file;  // JSON report
+} profile_config_t;
+
+int run_profile(profile_config_t *config);
+
+#endif
@@ -0,0 +1,162 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#include <math.h>
+#include "qformat.h"
+
+// QFORMAT_SCALAR builds only the scalar loops. The NEON kernels have not been run on an
+// ARM host yet, they are only built with QFORMAT_ENABLE_NEON.
+#if defined(QFORMAT_SCALAR)
+// no vector kernels
+#elif defined(__AVX2__)
+#include <immintrin.h>
+#define QFORMAT_AVX2 1
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define QFORMAT_SSE2 1
+#elif (defined(__ARM_NEON) || defined(__ARM_NEON__)) && defined(QFORMAT_ENABLE_NEON)
+#include <arm_neon.h>
+#define QFORMAT_NEON 1
+#endif
+
+const char *qformat_kernel_name(void)
+{
+#if QFORMAT_AVX2
+    return "avx2";
+#elif QFORMAT_SSE2
+    return "sse2";
+#elif QFORMAT_NEON
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+// Multiplying by a power of two is exact, so scaling after the conversion rounds
+// exactly like the scalar division by (1 << frac_bits).
+static float pow2f(int exponent)
+{
+    return (float)ldexp(1.0, exponent);
+}
+
+void qformat_q_to_float(const int32_t *in, float *out, size_t n, unsigned frac_bits)
+{
+    const float scale = pow2f(-(int)frac_bits);
+    size_t i = 0;
+#if QFORMAT_AVX2
+    const __m256 scale_v = _mm256_set1_ps(scale);
+    for (; i + 8 <= n; i += 8) {
+        __m256i q = _mm256_loadu_si256((const __m256i *)&in[i]);
+        _mm256_storeu_ps(&out[i], _mm256_mul_ps(_mm256_cvtepi32_ps(q), scale_v));
+    }
+#elif QFORMAT_SSE2
+    const __m128 scale_v = _mm_set1_ps(scale);
+    for (; i + 4 <= n; i += 4) {
+        __m128i q = _mm_loadu_si128((const __m128i *)&in[i]);
+        _mm_storeu_ps(&out[i], _mm_mul_ps(_mm_cvtepi32_ps(q), scale_v));
+    }
+#elif QFORMAT_NEON
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(&out[i], vmulq_n_f32(vcvtq_f32_s32(vld1q_s32(&in[i])), scale));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = (float)in[i] * scale;
+    }
+}
+
+void qformat_uq_to_float(const uint32_t *in, float *out, size_t n, unsigned frac_bits)
+{
+    const float scale = pow2f(-(int)frac_bits);
+    size_t i = 0;
+#if QFORMAT_AVX2 || QFORMAT_SSE2
+    // x86 only converts signed integers: convert the two 16-bit halves exactly
+    // and let the sum do the single rounding of the unsigned conversion
+#if QFORMAT_AVX2
+    const __m256 scale_v = _mm256_set1_ps(scale);
+    const __m256 hi_scale = _mm256_set1_ps(65536.0f);
+    const __m256i lo_mask = _mm256_set1_epi32(0xffff);
+    for (; i + 8 <= n; i += 8) {
+        __m256i q = _mm256_loadu_si256((const __m256i *)&in[i]);
+        __m256 hi = _mm256_mul_ps(_mm256_cvtepi32_ps(_mm256_srli_epi32(q, 16)), hi_scale);
+        __m256 lo = _mm256_cvtepi32_ps(_mm256_and_si256(q, lo_mask));
+        _mm256_storeu_ps(&out[i], _mm256_mul_ps(_mm256_add_ps(hi, lo), scale_v));
+    }
+#else
+    const __m128 scale_v = _mm_set1_ps(scale);
+    const __m128 hi_scale = _mm_set1_ps(65536.0f);
+    const __m128i lo_mask = _mm_set1_epi32(0xffff);
+    for (; i + 4 <= n; i += 4) {
+        __m128i q = _mm_loadu_si128((const __m128i *)&in[i]);
+        __m128 hi = _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(q, 16)), hi_scale);
+        __m128 lo = _mm_cvtepi32_ps(_mm_and_si128(q, lo_mask));
+        _mm_storeu_ps(&out[i], _mm_mul_ps(_mm_add_ps(hi, lo), scale_v));
+    }
+#endif
+#elif QFORMAT_NEON
+    for (; i + 4 <= n; i += 4) {
+        vst1q_f32(&out[i], vmulq_n_f32(vcvtq_f32_u32(vld1q_u32(&in[i])), scale));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = (float)in[i] * scale;
+    }
+}
+
+void qformat_q_to_double(const int32_t *in, double *out, size_t n, int exponent)
+{
+    size_t i = 0;
+    // outside of this range the scaled values could be denormal or overflow
+    if (exponent < -1022 + 31 || exponent > 1023 - 31) {
+        for (; i < n; i++) {
+            out[i] = ldexp((double)in[i], exponent);
+        }
+        return;
+    }
+    const double scale = ldexp(1.0, exponent);
+#if QFORMAT_AVX2
+    const __m256d scale_v = _mm256_set1_pd(scale);
+    for (; i + 4 <= n; i += 4) {
+        __m128i q = _mm_loadu_si128((const __m128i *)&in[i]);
+        _mm256_storeu_pd(&out[i], _mm256_mul_pd(_mm256_cvtepi32_pd(q), scale_v));
+    }
+#elif QFORMAT_SSE2
+    const __m128d scale_v = _mm_set1_pd(scale);
+    for (; i + 2 <= n; i += 2) {
+        __m128i q = _mm_loadl_epi64((const __m128i *)&in[i]);
+        _mm_storeu_pd(&out[i], _mm_mul_pd(_mm_cvtepi32_pd(q), scale_v));
+    }
+#elif QFORMAT_NEON && defined(__aarch64__)
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t d = vcvtq_f64_s64(vmovl_s32(vld1_s32(&in[i])));
+        vst1q_f64(&out[i], vmulq_n_f64(d, scale));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = (double)in[i] * scale;
+    }
+}
+
+void qformat_float_to_q(const float *in, int32_t *out, size_t n, unsigned frac_bits)
+{
+    const float scale = pow2f((int)frac_bits);
+    size_t i = 0;
+#if QFORMAT_AVX2
+    const __m256 scale_v = _mm256_set1_ps(scale);
+    for (; i + 8 <= n; i += 8) {
+        __m256 f = _mm256_mul_ps(_mm256_loadu_ps(&in[i]), scale_v);
+        _mm256_storeu_si256((__m256i *)&out[i], _mm256_cvttps_epi32(f));
+    }
+#elif QFORMAT_SSE2
+    const __m128 scale_v = _mm_set1_ps(scale);
+    for (; i + 4 <= n; i += 4) {
+        __m128 f = _mm_mul_ps(_mm_loadu_ps(&in[i]), scale_v);
+        _mm_storeu_si128((__m128i *)&out[i], _mm_cvttps_epi32(f));
+    }
+#elif QFORMAT_NEON
+    for (; i + 4 <= n; i += 4) {
+        vst1q_s32(&out[i], vcvtq_s32_f32(vmulq_n_f32(vld1q_f32(&in[i]), scale)));
+    }
+#endif
+    for (; i < n; i++) {
+        out[i] = (int32_t)(in[i] * scale);
+    }
+}
@@ -0,0 +1,28 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#ifndef QFORMAT_H
+#define QFORMAT_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Bulk conversions between fixed point arrays and floating point.
+// The kernels use AVX2 or SSE2 when the compiler targets them and give the same
+// results as the scalar conversions: out = in * 2^exponent, with a single rounding.
+// NEON is used when QFORMAT_ENABLE_NEON is defined too. test/qformat_test.c checks each kernel.
+
+// Name of the kernels selected at compile time, for diagnostics
+const char *qformat_kernel_name(void);
+
+// Signed and unsigned Q(frac_bits) to float, as (float)in[i] / (1 << frac_bits)
+void qformat_q_to_float(const int32_t *in, float *out, size_t n, unsigned frac_bits);
+void qformat_uq_to_float(const uint32_t *in, float *out, size_t n, unsigned frac_bits);
+
+// Mantissa array with a shared exponent to double, as ldexp(in[i], exponent).
+// Exponents outside of [-1022 + 31, 1023 - 31] fall back to ldexp.
+void qformat_q_to_double(const int32_t *in, double *out, size_t n, int exponent);
+
+// Float to signed Q(frac_bits), truncating towards zero as (int32_t)(in[i] * (1 << frac_bits)).
+// As with the scalar cast, the result for values out of the int32 range is not defined.
+void qformat_float_to_q(const float *in, int32_t *out, size_t n, unsigned frac_bits);
+
+#endif
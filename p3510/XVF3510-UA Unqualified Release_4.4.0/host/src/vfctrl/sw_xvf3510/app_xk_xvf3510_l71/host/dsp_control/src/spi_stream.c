@@ -0,0 +1,102 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+// SPI passthrough transfers of any length from the command line
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host_control_api.h"
+#include "spi_stream.h"
+
+#define SPI_HEX_BYTES_PER_LINE  (16)
+
+static uint8_t *read_all(const char *filename, unsigned *num_bytes)
+{
+    FILE *fp = stdin;
+    if (strcmp(filename, "-") != 0) {
+        fp = fopen(filename, "rb");
+        if (fp == NULL) {
+            printf("Error: cannot open %s\n", filename);
+            return NULL;
+        }
+    }
+    unsigned max_bytes = 4096;
+    uint8_t *data = malloc(max_bytes);
+    *num_bytes = 0;
+    size_t n;
+    while ((n = fread(&data[*num_bytes], 1, max_bytes - *num_bytes, fp)) > 0) {
+        *num_bytes += n;
+        if (*num_bytes == max_bytes) {
+            max_bytes *= 2;
+            data = realloc(data, max_bytes);
+        }
+    }
+    if (fp != stdin) {
+        fclose(fp);
+    }
+    return data;
+}
+
+static void print_throughput(void)
+{
+    vfctrl_spi_stats_t stats;
+    vfctrl_get_spi_stats(&stats);
+    if (stats.num_commands == 0) {
+        return;
+    }
+    double busy_s = stats.busy_us / 1e6;
+    double total_bytes = (double)(stats.bytes_written + stats.bytes_read);
+    printf("%.0f bytes in %u commands, %.3f s, %.1f kB/s", total_bytes, stats.num_commands, busy_s,
+           (busy_s > 0) ? total_bytes / busy_s / 1000 : 0);
+    if (stats.num_retries > 0) {
+        printf(", %u retries on a full device queue", stats.num_retries);
+    }
+    printf("\n");
+}
+
+int run_spi_stream(spi_stream_config_t *config, uint8_t log_for_data_partition)
+{
+    int ret = 0;
+    vfctrl_reset_spi_stats();
+    if (config->write_file != NULL) {
+        unsigned num_bytes;
+        uint8_t *data = read_all(config->write_file, &num_bytes);
+        if (data == NULL) {
+            return 1;
+        }
+        ret = vfctrl_spi_write(data, num_bytes, log_for_data_partition);
+        free(data);
+        if (ret == -2) {
+            printf("Error: the SPI passthrough is not available in this build\n");
+        }
+    }
+    if (ret == 0 && config->read_address >= 0) {
+        if (log_for_data_partition) {
+            printf("Error: SPI reads cannot be logged for the data partition\n");
+            return 1;
+        }
+        uint8_t *data = malloc(config->read_count + 1);
+        ret = vfctrl_spi_read((uint8_t)config->read_address, data, config->read_count);
+        if (ret == 0 && config->read_file != NULL) {
+            FILE *fp = fopen(config->read_file, "wb");
+            if (fp == NULL || fwrite(data, 1, config->read_count, fp) != config->read_count) {
+                printf("Error: cannot write %s\n", config->read_file);
+                ret = 1;
+            }
+            if (fp != NULL) {
+                fclose(fp);
+            }
+        } else if (ret == 0) {
+            for (unsigned i=0; i<config->read_count; i++) {
+                printf("%s%02x", (i % SPI_HEX_BYTES_PER_LINE == 0) ? "" : " ", data[i]);
+                if (i % SPI_HEX_BYTES_PER_LINE == SPI_HEX_BYTES_PER_LINE - 1 || i == config->read_count - 1) {
+                    printf("\n");
+                }
+            }
+        }
+        free(data);
+    }
+    if (!log_for_data_partition) {
+        print_throughput();
+    }
+    return (ret != 0) ? 1 : 0;
+}
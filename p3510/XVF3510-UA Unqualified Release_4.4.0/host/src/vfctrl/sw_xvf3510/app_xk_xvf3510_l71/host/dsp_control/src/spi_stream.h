@@ -0,0 +1,16 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#ifndef SPI_STREAM_H
+#define SPI_STREAM_H
+
+#include <stdint.h>
+
+typedef struct {
+    const char *write_file;   // bytes written as one SPI transaction, - for stdin
+    int read_address;         // -1 if nothing is read
+    unsigned read_count;
+    const char *read_file;    // binary output of the read, printed as hex if not given
+} spi_stream_config_t;
+
+int run_spi_stream(spi_stream_config_t *config, uint8_t log_for_data_partition);
+
+#endif
@@ -0,0 +1,289 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+// Sample a set of GET_ commands at a fixed rate and stream them to a time-series file
+
+// the ring buffer file can be larger than 2GB, off_t is 64 bits on the 32-bit hosts too
+#define _FILE_OFFSET_BITS 64
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <signal.h>
+#include <time.h>
+#include "host_control_api.h"
+#include "watch.h"
+
+#define WATCH_MAX_CMDS      (64)
+#define WATCH_MAX_CHANNELS  (256)
+#define WATCH_MAX_RATE_HZ   (1000000.0) // the ticks are counted in microseconds
+
+static volatile sig_atomic_t watch_stop = 0;
+
+static void watch_signal_handler(int sig)
+{
+    (void)sig;
+    watch_stop = 1;
+}
+
+// Accepts "50Hz", "50hz" or "50"
+int parse_watch_rate(const char *rate_str, double *rate_hz)
+{
+    char *end;
+    double rate = strtod(rate_str, &end);
+    if (end == rate_str || (*end != '\0' && strcmp(end, "Hz") != 0 && strcmp(end, "hz") != 0) || rate <= 0) {
+        fprintf(stderr, "Error: invalid rate %s, expected a value like 50Hz\n", rate_str);
+        return -1;
+    }
+    if (rate > WATCH_MAX_RATE_HZ) {
+        fprintf(stderr, "Error: rate %s is above the maximum of %.0fHz\n", rate_str, WATCH_MAX_RATE_HZ);
+        return -1;
+    }
+    *rate_hz = rate;
+    return 0;
+}
+
+static unsigned get_value_bytes(param_type type)
+{
+    switch (type) {
+        case TYPE_INT8:
+        case TYPE_UINT8:
+            return 1;
+        case TYPE_INT64:
+        case TYPE_UINT64:
+            return 8;
+        default:
+            return 4;
+    }
+}
+
+static double get_value(param_type type, void *data, unsigned i)
+{
+    switch (type) {
+        case TYPE_INT8:
+            return ((int8_t*)data)[i];
+        case TYPE_UINT8:
+            return ((uint8_t*)data)[i];
+        case TYPE_INT32:
+            return ((int32_t*)data)[i];
+        case TYPE_UINT32:
+        case TYPE_TICKS:
+            return ((uint32_t*)data)[i];
+        case TYPE_INT64:
+            return (double)((int64_t*)data)[i];
+        case TYPE_UINT64:
+            return (double)((uint64_t*)data)[i];
+        default:
+            return ((float*)data)[i];
+    }
+}
+
+static uint64_t get_wall_clock_us(void)
+{
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+// long is 32 bits on Windows, the record offsets are not
+static int seek_watch_file(FILE *fp, uint64_t offset)
+{
+#if defined(_WIN32)
+    return _fseeki64(fp, (__int64)offset, SEEK_SET);
+#else
+    return fseeko(fp, (off_t)offset, SEEK_SET);
+#endif
+}
+
+static int write_watch_header(FILE *fp, watch_file_header_t *header, char names[][WATCH_CHANNEL_NAME_CHARS])
+{
+    if (seek_watch_file(fp, 0) != 0 || fwrite(header, sizeof(*header), 1, fp) != 1) {
+        return -1;
+    }
+    if (names != NULL && fwrite(names, WATCH_CHANNEL_NAME_CHARS, header->num_channels, fp) != header->num_channels) {
+        return -1;
+    }
+    return 0;
+}
+
+static void free_buffers(void **data_out_ptrs, unsigned num_cmds)
+{
+    for (unsigned i=0; i<num_cmds; i++) {
+        free(data_out_ptrs[i]);
+    }
+}
+
+int run_watch(watch_config_t *config)
+{
+    cmdspec_t cmd_specs[WATCH_MAX_CMDS];
+    void *data_out_ptrs[WATCH_MAX_CMDS];
+    int cmd_ret[WATCH_MAX_CMDS];
+    unsigned first_channel[WATCH_MAX_CMDS];
+    unsigned num_cmds = 0;
+    unsigned num_channels = 0;
+    static char names[WATCH_MAX_CHANNELS][WATCH_CHANNEL_NAME_CHARS];
+    static double values[WATCH_MAX_CHANNELS];
+    int ret = 0;
+
+    // Look up the commands
+    for (char *name = strtok(config->cmd_list, ","); name != NULL; name = strtok(NULL, ",")) {
+        if (num_cmds == WATCH_MAX_CMDS) {
+            fprintf(stderr, "Error: too many commands to watch, max is %d\n", WATCH_MAX_CMDS);
+            free_buffers(data_out_ptrs, num_cmds);
+            return -1;
+        }
+        cmdspec_t *cmd = &cmd_specs[num_cmds];
+        ret = vfctrl_get_cmdspec(1, name, cmd, 0);
+        if (ret != 0) {
+            free_buffers(data_out_ptrs, num_cmds);
+            return ret;
+        }
+        if (cmd->rw != READ) {
+            fprintf(stderr, "Error: %s is not a read command\n", cmd->par_name);
+            free_buffers(data_out_ptrs, num_cmds);
+            return -1;
+        }
+        unsigned cmd_channels = cmd->app_read_result_size / get_value_bytes(cmd->type);
+        if (num_channels + cmd_channels > WATCH_MAX_CHANNELS) {
+            fprintf(stderr, "Error: too many values to watch, max is %d\n", WATCH_MAX_CHANNELS);
+            free_buffers(data_out_ptrs, num_cmds);
+            return -1;
+        }
+        first_channel[num_cmds] = num_channels;
+        for (unsigned i=0; i<cmd_channels; i++) {
+            if (cmd_channels == 1) {
+                snprintf(names[num_channels], WATCH_CHANNEL_NAME_CHARS, "%s", cmd->par_name);
+            } else {
+                snprintf(names[num_channels], WATCH_CHANNEL_NAME_CHARS, "%s[%u]", cmd->par_name, i);
+            }
+            num_channels++;
+        }
+        data_out_ptrs[num_cmds] = calloc(cmd->app_read_result_size, 1);
+        num_cmds++;
+    }
+    if (num_cmds == 0) {
+        fprintf(stderr, "Error: no commands to watch\n");
+        return -1;
+    }
+
+    // Open the output files
+    FILE *bin_fp = NULL;
+    FILE *csv_fp = NULL;
+    watch_file_header_t header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, WATCH_FILE_MAGIC, sizeof(header.magic));
+    header.num_channels = num_channels;
+    header.header_bytes = sizeof(header) + num_channels * WATCH_CHANNEL_NAME_CHARS;
+    header.record_bytes = sizeof(uint64_t) + num_channels * sizeof(double);
+    header.ring_size = config->ring_size;
+    header.rate_hz = config->rate_hz;
+    if (config->output_file != NULL) {
+        bin_fp = fopen(config->output_file, "w+b");
+        if (bin_fp == NULL) {
+            fprintf(stderr, "Error: cannot open %s\n", config->output_file);
+            free_buffers(data_out_ptrs, num_cmds);
+            return -1;
+        }
+    }
+    if (config->csv_file != NULL) {
+        csv_fp = fopen(config->csv_file, "w");
+        if (csv_fp == NULL) {
+            fprintf(stderr, "Error: cannot open %s\n", config->csv_file);
+            if (bin_fp != NULL) {
+                fclose(bin_fp);
+            }
+            free_buffers(data_out_ptrs, num_cmds);
+            return -1;
+        }
+    } else if (bin_fp == NULL) {
+        csv_fp = stdout;
+    }
+    if (csv_fp != NULL) {
+        fprintf(csv_fp, "time_s");
+        for (unsigned c=0; c<num_channels; c++) {
+            fprintf(csv_fp, ",%s", names[c]);
+        }
+        fprintf(csv_fp, "\n");
+    }
+
+    signal(SIGINT, watch_signal_handler);
+
+    uint64_t period_us = (uint64_t)(1000000.0 / config->rate_hz);
+    if (period_us == 0) {
+        period_us = 1;
+    }
+    uint64_t max_samples = config->num_samples;
+    uint64_t duration_us = (uint64_t)(config->duration_s * 1000000.0);
+    uint64_t num_records = 0;
+    uint64_t missed_ticks = 0;
+    uint64_t read_errors = 0;
+    uint64_t start_us = vfctrl_get_time_us();
+    header.start_time_us = get_wall_clock_us();
+    if (bin_fp != NULL && write_watch_header(bin_fp, &header, names) != 0) {
+        fprintf(stderr, "Error: cannot write to %s\n", config->output_file);
+        ret = -1;
+        watch_stop = 1;
+    }
+
+    uint64_t tick = 0;
+    while (!watch_stop && (max_samples == 0 || num_records < max_samples)) {
+        uint64_t tick_us = start_us + tick * period_us;
+        if (duration_us > 0 && tick_us - start_us >= duration_us) {
+            break;
+        }
+        uint64_t now_us = vfctrl_get_time_us();
+        if (now_us < tick_us) {
+            vfctrl_sleep_us((unsigned)(tick_us - now_us));
+        }
+        uint64_t timestamp_us = vfctrl_get_time_us() - start_us;
+
+        vfctrl_do_read_commands(cmd_specs, data_out_ptrs, cmd_ret, num_cmds);
+        for (unsigned i=0; i<num_cmds; i++) {
+            unsigned cmd_channels = cmd_specs[i].app_read_result_size / get_value_bytes(cmd_specs[i].type);
+            for (unsigned c=0; c<cmd_channels; c++) {
+                values[first_channel[i] + c] = (cmd_ret[i] == 0) ? get_value(cmd_specs[i].type, data_out_ptrs[i], c) : NAN;
+            }
+            if (cmd_ret[i] != 0) {
+                read_errors++;
+            }
+        }
+
+        if (bin_fp != NULL) {
+            uint64_t offset = header.header_bytes + (num_records % header.ring_size) * header.record_bytes;
+            seek_watch_file(bin_fp, offset);
+            fwrite(&timestamp_us, sizeof(timestamp_us), 1, bin_fp);
+            fwrite(values, sizeof(double), num_channels, bin_fp);
+            header.num_records = num_records + 1;
+            write_watch_header(bin_fp, &header, NULL);
+            fflush(bin_fp);
+        }
+        if (csv_fp != NULL) {
+            fprintf(csv_fp, "%.6f", timestamp_us / 1000000.0);
+            for (unsigned c=0; c<num_channels; c++) {
+                fprintf(csv_fp, ",%.9g", values[c]);
+            }
+            fprintf(csv_fp, "\n");
+            fflush(csv_fp);
+        }
+        num_records++;
+
+        // skip the ticks which have already passed rather than sampling in a burst
+        uint64_t next_tick = (vfctrl_get_time_us() - start_us) / period_us + 1;
+        if (next_tick > tick + 1) {
+            missed_ticks += next_tick - (tick + 1);
+        }
+        tick = next_tick;
+    }
+
+    double elapsed_s = (vfctrl_get_time_us() - start_us) / 1000000.0;
+    fprintf(stderr, "Watch: %llu samples in %.2f s (%.2f Hz), %llu ticks missed, %llu read errors\n",
+            (unsigned long long)num_records, elapsed_s, elapsed_s > 0 ? num_records / elapsed_s : 0.0,
+            (unsigned long long)missed_ticks, (unsigned long long)read_errors);
+
+    if (bin_fp != NULL) {
+        fclose(bin_fp);
+    }
+    if (csv_fp != NULL && csv_fp != stdout) {
+        fclose(csv_fp);
+    }
+    free_buffers(data_out_ptrs, num_cmds);
+    return ret;
+}
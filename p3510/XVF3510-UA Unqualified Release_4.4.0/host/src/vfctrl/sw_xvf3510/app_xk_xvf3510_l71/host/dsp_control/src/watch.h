@@ -0,0 +1,42 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#ifndef WATCH_H
+#define WATCH_H
+
+#include <stdint.h>
+
+#define WATCH_DEFAULT_RATE_HZ    (10.0)
+#define WATCH_DEFAULT_RING_SIZE  (65536)
+
+// Binary watch file layout, all fields in host byte order:
+//   watch_file_header_t
+//   num_channels channel names of WATCH_CHANNEL_NAME_CHARS bytes each
+//   ring_size records of: uint64_t timestamp in us since start_time_us, double values[num_channels]
+// Record n (counting from 0) is stored in slot n % ring_size. Values which could not be read are NaN.
+#define WATCH_FILE_MAGIC         "VFWATCH1"
+#define WATCH_CHANNEL_NAME_CHARS (48)
+
+typedef struct {
+    char magic[8];
+    uint32_t header_bytes;    // offset of the first record
+    uint32_t record_bytes;
+    uint32_t ring_size;       // number of records in the file
+    uint32_t num_channels;    // number of values in each record
+    uint64_t num_records;     // number of records written so far, updated after each record
+    uint64_t start_time_us;   // wall clock time of the first sample, in us since the epoch
+    double rate_hz;
+} watch_file_header_t;
+
+typedef struct {
+    char *cmd_list;           // comma separated list of GET_ commands
+    double rate_hz;
+    double duration_s;        // 0 to run until interrupted
+    unsigned num_samples;     // 0 to run until interrupted
+    const char *output_file;  // binary ring buffer file, optional
+    unsigned ring_size;       // number of records kept in output_file
+    const char *csv_file;     // optional
+} watch_config_t;
+
+int parse_watch_rate(const char *rate_str, double *rate_hz);
+int run_watch(watch_config_t *config);
+
+#endif
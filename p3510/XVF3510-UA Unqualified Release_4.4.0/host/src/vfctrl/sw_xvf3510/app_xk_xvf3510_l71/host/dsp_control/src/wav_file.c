@@ -0,0 +1,123 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+// PCM WAV file headers and whole file loading for the host side simulators
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <inttypes.h>
+#include "wav_file.h"
+
+#define WAV_FORMAT_PCM          (1)
+#define WAV_FORMAT_EXTENSIBLE   (0xfffe)
+
+uint32_t wav_get_le(const uint8_t *p, unsigned num_bytes)
+{
+    uint32_t v = 0;
+    for (unsigned i=0; i<num_bytes; i++) {
+        v |= (uint32_t)p[i] << (8 * i);
+    }
+    return v;
+}
+
+void wav_put_le(uint8_t *p, uint32_t v, unsigned num_bytes)
+{
+    for (unsigned i=0; i<num_bytes; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+int wav_read_header(FILE *fp, wav_info_t *info)
+{
+    uint8_t hdr[40];
+    unsigned have_fmt = 0;
+    if (fread(hdr, 1, 12, fp) != 12 || memcmp(hdr, "RIFF", 4) != 0 || memcmp(hdr + 8, "WAVE", 4) != 0) {
+        return -1;
+    }
+    while (fread(hdr, 1, 8, fp) == 8) {
+        uint32_t chunk_size = wav_get_le(hdr + 4, 4);
+        if (memcmp(hdr, "fmt ", 4) == 0) {
+            if (chunk_size < 16 || chunk_size > sizeof(hdr) || fread(hdr, 1, chunk_size, fp) != chunk_size) {
+                return -1;
+            }
+            unsigned format = wav_get_le(hdr, 2);
+            if (format == WAV_FORMAT_EXTENSIBLE && chunk_size >= 26) {
+                format = wav_get_le(hdr + 24, 2); // first bytes of the sub format GUID
+            }
+            info->num_channels = wav_get_le(hdr + 2, 2);
+            info->sample_rate = wav_get_le(hdr + 4, 4);
+            info->bits_per_sample = wav_get_le(hdr + 14, 2);
+            if (format != WAV_FORMAT_PCM || info->num_channels == 0 || info->num_channels > WAV_MAX_CHANNELS ||
+                (info->bits_per_sample != 16 && info->bits_per_sample != 24 && info->bits_per_sample != 32)) {
+                return -1;
+            }
+            have_fmt = 1;
+            if (chunk_size & 1) {
+                fseek(fp, 1, SEEK_CUR);
+            }
+        } else if (memcmp(hdr, "data", 4) == 0) {
+            if (!have_fmt) {
+                return -1;
+            }
+            info->num_frames = chunk_size / (info->num_channels * (info->bits_per_sample / 8));
+            return 0;
+        } else if (fseek(fp, chunk_size + (chunk_size & 1), SEEK_CUR) != 0) {
+            return -1;
+        }
+    }
+    return -1;
+}
+
+void wav_write_header(FILE *fp, unsigned num_channels, unsigned sample_rate, uint64_t num_frames)
+{
+    uint8_t hdr[44];
+    uint32_t data_size = (uint32_t)(num_frames * num_channels * 4);
+    memcpy(hdr, "RIFF", 4);
+    wav_put_le(hdr + 4, 36 + data_size, 4);
+    memcpy(hdr + 8, "WAVEfmt ", 8);
+    wav_put_le(hdr + 16, 16, 4);
+    wav_put_le(hdr + 20, WAV_FORMAT_PCM, 2);
+    wav_put_le(hdr + 22, num_channels, 2);
+    wav_put_le(hdr + 24, sample_rate, 4);
+    wav_put_le(hdr + 28, sample_rate * num_channels * 4, 4);
+    wav_put_le(hdr + 32, num_channels * 4, 2);
+    wav_put_le(hdr + 34, 32, 2);
+    memcpy(hdr + 36, "data", 4);
+    wav_put_le(hdr + 40, data_size, 4);
+    fwrite(hdr, 1, sizeof(hdr), fp);
+}
+
+int wav_load_channel(const char *filename, unsigned channel, int32_t **samples, wav_info_t *info)
+{
+    FILE *fp = fopen(filename, "rb");
+    if (fp == NULL) {
+        fprintf(stderr, "Error: cannot open %s\n", filename);
+        return -1;
+    }
+    if (wav_read_header(fp, info) != 0) {
+        fprintf(stderr, "Error: %s is not a 16, 24 or 32-bit PCM WAV file\n", filename);
+        fclose(fp);
+        return -1;
+    }
+    if (channel >= info->num_channels) {
+        fprintf(stderr, "Error: %s has %u channels\n", filename, info->num_channels);
+        fclose(fp);
+        return -1;
+    }
+    unsigned bytes_per_sample = info->bits_per_sample / 8;
+    unsigned frame_bytes = bytes_per_sample * info->num_channels;
+    uint8_t *frame = malloc(frame_bytes);
+    *samples = malloc((size_t)info->num_frames * sizeof(int32_t) + 1);
+    uint64_t n;
+    for (n=0; n<info->num_frames && fread(frame, frame_bytes, 1, fp) == 1; n++) {
+        // left justified to 32 bits as the samples are on the device
+        (*samples)[n] = (int32_t)(wav_get_le(&frame[channel * bytes_per_sample], bytes_per_sample) << (32 - info->bits_per_sample));
+    }
+    if (n < info->num_frames) {
+        fprintf(stderr, "Warning: %s is truncated, %" PRIu64 " frames missing\n", filename, info->num_frames - n);
+        info->num_frames = n;
+    }
+    free(frame);
+    fclose(fp);
+    return 0;
+}
@@ -0,0 +1,26 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+#ifndef WAV_FILE_H
+#define WAV_FILE_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+#define WAV_MAX_CHANNELS        (16)
+
+typedef struct {
+    unsigned num_channels;
+    unsigned sample_rate;
+    unsigned bits_per_sample;
+    uint64_t num_frames;
+} wav_info_t;
+
+uint32_t wav_get_le(const uint8_t *p, unsigned num_bytes);
+void wav_put_le(uint8_t *p, uint32_t v, unsigned num_bytes);
+// Read the header of a 16, 24 or 32-bit PCM file and leave fp at the start of the samples
+int wav_read_header(FILE *fp, wav_info_t *info);
+// Header of a 32-bit PCM file
+void wav_write_header(FILE *fp, unsigned num_channels, unsigned sample_rate, uint64_t num_frames);
+// Load one channel of a file, left justified to 32 bits. The samples are allocated and freed by the caller.
+int wav_load_channel(const char *filename, unsigned channel, int32_t **samples, wav_info_t *info);
+
+#endif
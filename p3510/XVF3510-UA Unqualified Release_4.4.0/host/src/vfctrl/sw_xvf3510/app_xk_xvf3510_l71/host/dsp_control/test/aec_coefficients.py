@@ -0,0 +1,24 @@
+import numpy as np
+# AEC filter with known impulse responses for the aec_ir test: mic 0 peaks at sample 70, mic 1 at 74
+frame_advance = 32
+y_channel_count = 2
+x_channel_count = 1
+max_phase_count = 8
+f_bin_count = 33
+H_hat = np.zeros((y_channel_count, x_channel_count, max_phase_count, f_bin_count), dtype=np.complex128)
+H_hat[0][0][0] = np.asarray([0.000000000000, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000])
+H_hat[0][0][1] = np.asarray([0.000000000000, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000])
+H_hat[0][0][2] = np.asarray([1.200000000000, 1.022857679449 + -0.613627168470j, 0.548977354826 + -1.034993579115j, -0.068211665183 + -1.135387371076j, -0.630570094714 + -0.891882687689j, -0.961181852337 + -0.394127267351j, -0.962897596915 + 0.186526376284j, -0.649849580385 + 0.655085359433j, -0.141421356237 + 0.858578643763j, 0.379185980150 + 0.737190264937j, 0.727722476431 + 0.343665367962j, 0.781748335069 + -0.175486893950j, 0.522330874684 + -0.630570094714j, 0.040488231344 + -0.853906623571j, -0.493797478969 + -0.757585610051j, -0.889526547753 + -0.364182165873j, -1.000000000000 + 0.200000000000j, -0.773412676852 + 0.746958300166j, -0.271569385761 + 1.090173454972j, 0.349692412689 + 1.107663937236j, 0.891882687689 + 0.783643467660j, 1.179822225738 + 0.214693750082j, 1.120036588592 + -0.421701496768j, 0.731954485889 + -0.925748959668j, 0.141421356237 + -1.141421356237j, -0.461290885654 + -1.007853865172j, -0.884861468108 + -0.578840488446j, -1.000388708469 + -0.003946623318j, -0.783643467660 + 0.522330874684j, -0.321968978849 + 0.826183189731j, 0.216389509905 + 0.812765485907j, 0.640081545156 + 0.497513297569j, 0.800000000000])
+H_hat[0][0][3] = np.asarray([0.000000000000, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000])
+H_hat[0][0][4] = np.asarray([0.000000000000, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000])
+H_hat[0][0][5] = np.asarray([0.100000000000, 0.100000000000 + 0.000000000000j, 0.100000000000 + -0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + -0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000 + 0.000000000000j, 0.100000000000])
+H_hat[0][0][6] = np.asarray([0.000000000000, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000])
+H_hat[0][0][7] = np.asarray([0.000000000000, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000])
+H_hat[1][0][0] = np.asarray([0.000000000000, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000])
+H_hat[1][0][1] = np.asarray([0.000000000000, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000])
+H_hat[1][0][2] = np.asarray([-0.700000000000, -0.373745508297 + 0.594465011723j, 0.306146745892 + 0.639103626009j, 0.713917546204 + 0.085361579494j, 0.465685424949 + -0.565685424949j, -0.226782935732 + -0.713917546204j, -0.739103626009 + -0.206146745892j, -0.594465011723 + 0.515166864534j, 0.100000000000 + 0.800000000000j, 0.735886367961 + 0.373745508297j, 0.739103626009 + -0.406146745892j, 0.085361579494 + -0.855338902441j, -0.665685424949 + -0.565685424949j, -0.855338902441 + 0.226782935732j, -0.306146745892 + 0.839103626009j, 0.515166864534 + 0.735886367961j, 0.900000000000 + 0.000000000000j, 0.515166864534 + -0.735886367961j, -0.306146745892 + -0.839103626009j, -0.855338902441 + -0.226782935732j, -0.665685424949 + 0.565685424949j, 0.085361579494 + 0.855338902441j, 0.739103626009 + 0.406146745892j, 0.735886367961 + -0.373745508297j, 0.100000000000 + -0.800000000000j, -0.594465011723 + -0.515166864534j, -0.739103626009 + 0.206146745892j, -0.226782935732 + 0.713917546204j, 0.465685424949 + 0.565685424949j, 0.713917546204 + -0.085361579494j, 0.306146745892 + -0.639103626009j, -0.373745508297 + -0.594465011723j, -0.700000000000])
+H_hat[1][0][3] = np.asarray([0.000000000000, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000])
+H_hat[1][0][4] = np.asarray([0.000000000000, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000])
+H_hat[1][0][5] = np.asarray([0.000000000000, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000])
+H_hat[1][0][6] = np.asarray([0.000000000000, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000])
+H_hat[1][0][7] = np.asarray([0.000000000000, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + -0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000 + 0.000000000000j, 0.000000000000])
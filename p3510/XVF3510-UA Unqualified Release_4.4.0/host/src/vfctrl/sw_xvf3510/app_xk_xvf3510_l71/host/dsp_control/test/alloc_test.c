@@ -0,0 +1,118 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+// Checks that the control reads and writes do not allocate once the device is open.
+// The host code is linked with -Wl,--wrap for the allocation functions, which are counted here,
+// and talks to a fake I2C device which completes every command at once.
+// The USB transport is not covered: libusb allocates a transfer inside each synchronous
+// control request, which is outside the host code.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "control_host.h"
+#include "host_control_api.h"
+
+#define NUM_ITERATIONS (1000)
+
+void *__real_malloc(size_t size);
+void *__real_calloc(size_t num, size_t size);
+void *__real_realloc(void *ptr, size_t size);
+
+static unsigned num_allocations = 0;
+
+void *__wrap_malloc(size_t size)
+{
+    num_allocations++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(size_t num, size_t size)
+{
+    num_allocations++;
+    return __real_calloc(num, size);
+}
+
+void *__wrap_realloc(void *ptr, size_t size)
+{
+    num_allocations++;
+    return __real_realloc(ptr, size);
+}
+
+control_ret_t control_init_i2c(unsigned char i2c_slave_address)
+{
+    (void)i2c_slave_address;
+    return CONTROL_SUCCESS;
+}
+
+control_ret_t control_cleanup_i2c(void)
+{
+    return CONTROL_SUCCESS;
+}
+
+control_ret_t control_write_command(control_resid_t resid, control_cmd_t cmd,
+                                    const uint8_t payload[], size_t payload_len)
+{
+    (void)resid;
+    (void)cmd;
+    (void)payload;
+    (void)payload_len;
+    return CONTROL_SUCCESS;
+}
+
+control_ret_t control_read_command(control_resid_t resid, control_cmd_t cmd,
+                                   uint8_t payload[], size_t payload_len)
+{
+    // status 0 in the first byte is CTRL_DONE
+    memset(payload, 0, payload_len);
+    if (resid == CONTROL_SPECIAL_RESID && cmd == CONTROL_GET_VERSION) {
+        payload[0] = CONTROL_VERSION;
+    }
+    return CONTROL_SUCCESS;
+}
+
+static int run_commands(void)
+{
+    const char *read_args[] = {"GET_BYPASS_AEC"};
+    const char *write_args[] = {"SET_BYPASS_AEC", "1"};
+    cmdspec_t read_cmd;
+    cmdspec_t write_cmd;
+    int64_t data_out[CMD_MAX_BYTES];
+    int32_t value;
+
+    if (vfctrl_get_cmdspec(1, read_args[0], &read_cmd, 0) != 0 ||
+        vfctrl_get_cmdspec(2, write_args[0], &write_cmd, 0) != 0) {
+        printf("Error: command not found\n");
+        return -1;
+    }
+    if (vfctrl_do_command(&read_cmd, read_args, data_out, 0) != 0 ||
+        vfctrl_do_command(&write_cmd, write_args, NULL, 0) != 0 ||
+        vfctrl_get_int(VFCTRL_GET_BYPASS_AEC, &value) != 0 ||
+        vfctrl_set_int(VFCTRL_SET_BYPASS_AEC, 0) != 0) {
+        printf("Error: command failed\n");
+        return -1;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    // the attribute cache is a file, it is not part of the control path
+    vfctrl_set_attribute_cache(0);
+
+    // opens the device and builds the command table
+    if (run_commands() != 0) {
+        return 1;
+    }
+
+    num_allocations = 0;
+    for (unsigned i=0; i<NUM_ITERATIONS; i++) {
+        if (run_commands() != 0) {
+            return 1;
+        }
+    }
+
+    if (num_allocations != 0) {
+        printf("Error: %u allocations in %u iterations of the control commands\n", num_allocations, NUM_ITERATIONS);
+        return 1;
+    }
+    printf("No allocations in %u iterations of the control commands\n", NUM_ITERATIONS);
+    return 0;
+}
@@ -0,0 +1,87 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+// Runs the autotuner on the AGC simulator with a steady tone 26 dB below the target level.
+// The level spread is zero with a fixed gain, so the tuner must turn the adaption off and find the gain
+// which puts the tone on the target level, within the precision of its steps.
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "wav_file.h"
+#include "autotune.h"
+
+#ifndef M_PI
+#define M_PI 3.14159265358979323846
+#endif
+
+#define TEST_WAV_FILE       "autotune_test.wav"
+#define TEST_OUTPUT_FILE    "autotune_test.txt"
+#define TEST_SAMPLE_RATE    (16000)
+#define TEST_SECONDS        (2)
+#define TEST_TONE_HZ        (1000.0)
+#define TEST_TONE_DBFS      (-46.0)
+#define TEST_TARGET_DBFS    (-20.0)
+#define TEST_TOLERANCE_DB   (0.5)
+
+static int write_tone(const char *filename)
+{
+    FILE *fp = fopen(filename, "wb");
+    if (fp == NULL) {
+        printf("Error: cannot open %s\n", filename);
+        return -1;
+    }
+    unsigned num_frames = TEST_SAMPLE_RATE * TEST_SECONDS;
+    double amplitude = sqrt(2.0) * pow(10.0, TEST_TONE_DBFS / 20.0);
+    wav_write_header(fp, 1, TEST_SAMPLE_RATE, num_frames);
+    for (unsigned i=0; i<num_frames; i++) {
+        uint8_t sample[4];
+        double x = amplitude * sin(2 * M_PI * TEST_TONE_HZ * i / TEST_SAMPLE_RATE);
+        wav_put_le(sample, (uint32_t)(int32_t)lround(x * 2147483647.0), 4);
+        fwrite(sample, 1, sizeof(sample), fp);
+    }
+    fclose(fp);
+    return 0;
+}
+
+int main(void)
+{
+    autotune_config_t config = {1, "GAIN_CH0_AGC,ADAPT_CH0_AGC", TEST_WAV_FILE, AUTOTUNE_DEFAULT_PASSES,
+                                AUTOTUNE_DEFAULT_JOBS, AUTOTUNE_DEFAULT_WINDOW_MS, AUTOTUNE_DEFAULT_SETTLE_MS,
+                                TEST_TARGET_DBFS, TEST_OUTPUT_FILE};
+    if (write_tone(TEST_WAV_FILE) != 0 || run_autotune(&config) != 0) {
+        return 1;
+    }
+
+    FILE *fp = fopen(TEST_OUTPUT_FILE, "r");
+    if (fp == NULL) {
+        printf("Error: cannot open %s\n", TEST_OUTPUT_FILE);
+        return 1;
+    }
+    char line[256];
+    char name[64];
+    double value;
+    double gain = -1, adapt = -1;
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        if (sscanf(line, "SET_%63s %lf", name, &value) != 2) {
+            continue;
+        }
+        if (strcmp(name, "GAIN_CH0_AGC") == 0) {
+            gain = value;
+        } else if (strcmp(name, "ADAPT_CH0_AGC") == 0) {
+            adapt = value;
+        }
+    }
+    fclose(fp);
+
+    if (gain <= 0 || adapt != 0) {
+        printf("Error: tuned to SET_GAIN_CH0_AGC %g, SET_ADAPT_CH0_AGC %g, expected a fixed gain\n", gain, adapt);
+        return 1;
+    }
+    double level_dbfs = TEST_TONE_DBFS + 20 * log10(gain);
+    if (fabs(level_dbfs - TEST_TARGET_DBFS) > TEST_TOLERANCE_DB) {
+        printf("Error: the tuned gain of %g puts the tone at %.2f dBFS, expected %.1f dBFS\n",
+               gain, level_dbfs, TEST_TARGET_DBFS);
+        return 1;
+    }
+    printf("The tuned gain of %g puts the tone at %.2f dBFS\n", gain, level_dbfs);
+    return 0;
+}
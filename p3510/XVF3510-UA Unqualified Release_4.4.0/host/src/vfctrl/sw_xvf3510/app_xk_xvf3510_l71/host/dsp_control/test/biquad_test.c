@@ -0,0 +1,120 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+// Checks the Q28 biquad cascade simulator against known vectors.
+// The expected words were computed with integer arithmetic from the model described in biquad_sim.h:
+// 64-bit accumulation from 1 << 27, arithmetic shift right by 28, saturation to 32 bits.
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "biquad_sim.h"
+
+#define NUM_ELEMENTS(a) (sizeof(a) / sizeof(a[0]))
+
+// stage 0: a1 = -0.5, a2 = 0.25, b0 = 1, b1 = 0.5, b2 = -0.25, stage 1: gain of 0.75
+static const double coeffs[BIQUAD_NUM_COEFFS] = {-0.5, 0.25, 1.0, 0.5, -0.25, 0.0, 0.0, 0.75, 0.0, 0.0};
+static const int32_t expected_q_coeffs[BIQUAD_NUM_COEFFS] = {
+    268435456, 134217728, -67108864, 134217728, -67108864,
+    201326592, 0, 0, 0, 0,
+};
+static const int32_t input[] = {
+    1 << 24, 0, 0, 0, -1000, 123456789, -987654321, 7, -7, INT32_MAX, INT32_MIN, 0, 0, 0,
+};
+static const int32_t expected_output[] = {
+    12582912, 12582912, 0, -3145728, -1573614, 92591842, -647754933,
+    -740543940, -23148054, 1610612735, 5787014, -1607719228, -402653184, 200603216,
+};
+
+// stage 0: gain of 4, which saturates, stage 1: gain of 1
+static const double gain_coeffs[BIQUAD_NUM_COEFFS] = {0.0, 0.0, 4.0, 0.0, 0.0, 0.0, 0.0, 1.0, 0.0, 0.0};
+static const int32_t gain_input[] = {1000, 1 << 30, -(1 << 30), -(1 << 29) - 1, 3};
+static const int32_t gain_expected_output[] = {4000, INT32_MAX, INT32_MIN, INT32_MIN, 12};
+
+static int check_words(const char *name, const int32_t *expected, const int32_t *actual, size_t n)
+{
+    for (size_t i=0; i<n; i++) {
+        if (expected[i] != actual[i]) {
+            printf("Error: %s %u is %d, expected %d\n", name, (unsigned)i, actual[i], expected[i]);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int test_coefficients(void)
+{
+    int32_t q_coeffs[BIQUAD_NUM_COEFFS];
+    if (biquad_coeffs_to_q28(coeffs, q_coeffs) != 0) {
+        printf("Error: coefficients reported out of range\n");
+        return 1;
+    }
+    return check_words("coefficient", expected_q_coeffs, q_coeffs, BIQUAD_NUM_COEFFS);
+}
+
+static int test_cascade(void)
+{
+    biquad_cascade_t bq;
+    int32_t q_coeffs[BIQUAD_NUM_COEFFS];
+    int32_t output[NUM_ELEMENTS(input)];
+
+    biquad_coeffs_to_q28(coeffs, q_coeffs);
+    biquad_cascade_init(&bq, q_coeffs);
+    // in two calls, the state is kept between them
+    biquad_cascade_process(&bq, input, output, 5);
+    biquad_cascade_process(&bq, input + 5, output + 5, NUM_ELEMENTS(input) - 5);
+    if (check_words("output", expected_output, output, NUM_ELEMENTS(input))) {
+        return 1;
+    }
+    if (bq.num_samples != NUM_ELEMENTS(input) || bq.num_saturations[0] != 1 || bq.num_saturations[1] != 0) {
+        printf("Error: %u samples and %u, %u saturations, expected %u and 1, 0\n", (unsigned)bq.num_samples,
+               (unsigned)bq.num_saturations[0], (unsigned)bq.num_saturations[1], (unsigned)NUM_ELEMENTS(input));
+        return 1;
+    }
+    return 0;
+}
+
+static int test_saturation(void)
+{
+    biquad_cascade_t bq;
+    int32_t q_coeffs[BIQUAD_NUM_COEFFS];
+    int32_t output[NUM_ELEMENTS(gain_input)];
+
+    biquad_coeffs_to_q28(gain_coeffs, q_coeffs);
+    biquad_cascade_init(&bq, q_coeffs);
+    biquad_cascade_process(&bq, gain_input, output, NUM_ELEMENTS(gain_input));
+    if (check_words("saturated output", gain_expected_output, output, NUM_ELEMENTS(gain_input))) {
+        return 1;
+    }
+    if (bq.num_saturations[0] != 3 || bq.num_saturations[1] != 0) {
+        printf("Error: %u, %u saturations, expected 3, 0\n",
+               (unsigned)bq.num_saturations[0], (unsigned)bq.num_saturations[1]);
+        return 1;
+    }
+    return 0;
+}
+
+static int test_check(void)
+{
+    // a2 = 1.21 puts the poles of stage 1 at a radius of 1.1
+    double unstable[BIQUAD_NUM_COEFFS];
+    biquad_check_t check;
+
+    if (biquad_cascade_check(coeffs, &check) < 0 || fabs(check.pole_radius[0] - 0.5) > 1e-6) {
+        printf("Error: stable coefficients rejected, pole radius %f\n", check.pole_radius[0]);
+        return 1;
+    }
+    memcpy(unstable, coeffs, sizeof(unstable));
+    unstable[6] = 1.21;
+    if (biquad_cascade_check(unstable, &check) != -1 || fabs(check.pole_radius[1] - 1.1) > 1e-6) {
+        printf("Error: unstable coefficients accepted, pole radius %f\n", check.pole_radius[1]);
+        return 1;
+    }
+    return 0;
+}
+
+int main(void)
+{
+    if (test_coefficients() || test_cascade() || test_saturation() || test_check()) {
+        return 1;
+    }
+    printf("The biquad cascade matches the known vectors\n");
+    return 0;
+}
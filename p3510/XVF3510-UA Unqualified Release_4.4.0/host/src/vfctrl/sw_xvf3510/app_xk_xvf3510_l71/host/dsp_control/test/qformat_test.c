@@ -0,0 +1,141 @@
+// Copyright (c) 2020, XMOS Ltd, All rights reserved
+// Compares the Q format conversion kernels with the scalar expressions on random values.
+// It is built once for each kernel, QFORMAT_TEST_KERNEL is the name of the expected kernel.
+#include <stdio.h>
+#include <string.h>
+#include <math.h>
+#include "qformat.h"
+
+#define NUM_ITERATIONS (2000)
+#define MAX_VALUES     (67) // not a multiple of the vector widths, so the tails are tested too
+#define SKIPPED        (77) // exit code ctest reports as a skipped test
+
+static uint32_t random_state = 0x12345678;
+
+// xorshift32, the same values on all the hosts
+static uint32_t random_u32(void)
+{
+    random_state ^= random_state << 13;
+    random_state ^= random_state >> 17;
+    random_state ^= random_state << 5;
+    return random_state;
+}
+
+static uint32_t random_value(void)
+{
+    // the extremes and small values are more likely than in a uniform draw
+    static const uint32_t special[] = {0, 1, 0xffffffff, 0x7fffffff, 0x80000000, 0x00ffffff, 0x01000001, 0xfeffffff};
+    switch (random_u32() % 4) {
+        case 0:
+            return special[random_u32() % (sizeof(special) / sizeof(special[0]))];
+        case 1:
+            return random_u32() >> (random_u32() % 32);
+        default:
+            return random_u32();
+    }
+}
+
+static float random_float(unsigned frac_bits)
+{
+    // below 2^31 once scaled, where the cast is defined
+    float f = (float)((int32_t)random_u32() >> (random_u32() % 32));
+    return (float)ldexp(f, -(int)frac_bits) * ((random_u32() & 1) ? 0.999f : 0.5f);
+}
+
+static int check(const char *name, const void *expected, const void *actual, size_t n, size_t size, int param)
+{
+    for (size_t i=0; i<n; i++) {
+        if (memcmp((const char *)expected + i*size, (const char *)actual + i*size, size) != 0) {
+            printf("Error: %s mismatch at index %u of %u, parameter %d\n", name, (unsigned)i, (unsigned)n, param);
+            return 1;
+        }
+    }
+    return 0;
+}
+
+static int test_q_to_float(void)
+{
+    int32_t in[MAX_VALUES] = {0};
+    float expected[MAX_VALUES];
+    float actual[MAX_VALUES];
+    size_t n = random_u32() % (MAX_VALUES + 1);
+    unsigned frac_bits = random_u32() % 33;
+
+    for (size_t i=0; i<n; i++) {
+        in[i] = (int32_t)random_value();
+        expected[i] = (float)in[i] / (float)((uint64_t)1 << frac_bits);
+    }
+    qformat_q_to_float(in, actual, n, frac_bits);
+    return check("qformat_q_to_float", expected, actual, n, sizeof(float), (int)frac_bits);
+}
+
+static int test_uq_to_float(void)
+{
+    uint32_t in[MAX_VALUES] = {0};
+    float expected[MAX_VALUES];
+    float actual[MAX_VALUES];
+    size_t n = random_u32() % (MAX_VALUES + 1);
+    unsigned frac_bits = random_u32() % 33;
+
+    for (size_t i=0; i<n; i++) {
+        in[i] = random_value();
+        expected[i] = (float)in[i] / (float)((uint64_t)1 << frac_bits);
+    }
+    qformat_uq_to_float(in, actual, n, frac_bits);
+    return check("qformat_uq_to_float", expected, actual, n, sizeof(float), (int)frac_bits);
+}
+
+static int test_q_to_double(void)
+{
+    int32_t in[MAX_VALUES] = {0};
+    double expected[MAX_VALUES];
+    double actual[MAX_VALUES];
+    size_t n = random_u32() % (MAX_VALUES + 1);
+    // mostly the exponents of the coefficient exports, sometimes the ldexp fallback
+    int exponent = (random_u32() % 8 == 0) ? (int)(random_u32() % 2200) - 1100 : (int)(random_u32() % 128) - 64;
+
+    for (size_t i=0; i<n; i++) {
+        in[i] = (int32_t)random_value();
+        expected[i] = ldexp((double)in[i], exponent);
+    }
+    qformat_q_to_double(in, actual, n, exponent);
+    return check("qformat_q_to_double", expected, actual, n, sizeof(double), exponent);
+}
+
+static int test_float_to_q(void)
+{
+    float in[MAX_VALUES] = {0};
+    int32_t expected[MAX_VALUES];
+    int32_t actual[MAX_VALUES];
+    size_t n = random_u32() % (MAX_VALUES + 1);
+    unsigned frac_bits = random_u32() % 32;
+
+    for (size_t i=0; i<n; i++) {
+        in[i] = random_float(frac_bits);
+        expected[i] = (int32_t)(in[i] * (float)((uint32_t)1 << frac_bits));
+    }
+    qformat_float_to_q(in, actual, n, frac_bits);
+    return check("qformat_float_to_q", expected, actual, n, sizeof(int32_t), (int)frac_bits);
+}
+
+int main(void)
+{
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+    if (strcmp(QFORMAT_TEST_KERNEL, "avx2") == 0 && !__builtin_cpu_supports("avx2")) {
+        printf("The CPU does not support AVX2, test skipped\n");
+        return SKIPPED;
+    }
+#endif
+    if (strcmp(qformat_kernel_name(), QFORMAT_TEST_KERNEL) != 0) {
+        printf("Error: the %s kernels are built, expected %s\n", qformat_kernel_name(), QFORMAT_TEST_KERNEL);
+        return 1;
+    }
+
+    for (unsigned i=0; i<NUM_ITERATIONS; i++) {
+        if (test_q_to_float() || test_uq_to_float() || test_q_to_double() || test_float_to_q()) {
+            return 1;
+        }
+    }
+    printf("The %s kernels match the scalar conversions in %u iterations\n", QFORMAT_TEST_KERNEL, NUM_ITERATIONS);
+    return 0;
+}
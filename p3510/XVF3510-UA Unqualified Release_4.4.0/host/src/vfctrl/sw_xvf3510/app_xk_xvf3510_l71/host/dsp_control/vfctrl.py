@@ -10,6 +10,12 @@ import sys
 import subprocess
 from subprocess import Popen, PIPE
 import time
+import ctypes
+import struct
+try:
+    import numpy as np
+except ImportError:
+    np = None
 
 TIMEOUT = 3
 
@@ -26,13 +32,86 @@ machine = platform.uname()[4]
 control_retries = 10
 control_retry_wait = 0.1
 
+# Shared library of the host app, None when the commands are run with the binary
+lib = None
 
-def init(interface, custom_bin=None, build=False):
+MAX_PAR_NAME_CHARS = 40
+MAX_PAR_INFO_CHARS = 200
+MAX_OUTPUT_STR_CHARS = 1000
+CMD_MAX_BYTES = 64
+READ = 0
+
+# struct.pack() format and numpy dtype of the values of each param_type, in the order of host_control_api.h:
+# FIXED_0_32, FIXED_1_31, FIXED_7_24, FIXED_8_24, FIXED_16_16, UINT8, INT8, UINT32, INT32, UINT64, INT64,
+# TICKS, ENERGY. The fixed point and energy values are returned as floats by the host app.
+value_formats = ['f', 'f', 'f', 'f', 'f', 'B', 'b', 'I', 'i', 'Q', 'q', 'I', 'f']
+value_dtypes = ['float32', 'float32', 'float32', 'float32', 'float32', 'uint8', 'int8', 'uint32', 'int32',
+                'uint64', 'int64', 'uint32', 'float32']
+
+
+class VfctrlError(Exception):
+    """Error returned by the shared library, the app prints the details"""
+    def __init__(self, cmd_id, code):
+        super(VfctrlError, self).__init__("{} returned error {}".format(cmd_id, code))
+        self.cmd_id = cmd_id
+        self.code = code
+
+
+class CmdSpec(ctypes.Structure):
+    """ cmdspec_t of host_control_api.h """
+    _fields_ = [('resid', ctypes.c_uint8),
+                ('par_name', ctypes.c_char * MAX_PAR_NAME_CHARS),
+                ('type', ctypes.c_int),
+                ('offset', ctypes.c_uint),
+                ('rw', ctypes.c_int),
+                ('num_values', ctypes.c_uint),
+                ('info', ctypes.c_char * MAX_PAR_INFO_CHARS),
+                ('device_rw_size', ctypes.c_uint),
+                ('app_read_result_size', ctypes.c_uint)]
+
+
+def load_library(path):
+    """ Load the shared library built next to the host app binary
+
+    Args:
+        path: path of the host app binary
+
+    Returns:
+        ctypes library or None if not found
+    """
+    name = os.path.basename(path)
+    if name.endswith('.exe'):
+        name = name[:-len('.exe')]
+    if system == 'Windows':
+        lib_name = '{}.dll'.format(name)
+    elif system == 'Darwin':
+        lib_name = 'lib{}.dylib'.format(name)
+    else:
+        lib_name = 'lib{}.so'.format(name)
+    lib_path = os.path.join(os.path.dirname(path), lib_name)
+    if not os.path.isfile(lib_path):
+        return None
+    try:
+        native = ctypes.CDLL(lib_path)
+    except OSError as e:
+        print("Warning: cannot load {}: {}".format(lib_path, e))
+        return None
+    native.vfctrl_get_cmdspec.argtypes = [ctypes.c_int, ctypes.c_char_p, ctypes.POINTER(CmdSpec), ctypes.c_uint8]
+    native.vfctrl_get_cmdspec.restype = ctypes.c_int
+    native.vfctrl_execute_command.argtypes = [ctypes.POINTER(CmdSpec), ctypes.POINTER(ctypes.c_char_p),
+                                              ctypes.c_void_p, ctypes.c_uint8, ctypes.c_char_p]
+    native.vfctrl_execute_command.restype = ctypes.c_int
+    return native
+
+
+def init(interface, custom_bin=None, build=False, native=True):
     """ Sets the path to the binary
 
     Args:
         interface: control interface to use
         custom_bin: optional parameter to use a custom build
+        native: run the commands in the shared library of the host app when it is
+                found next to the binary, instead of starting the binary for each command
 
     Returns:
         None
@@ -42,8 +121,10 @@ def init(interface, custom_bin=None, build=False):
         build_host_app()
 
     global bin_path
+    global lib
     if custom_bin is not None:
         bin_path = custom_bin
+        lib = load_library(os.path.abspath(bin_path)) if native else None
         return
     bin_path = 'bin/{}'
     if interface == 'usb':
@@ -59,11 +140,18 @@ def init(interface, custom_bin=None, build=False):
             print("Error: Host app binary not found")
             exit(2)
     bin_path = os.path.abspath(bin_path)
-    ret = do_command('GET_VERSION', quiet=True)
+    lib = load_library(bin_path) if native else None
+    try:
+        ret = do_command('GET_VERSION', quiet=True)
+    except VfctrlError:
+        ret = False
     if not ret:
         print("Error: Device not responding")
         sys.exit(1)
-    print("Using the host app binary {}".format(bin_path))
+    if lib is not None:
+        print("Using the host app library {}".format(lib._name))
+    else:
+        print("Using the host app binary {}".format(bin_path))
 
 
 def command_timeout(done_event):
@@ -81,7 +169,12 @@ def do_command(cmd_id, *args, **kwargs):
         args: additional values
 
     Returns:
-        None or values of GET_ commands
+        None or values of GET_ commands. With the app binary False on error.
+
+    Raises:
+        VfctrlError: the shared library returned an error. The library never returns False,
+                     so the callers which test for False must catch VfctrlError as well,
+                     or call init() with native=False to keep the app binary behaviour.
     """
 
     quiet = False
@@ -93,6 +186,13 @@ def do_command(cmd_id, *args, **kwargs):
 
     if bin_path is None:
         raise Exception("vfctrl not initialised.")
+    if lib is not None:
+        output = native_command(cmd_id, args)
+        if not output:
+            return b''
+        if not quiet:
+            print('{}:{}'.format(cmd_id, output))
+        return output.encode() + b'\n'
     cmd = [bin_path, cmd_id] + [str(a) for a in args]
     for i in range(control_retries):
         try:
@@ -115,6 +215,117 @@ def do_command(cmd_id, *args, **kwargs):
         return False
     return output[len(cmd_id)+1:]
 
+def native_command(cmd_id, args, data_out=None):
+    """Run a command in the shared library
+
+    Args:
+        cmd_id: parameter command
+        args: values of SET_ commands
+        data_out: optional ctypes buffer for the values of GET_ commands
+
+    Returns:
+        formatted values of GET_ commands
+
+    Raises:
+        VfctrlError: the command is not valid or the library returned an error
+    """
+    words = [cmd_id] + [str(a) for a in args]
+    argv = (ctypes.c_char_p * len(words))(*[w.encode() for w in words])
+    cmd_spec = CmdSpec()
+    ret = lib.vfctrl_get_cmdspec(len(words), words[0].encode(), ctypes.byref(cmd_spec), 0)
+    if ret != 0:
+        raise VfctrlError(cmd_id, ret)
+    output_string = ctypes.create_string_buffer(MAX_OUTPUT_STR_CHARS)
+    ret = lib.vfctrl_execute_command(ctypes.byref(cmd_spec), argv, data_out, 0, output_string)
+    if ret != 0:
+        raise VfctrlError(cmd_id, ret)
+    return output_string.value.decode(errors='replace')
+
+
+def get_cmdspec(cmd_id):
+    """Return the CmdSpec of a command, from the shared library
+
+    Args:
+        cmd_id: parameter command
+
+    Returns:
+        CmdSpec or None if the command does not exist
+    """
+    cmd_spec = CmdSpec()
+    if lib.vfctrl_get_cmdspec(1, cmd_id.encode(), ctypes.byref(cmd_spec), 0) != 0:
+        return None
+    return cmd_spec
+
+
+def get_values(cmd_id):
+    """Read the values of a GET_ command
+
+    Args:
+        cmd_id: parameter command
+
+    Returns:
+        the value of single value commands, an array of the values otherwise (a list without numpy),
+        None on error with the app binary
+
+    Raises:
+        VfctrlError: the shared library returned an error
+    """
+    if lib is None:
+        output = do_command(cmd_id, quiet=True)
+        if not output:
+            return None
+        values = []
+        for word in output.decode().split():
+            try:
+                values.append(int(word))
+            except ValueError:
+                try:
+                    values.append(float(word))
+                except ValueError:
+                    pass # units and comments
+        if len(values) == 1:
+            return values[0]
+        return np.array(values) if np is not None else values
+
+    cmd_spec = get_cmdspec(cmd_id)
+    if cmd_spec is None or cmd_spec.rw != READ or cmd_spec.type >= len(value_formats):
+        print("Error: {} does not return values".format(cmd_id))
+        raise VfctrlError(cmd_id, -1)
+    # the app formats the GET_ERLE_ commands as a single value
+    num_values = cmd_spec.app_read_result_size // struct.calcsize(value_formats[cmd_spec.type])
+    data_out = ctypes.create_string_buffer(max(cmd_spec.app_read_result_size, CMD_MAX_BYTES * 8))
+    ret = lib.vfctrl_execute_command(ctypes.byref(cmd_spec), (ctypes.c_char_p * 1)(cmd_id.encode()),
+                                     data_out, 0, ctypes.create_string_buffer(MAX_OUTPUT_STR_CHARS))
+    if ret != 0:
+        raise VfctrlError(cmd_id, ret)
+    raw = data_out.raw[:cmd_spec.app_read_result_size]
+    if np is not None:
+        values = np.frombuffer(raw, dtype=value_dtypes[cmd_spec.type]).copy()
+    else:
+        values = list(struct.unpack('{}{}'.format(num_values, value_formats[cmd_spec.type]), raw))
+    if num_values == 1:
+        return values[0]
+    return values
+
+
+def set_values(cmd_id, *values):
+    """Write the values of a SET_ command
+
+    Args:
+        cmd_id: parameter command
+        values: values, or a single list or array of values
+
+    Returns:
+        True on success, False on error with the app binary
+
+    Raises:
+        VfctrlError: the shared library returned an error
+    """
+    if len(values) == 1 and hasattr(values[0], '__len__') and not isinstance(values[0], str):
+        values = values[0]
+    return do_command(cmd_id, *values, quiet=True) is not False
+
+
 def build_host_app():
     """Build the host app for the given platform
 
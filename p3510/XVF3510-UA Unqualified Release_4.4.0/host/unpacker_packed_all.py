@@ -2,6 +2,7 @@
 
 """This module contains the script to unpack the packed 16kHz stereo data on one, 48kHz channel
    of a stereo wav file.
+   The unpacker host app in src/unpacker does the same on long captures in a single pass.
    The script requires three positional parameters, stereo 48kHz wav file, channel to unpack and output wav file name.
 """
 import argparse
@@ -33,6 +33,10 @@
 #include <signal.h>
 #include <string.h>
 #include <limits.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
 
 #define ID_RIFF 0x46464952
 #define ID_WAVE 0x45564157
@@ -41,6 +45,17 @@
 
 #define FORMAT_PCM 1
 
+/* Packed capture (PACKED_ALL io map of the XVF3510): each triple of 48 kHz samples of a channel pair
+ * carries one 16 kHz sample of the mics, the references and the outputs of the two channels. The first
+ * sample of a triple has its lowest bit set on at least one channel. */
+#define PACKED_RATE         48000
+#define UNPACKED_RATE       16000
+#define UNPACKED_CHANNELS   6
+#define FRAME_SAMPLES       3
+
+/* Periods in flight between the capture and the unpacking threads */
+#define RING_SLOTS          16
+
 struct wav_header {
     uint32_t riff_id;
     uint32_t riff_sz;
@@ -57,6 +72,44 @@ struct wav_header {
     uint32_t data_sz;
 };
 
+/* Single producer single consumer ring of captured periods: only the capture thread moves head and
+ * only the unpacking thread moves tail, so no lock is needed. */
+struct ring {
+    char *data[RING_SLOTS];
+    unsigned int frames[RING_SLOTS];
+    unsigned int head;
+    unsigned int tail;
+    int done;
+    unsigned int stalls;        /* periods the capture waited for a free slot */
+};
+
+struct unpacker {
+    unsigned int channels;      /* channels of the capture */
+    unsigned int first;         /* first channel of the packed pair */
+    unsigned int bits;
+    int32_t flag_mask;
+    int32_t *pair;              /* packed pair of a period, left aligned, after the pending samples */
+    int32_t *out;
+    unsigned int pending;       /* samples of a frame split between two periods */
+    uint64_t sample_index;      /* 48 kHz samples of the periods before the current one */
+    uint64_t last_start;        /* index of the last frame start + 1, 0 before the first */
+    uint64_t frames;
+    unsigned int corrupted;
+    uint64_t mismatches;        /* benchmark only, unpacked samples which differ from the synthetic input */
+    int verify;
+    FILE *file;
+};
+
+struct capture_args {
+    struct ring *ring;
+    struct pcm *pcm;            /* NULL for the synthetic input of the benchmark */
+    unsigned int channels;
+    unsigned int first;
+    unsigned int bits;
+    unsigned int period_frames;
+    uint64_t total_frames;
+};
+
 int capturing = 1;
 int prinfo = 1;
 
@@ -65,6 +118,10 @@ unsigned int capture_sample(FILE *file, unsigned int card, unsigned int device,
                             enum pcm_format format, unsigned int period_size,
                             unsigned int period_count, unsigned int capture_time);
 
+unsigned int capture_unpacked(FILE *file, struct pcm *pcm, unsigned int channels, unsigned int first,
+                              unsigned int bits, unsigned int period_size, unsigned int period_count,
+                              unsigned int capture_frames, int verify);
+
 void sigint_handler(int sig)
 {
     if (sig == SIGINT){
@@ -87,10 +144,63 @@ int main(int argc, char **argv)
     unsigned int capture_time = 60;
     enum pcm_format format;
     int no_header = 0;
+    int unpack_first = -1;
+    unsigned int bench_time = 0;
+    const char *filename = NULL;
+    int i;
 
-    file = fopen("xmos_test.wav", "wb");
+    for (i = 1; i < argc; i++) {
+        if (i + 1 >= argc) {
+            fprintf(stderr, "Usage: %s [-D card] [-d device] [-c channels] [-r rate] [-b bits] [-p period_size]"
+                    " [-n period_count] [-T seconds] [-u first_channel] [-B seconds] [-o file]\n", argv[0]);
+            fprintf(stderr, "    -u CH   unpack the packed channels CH and CH+1 while capturing\n");
+            fprintf(stderr, "    -B S    benchmark the unpacking on S seconds of synthetic packed audio, no device is used\n");
+            return 1;
+        }
+        if (strcmp(argv[i], "-D") == 0) {
+            card = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-d") == 0) {
+            device = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-c") == 0) {
+            channels = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-r") == 0) {
+            rate = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-b") == 0) {
+            bits = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-p") == 0) {
+            period_size = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-n") == 0) {
+            period_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-T") == 0) {
+            capture_time = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-u") == 0) {
+            unpack_first = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-B") == 0) {
+            bench_time = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "-o") == 0) {
+            filename = argv[++i];
+        } else {
+            fprintf(stderr, "Unknown option %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (bench_time > 0 && unpack_first < 0) {
+        unpack_first = 0;
+    }
+    if (unpack_first >= 0) {
+        rate = PACKED_RATE;
+        if ((unsigned int)unpack_first + 1 >= channels) {
+            fprintf(stderr, "The packed channels %d and %d are not captured\n", unpack_first, unpack_first + 1);
+            return 1;
+        }
+    }
+    if (filename == NULL) {
+        filename = (unpack_first >= 0) ? "xmos_unpacked.wav" : "xmos_test.wav";
+    }
+
+    file = fopen(filename, "wb");
     if (!file) {
-        fprintf(stderr, "Unable to create file '%s'\n", argv[1]);
+        fprintf(stderr, "Unable to create file '%s'\n", filename);
         return 1;
     }
 
@@ -123,6 +233,15 @@ int main(int argc, char **argv)
     header.block_align = channels * (header.bits_per_sample / 8);
     header.data_id = ID_DATA;
 
+    if (unpack_first >= 0) {
+        /* the file holds the unpacked channels, always 32-bit */
+        header.num_channels = UNPACKED_CHANNELS;
+        header.sample_rate = UNPACKED_RATE;
+        header.bits_per_sample = 32;
+        header.byte_rate = 4 * UNPACKED_CHANNELS * UNPACKED_RATE;
+        header.block_align = 4 * UNPACKED_CHANNELS;
+    }
+
     /* leave enough room for header */
     if (!no_header) {
         fseek(file, sizeof(struct wav_header), SEEK_SET);
@@ -130,9 +249,37 @@ int main(int argc, char **argv)
 
     /* install signal handler and begin capturing */
     signal(SIGINT, sigint_handler);
-    frames = capture_sample(file, card, device, header.num_channels,
-                            header.sample_rate, format,
-                            period_size, period_count, capture_time);
+    if (bench_time > 0) {
+        frames = capture_unpacked(file, NULL, channels, unpack_first, bits, period_size, period_count,
+                                  bench_time * rate, 1);
+    } else if (unpack_first >= 0) {
+        struct pcm_config config;
+        struct pcm *pcm;
+
+        memset(&config, 0, sizeof(config));
+        config.channels = channels;
+        config.rate = rate;
+        config.period_size = period_size;
+        config.period_count = period_count;
+        config.format = format;
+        pcm = pcm_open(card, device, PCM_IN, &config);
+        if (!pcm || !pcm_is_ready(pcm)) {
+            fprintf(stderr, "Unable to open PCM device (%s)\n", pcm_get_error(pcm));
+            frames = 0;
+        } else {
+            if (prinfo) {
+                printf("Capturing and unpacking channels %d and %d: %u ch, %u hz, %u bit\n",
+                       unpack_first, unpack_first + 1, channels, rate, bits);
+            }
+            frames = capture_unpacked(file, pcm, channels, unpack_first, bits, period_size, period_count,
+                                      capture_time * rate, 0);
+            pcm_close(pcm);
+        }
+    } else {
+        frames = capture_sample(file, card, device, header.num_channels,
+                                header.sample_rate, format,
+                                period_size, period_count, capture_time);
+    }
     if (prinfo) {
         printf("Captured %u frames\n", frames);
     }
@@ -213,3 +360,217 @@ unsigned int capture_sample(FILE *file, unsigned int card, unsigned int device,
     return total_frames_read;
 }
 
+
+/* Value of the synthetic packed input: a counter of the unpacked samples, with the frame start bit */
+static uint32_t synthetic_sample(uint64_t triple, unsigned int word, unsigned int bits)
+{
+    uint32_t value = (uint32_t)((triple * UNPACKED_CHANNELS + word) << 1);
+    if (word < 2) {
+        value |= 1;
+    }
+    return (bits == 32) ? value : (value & ((1u << bits) - 1));
+}
+
+static void fill_synthetic(char *data, unsigned int frames, uint64_t first_sample, unsigned int channels,
+                           unsigned int first, unsigned int bits)
+{
+    unsigned int bytes = (bits == 16) ? 2 : 4;
+    unsigned int f, j;
+
+    memset(data, 0, (size_t)frames * channels * bytes);
+    for (f = 0; f < frames; f++) {
+        uint64_t s = first_sample + f;
+        for (j = 0; j < 2; j++) {
+            uint32_t v = synthetic_sample(s / FRAME_SAMPLES, (s % FRAME_SAMPLES) * 2 + j, bits);
+            char *p = &data[((size_t)f * channels + first + j) * bytes];
+            if (bytes == 2) {
+                uint16_t v16 = (uint16_t)v;
+                memcpy(p, &v16, 2);
+            } else {
+                memcpy(p, &v, 4);
+            }
+        }
+    }
+}
+
+/* Capture thread: fills the free slots of the ring with periods from the device or the synthetic input */
+static void *capture_thread(void *arg)
+{
+    struct capture_args *a = arg;
+    struct ring *r = a->ring;
+    uint64_t captured = 0;
+
+    while (capturing && captured < a->total_frames) {
+        unsigned int head = r->head;
+        unsigned int frames = a->period_frames;
+        int ret;
+
+        while (head - __atomic_load_n(&r->tail, __ATOMIC_ACQUIRE) >= RING_SLOTS) {
+            r->stalls++;
+            sched_yield();
+        }
+        if (frames > a->total_frames - captured) {
+            frames = (unsigned int)(a->total_frames - captured);
+        }
+        if (a->pcm) {
+            ret = pcm_readi(a->pcm, r->data[head % RING_SLOTS], frames);
+            if (ret < 0) {
+                fprintf(stderr, "Error capturing sample (%s)\n", pcm_get_error(a->pcm));
+                break;
+            }
+            frames = ret;
+        } else {
+            fill_synthetic(r->data[head % RING_SLOTS], frames, captured, a->channels, a->first, a->bits);
+        }
+        r->frames[head % RING_SLOTS] = frames;
+        captured += frames;
+        __atomic_store_n(&r->head, head + 1, __ATOMIC_RELEASE);
+    }
+    __atomic_store_n(&r->done, 1, __ATOMIC_RELEASE);
+    return NULL;
+}
+
+/* Unpack a period: the frames found in the packed pair are written to the file as they are, the
+ * samples of a frame are already in the order of the unpacked channels */
+static int unpack_period(struct unpacker *u, const char *data, unsigned int frames)
+{
+    int32_t *pair = &u->pair[u->pending * 2];
+    unsigned int n = u->pending + frames;
+    unsigned int num_out = 0;
+    unsigned int f, i;
+
+    for (f = 0; f < frames; f++) {
+        if (u->bits == 16) {
+            const int16_t *p = (const int16_t *)data + (size_t)f * u->channels + u->first;
+            pair[2 * f] = (int32_t)((uint32_t)(uint16_t)p[0] << 16);
+            pair[2 * f + 1] = (int32_t)((uint32_t)(uint16_t)p[1] << 16);
+        } else {
+            const int32_t *p = (const int32_t *)data + (size_t)f * u->channels + u->first;
+            unsigned int shift = 32 - u->bits;
+            pair[2 * f] = (int32_t)((uint32_t)p[0] << shift);
+            pair[2 * f + 1] = (int32_t)((uint32_t)p[1] << shift);
+        }
+    }
+
+    i = 0;
+    while (i + 2 < n) {
+        const int32_t *p = &u->pair[2 * i];
+        uint64_t sample = u->sample_index - u->pending + i;
+        if (((p[0] | p[1]) & u->flag_mask) == 0) {
+            i++;
+            continue;
+        }
+        if (u->last_start != 0 && sample + 1 - u->last_start != FRAME_SAMPLES) {
+            u->corrupted++;
+        }
+        u->last_start = sample + 1;
+        memcpy(&u->out[num_out * UNPACKED_CHANNELS], p, UNPACKED_CHANNELS * sizeof(int32_t));
+        if (u->verify) {
+            unsigned int w;
+            for (w = 0; w < UNPACKED_CHANNELS; w++) {
+                uint32_t expected = synthetic_sample(u->frames + num_out, w, u->bits) << (32 - u->bits);
+                if ((uint32_t)p[w] != expected) {
+                    u->mismatches++;
+                }
+            }
+        }
+        num_out++;
+        /* the other two samples of an aligned frame cannot start a frame */
+        i += (((p[2] | p[3] | p[4] | p[5]) & u->flag_mask) == 0) ? FRAME_SAMPLES : 1;
+    }
+    u->pending = n - i;
+    memmove(u->pair, &u->pair[2 * i], u->pending * 2 * sizeof(int32_t));
+    u->sample_index += frames;
+    u->frames += num_out;
+    if (num_out > 0 && fwrite(u->out, UNPACKED_CHANNELS * sizeof(int32_t), num_out, u->file) != num_out) {
+        fprintf(stderr, "Error writing the unpacked channels\n");
+        return -1;
+    }
+    return 0;
+}
+
+/* Capture on one thread and unpack on the calling thread, the two are decoupled by the ring so that
+ * the writes cannot delay the reads from the device. Returns the number of unpacked frames. */
+unsigned int capture_unpacked(FILE *file, struct pcm *pcm, unsigned int channels, unsigned int first,
+                              unsigned int bits, unsigned int period_size, unsigned int period_count,
+                              unsigned int capture_frames, int verify)
+{
+    struct ring ring;
+    struct unpacker u;
+    struct capture_args args;
+    pthread_t thread;
+    unsigned int bytes_per_sample = (bits == 16) ? 2 : 4;
+    unsigned int period_frames = period_size * period_count;
+    struct timespec start, end;
+    double elapsed;
+    unsigned int k;
+
+    memset(&ring, 0, sizeof(ring));
+    for (k = 0; k < RING_SLOTS; k++) {
+        ring.data[k] = malloc((size_t)period_frames * channels * bytes_per_sample);
+    }
+    memset(&u, 0, sizeof(u));
+    u.channels = channels;
+    u.first = first;
+    u.bits = bits;
+    u.flag_mask = (int32_t)(1u << (32 - bits));
+    u.pair = malloc(((size_t)period_frames + FRAME_SAMPLES) * 2 * sizeof(int32_t));
+    u.out = malloc(((size_t)period_frames + FRAME_SAMPLES) * UNPACKED_CHANNELS * sizeof(int32_t));
+    u.verify = verify;
+    u.file = file;
+
+    memset(&args, 0, sizeof(args));
+    args.ring = &ring;
+    args.pcm = pcm;
+    args.channels = channels;
+    args.first = first;
+    args.bits = bits;
+    args.period_frames = period_frames;
+    args.total_frames = capture_frames;
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    pthread_create(&thread, NULL, capture_thread, &args);
+    for (;;) {
+        unsigned int tail = ring.tail;
+        if (tail == __atomic_load_n(&ring.head, __ATOMIC_ACQUIRE)) {
+            if (__atomic_load_n(&ring.done, __ATOMIC_ACQUIRE) && tail == __atomic_load_n(&ring.head, __ATOMIC_ACQUIRE)) {
+                break;
+            }
+            usleep(1000);
+            continue;
+        }
+        if (unpack_period(&u, ring.data[tail % RING_SLOTS], ring.frames[tail % RING_SLOTS]) != 0) {
+            capturing = 0;
+        }
+        __atomic_store_n(&ring.tail, tail + 1, __ATOMIC_RELEASE);
+    }
+    pthread_join(thread, NULL);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    if (prinfo) {
+        printf("Unpacked %llu frames (%.1f s) in %.3f s", (unsigned long long)u.frames,
+               (double)u.frames / UNPACKED_RATE, elapsed);
+        if (!pcm && elapsed > 0) {
+            printf(", %.0fx real time, %.1f MB/s of packed input", (double)u.frames / UNPACKED_RATE / elapsed,
+                   (double)u.sample_index * channels * bytes_per_sample / elapsed / 1e6);
+        }
+        printf("\n");
+        if (ring.stalls > 0) {
+            printf("The capture waited %u times for the unpacking\n", ring.stalls);
+        }
+        if (u.corrupted > 0) {
+            printf("%u corrupted frames\n", u.corrupted);
+        }
+        if (verify) {
+            printf("%llu unpacked samples differ from the synthetic input\n", (unsigned long long)u.mismatches);
+        }
+    }
+
+    for (k = 0; k < RING_SLOTS; k++) {
+        free(ring.data[k]);
+    }
+    free(u.pair);
+    free(u.out);
+    return (unsigned int)u.frames;
+}